@@ -741,6 +741,41 @@ macro(ost_unittest)
     # message("${OUTT}")
 endmacro()
 
+#-------------------------------------------------------------------------------
+# ost_benchmark
+#
+# Synopsis
+#   ost_benchmark(NAME bench_name MODULE mod SOURCES source1 source2 LINK ...)
+#
+# Description:
+#  Compile a C++ benchmark executable. Benchmarks are never built by default and
+#  not registered with ctest. Use 'make benchmarks' to build all of them, the
+#  executables end up in the benchmarks directory of the build tree.
+#-------------------------------------------------------------------------------
+add_custom_target(benchmarks)
+set_target_properties(benchmarks PROPERTIES EXCLUDE_FROM_ALL "1")
+
+macro(ost_benchmark)
+  set(_ARG_PREFIX ost)
+  parse_argument_list(_ARG 
+                      "NAME;MODULE;PREFIX;SOURCES;LINK" "" ${ARGN})
+  if (NOT _ARG_NAME)
+    message(FATAL_ERROR "invalid use of ost_benchmark(): a name must be provided")
+  endif()
+  add_executable(${_ARG_NAME} EXCLUDE_FROM_ALL ${_ARG_SOURCES})
+  set_target_properties(${_ARG_NAME} PROPERTIES RUNTIME_OUTPUT_DIRECTORY
+                        "${CMAKE_BINARY_DIR}/benchmarks")
+  set_target_properties(${_ARG_NAME} PROPERTIES RUNTIME_OUTPUT_DIRECTORY_DEBUG
+                        "${CMAKE_BINARY_DIR}/benchmarks")
+  set_target_properties(${_ARG_NAME} PROPERTIES RUNTIME_OUTPUT_DIRECTORY_RELEASE
+                        "${CMAKE_BINARY_DIR}/benchmarks")
+  target_link_libraries(${_ARG_NAME} "${_ARG_PREFIX}_${_ARG_MODULE}")
+  if (_ARG_LINK)
+    target_link_libraries(${_ARG_NAME} ${_ARG_LINK})
+  endif()
+  add_dependencies(benchmarks ${_ARG_NAME})
+endmacro()
+
 #-------------------------------------------------------------------------------
 # make sure the previously detected Python interpreter has the given module
 #-------------------------------------------------------------------------------
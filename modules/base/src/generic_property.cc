@@ -16,9 +16,239 @@
 // along with this library; if not, write to the Free Software Foundation, Inc.,
 // 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 //------------------------------------------------------------------------------
+#include <algorithm>
 #include "generic_property.hh"
 
 namespace ost {
 
+GenericPropValue GenericPropTable::Column::Get(unsigned int slot) const
+{
+  switch (type_) {
+    case STRING:
+      return strings_[slot];
+    case REAL:
+      return reals_[slot];
+    case INT:
+      return ints_[slot];
+    case BOOL:
+      return ints_[slot]!=0;
+    case VEC3:
+      return vec3s_[slot];
+    default:
+      return mixed_[slot];
+  }
+}
+
+bool GenericPropTable::Column::GetNumeric(unsigned int slot, 
+                                          Real& value) const
+{
+  switch (type_) {
+    case REAL:
+      value=reals_[slot];
+      return true;
+    case INT:
+    case BOOL:
+      value=static_cast<Real>(ints_[slot]);
+      return true;
+    case MIXED: {
+      const GenericPropValue& v=mixed_[slot];
+      switch (v.which()) {
+        case REAL:
+          value=boost::get<Real>(v);
+          return true;
+        case INT:
+          value=static_cast<Real>(boost::get<int>(v));
+          return true;
+        case BOOL:
+          value=static_cast<Real>(boost::get<bool>(v));
+          return true;
+      }
+      return false;
+    }
+    default:
+      return false;
+  }
+}
+
+void GenericPropTable::Column::Set(unsigned int slot, 
+                                   const GenericPropValue& value)
+{
+  if (count_==0) {
+    // the type of an empty column can be changed freely
+    type_=value.which();
+    reals_.clear();
+    ints_.clear();
+    strings_.clear();
+    vec3s_.clear();
+    mixed_.clear();
+  } else if (type_!=MIXED && type_!=value.which()) {
+    this->ToMixed();
+  }
+  if (slot>=present_.size()) {
+    size_t size=std::max<size_t>(slot+1, 2*present_.size());
+    present_.resize(size, 0);
+  }
+  size_t size=present_.size();
+  switch (type_) {
+    case STRING:
+      strings_.resize(size);
+      strings_[slot]=boost::get<String>(value);
+      break;
+    case REAL:
+      reals_.resize(size);
+      reals_[slot]=boost::get<Real>(value);
+      break;
+    case INT:
+      ints_.resize(size);
+      ints_[slot]=boost::get<int>(value);
+      break;
+    case BOOL:
+      ints_.resize(size);
+      ints_[slot]=boost::get<bool>(value);
+      break;
+    case VEC3:
+      vec3s_.resize(size);
+      vec3s_[slot]=boost::get<geom::Vec3>(value);
+      break;
+    default:
+      mixed_.resize(size);
+      mixed_[slot]=value;
+  }
+  if (!present_[slot]) {
+    present_[slot]=1;
+    ++count_;
+  }
+}
+
+void GenericPropTable::Column::Remove(unsigned int slot)
+{
+  if (!this->Has(slot)) {
+    return;
+  }
+  present_[slot]=0;
+  --count_;
+  // release memory held by the value
+  if (type_==STRING) {
+    String().swap(strings_[slot]);
+  } else if (type_==MIXED) {
+    mixed_[slot]=GenericPropValue();
+  }
+}
+
+void GenericPropTable::Column::ToMixed()
+{
+  mixed_.resize(present_.size());
+  for (size_t i=0; i<present_.size(); ++i) {
+    if (present_[i]) {
+      mixed_[i]=this->Get(i);
+    }
+  }
+  type_=MIXED;
+  std::vector<Real>().swap(reals_);
+  std::vector<int>().swap(ints_);
+  std::vector<String>().swap(strings_);
+  std::vector<geom::Vec3>().swap(vec3s_);
+}
+
+unsigned int GenericPropTable::AllocSlot()
+{
+  if (!free_slots_.empty()) {
+    unsigned int slot=free_slots_.back();
+    free_slots_.pop_back();
+    return slot;
+  }
+  return num_slots_++;
+}
+
+void GenericPropTable::FreeSlot(unsigned int slot)
+{
+  this->Clear(slot);
+  free_slots_.push_back(slot);
+}
+
+bool GenericPropTable::Has(unsigned int slot, const String& key) const
+{
+  ColumnMap::const_iterator i=columns_.find(key);
+  return i!=columns_.end() && i->second.Has(slot);
+}
+
+bool GenericPropTable::Get(unsigned int slot, const String& key,
+                           GenericPropValue& value) const
+{
+  ColumnMap::const_iterator i=columns_.find(key);
+  if (i==columns_.end() || !i->second.Has(slot)) {
+    return false;
+  }
+  value=i->second.Get(slot);
+  return true;
+}
+
+bool GenericPropTable::GetNumeric(unsigned int slot, const String& key,
+                                  Real& value) const
+{
+  ColumnMap::const_iterator i=columns_.find(key);
+  if (i==columns_.end() || !i->second.Has(slot)) {
+    return false;
+  }
+  if (!i->second.GetNumeric(slot, value)) {
+    std::ostringstream m("");
+    m << "property '" << key << "' is not numeric";
+    throw GenericPropError(m.str());
+  }
+  return true;
+}
+
+void GenericPropTable::Set(unsigned int slot, const String& key,
+                           const GenericPropValue& value)
+{
+  columns_[key].Set(slot, value);
+}
+
+void GenericPropTable::Remove(unsigned int slot, const String& key)
+{
+  ColumnMap::iterator i=columns_.find(key);
+  if (i==columns_.end()) {
+    return;
+  }
+  i->second.Remove(slot);
+  if (i->second.GetCount()==0) {
+    columns_.erase(i);
+  }
+}
+
+void GenericPropTable::Clear(unsigned int slot)
+{
+  for (ColumnMap::iterator i=columns_.begin(); i!=columns_.end(); ) {
+    i->second.Remove(slot);
+    if (i->second.GetCount()==0) {
+      columns_.erase(i++);
+    } else {
+      ++i;
+    }
+  }
+}
+
+GenericPropMap GenericPropTable::GetMap(unsigned int slot) const
+{
+  GenericPropMap props;
+  for (ColumnMap::const_iterator i=columns_.begin(); i!=columns_.end(); ++i) {
+    if (i->second.Has(slot)) {
+      props.insert(props.end(), std::make_pair(i->first, 
+                                               i->second.Get(slot)));
+    }
+  }
+  return props;
+}
+
+std::vector<String> GenericPropTable::GetKeys(unsigned int slot) const
+{
+  std::vector<String> keys;
+  for (ColumnMap::const_iterator i=columns_.begin(); i!=columns_.end(); ++i) {
+    if (i->second.Has(slot)) {
+      keys.push_back(i->first);
+    }
+  }
+  return keys;
+}
 
 } // ns
@@ -32,6 +32,7 @@
 #include <map>
 #include <vector>
 #include <boost/variant.hpp>
+#include <boost/shared_ptr.hpp>
 
 #include <ost/module_config.hh>
 #include <ost/invalid_handle.hh>
@@ -49,52 +50,235 @@ struct  DLLEXPORT GenericPropError: public Error
 
 typedef boost::variant<String, Real, int, bool, geom::Vec3> GenericPropValue;
 
+typedef std::map<String,GenericPropValue> GenericPropMap;
+
+/// \brief columnar storage of generic properties
+///
+/// Stores the generic properties of many objects, e.g. all atoms of an
+/// entity. Objects are identified by slots. There is one dense column per
+/// property name, holding the values of all slots in a typed array, as long
+/// as all values of the column have the same type. Columns with values of
+/// different types fall back to storing variants.
+///
+/// Compared to one map per object, this avoids many small allocations and
+/// the string keys are stored only once. The table is not thread safe:
+/// properties of objects sharing a table must not be modified concurrently.
+class DLLEXPORT_OST_BASE GenericPropTable {
+public:
+  GenericPropTable(): num_slots_(0) {}
+
+  /// \brief reserve slot for a new object
+  unsigned int AllocSlot();
+
+  /// \brief remove all properties of slot and make it available for reuse
+  void FreeSlot(unsigned int slot);
+
+  bool Has(unsigned int slot, const String& key) const;
+
+  /// \brief get value, returns false if the property does not exist
+  bool Get(unsigned int slot, const String& key,
+           GenericPropValue& value) const;
+
+  /// \brief get numeric value, returns false if the property does not exist
+  ///
+  /// \throws GenericPropError if the property is not numeric
+  bool GetNumeric(unsigned int slot, const String& key, Real& value) const;
+
+  void Set(unsigned int slot, const String& key,
+           const GenericPropValue& value);
+
+  void Remove(unsigned int slot, const String& key);
+
+  /// \brief remove all properties of slot
+  void Clear(unsigned int slot);
+
+  GenericPropMap GetMap(unsigned int slot) const;
+
+  std::vector<String> GetKeys(unsigned int slot) const;
+
+  /// \brief number of property names with at least one value
+  size_t GetColumnCount() const { return columns_.size(); }
+
+  /// \brief number of slots in use
+  size_t GetSlotCount() const { return num_slots_-free_slots_.size(); }
+
+private:
+  class Column {
+  public:
+    Column(): type_(EMPTY), count_(0) {}
+
+    bool Has(unsigned int slot) const
+    {
+      return slot<present_.size() && present_[slot];
+    }
+
+    GenericPropValue Get(unsigned int slot) const;
+
+    bool GetNumeric(unsigned int slot, Real& value) const;
+
+    void Set(unsigned int slot, const GenericPropValue& value);
+
+    void Remove(unsigned int slot);
+
+    size_t GetCount() const { return count_; }
+
+  private:
+    // the types of the typed columns match GenericPropValue::which()
+    enum {
+      STRING=0, REAL=1, INT=2, BOOL=3, VEC3=4, MIXED=5, EMPTY=6
+    };
+
+    void ToMixed();
+
+    int                           type_;
+    size_t                        count_;
+    std::vector<char>             present_;
+    std::vector<Real>             reals_;
+    // values of int and bool columns
+    std::vector<int>              ints_;
+    std::vector<String>           strings_;
+    std::vector<geom::Vec3>       vec3s_;
+    std::vector<GenericPropValue> mixed_;
+  };
+
+  typedef std::map<String, Column> ColumnMap;
+
+  ColumnMap                 columns_;
+  std::vector<unsigned int> free_slots_;
+  unsigned int              num_slots_;
+};
+
+typedef boost::shared_ptr<GenericPropTable> GenericPropTablePtr;
+
 ///  \brief base class for the implementation
+///
+/// Properties are stored in a map owned by the object, unless the object is
+/// attached to a GenericPropTable with SetPropTable().
 class  TEMPLATE_EXPORT GenericPropContainerImpl
 {
-  typedef std::map<String,GenericPropValue> PropertyMap;
+  typedef GenericPropMap PropertyMap;
   
 public:
-  GenericPropContainerImpl(): map_(NULL) {}
+  GenericPropContainerImpl(): map_(NULL), table_(), slot_(0) {}
   ~GenericPropContainerImpl()
   {
     if (map_) {
       delete map_;
     }
+    if (table_) {
+      table_->FreeSlot(slot_);
+    }
   }
   GenericPropContainerImpl(const GenericPropContainerImpl& rhs):
-    map_(rhs.map_ ? new PropertyMap(*rhs.map_) : NULL)
-  { }
+    map_(NULL), table_(), slot_(0)
+  {
+    this->Assign(rhs);
+  }
   
   GenericPropContainerImpl& operator=(const GenericPropContainerImpl& r)   
   {
     this->Assign(r);
     return *this;
   }
-  
-  GenericPropValue& GenericProp(const String& key) 
+
+  /// \brief store properties in table from now on
+  ///
+  /// Properties set so far are moved to the table.
+  void SetPropTable(const GenericPropTablePtr& table)
+  {
+    if (table==table_) {
+      return;
+    }
+    PropertyMap props=this->GetPropMap();
+    this->ClearProps();
+    if (table_) {
+      table_->FreeSlot(slot_);
+    }
+    table_=table;
+    if (table_) {
+      slot_=table_->AllocSlot();
+    }
+    if (map_) {
+      delete map_;
+      map_=NULL;
+    }
+    for (PropertyMap::const_iterator i=props.begin(); i!=props.end(); ++i) {
+      this->SetProp(i->first, i->second);
+    }
+  }
+
+  const GenericPropTablePtr& GetPropTable() const { return table_; }
+
+  /// \brief get value, returns false if the property does not exist
+  bool FindProp(const String& key, GenericPropValue& value) const
   {
+    if (table_) {
+      return table_->Get(slot_, key, value);
+    }
     if (!map_) {
-      map_=new PropertyMap;
+      return false;
+    }
+    PropertyMap::const_iterator i=map_->find(key);
+    if (i==map_->end()) {
+      return false;
     }
-    return (*map_)[key];
+    value=i->second;
+    return true;
   }
-  
-  const GenericPropValue& GenericProp(const String& key) const
+
+  /// \brief get numeric value, returns false if the property does not exist
+  ///
+  /// \throws GenericPropError if the property is not numeric
+  bool FindNumericProp(const String& key, Real& value) const
   {
+    if (table_) {
+      return table_->GetNumeric(slot_, key, value);
+    }
+    GenericPropValue v;
+    if (!this->FindProp(key, v)) {
+      return false;
+    }
+    switch (v.which()) {
+      case 1:
+        value=boost::get<Real>(v);
+        return true;
+      case 2:
+        value=static_cast<Real>(boost::get<int>(v));
+        return true;
+      case 3:
+        value=static_cast<Real>(boost::get<bool>(v));
+        return true;
+    }
+    std::ostringstream m("");
+    m << "property '" << key << "' is not numeric";
+    throw GenericPropError(m.str());
+  }
+
+  void SetProp(const String& key, const GenericPropValue& value)
+  {
+    if (table_) {
+      table_->Set(slot_, key, value);
+      return;
+    }
     if (!map_) {
       map_=new PropertyMap;
-    }    
-    return (*map_)[key];
+    }
+    (*map_)[key]=value;
   }
   
   bool HasProp(const String& key) const
   {
+    if (table_) {
+      return table_->Has(slot_, key);
+    }
     return map_ && map_->find(key) != map_->end();
   }
   
   void ClearProps()
   {
+    if (table_) {
+      table_->Clear(slot_);
+    }
     if (map_) {
       map_->clear();      
     }
@@ -102,6 +286,9 @@ public:
   
   void RemoveProp(const String& key)
   {
+    if (table_) {
+      table_->Remove(slot_, key);
+    }
     if (map_) {
       map_->erase(key);
     }
@@ -109,27 +296,44 @@ public:
 
   void Assign(const GenericPropContainerImpl& impl)
   {
-    if (impl.map_) {
-      if (!map_) {
-        map_=new PropertyMap(*impl.map_);
+    if (&impl==this) {
+      return;
+    }
+    if (!table_ && !impl.table_) {
+      if (impl.map_) {
+        if (!map_) {
+          map_=new PropertyMap(*impl.map_);
+        } else {
+          *map_=*impl.map_;
+        }
       } else {
-        *map_=*impl.map_;
+        this->ClearProps();
       }
-    } else {
-      this->ClearProps();
+      return;
+    }
+    PropertyMap props=impl.GetPropMap();
+    this->ClearProps();
+    for (PropertyMap::const_iterator i=props.begin(); i!=props.end(); ++i) {
+      this->SetProp(i->first, i->second);
     }
   }
   
   PropertyMap GetPropMap() const
   {
+    if (table_) {
+      return table_->GetMap(slot_);
+    }
     if (!map_) {
-      map_=new PropertyMap;
+      return PropertyMap();
     }    
     return *map_;
   }
       
   std::vector<String> GetPropList() const
   {
+    if (table_) {
+      return table_->GetKeys(slot_);
+    }
     std::vector<String> prop_list;
     if (map_) {
       PropertyMap::const_iterator i;
@@ -141,7 +345,9 @@ public:
   }
   
 private:
-  mutable PropertyMap* map_;
+  PropertyMap*        map_;
+  GenericPropTablePtr table_;
+  unsigned int        slot_;
 };  
 
 template <typename H>
@@ -150,8 +356,9 @@ protected:
   
   template<typename T>
   T gp_get(const String& key) const {
-    if(HasProp(key)) {
-      return boost::get<T>(GetImpl()->GenericProp(key));
+    GenericPropValue value;
+    if(GetImpl()->FindProp(key, value)) {
+      return boost::get<T>(value);
     } else {
       std::ostringstream m("");
       m << "unknown property " << key;
@@ -161,8 +368,9 @@ protected:
 
   template<typename T>
   T gp_get(const String& key, const T& def) const {
-    if(HasProp(key)) {
-      return boost::get<T>(GetImpl()->GenericProp(key));
+    GenericPropValue value;
+    if(GetImpl()->FindProp(key, value)) {
+      return boost::get<T>(value);
     }
     return def;
   }
@@ -193,9 +401,10 @@ public:
   String GetPropAsString(const String& key) const
   {
     CheckHandleValidity(*static_cast<const H*>(this));    
-    if(!HasProp(key)) return "";
+    GenericPropValue value;
+    if(!this->GetImpl()->FindProp(key, value)) return "";
     std::ostringstream rep("");
-    rep << this->GetImpl()->GenericProp(key);
+    rep << value;
     return rep.str();
   }  
 
@@ -211,19 +420,9 @@ public:
   Real GetFloatProp(const String& key) const
   {
     CheckHandleValidity(*static_cast<const H*>(this));    
-    if(HasProp(key)) {
-      GenericPropValue value=this->GetImpl()->GenericProp(key);
-      switch (value.which()) {
-        case 1:
-          return boost::get<Real>(value);
-        case 2:
-          return static_cast<Real>(boost::get<int>(value));
-        case 3:
-          return static_cast<Real>(boost::get<bool>(value));
-      }
-      std::ostringstream m("");
-      m << "property '" << key << "' is not numeric";
-      throw GenericPropError(m.str());
+    Real value;
+    if(this->GetImpl()->FindNumericProp(key, value)) {
+      return value;
     }
     std::ostringstream m("");
     m << "unknown property " << key;
@@ -233,8 +432,8 @@ public:
   int GetIntProp(const String& key) const
   {
     CheckHandleValidity(*static_cast<const H*>(this));    
-    if (HasProp(key)){
-      GenericPropValue value=this->GetImpl()->GenericProp(key);
+    GenericPropValue value;
+    if (this->GetImpl()->FindProp(key, value)){
       switch (value.which()) {
         case 2:
           return boost::get<int>(value);
@@ -276,19 +475,9 @@ public:
   Real GetFloatProp(const String& key, Real def) const
   {
     CheckHandleValidity(*static_cast<const H*>(this));    
-    if(this->HasProp(key)) {
-      GenericPropValue value=GetImpl()->GenericProp(key);
-      switch (value.which()) {
-        case 1:
-          return boost::get<Real>(value);
-        case 2:
-          return static_cast<Real>(boost::get<int>(value));
-        case 3:
-          return static_cast<Real>(boost::get<bool>(value));
-      }
-      std::ostringstream m("");
-      m << "property '" << key << "' is not numeric";
-      throw GenericPropError(m.str());
+    Real value;
+    if(this->GetImpl()->FindNumericProp(key, value)) {
+      return value;
     }
     return def;
   }
@@ -297,8 +486,8 @@ public:
   int GetIntProp(const String& key, int def) const
   {
     CheckHandleValidity(*static_cast<const H*>(this));    
-    if(this->HasProp(key)) {
-      GenericPropValue value=GetImpl()->GenericProp(key);
+    GenericPropValue value;
+    if(this->GetImpl()->FindProp(key, value)) {
       switch (value.which()) {
         case 2:
           return boost::get<int>(value);
@@ -348,35 +537,35 @@ public:
   void SetStringProp(const String& key, const String& value)
   {
     CheckHandleValidity(*static_cast<const H*>(this));    
-    this->GetImpl()->GenericProp(key)=value;
+    this->GetImpl()->SetProp(key, value);
   }
 
   /// \brief sets floating point property
   void SetFloatProp(const String& key, Real value)
   {
     CheckHandleValidity(*static_cast<const H*>(this));    
-    this->GetImpl()->GenericProp(key)=value;
+    this->GetImpl()->SetProp(key, value);
   }
 
   /// \brief sets integer property
   void SetIntProp(const String& key, int value)
   {
     CheckHandleValidity(*static_cast<const H*>(this));    
-    this->GetImpl()->GenericProp(key)=value;
+    this->GetImpl()->SetProp(key, value);
   }
 
   /// \ brief sets boolean property
   void SetBoolProp(const String& key, bool value)
   {
     CheckHandleValidity(*static_cast<const H*>(this));    
-    this->GetImpl()->GenericProp(key)=value;
+    this->GetImpl()->SetProp(key, value);
   }
   
   /// \ brief sets Vec3 property
   void SetVec3Prop(const String& key, geom::Vec3 value)
   {
     CheckHandleValidity(*static_cast<const H*>(this));    
-    this->GetImpl()->GenericProp(key)=value;
+    this->GetImpl()->SetProp(key, value);
   } 
 
   void RemoveProp(const String& key)
@@ -21,6 +21,7 @@
 #include <boost/test/unit_test.hpp>
 
 #include <ost/mol/mol.hh>
+#include <ost/mol/impl/entity_impl.hh>
 
 using namespace ost;
 using namespace ost::mol;
@@ -72,4 +73,76 @@ BOOST_AUTO_TEST_CASE( test_generic_property )
   BOOST_CHECK(atom.GetIntProp("xx")==1);
 }
 
+BOOST_AUTO_TEST_CASE( test_generic_prop_table )
+{
+  GenericPropTable table;
+  unsigned int s1=table.AllocSlot();
+  unsigned int s2=table.AllocSlot();
+  BOOST_CHECK_EQUAL(table.GetSlotCount(), size_t(2));
+  table.Set(s1, "x", Real(1.5));
+  table.Set(s2, "x", Real(2.5));
+  table.Set(s2, "name", String("abc"));
+  BOOST_CHECK_EQUAL(table.GetColumnCount(), size_t(2));
+  BOOST_CHECK(table.Has(s1, "x"));
+  BOOST_CHECK(!table.Has(s1, "name"));
+  Real r=0.0;
+  BOOST_CHECK(table.GetNumeric(s2, "x", r));
+  BOOST_CHECK_EQUAL(r, Real(2.5));
+  BOOST_CHECK(!table.GetNumeric(s1, "name", r));
+  BOOST_CHECK_THROW(table.GetNumeric(s2, "name", r), GenericPropError);
+
+  // values of different types in the same column
+  table.Set(s1, "x", 3);
+  GenericPropValue v;
+  BOOST_CHECK(table.Get(s1, "x", v));
+  BOOST_CHECK_EQUAL(boost::get<int>(v), 3);
+  BOOST_CHECK(table.Get(s2, "x", v));
+  BOOST_CHECK_EQUAL(boost::get<Real>(v), Real(2.5));
+  BOOST_CHECK(table.GetNumeric(s1, "x", r));
+  BOOST_CHECK_EQUAL(r, Real(3.0));
+
+  BOOST_CHECK_EQUAL(table.GetMap(s2).size(), size_t(2));
+  table.Remove(s2, "name");
+  BOOST_CHECK_EQUAL(table.GetColumnCount(), size_t(1));
+  table.FreeSlot(s1);
+  BOOST_CHECK_EQUAL(table.GetSlotCount(), size_t(1));
+  // freed slots are reused without the properties of the previous owner
+  unsigned int s3=table.AllocSlot();
+  BOOST_CHECK_EQUAL(s3, s1);
+  BOOST_CHECK(!table.Has(s3, "x"));
+  table.Clear(s2);
+  BOOST_CHECK_EQUAL(table.GetColumnCount(), size_t(0));
+}
+
+BOOST_AUTO_TEST_CASE( test_generic_property_columnar )
+{
+  EntityHandle eh=CreateEntity();
+  XCSEditor editor=eh.EditXCS();
+  ChainHandle ch=editor.InsertChain("A");
+  ResidueHandle res=editor.AppendResidue(ch, "X");
+  AtomHandle a1=editor.InsertAtom(res, "A1", geom::Vec3(1, 0, 0));
+  AtomHandle a2=editor.InsertAtom(res, "A2", geom::Vec3(2, 0, 0));
+  a1.SetFloatProp("score", 1.0);
+  a2.SetFloatProp("score", 2.0);
+  a2.SetStringProp("tag", "x");
+  impl::EntityImplPtr impl=eh.Impl();
+  BOOST_CHECK_EQUAL(impl->GetAtomPropTable()->GetColumnCount(), size_t(2));
+  BOOST_CHECK_EQUAL(impl->GetAtomPropTable()->GetSlotCount(), size_t(2));
+  BOOST_CHECK_EQUAL(eh.Select("gascore>1.5").GetAtomCount(), 1);
+  BOOST_CHECK_EQUAL(a2.GetPropList().size(), size_t(2));
+
+  EntityHandle copy=eh.Copy();
+  AtomHandle c2=copy.FindAtom("A", ResNum(1), "A2");
+  BOOST_CHECK_EQUAL(c2.GetFloatProp("score"), Real(2.0));
+  c2.SetFloatProp("score", 5.0);
+  BOOST_CHECK_EQUAL(a2.GetFloatProp("score"), Real(2.0));
+
+  // the slot is released when the last handle to the atom goes away
+  editor.DeleteAtom(a1);
+  a1=AtomHandle();
+  BOOST_CHECK_EQUAL(impl->GetAtomPropTable()->GetSlotCount(), size_t(1));
+  a2.ClearProps();
+  BOOST_CHECK_EQUAL(impl->GetAtomPropTable()->GetColumnCount(), size_t(0));
+}
+
 BOOST_AUTO_TEST_SUITE_END();
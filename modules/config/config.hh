@@ -0,0 +1,37 @@
+//------------------------------------------------------------------------------
+// This file is part of the OpenStructure project <www.openstructure.org>
+//
+// Copyright (C) 2008-2020 by the OpenStructure authors
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 3.0 of the License, or (at your option)
+// any later version.
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//------------------------------------------------------------------------------
+#ifndef OST_CONFIG_HH
+#define OST_CONFIG_HH
+
+/*
+  DO NOT EDIT, automatically generated by CMake
+*/
+
+#define OST_SHADER_SUPPORT_ENABLED 0
+#define OST_PROFILING_ENABLED 0
+#define OST_ANIMATIONS_ENABLED 0
+#define OST_IMG_ENABLED 0
+#define OST_DOUBLE_PRECISION 0
+#define OST_STATIC_PROPERTY_WORKAROUND 0
+#define OST_FFT_USE_THREADS 0
+#define OST_NUMPY_SUPPORT_ENABLED 0
+#define OST_UBUNTU_LAYOUT 0
+#define OST_INFO_ENABLED 0
+
+#endif
@@ -31,7 +31,8 @@
 namespace ost { namespace conop {
 
 void HeuristicProcessor::ProcessUnkResidue(DiagnosticsPtr diags, 
-                                           mol::ResidueHandle res) const {
+                                           mol::ResidueHandle res,
+                                           ChainNeighbors& neighbors) const {
   mol::AtomHandleList atoms = res.GetAtomList(); 
   for (mol::AtomHandleList::iterator 
        i = atoms.begin(), e = atoms.end(); i != e; ++i) {
@@ -45,7 +46,7 @@ void HeuristicProcessor::ProcessUnkResidue(DiagnosticsPtr diags,
   if (!this->GetConnect()) { return; }
   for (mol::AtomHandleList::iterator 
        i = atoms.begin(), e = atoms.end(); i != e; ++i) {
-    this->DistanceBasedConnect(*i);
+    this->DistanceBasedConnect(*i, neighbors);
   }
 }
 
@@ -59,13 +60,14 @@ void HeuristicProcessor::DoProcess(DiagnosticsPtr diags,
     mol::ChainHandle& chain = *i;
     mol::ResidueHandleList residues = chain.GetResidueList();
     mol::ResidueHandle prev;
+    ChainNeighbors neighbors(chain);
     for (mol::ResidueHandleList::iterator 
          j = residues.begin(), e2 = residues.end(); j != e2; ++j) {
       mol::ResidueHandle residue = *j;
       CompoundPtr compound = lib_.FindCompound(residue.GetName(), Compound::PDB);
       if (!compound) {
         // process unknown residue...
-        this->ProcessUnkResidue(diags, residue);
+        this->ProcessUnkResidue(diags, residue, neighbors);
         if (this->GetConnectAminoAcids()) 
           this->ConnectResidues(prev, residue);
         prev = residue;
@@ -84,7 +86,7 @@ void HeuristicProcessor::DoProcess(DiagnosticsPtr diags,
       for (mol::AtomHandleList::iterator 
           i = atoms.begin(), e = atoms.end(); i != e; ++i) {
         if (i->GetBondCount() == 0)
-          this->DistanceBasedConnect(*i);
+          this->DistanceBasedConnect(*i, neighbors);
       }
     }
     if (residues.empty() || !this->GetAssignTorsions()) {
@@ -48,7 +48,8 @@ public:
 
   virtual String ToString() const;
 protected:
-  void ProcessUnkResidue(DiagnosticsPtr diags, mol::ResidueHandle res) const;
+  void ProcessUnkResidue(DiagnosticsPtr diags, mol::ResidueHandle res,
+                         ChainNeighbors& neighbors) const;
   virtual void DoProcess(DiagnosticsPtr diags, 
                          mol::EntityHandle ent) const;
 private:
@@ -23,7 +23,10 @@
 #include <ost/mol/torsion_handle.hh>
 #include <ost/mol/impl/residue_impl.hh>
 #include <ost/mol/impl/atom_impl.hh>
+#include <ost/mol/impl/entity_impl.hh>
 #include <ost/mol/residue_handle.hh>
+#include <ost/mol/chain_handle.hh>
+#include <ost/mol/neighbor_search.hh>
 #include "processor.hh"
 
 namespace ost { namespace conop {
@@ -382,11 +385,11 @@ mol::AtomHandleList GetUnknownAtomsOfResidue(mol::ResidueHandle res,
   return unks;
 }
 
-void Processor::DistanceBasedConnect(mol::AtomHandle atom) const
+void Processor::DistanceBasedConnect(mol::AtomHandle atom,
+                                     ChainNeighbors& neighbors) const
 {
-  mol::EntityHandle ent=atom.GetEntity();
-  mol::XCSEditor editor=ent.EditXCS(mol::BUFFERED_EDIT);
-  mol::AtomHandleList alist = ent.FindWithin(atom.GetPos(),4.0);
+  mol::XCSEditor editor=atom.GetEntity().EditXCS(mol::BUFFERED_EDIT);
+  mol::AtomHandleList alist=neighbors.GetNeighbors(atom);
   mol::ResidueHandle res_a=atom.GetResidue();
   for (mol::AtomHandleList::const_iterator it=alist.begin(),
        e=alist.end();it!=e;++it) {
@@ -401,6 +404,51 @@ void Processor::DistanceBasedConnect(mol::AtomHandle atom) const
   }
 }
 
+void ChainNeighbors::Build()
+{
+  // bonds are only formed within a residue or between consecutive residues of
+  // the same chain, so the atoms of the chain are the only candidates.
+  atoms_=chain_.GetAtomList();
+  atom_count_=chain_.GetAtomCount();
+  coord_version_=chain_.GetEntity().Impl()->GetCoordVersion();
+  index_.clear();
+  neighbors_.assign(atoms_.size(), std::vector<size_t>());
+  geom::Vec3List pos;
+  pos.reserve(atoms_.size());
+  for (size_t i=0; i<atoms_.size(); ++i) {
+    index_[atoms_[i].GetHashCode()]=i;
+    pos.push_back(atoms_[i].GetPos());
+  }
+  mol::NeighborPairList pairs=mol::FindAllPairsWithin(pos, 4.0);
+  for (mol::NeighborPairList::const_iterator i=pairs.begin(),
+       e=pairs.end(); i!=e; ++i) {
+    neighbors_[i->first].push_back(i->second);
+    neighbors_[i->second].push_back(i->first);
+  }
+}
+
+mol::AtomHandleList ChainNeighbors::GetNeighbors(const mol::AtomHandle& atom)
+{
+  // atoms are only ever removed while processing, which changes the count.
+  // Moving atoms of the entity increments its coordinate version.
+  if (atom_count_!=chain_.GetAtomCount() ||
+      coord_version_!=chain_.GetEntity().Impl()->GetCoordVersion()) {
+    this->Build();
+  }
+  mol::AtomHandleList neighbors;
+  std::map<long, size_t>::const_iterator i=index_.find(atom.GetHashCode());
+  if (i==index_.end()) {
+    return neighbors;
+  }
+  neighbors.reserve(neighbors_[i->second].size()+1);
+  neighbors.push_back(atom);
+  for (std::vector<size_t>::const_iterator j=neighbors_[i->second].begin(),
+       e=neighbors_[i->second].end(); j!=e; ++j) {
+    neighbors.push_back(atoms_[*j]);
+  }
+  return neighbors;
+}
+
 String StringFromConopAction(ConopAction action) {
   switch (action) {
     case CONOP_FATAL:
@@ -19,6 +19,8 @@
 #ifndef OST_CONOP_PROCESSOR_HH
 #define OST_CONOP_PROCESSOR_HH
 
+#include <map>
+#include <vector>
 #include <ost/mol/entity_handle.hh>
 #include "module_config.hh"
 #include "diag.hh"
@@ -39,6 +41,31 @@ enum ConopAction {
   CONOP_FATAL
 };
 
+/// \brief neighbours of the atoms of a chain within the distance used for
+///     distance based connectivity
+///
+/// The neighbours of all atoms of the chain are determined with a single
+/// neighbour search the first time they are needed, and again after atoms have
+/// been removed from the chain or atoms of the entity have been moved.
+class DLLEXPORT_OST_CONOP ChainNeighbors {
+public:
+  ChainNeighbors(mol::ChainHandle chain): chain_(chain), atom_count_(-1),
+    coord_version_(0) { }
+
+  /// \brief atoms of the chain at most 4 A away from \p atom, including
+  ///     \p atom itself
+  mol::AtomHandleList GetNeighbors(const mol::AtomHandle& atom);
+private:
+  void Build();
+
+  mol::ChainHandle             chain_;
+  int                          atom_count_;
+  unsigned long                coord_version_;
+  mol::AtomHandleList          atoms_;
+  std::map<long, size_t>       index_;
+  std::vector<std::vector<size_t> > neighbors_;
+};
+
 class Processor;
 typedef boost::shared_ptr<Processor> ProcessorPtr;
 // the base class for all options
@@ -63,7 +90,11 @@ protected:
                              CompoundPtr compound, bool strict_hydrogens) const;
   void ConnectResidues(mol::ResidueHandle residue, mol::ResidueHandle next) const;
   static bool AreResiduesConsecutive(mol::ResidueHandle a, mol::ResidueHandle b);
-  void DistanceBasedConnect(mol::AtomHandle atom) const;
+  /// \brief connect \p atom to the atoms of the same or of a consecutive
+  ///     residue within bonding distance, taken from the neighbour lists of
+  ///     the chain
+  void DistanceBasedConnect(mol::AtomHandle atom,
+                            ChainNeighbors& neighbors) const;
   mol::AtomHandle LocateAtom(const mol::AtomHandleList&, int ordinal) const;
 public:
   Processor(bool bf, bool at, bool cn, bool aa, ConopAction zo): check_bond_feasibility_(bf),
@@ -41,6 +41,7 @@ void RuleBasedProcessor::DoProcess(DiagnosticsPtr diags,
     mol::ChainHandle& chain = *i;
     mol::ResidueHandleList residues = chain.GetResidueList();
     mol::ResidueHandle prev;
+    ChainNeighbors neighbors(chain);
     for (mol::ResidueHandleList::iterator 
          j = residues.begin(), e2 = residues.end(); j != e2; ++j) {
       mol::ResidueHandle residue = *j;
@@ -51,7 +52,7 @@ void RuleBasedProcessor::DoProcess(DiagnosticsPtr diags,
         this->ProcessUnkResidue(diags, residue, atoms_to_connect);
         for (mol::AtomHandleList::iterator k = atoms_to_connect.begin(),
              e3=atoms_to_connect.end(); k!= e3; ++k) {
-          this->DistanceBasedConnect(*k);
+          this->DistanceBasedConnect(*k, neighbors);
         }
         continue;
       }
@@ -76,7 +77,7 @@ void RuleBasedProcessor::DoProcess(DiagnosticsPtr diags,
           this->ConnectResidues(prev, residue);
         for (mol::AtomHandleList::iterator k = atoms_to_connect.begin(),
              e3=atoms_to_connect.end(); k!= e3; ++k) {
-          this->DistanceBasedConnect(*k);
+          this->DistanceBasedConnect(*k, neighbors);
         }
         if (!this->GetStrictHydrogens()) {
           mol::AtomHandleList atoms = residue.GetAtomList();
@@ -84,7 +85,7 @@ void RuleBasedProcessor::DoProcess(DiagnosticsPtr diags,
                e3 = atoms.end(); k != e3; ++k) {
             const String& ele = k->GetElement();
             if ((ele == "D" || ele == "H") && k->GetBondCount() == 0) {
-              this->DistanceBasedConnect(*k);
+              this->DistanceBasedConnect(*k, neighbors);
             }
           }
         }
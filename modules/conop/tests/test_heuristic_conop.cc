@@ -179,5 +179,53 @@ BOOST_AUTO_TEST_CASE(quack_types_unknown_residues) {
 
 }
 
+BOOST_AUTO_TEST_CASE(connects_unknown_residue_before_next_residue)
+{
+  // XZ is not part of GLY and is close to the atom of the preceding unknown
+  // residue and to CA and N. Being connected to the unknown residue first, it
+  // is not connected based on distance again.
+  mol::EntityHandle e = Builder()
+    .Chain("A")
+      .Residue("???")
+        .Atom("C1", geom::Vec3(0.0, 0.0, 0.0))
+      .Residue("GLY")
+        .Atom("N", geom::Vec3(3.0, 1.2, 0.0))
+        .Atom("CA", geom::Vec3(3.0, 0.0, 0.0))
+        .Atom("C", geom::Vec3(4.5, 0.0, 0.0))
+        .Atom("O", geom::Vec3(4.5, 1.2, 0.0))
+        .Atom("XZ", geom::Vec3(1.5, 0.0, 0.0))
+  ;
+  mol::AtomHandleList atoms = e.GetAtomList();
+  for (mol::AtomHandleList::iterator i = atoms.begin(); i != atoms.end(); ++i) {
+    i->SetRadius(1.7);
+  }
+  HeuristicProcessor proc;
+  proc.SetCheckBondFeasibility(true);
+  proc.Process(e);
+  mol::AtomHandle xz = e.FindAtom("A", 2, "XZ");
+  BOOST_CHECK(mol::BondExists(e.FindAtom("A", 1, "C1"), xz));
+  BOOST_CHECK_EQUAL(xz.GetBondCount(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(chain_neighbors_follow_moved_atoms)
+{
+  mol::EntityHandle e = Builder()
+    .Chain("A")
+      .Residue("GLY")
+        .Atom("N", geom::Vec3(0.0, 0.0, 0.0))
+        .Atom("CA", geom::Vec3(1.5, 0.0, 0.0))
+        .Atom("C", geom::Vec3(10.0, 0.0, 0.0))
+  ;
+  mol::AtomHandle n = e.FindAtom("A", 1, "N");
+  mol::AtomHandle c = e.FindAtom("A", 1, "C");
+  ChainNeighbors neighbors(e.FindChain("A"));
+  BOOST_CHECK_EQUAL(neighbors.GetNeighbors(n).size(), size_t(2));
+  BOOST_CHECK_EQUAL(neighbors.GetNeighbors(c).size(), size_t(1));
+  // the neighbour lists are rebuilt after moving C next to N
+  e.EditXCS().SetAtomPos(c, geom::Vec3(-1.5, 0.0, 0.0));
+  BOOST_CHECK_EQUAL(neighbors.GetNeighbors(n).size(), size_t(3));
+  BOOST_CHECK_EQUAL(neighbors.GetNeighbors(c).size(), size_t(3));
+}
+
 BOOST_AUTO_TEST_SUITE_END();
 
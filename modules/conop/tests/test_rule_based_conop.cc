@@ -211,4 +211,32 @@ BOOST_AUTO_TEST_CASE(rule_based_unk_res)
   BOOST_CHECK(!ent2.FindResidue("A", 1));
 }
 
+BOOST_AUTO_TEST_CASE(rule_based_connects_unknown_residue_first)
+{
+  CompoundLibPtr lib = load_lib();
+  if (!lib) { return; }
+  RuleBasedProcessor rbc(lib);
+  rbc.SetCheckBondFeasibility(true);
+  EntityHandle ent = CreateEntity();
+  XCSEditor edi=ent.EditXCS();
+  ChainHandle ch = edi.InsertChain("A");
+  ResidueHandle unk = edi.AppendResidue(ch, "???");
+  AtomHandle x = edi.InsertAtom(unk, "X", geom::Vec3(0,0,0), "C");
+  ResidueHandle gly = edi.AppendResidue(ch, "GLY");
+  edi.InsertAtom(gly, "N", geom::Vec3(3.0,1.2,0), "N");
+  edi.InsertAtom(gly, "CA", geom::Vec3(3.0,0,0), "C");
+  edi.InsertAtom(gly, "C", geom::Vec3(4.5,0,0), "C");
+  edi.InsertAtom(gly, "O", geom::Vec3(4.5,1.2,0), "O");
+  // the hydrogen is connected to the preceding unknown residue first and thus
+  // not connected to CA and N based on distance
+  AtomHandle h = edi.InsertAtom(gly, "HXX", geom::Vec3(1.5,0,0), "H");
+  AtomHandleList atoms = ent.GetAtomList();
+  for (AtomHandleList::iterator i = atoms.begin(); i != atoms.end(); ++i) {
+    i->SetRadius(1.7);
+  }
+  rbc.Process(ent);
+  BOOST_CHECK(BondExists(x, h));
+  BOOST_CHECK_EQUAL(h.GetBondCount(), 1);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
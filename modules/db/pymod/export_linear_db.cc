@@ -194,13 +194,15 @@ void export_linear_db() {
 
   class_<LinearCharacterContainer, 
          LinearCharacterContainerPtr>("LinearCharacterContainer", init<>())  
-    .def("Load", &LinearCharacterContainer::Load, arg("filename")).staticmethod("Load")
+    .def("Load", &LinearCharacterContainer::Load, (arg("filename"),
+                                    arg("memory_map")=false)).staticmethod("Load")
     .def("Save", &LinearCharacterContainer::Save, arg("filename"))
     .def("ClearRange", &WrapClearCharacterRange, arg("range"))
     .def("AddCharacters", &LinearCharacterContainer::AddCharacters, arg("characters"))
     .def("GetCharacter", &LinearCharacterContainer::GetCharacter, arg("idx"))
     .def("GetCharacters", &WrapGetCharacters, arg("range"))
     .def("GetNumElements", &LinearCharacterContainer::GetNumElements)
+    .def("IsMemoryMapped", &LinearCharacterContainer::IsMemoryMapped)
     .def("__eq__", &LinearCharacterContainer::operator==)
     .def("__ne__", &LinearCharacterContainer::operator!=)
   ;
@@ -208,13 +210,15 @@ void export_linear_db() {
 
   class_<LinearPositionContainer,
          LinearPositionContainerPtr>("LinearPositionContainer", init<>())
-    .def("Load", &LinearPositionContainer::Load, arg("filename")).staticmethod("Load")
+    .def("Load", &LinearPositionContainer::Load, (arg("filename"),
+                                    arg("memory_map")=false)).staticmethod("Load")
     .def("Save", &LinearPositionContainer::Save, arg("filename"))
     .def("ClearRange", &WrapClearPositionRange, arg("range"))
     .def("AddPositions", &LinearPositionContainer::AddPositions, arg("positions"))
     .def("GetPosition", &LinearPositionContainer::GetPosition, arg("idx"), arg("pos"))
     .def("GetPositions", &WrapGetPositions, (arg("range"),arg("positions")))
     .def("GetNumElements", &LinearPositionContainer::GetNumElements)
+    .def("IsMemoryMapped", &LinearPositionContainer::IsMemoryMapped)
     .def("__eq__", &LinearPositionContainer::operator==)
     .def("__ne__", &LinearPositionContainer::operator!=)
   ;
@@ -18,13 +18,87 @@
 //------------------------------------------------------------------------------
 
 
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 #include <ost/db/binary_container.hh>
 #include <ost/message.hh>
 
 
 namespace ost{ namespace db{
 
-LinearCharacterContainerPtr LinearCharacterContainer::Load(const String& fn) {
+namespace {
+
+// The files written by PagedArray::Write consist of the number of elements
+// followed by the raw data, which can directly be accessed when the file is
+// mapped into memory. The number of elements is checked against the file size
+// before the file is mapped.
+template <typename T>
+const T* MapContainerFile(const String& fn, MappedFilePtr& mapped_file,
+                          uint64_t& num_elements) {
+  std::ifstream in_stream(fn.c_str(), std::ios::binary);
+  if (!in_stream) {
+    throw ost::Error("Could not open " + fn);
+  }
+  in_stream.seekg(0, std::ios::end);
+  uint64_t file_size = static_cast<uint64_t>(in_stream.tellg());
+  in_stream.seekg(0, std::ios::beg);
+  if (!in_stream.read(reinterpret_cast<char*>(&num_elements),
+                      sizeof(uint64_t))) {
+    throw ost::Error("Corrupted container file " + fn);
+  }
+  in_stream.close();
+  // num_elements * sizeof(T) must not overflow
+  uint64_t data_size = file_size - sizeof(uint64_t);
+  if (num_elements > data_size / sizeof(T) ||
+      num_elements * sizeof(T) != data_size) {
+    throw ost::Error("Corrupted container file " + fn);
+  }
+  try {
+    mapped_file.reset(new boost::iostreams::mapped_file_source(fn));
+  } catch (std::exception&) {
+    throw ost::Error("Could not open " + fn);
+  }
+  if (static_cast<uint64_t>(mapped_file->size()) != file_size) {
+    throw ost::Error("Container file " + fn + " changed while loading");
+  }
+  return reinterpret_cast<const T*>(mapped_file->data() + sizeof(uint64_t));
+}
+
+// Writes the data of a memory mapped container to a temporary file, which is
+// then renamed. Writing directly would truncate the mapped file and crash
+// with SIGBUS if filename is the mapped file itself (or a link to it). The
+// mapping stays valid when the file is replaced.
+void SaveMappedFile(const String& filename, const MappedFilePtr& mapped_file) {
+  String tmp_filename = filename + ".tmp";
+  std::ofstream out_stream(tmp_filename.c_str(), std::ios::binary);
+  if (!out_stream) {
+    throw ost::Error("Could not open " + tmp_filename);
+  }
+  out_stream.write(mapped_file->data(), mapped_file->size());
+  out_stream.close();
+  if (!out_stream) {
+    std::remove(tmp_filename.c_str());
+    throw ost::Error("Could not write " + tmp_filename);
+  }
+  if (std::rename(tmp_filename.c_str(), filename.c_str()) != 0) {
+    std::remove(tmp_filename.c_str());
+    throw ost::Error("Could not replace " + filename);
+  }
+}
+
+}
+
+LinearCharacterContainerPtr LinearCharacterContainer::Load(const String& fn,
+                                                           bool memory_map) {
+
+  if (memory_map) {
+    LinearCharacterContainerPtr loaded_container(new LinearCharacterContainer);
+    loaded_container->mapped_data_ =
+      MapContainerFile<char>(fn, loaded_container->mapped_file_,
+                             loaded_container->num_elements_);
+    return loaded_container;
+  }
 
   std::ifstream in_stream(fn.c_str(), std::ios::binary);
   if (!in_stream) {
@@ -38,6 +112,11 @@ LinearCharacterContainerPtr LinearCharacterContainer::Load(const String& fn) {
 
 void LinearCharacterContainer::Save(const String& filename) const {
 
+  if (mapped_data_) {
+    SaveMappedFile(filename, mapped_file_);
+    return;
+  }
+
   std::ofstream out_stream(filename.c_str(), std::ios::binary);
   if (!out_stream) {
     throw ost::Error("Could not open " + filename);
@@ -47,6 +126,11 @@ void LinearCharacterContainer::Save(const String& filename) const {
 }
 
 void LinearCharacterContainer::AddCharacters(const String& characters) {
+
+  if (mapped_data_) {
+    throw ost::Error("Cannot modify memory mapped LinearCharacterContainer!");
+  }
+
   for(uint i = 0; i < characters.size(); ++i) {
     data_.push_back(characters[i]);
   }
@@ -55,6 +139,10 @@ void LinearCharacterContainer::AddCharacters(const String& characters) {
 
 void LinearCharacterContainer::ClearRange(std::pair<uint64_t, uint64_t> range) {
 
+  if (mapped_data_) {
+    throw ost::Error("Cannot modify memory mapped LinearCharacterContainer!");
+  }
+
   if(range.second <= range.first) {
     throw ost::Error("Cannot clear invalid range in "
                      "LinearCharacterContainer!");
@@ -69,6 +157,24 @@ void LinearCharacterContainer::ClearRange(std::pair<uint64_t, uint64_t> range) {
   num_elements_ = data_.size();
 }
 
+bool LinearCharacterContainer::operator==(
+                              const LinearCharacterContainer& other) const {
+
+  if (!mapped_data_ && !other.mapped_data_) {
+    return data_ == other.data_; // no check for num_elements_
+                                 // they are coupled anyway
+  }
+  if (num_elements_ != other.num_elements_) {
+    return false;
+  }
+  for(uint64_t i = 0; i < num_elements_; ++i) {
+    if (this->GetData(i) != other.GetData(i)) {
+      return false;
+    }
+  }
+  return true;
+}
+
 char LinearCharacterContainer::GetCharacter(uint64_t idx) const {
 
   if(idx >= num_elements_) {
@@ -76,7 +182,7 @@ char LinearCharacterContainer::GetCharacter(uint64_t idx) const {
                      "LinearCharacterContainer!");
   }
 
-  return data_[idx];
+  return this->GetData(idx);
 }
 
 void LinearCharacterContainer::GetCharacters(std::pair<uint64_t, uint64_t> range,
@@ -93,6 +199,10 @@ void LinearCharacterContainer::GetCharacters(std::pair<uint64_t, uint64_t> range
   }
 
   uint64_t size = range.second - range.first;
+  if (mapped_data_) {
+    s.assign(mapped_data_ + range.first, size);
+    return;
+  }
   s = String(size, '-');
   for(uint64_t i = 0; i < size; ++i) {
     s[i] = data_[range.first + i];
@@ -100,7 +210,16 @@ void LinearCharacterContainer::GetCharacters(std::pair<uint64_t, uint64_t> range
 }
 
 
-LinearPositionContainerPtr LinearPositionContainer::Load(const String& fn) {
+LinearPositionContainerPtr LinearPositionContainer::Load(const String& fn,
+                                                         bool memory_map) {
+
+  if (memory_map) {
+    LinearPositionContainerPtr loaded_container(new LinearPositionContainer);
+    loaded_container->mapped_data_ =
+      MapContainerFile<uint64_t>(fn, loaded_container->mapped_file_,
+                                 loaded_container->num_elements_);
+    return loaded_container;
+  }
 
   std::ifstream in_stream(fn.c_str(), std::ios::binary);
   if (!in_stream) {
@@ -114,6 +233,11 @@ LinearPositionContainerPtr LinearPositionContainer::Load(const String& fn) {
 
 void LinearPositionContainer::Save(const String& filename) const {
 
+  if (mapped_data_) {
+    SaveMappedFile(filename, mapped_file_);
+    return;
+  }
+
   std::ofstream out_stream(filename.c_str(), std::ios::binary);
   if (!out_stream) {
     throw ost::Error("Could not open " + filename);
@@ -125,6 +249,10 @@ void LinearPositionContainer::Save(const String& filename) const {
 
 void LinearPositionContainer::AddPositions(const geom::Vec3List& positions) {
 
+  if (mapped_data_) {
+    throw ost::Error("Cannot modify memory mapped LinearPositionContainer!");
+  }
+
   for(uint i = 0; i < positions.size(); ++i) {
 
     int64_t data = 0;
@@ -179,6 +307,10 @@ void LinearPositionContainer::AddPositions(const geom::Vec3List& positions) {
 
 void LinearPositionContainer::ClearRange(std::pair<uint64_t, uint64_t> range) {
 
+  if (mapped_data_) {
+    throw ost::Error("Cannot modify memory mapped LinearPositionContainer!");
+  }
+
   if(range.second <= range.first) {
     throw ost::Error("Cannot clear invalid range in "
                      "LinearPositionContainer!");
@@ -194,6 +326,24 @@ void LinearPositionContainer::ClearRange(std::pair<uint64_t, uint64_t> range) {
 }
 
 
+bool LinearPositionContainer::operator==(
+                              const LinearPositionContainer& other) const {
+
+  if (!mapped_data_ && !other.mapped_data_) {
+    return data_ == other.data_; // no check for num_elements_
+                                 // they are coupled anyway
+  }
+  if (num_elements_ != other.num_elements_) {
+    return false;
+  }
+  for(uint64_t i = 0; i < num_elements_; ++i) {
+    if (this->GetData(i) != other.GetData(i)) {
+      return false;
+    }
+  }
+  return true;
+}
+
 void LinearPositionContainer::GetPosition(uint64_t idx, geom::Vec3& pos) const {
 
   if(idx >= num_elements_) {
@@ -201,7 +351,7 @@ void LinearPositionContainer::GetPosition(uint64_t idx, geom::Vec3& pos) const {
                      "LinearPositionContainer!");
   }
 
-  int64_t data = data_[idx];
+  int64_t data = this->GetData(idx);
   Real factor = (data < 0) ? 0.1 : 0.01;
   pos[0] = factor * Real(static_cast<int>(((data & X_POS_MASK) >> X_POS_SHIFT)) - 
                          CUSTOM_INT_MAX);
@@ -23,6 +23,7 @@
 
 #include <vector>
 #include <boost/shared_ptr.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
 #include <ost/base.hh>
 #include <ost/stdint.hh>
 #include <ost/geom/vec3.hh>
@@ -36,15 +37,23 @@ class LinearCharacterContainer;
 class LinearPositionContainer;
 typedef boost::shared_ptr<LinearCharacterContainer> LinearCharacterContainerPtr;
 typedef boost::shared_ptr<LinearPositionContainer> LinearPositionContainerPtr;
+typedef boost::shared_ptr<boost::iostreams::mapped_file_source> MappedFilePtr;
 
 
 class LinearCharacterContainer {
 
 public:
 
-  LinearCharacterContainer(): num_elements_(0) { }
+  LinearCharacterContainer(): num_elements_(0), mapped_data_(NULL) { }
 
-  static LinearCharacterContainerPtr Load(const std::string& filename);
+  /// \brief load container from file
+  ///
+  /// If memory_map is true, the file is mapped into memory read-only instead
+  /// of being read. Loading is then instantaneous, the data is paged in on
+  /// first access and the pages are shared between all processes mapping the
+  /// same file. A memory mapped container cannot be modified.
+  static LinearCharacterContainerPtr Load(const std::string& filename,
+                                          bool memory_map=false);
 
   void Save(const std::string& filename) const;
 
@@ -58,10 +67,9 @@ public:
 
   uint64_t GetNumElements() const { return num_elements_; }
 
-  bool operator==(const LinearCharacterContainer& other) const {
-    return data_ == other.data_; // no check for num_elements_
-                                 // they are coupled anyway
-  }
+  bool IsMemoryMapped() const { return mapped_data_ != NULL; }
+
+  bool operator==(const LinearCharacterContainer& other) const;
 
   bool operator!=(const LinearCharacterContainer& other) const {
     return !(*this == other);
@@ -69,10 +77,17 @@ public:
 
 private:
 
+  char GetData(uint64_t idx) const {
+    return mapped_data_ ? mapped_data_[idx] : data_[idx];
+  }
+
   PagedArray<char, 1048576> data_;
   // we track number of entries manually for fast checking of indices
   // the .size() function of data_ is too slow
   uint64_t num_elements_;
+  // set if the container is memory mapped, data_ is empty in that case
+  MappedFilePtr mapped_file_;
+  const char* mapped_data_;
 };
 
 
@@ -82,9 +97,13 @@ class LinearPositionContainer {
 
 public:
 
-  LinearPositionContainer(): num_elements_(0) { }
+  LinearPositionContainer(): num_elements_(0), mapped_data_(NULL) { }
 
-  static LinearPositionContainerPtr Load(const std::string& filename);
+  /// \brief load container from file
+  ///
+  /// See LinearCharacterContainer::Load for the meaning of memory_map
+  static LinearPositionContainerPtr Load(const std::string& filename,
+                                         bool memory_map=false);
 
   void Save(const std::string& filename) const;
 
@@ -99,10 +118,9 @@ public:
 
   uint64_t GetNumElements() const { return num_elements_; }
 
-  bool operator==(const LinearPositionContainer& other) const {
-    return data_ == other.data_; // no check for num_elements_
-                                 // they are coupled anyway
-  }
+  bool IsMemoryMapped() const { return mapped_data_ != NULL; }
+
+  bool operator==(const LinearPositionContainer& other) const;
 
   bool operator!=(const LinearPositionContainer& other) const {
     return !(*this == other);
@@ -126,10 +144,17 @@ private:
   static const int CUSTOM_INT_MIN = -1048576;
   static const int CUSTOM_INT_MAX = 1048576;
 
+  uint64_t GetData(uint64_t idx) const {
+    return mapped_data_ ? mapped_data_[idx] : data_[idx];
+  }
+
   PagedArray<uint64_t, 1048576> data_;
   // we track number of entries manually for fast checking of indices
   // the .size() function of data_ is too slow
   uint64_t num_elements_;  
+  // set if the container is memory mapped, data_ is empty in that case
+  MappedFilePtr mapped_file_;
+  const uint64_t* mapped_data_;
 };
 
 
@@ -1,4 +1,4 @@
-import unittest,os
+import unittest,os,struct
 from ost.db import LinearIndexer
 from ost.db import LinearCharacterContainer
 from ost.db import LinearPositionContainer
@@ -157,6 +157,39 @@ class TestLinearDB(unittest.TestCase):
     loaded_container = LinearCharacterContainer.Load("test_character_container.dat")
     self.assertEqual(container, loaded_container)
 
+    # memory mapped containers give the same data but cannot be modified
+    mapped_container = LinearCharacterContainer.Load("test_character_container.dat",
+                                                     memory_map=True)
+    self.assertTrue(mapped_container.IsMemoryMapped())
+    self.assertFalse(loaded_container.IsMemoryMapped())
+    self.assertEqual(container, mapped_container)
+    self.assertEqual(mapped_container.GetNumElements(),
+                     container.GetNumElements())
+    for i in range(container.GetNumElements()):
+      self.assertEqual(full_expected_string[i], mapped_container.GetCharacter(i))
+    self.assertEqual(mapped_container.GetCharacters((2, 7)),
+                     container.GetCharacters((2, 7)))
+    self.assertRaises(Exception, mapped_container.AddCharacters, "A")
+    self.assertRaises(Exception, mapped_container.ClearRange, (0, 1))
+    mapped_container.Save("test_character_container_2.dat")
+    loaded_container = LinearCharacterContainer.Load("test_character_container_2.dat")
+    self.assertEqual(container, loaded_container)
+    # saving to the mapped file itself must neither crash nor change the data
+    mapped_container.Save("test_character_container.dat")
+    self.assertEqual(container, mapped_container)
+    loaded_container = LinearCharacterContainer.Load("test_character_container.dat")
+    self.assertEqual(container, loaded_container)
+    del mapped_container
+
+    # the number of elements in the header must match the file size
+    with open("test_character_container_2.dat", "r+b") as f:
+      f.write(struct.pack("<Q", 2**63))
+    self.assertRaises(Exception, LinearCharacterContainer.Load,
+                      "test_character_container_2.dat", memory_map=True)
+
+    if os.path.exists("test_character_container_2.dat"):
+        os.remove("test_character_container_2.dat")
+
     if os.path.exists("test_character_container.dat"):
         os.remove("test_character_container.dat")
 
@@ -271,6 +304,33 @@ class TestLinearDB(unittest.TestCase):
     loaded_container = LinearPositionContainer.Load("test_position_container.dat")
     self.assertEqual(container, loaded_container)
 
+    # memory mapped containers give the same data but cannot be modified
+    mapped_container = LinearPositionContainer.Load("test_position_container.dat",
+                                                    memory_map=True)
+    self.assertTrue(mapped_container.IsMemoryMapped())
+    self.assertEqual(container, mapped_container)
+    mapped_positions = geom.Vec3List()
+    mapped_container.GetPositions((0, container.GetNumElements()),
+                                  mapped_positions)
+    for i in range(len(pos_13_target_list)):
+      self.assertTrue(geom.Distance(mapped_positions[i],
+                                    pos_13_target_list[i]) < eps)
+    self.assertRaises(Exception, mapped_container.AddPositions, pos_1)
+    self.assertRaises(Exception, mapped_container.ClearRange, (0, 1))
+    mapped_container.Save("test_position_container.dat")
+    self.assertEqual(container, mapped_container)
+    loaded_container = LinearPositionContainer.Load("test_position_container.dat")
+    self.assertEqual(container, loaded_container)
+    del mapped_container
+
+    # a number of elements, whose size in bytes overflows to the file size
+    with open("test_position_container.dat", "r+b") as f:
+      n = struct.unpack("<Q", f.read(8))[0]
+      f.seek(0)
+      f.write(struct.pack("<Q", n + 2**61))
+    self.assertRaises(Exception, LinearPositionContainer.Load,
+                      "test_position_container.dat", memory_map=True)
+
     if os.path.exists("test_position_container.dat"):
         os.remove("test_position_container.dat")
 
@@ -30,6 +30,7 @@
 #include <ost/img/alg/cross_correlate.hh>
 #include <ost/img/alg/convolute.hh>
 #include <ost/img/alg/fft.hh>
+#include <ost/img/alg/fft_plan_cache.hh>
 #include <ost/img/alg/dft.hh>
 #include <ost/img/alg/fill.hh>
 #include <ost/img/alg/threshold.hh>
@@ -43,6 +44,8 @@
 #include <ost/img/alg/mask_image.hh>
 #include <ost/img/alg/smooth_mask_image.hh>
 #include <ost/img/alg/clip_min_max.hh>
+#include <ost/img/alg/local_correlation.hh>
+#include <ost/img/alg/local_normalize.hh>
 #include <ost/img/alg/local_sigma_threshold.hh>
 #include <ost/img/extent.hh>
 #include <ost/img/alg/transform.hh>
@@ -127,9 +130,22 @@ BOOST_PYTHON_MODULE(_ost_img_alg)
 
   class_<alg::Conj,bases<ConstModIPAlgorithm> >("Conj", init<>());
 
-  class_<alg::ExplicitConvolute,bases<ConstModOPAlgorithm> >("ExplicitConvolute", init<const ConstImageHandle&,optional<bool> >());
+  enum_<alg::ConvolutionMethod>("ConvolutionMethod")
+    .value("CONVOLUTION_AUTO", alg::CONVOLUTION_AUTO)
+    .value("CONVOLUTION_DIRECT", alg::CONVOLUTION_DIRECT)
+    .value("CONVOLUTION_FFT", alg::CONVOLUTION_FFT)
+    .export_values()
+  ;
 
-  class_<alg::ExplicitCorrelate,bases<ConstModOPAlgorithm> >("ExplicitCorrelate", init<const ConstImageHandle&>());
+  class_<alg::ExplicitConvolute,bases<ConstModOPAlgorithm> >("ExplicitConvolute", init<const ConstImageHandle&,optional<bool> >())
+    .def("SetMethod", &alg::ExplicitConvolute::SetMethod)
+    .def("GetMethod", &alg::ExplicitConvolute::GetMethod)
+  ;
+
+  class_<alg::ExplicitCorrelate,bases<ConstModOPAlgorithm> >("ExplicitCorrelate", init<const ConstImageHandle&,optional<bool> >())
+    .def("SetMethod", &alg::ExplicitCorrelate::SetMethod)
+    .def("GetMethod", &alg::ExplicitCorrelate::GetMethod)
+  ;
 
   class_<alg::CrossCorrelate,bases<ConstModIPAlgorithm> >("CrossCorrelate", init<const ConstImageHandle&>());
 
@@ -137,6 +153,26 @@ BOOST_PYTHON_MODULE(_ost_img_alg)
 
   class_<alg::FFT,bases<ConstModOPAlgorithm> >("FFT", init<>());
 
+  {
+    scope fft_plan_cache_scope=class_<alg::FFTPlanCache, boost::noncopyable>("FFTPlanCache", no_init)
+      .def("Instance", &alg::FFTPlanCache::Instance, return_value_policy<reference_existing_object>()).staticmethod("Instance")
+      .def("SetPlannerMode", &alg::FFTPlanCache::SetPlannerMode)
+      .def("GetPlannerMode", &alg::FFTPlanCache::GetPlannerMode)
+      .def("SetThreadCount", &alg::FFTPlanCache::SetThreadCount)
+      .def("GetThreadCount", &alg::FFTPlanCache::GetThreadCount)
+      .def("GetPlanCount", &alg::FFTPlanCache::GetPlanCount)
+      .def("Clear", &alg::FFTPlanCache::Clear)
+      .def("LoadWisdom", &alg::FFTPlanCache::LoadWisdom)
+      .def("SaveWisdom", &alg::FFTPlanCache::SaveWisdom)
+    ;
+    enum_<alg::FFTPlanCache::PlannerMode>("PlannerMode")
+      .value("ESTIMATE", alg::FFTPlanCache::ESTIMATE)
+      .value("MEASURE", alg::FFTPlanCache::MEASURE)
+      .value("PATIENT", alg::FFTPlanCache::PATIENT)
+      .export_values()
+    ;
+  }
+
   class_<alg::PowerSpectrum,bases<ConstModOPAlgorithm> >("PowerSpectrum",init<>());
 
   class_<alg::Fill,bases<ConstModIPAlgorithm> >("Fill", init<const Complex&>())
@@ -202,6 +238,14 @@ BOOST_PYTHON_MODULE(_ost_img_alg)
     ;
 
   class_<alg::LocalSigmaThreshold, bases<ConstModOPAlgorithm> >("LocalSigmaThreshold", init<int,Real>() );
+  class_<alg::LocalNormalize, bases<ConstModOPAlgorithm> >("LocalNormalize", init<optional<int> >() )
+    .def("GetSize",&alg::LocalNormalize::GetSize)
+    .def("SetSize",&alg::LocalNormalize::SetSize)
+  ;
+  class_<alg::LocalCorrelation, bases<ConstModOPAlgorithm> >("LocalCorrelation", init<const ConstImageHandle&,optional<int> >() )
+    .def("GetSize",&alg::LocalCorrelation::GetSize)
+    .def("SetSize",&alg::LocalCorrelation::SetSize)
+  ;
 
   export_Filter();
   export_Normalizer();
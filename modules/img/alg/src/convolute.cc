@@ -18,6 +18,8 @@
 // 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 //------------------------------------------------------------------------------
 
+#include <ost/message.hh>
+
 #include "convolute.hh"
 
 #include <ost/img/image_state/dispatch.hh>
@@ -31,17 +33,7 @@ template<typename T1, class D1, typename T2, class D2>
 struct fnc_expl_convolute_wrap_op {
   ImageStateBasePtr operator()(const ImageStateImpl<T1,D1>* lhs,
 			       const ImageStateImpl<T2,D2>* rhs) {
-    boost::shared_ptr<ImageStateImpl<T1,D1> > res = lhs->CloneState(false);
-
-    Extent ex1=lhs->GetExtent();
-    for(ExtentIterator it1(ex1);!it1.AtEnd(); ++it1) {
-      T1 val(0);
-      for(ExtentIterator it2(rhs->GetExtent());!it2.AtEnd();++it2) {
-	val+=lhs->Value(ex1.WrapAround(Point(it1)-Point(it2))) * Val2Val<T2,T1>(rhs->Value(it2));
-      }
-      res->Value(it1) = val;
-    }
-    return res;
+    return DirectConvolute(*lhs,*rhs,true,false);
   }
 };
 
@@ -50,37 +42,36 @@ template<typename T1, class D1, typename T2, class D2>
 struct fnc_expl_convolute_op {
   ImageStateBasePtr operator()(const ImageStateImpl<T1,D1>* lhs,
 			       const ImageStateImpl<T2,D2>* rhs) {
-    boost::shared_ptr<ImageStateImpl<T1,D1> > res = lhs->CloneState(false);
-
-    Extent ex1=lhs->GetExtent();
-    for(ExtentIterator it1(ex1);!it1.AtEnd(); ++it1) {
-      T1 val(0);
-      for(ExtentIterator it2(rhs->GetExtent());!it2.AtEnd();++it2) {
-	val+=lhs->GetCheckedValue(Point(it1)-Point(it2)) * Val2Val<T2,T1>(rhs->Value(it2));
-      }
-      res->Value(it1) = val;
-    }
-    return res;
+    return DirectConvolute(*lhs,*rhs,false,false);
   }
 };
 
 } // anon ns
 
 ExplicitConvoluteFnc::ExplicitConvoluteFnc():
-  ref_()
+  ref_(), wrap_(true), method_(CONVOLUTION_AUTO)
 {}
 
 ExplicitConvoluteFnc::ExplicitConvoluteFnc(const ConstImageHandle& ref, bool wrap):
-  ref_(ref.ImageStatePtr()), wrap_(wrap)
+  ref_(ref.ImageStatePtr()), wrap_(wrap), method_(CONVOLUTION_AUTO)
 {}
 
 ExplicitConvoluteFnc::ExplicitConvoluteFnc(const ImageStateBasePtr& ref, bool wrap):
-  ref_(ref), wrap_(wrap)
+  ref_(ref), wrap_(wrap), method_(CONVOLUTION_AUTO)
 {}
 
 template <typename V, class D>
 ImageStateBasePtr ExplicitConvoluteFnc::VisitState(const ImageStateImpl<V,D>& isi) const 
 {
+  const RealSpatialImageState* lhs=dynamic_cast<const RealSpatialImageState*>(&isi);
+  const RealSpatialImageState* rhs=dynamic_cast<const RealSpatialImageState*>(ref_.get());
+  if(method_==CONVOLUTION_FFT && !(lhs && rhs)) {
+    throw Error("FFT convolution requires real spatial images");
+  }
+  if(lhs && rhs && (method_==CONVOLUTION_FFT || (method_==CONVOLUTION_AUTO &&
+     PreferFFTConvolute(lhs->GetExtent(),rhs->GetExtent())))) {
+    return FFTConvolute(*lhs,*rhs,wrap_,false);
+  }
   if(wrap_) {
     image_state::dispatch::binary_dispatch_op<fnc_expl_convolute_wrap_op> cnv;
     return cnv(&isi,ref_.get());
@@ -23,6 +23,8 @@
 
 #include <ost/img/image_state.hh>
 #include <ost/img/alg/module_config.hh>
+#include "fft_convolute.hh"
+
 namespace ost { namespace img { namespace alg {
 
 class DLLEXPORT_IMG_ALG ExplicitConvoluteFnc {
@@ -38,9 +40,17 @@ public:
 
   String GetAlgorithmName() {return "Convolute";}
 
+  /// \brief select the direct sum or the FFT based convolution
+  ///
+  /// CONVOLUTION_AUTO (the default) uses the FFT for real spatial images and
+  /// kernels if it is expected to be faster, see PreferFFTConvolute.
+  void SetMethod(ConvolutionMethod method) {method_=method;}
+  ConvolutionMethod GetMethod() const {return method_;}
+
 private:
   ImageStateBasePtr ref_;
   bool wrap_;
+  ConvolutionMethod method_;
 };
 
 typedef ImageStateConstModOPAlgorithm<ExplicitConvoluteFnc> ExplicitConvolute;
@@ -18,6 +18,8 @@
 // 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 //------------------------------------------------------------------------------
 
+#include <ost/message.hh>
+
 #include "correlate.hh"
 
 #include <ost/img/image_state/dispatch.hh>
@@ -26,31 +28,12 @@ namespace ost { namespace img { namespace alg {
 
 namespace {
 
-template <typename X>
-X Conj(const X& x);
-
-template<>
-Complex Conj(const Complex& x) {return std::conj(x);}
-
-template <typename X>
-X Conj(const X& x) {return x;}
-
 // explicit correlation with wrap around
 template<typename T1, class D1, typename T2, class D2>
 struct fnc_expl_correlate_wrap_op {
   ImageStateBasePtr operator()(const ImageStateImpl<T1,D1>* lhs,
 			       const ImageStateImpl<T2,D2>* rhs) {
-    boost::shared_ptr<ImageStateImpl<T1,D1> > res = lhs->CloneState(false);
-
-    Extent ex1=lhs->GetExtent();
-    for(ExtentIterator it1(ex1);!it1.AtEnd(); ++it1) {
-      T1 val(0); // default ctor sets value to zero
-      for(ExtentIterator it2(rhs->GetExtent());!it2.AtEnd();++it2) {
-	val+=lhs->Value(ex1.WrapAround(Point(it1)+Point(it2))) * Val2Val<T2,T1>(Conj(rhs->Value(it2)));
-      }
-      res->Value(it1) = val;
-    }
-    return res;
+    return DirectConvolute(*lhs,*rhs,true,true);
   }
 };
 
@@ -59,23 +42,32 @@ template<typename T1, class D1, typename T2, class D2>
 struct fnc_expl_correlate_op {
   ImageStateBasePtr operator()(const ImageStateImpl<T1,D1>* lhs,
 			       const ImageStateImpl<T2,D2>* rhs) {
-    throw("non wrap-around correlate not yet implemented");
+    return DirectConvolute(*lhs,*rhs,false,true);
   }
 };
 
 } // anon ns
 
 ExplicitCorrelateFnc::ExplicitCorrelateFnc():
-  ref_()
+  ref_(), wrap_(true), method_(CONVOLUTION_AUTO)
 {}
 
 ExplicitCorrelateFnc::ExplicitCorrelateFnc(const ConstImageHandle& ref, bool wrap):
-  ref_(ref), wrap_(wrap)
+  ref_(ref), wrap_(wrap), method_(CONVOLUTION_AUTO)
 {}
 
 template <typename V, class D>
 ImageStateBasePtr ExplicitCorrelateFnc::VisitState(const ImageStateImpl<V,D>& isi) const 
 {
+  const RealSpatialImageState* lhs=dynamic_cast<const RealSpatialImageState*>(&isi);
+  const RealSpatialImageState* rhs=dynamic_cast<const RealSpatialImageState*>(ref_.ImageStatePtr().get());
+  if(method_==CONVOLUTION_FFT && !(lhs && rhs)) {
+    throw Error("FFT correlation requires real spatial images");
+  }
+  if(lhs && rhs && (method_==CONVOLUTION_FFT || (method_==CONVOLUTION_AUTO &&
+     PreferFFTConvolute(lhs->GetExtent(),rhs->GetExtent())))) {
+    return FFTConvolute(*lhs,*rhs,wrap_,true);
+  }
   if(wrap_) {
     image_state::dispatch::binary_dispatch_op<fnc_expl_correlate_wrap_op> cnv;
     return cnv(&isi,ref_.ImageStatePtr().get());
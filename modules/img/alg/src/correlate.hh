@@ -23,6 +23,7 @@
 
 #include <ost/img/image_state.hh>
 #include <ost/img/alg/module_config.hh>
+#include "fft_convolute.hh"
 
 namespace ost { namespace img { namespace alg {
 
@@ -36,9 +37,15 @@ public:
 
   String GetAlgorithmName() {return "Correlate";}
 
+  /// \brief select the direct sum or the FFT based correlation, see
+  ///     ExplicitConvoluteFnc::SetMethod
+  void SetMethod(ConvolutionMethod method) {method_=method;}
+  ConvolutionMethod GetMethod() const {return method_;}
+
 private:
   ConstImageHandle ref_;
   bool wrap_;
+  ConvolutionMethod method_;
 };
 
 typedef ImageStateConstModOPAlgorithm<ExplicitCorrelateFnc> ExplicitCorrelate;
@@ -24,18 +24,11 @@
 
 #include <boost/shared_ptr.hpp>
 
-#include <fftw3.h>
-#if OST_INFO_ENABLED
-#include <QThread>
-#define IDEAL_NUMBER_OF_THREADS() QThread::idealThreadCount()
-#else
-#define IDEAL_NUMBER_OF_THREADS() 1
-#endif
 #include <ost/message.hh>
 #include <ost/img/value_util.hh>
 #include <ost/img/image_state/image_state_def.hh>
 #include "fft.hh"
-#include <ost/img/alg/fftw_helper.hh>
+#include "fft_plan_cache.hh"
 
 
 namespace ost { namespace img { namespace alg {
@@ -59,18 +52,17 @@ int half_plus_one(int n) {
 
 } // anon ns
 
+// FFTW is initialised and cleaned up by the plan cache. Cleaning up here
+// would invalidate the cached plans.
 FFTFnc::FFTFnc(): ori_flag_(false)
 {
-  OST_FFTW_fftw_init_threads();
 }
 FFTFnc::FFTFnc(bool f): ori_flag_(f)
 {
-  OST_FFTW_fftw_init_threads();
 }
 
 FFTFnc::~FFTFnc()
 {
-  OST_FFTW_fftw_cleanup();
 }
 
 // real spatial -> complex half-frequency
@@ -93,13 +85,9 @@ ImageStateBasePtr FFTFnc::VisitState<Real,SpatialDomain>(const RealSpatialImageS
   out_state->SetSpatialOrigin(in_state.GetSpatialOrigin());
   out_state->SetAbsoluteOrigin(in_state.GetAbsoluteOrigin());
 
-  assert(sizeof(OST_FFTW_fftw_complex)==sizeof(Complex));
-  OST_FFTW_fftw_complex* fftw_out = reinterpret_cast<OST_FFTW_fftw_complex*>(out_state->Data().GetData());
+  Complex* fftw_out = out_state->Data().GetData();
   Real* fftw_in = const_cast<Real*>(in_state.Data().GetData());
-  OST_FFTW_fftw_plan_with_nthreads(std::max<int>(1,IDEAL_NUMBER_OF_THREADS()));
-  OST_FFTW_fftw_plan plan = OST_FFTW_fftw_plan_dft_r2c(rank,n,fftw_in,fftw_out,FFTW_ESTIMATE|FFTW_PRESERVE_INPUT);
-  OST_FFTW_fftw_execute(plan);
-  OST_FFTW_fftw_destroy_plan(plan);
+  FFTPlanCache::Instance().Execute(FFTPlanCache::REAL_TO_COMPLEX,rank,n,fftw_in,fftw_out);
 
   if(ori_flag_) out_state->AdjustPhaseOrigin(in_state.GetSpatialOrigin());
 
@@ -159,18 +147,9 @@ ImageStateBasePtr FFTFnc::VisitState<Complex,HalfFrequencyDomain>(const ComplexH
   out_state->SetAbsoluteOrigin(in_state.GetAbsoluteOrigin());
 
 
-  Real* out_ptr = out_state->Data().GetData();
-  Real* fftw_out = reinterpret_cast<Real*>(out_ptr);
-  
-  assert(sizeof(OST_FFTW_fftw_complex)==sizeof(Complex));
-  OST_FFTW_fftw_plan_with_nthreads(std::max<int>(1,IDEAL_NUMBER_OF_THREADS()));
-  Complex* in_ptr = tmp_state.Data().GetData();
-  OST_FFTW_fftw_complex* fftw_in =reinterpret_cast<OST_FFTW_fftw_complex*>(in_ptr);
-
-  OST_FFTW_fftw_plan plan = OST_FFTW_fftw_plan_dft_c2r(rank,n,fftw_in,fftw_out,FFTW_ESTIMATE | FFTW_DESTROY_INPUT);
-
-  OST_FFTW_fftw_execute(plan);
-  OST_FFTW_fftw_destroy_plan(plan);
+  Real* fftw_out = out_state->Data().GetData();
+  Complex* fftw_in = tmp_state.Data().GetData();
+  FFTPlanCache::Instance().Execute(FFTPlanCache::COMPLEX_TO_REAL,rank,n,fftw_in,fftw_out);
 
 
   Real fac = 1.0/static_cast<Real>(out_state->GetSize().GetVolume());
@@ -186,26 +165,20 @@ ImageStateBasePtr FFTFnc::VisitState<Complex,HalfFrequencyDomain>(const ComplexH
 template <>
 ImageStateBasePtr FFTFnc::VisitState<Complex,SpatialDomain>(const ComplexSpatialImageState& in_state) const
 {
-  assert(sizeof(OST_FFTW_fftw_complex)==sizeof(Complex));
-
   Size size=in_state.GetExtent().GetSize();
   PixelSampling ps=in_state.GetSampling();
   ps.SetDomain(FREQUENCY);
   int rank = size.GetDim();
   int n[3] = {static_cast<int>(size[0]),static_cast<int>(size[1]),static_cast<int>(size[2])};
-  int dir = FFTW_FORWARD;
-  OST_FFTW_fftw_complex* fftw_in = const_cast<OST_FFTW_fftw_complex*>(reinterpret_cast<const OST_FFTW_fftw_complex*>(in_state.Data().GetData()));
+  Complex* fftw_in = const_cast<Complex*>(in_state.Data().GetData());
 
   boost::shared_ptr<ComplexFrequencyImageState> out_state(new ComplexFrequencyImageState(size,ps));
   out_state->SetSpatialOrigin(in_state.GetSpatialOrigin());
   out_state->SetAbsoluteOrigin(in_state.GetAbsoluteOrigin());
-  OST_FFTW_fftw_complex* fftw_out = reinterpret_cast<OST_FFTW_fftw_complex*>(out_state->Data().GetData());
+  Complex* fftw_out = out_state->Data().GetData();
 
   // out of place transform
-  OST_FFTW_fftw_plan_with_nthreads(std::max<int>(1,IDEAL_NUMBER_OF_THREADS()));
-  OST_FFTW_fftw_plan plan = OST_FFTW_fftw_plan_dft(rank,n,fftw_in, fftw_out,dir,FFTW_ESTIMATE | FFTW_PRESERVE_INPUT);
-  OST_FFTW_fftw_execute(plan);
-  OST_FFTW_fftw_destroy_plan(plan);
+  FFTPlanCache::Instance().Execute(FFTPlanCache::COMPLEX_FORWARD,rank,n,fftw_in,fftw_out);
 
   if(ori_flag_) out_state->AdjustPhaseOrigin(in_state.GetSpatialOrigin());
 
@@ -216,38 +189,29 @@ ImageStateBasePtr FFTFnc::VisitState<Complex,SpatialDomain>(const ComplexSpatial
 template <>
 ImageStateBasePtr FFTFnc::VisitState<Complex,FrequencyDomain>(const ComplexFrequencyImageState& in_state) const
 {
-  assert(sizeof(OST_FFTW_fftw_complex)==sizeof(Complex));
-
   Size size=in_state.GetExtent().GetSize();
   PixelSampling ps=in_state.GetSampling();
   ps.SetDomain(SPATIAL);
   int rank = size.GetDim();
   int n[3] = {static_cast<int>(size[0]),static_cast<int>(size[1]),static_cast<int>(size[2])};
-  int dir = FFTW_BACKWARD;
 
   boost::shared_ptr<ComplexSpatialImageState> out_state(new ComplexSpatialImageState(size,ps));
   out_state->SetSpatialOrigin(in_state.GetSpatialOrigin());
   out_state->SetAbsoluteOrigin(in_state.GetAbsoluteOrigin());
-  OST_FFTW_fftw_complex* fftw_out = reinterpret_cast<OST_FFTW_fftw_complex*>(out_state->Data().GetData());
+  Complex* fftw_out = out_state->Data().GetData();
 
   if(ori_flag_){
     // copy in state
     ComplexFrequencyImageState tmp_state(in_state);
     tmp_state.AdjustPhaseOrigin(-in_state.GetSpatialOrigin());
-    OST_FFTW_fftw_complex* fftw_in = reinterpret_cast<OST_FFTW_fftw_complex*>(tmp_state.Data().GetData());
+    Complex* fftw_in = tmp_state.Data().GetData();
     // out of place transform
-    OST_FFTW_fftw_plan_with_nthreads(std::max<int>(1,IDEAL_NUMBER_OF_THREADS()));
-    OST_FFTW_fftw_plan plan = OST_FFTW_fftw_plan_dft(rank,n, fftw_in, fftw_out,dir,FFTW_ESTIMATE | FFTW_PRESERVE_INPUT);
-    OST_FFTW_fftw_execute(plan);
-    OST_FFTW_fftw_destroy_plan(plan);
+    FFTPlanCache::Instance().Execute(FFTPlanCache::COMPLEX_BACKWARD,rank,n,fftw_in,fftw_out);
   }else{
     // use in state
-    OST_FFTW_fftw_complex* fftw_in = const_cast<OST_FFTW_fftw_complex*>(reinterpret_cast<const OST_FFTW_fftw_complex*>(in_state.Data().GetData()));
+    Complex* fftw_in = const_cast<Complex*>(in_state.Data().GetData());
     // out of place transform
-    OST_FFTW_fftw_plan_with_nthreads(std::max<int>(1,IDEAL_NUMBER_OF_THREADS()));
-    OST_FFTW_fftw_plan plan = OST_FFTW_fftw_plan_dft(rank,n, fftw_in, fftw_out,dir,FFTW_ESTIMATE | FFTW_PRESERVE_INPUT);
-    OST_FFTW_fftw_execute(plan);
-    OST_FFTW_fftw_destroy_plan(plan);
+    FFTPlanCache::Instance().Execute(FFTPlanCache::COMPLEX_BACKWARD,rank,n,fftw_in,fftw_out);
   }
 
   Real fac = 1.0/static_cast<Real>(size.GetVolume());
@@ -0,0 +1,226 @@
+//------------------------------------------------------------------------------
+// This file is part of the OpenStructure project <www.openstructure.org>
+//
+// Copyright (C) 2008-2020 by the OpenStructure authors
+// Copyright (C) 2003-2010 by the IPLT authors
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 3.0 of the License, or (at your option)
+// any later version.
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//------------------------------------------------------------------------------
+#include <cmath>
+
+#include "fft_convolute.hh"
+#include "fft_plan_cache.hh"
+
+namespace ost { namespace img { namespace alg {
+
+namespace {
+
+// Costs relative to one term of the direct sum: TRANSFORM_COST per n*log2(n)
+// of a real-to-complex or complex-to-real transform of n points, POINT_COST
+// per point of a tile for padding, multiplying and copying. bench_convolute
+// shows the actual timings of both methods on a given machine.
+const double TRANSFORM_COST=0.5;
+const double POINT_COST=2.0;
+
+// smallest size not smaller than n with only 2, 3, 5 and 7 as prime factors,
+// for which FFTW is fast
+int good_fft_size(int n)
+{
+  static const int factors[]={2,3,5,7};
+  for(int m=std::max(n,1);;++m) {
+    int r=m;
+    for(int i=0;i<4;++i) {
+      while(r%factors[i]==0) {
+        r/=factors[i];
+      }
+    }
+    if(r==1) {
+      return m;
+    }
+  }
+}
+
+// Sizes of the padded transforms. With the kernel offsets running from lo to
+// hi, the output points i of a tile need the image points i-hi to i-lo,
+// which are stored in the image buffer starting at index 0. The kernel value
+// of offset o goes to index o-lo of the kernel buffer, so that output point i
+// ends up at index i+hi-lo of the (linear) convolution of the buffers.
+struct TilePlan {
+  TilePlan(const Extent& image, const Point& lo, const Point& hi,
+           size_t max_tile_volume)
+  {
+    Size size=image.GetSize();
+    for(int i=0;i<3;++i) {
+      n[i]=size[i];
+      span[i]=hi[i]-lo[i]+1;
+      tile[i]=n[i];
+      p[i]=good_fft_size(n[i]+span[i]-1);
+    }
+    // split along the first axis, but not into slabs thinner than the kernel
+    size_t plane=size_t(p[1])*p[2];
+    if(size_t(p[0])*plane>max_tile_volume) {
+      int rows=static_cast<int>(max_tile_volume/plane)-span[0]+1;
+      tile[0]=std::min(n[0],std::max(rows,span[0]));
+      p[0]=good_fft_size(tile[0]+span[0]-1);
+    }
+    tile_count=(n[0]+tile[0]-1)/tile[0];
+    rank=3;
+    while(rank>1 && p[rank-1]==1) {
+      --rank;
+    }
+  }
+
+  size_t GetVolume() const
+  {
+    return size_t(p[0])*p[1]*p[2];
+  }
+
+  // number of complex values of the half complex transform
+  size_t GetComplexVolume() const
+  {
+    size_t vol=1;
+    for(int i=0;i<rank-1;++i) {
+      vol*=p[i];
+    }
+    return vol*(p[rank-1]/2+1);
+  }
+
+  int n[3];
+  int span[3];
+  int tile[3];
+  int p[3];
+  int tile_count;
+  int rank;
+};
+
+double fft_cost(const TilePlan& plan)
+{
+  double vol=plan.GetVolume();
+  // one forward and one backward transform per tile, plus the kernel
+  return (2*plan.tile_count+1)*vol*(TRANSFORM_COST*std::log(vol)/std::log(2.0)+
+                                    POINT_COST);
+}
+
+void kernel_offsets(const Extent& kernel, bool correlate, Point& lo, Point& hi)
+{
+  if(correlate) {
+    lo=-kernel.GetEnd();
+    hi=-kernel.GetStart();
+  } else {
+    lo=kernel.GetStart();
+    hi=kernel.GetEnd();
+  }
+}
+
+} // anon ns
+
+bool PreferFFTConvolute(const Extent& image, const Extent& kernel,
+                        size_t max_tile_volume)
+{
+  Point lo, hi;
+  kernel_offsets(kernel,false,lo,hi);
+  TilePlan plan(image,lo,hi,max_tile_volume);
+  double direct_cost=double(image.GetVolume())*kernel.GetVolume();
+  return direct_cost>fft_cost(plan);
+}
+
+ImageStateBasePtr FFTConvolute(const RealSpatialImageState& image,
+                               const RealSpatialImageState& kernel,
+                               bool wrap, bool correlate,
+                               size_t max_tile_volume)
+{
+  Point lo, hi;
+  kernel_offsets(kernel.GetExtent(),correlate,lo,hi);
+  TilePlan plan(image.GetExtent(),lo,hi,max_tile_volume);
+  const int* p=plan.p;
+  const int* n=plan.n;
+  const int* span=plan.span;
+  size_t vol=plan.GetVolume();
+  size_t cvol=plan.GetComplexVolume();
+
+  // transform of the kernel, which is shared by all tiles
+  std::vector<Real> buffer(vol,0.0);
+  for(ExtentIterator it(kernel.GetExtent());!it.AtEnd();++it) {
+    Point o(it);
+    Real v=kernel.Value(o);
+    if(correlate) {
+      o=-o;
+    }
+    o-=lo;
+    buffer[(size_t(o[0])*p[1]+o[1])*p[2]+o[2]]=v;
+  }
+  std::vector<Complex> kernel_ft(cvol);
+  FFTPlanCache& cache=FFTPlanCache::Instance();
+  cache.Execute(FFTPlanCache::REAL_TO_COMPLEX,plan.rank,p,&buffer[0],
+                &kernel_ft[0]);
+  // the normalization of the backward transform goes into the kernel
+  Real fac=1.0/static_cast<Real>(vol);
+  for(size_t i=0;i<cvol;++i) {
+    kernel_ft[i]*=fac;
+  }
+
+  // image coordinates along the axes of the buffer, the first one shifted by
+  // the start of the tile
+  std::vector<int> src0=detail::source_coords(n[0],lo[0],hi[0],wrap);
+  std::vector<int> src1=detail::source_coords(n[1],lo[1],hi[1],wrap);
+  std::vector<int> src2=detail::source_coords(n[2],lo[2],hi[2],wrap);
+
+  boost::shared_ptr<RealSpatialImageState> res=image.CloneState(false);
+  const Real* in=image.Data().GetData();
+  Real* out=res->Data().GetData();
+  std::vector<Complex> image_ft(cvol);
+  for(int t=0;t<plan.tile_count;++t) {
+    int start=t*plan.tile[0];
+    int rows=std::min(plan.tile[0],n[0]-start);
+    std::fill(buffer.begin(),buffer.end(),0.0);
+    for(int u=0;u<rows+span[0]-1;++u) {
+      int a=src0[start+u];
+      if(a<0) {
+        continue;
+      }
+      for(int v=0;v<n[1]+span[1]-1;++v) {
+        int b=src1[v];
+        if(b<0) {
+          continue;
+        }
+        const Real* src=in+(size_t(a)*n[1]+b)*n[2];
+        Real* dst=&buffer[(size_t(u)*p[1]+v)*p[2]];
+        for(int w=0;w<n[2]+span[2]-1;++w) {
+          int c=src2[w];
+          if(c>=0) {
+            dst[w]=src[c];
+          }
+        }
+      }
+    }
+    cache.Execute(FFTPlanCache::REAL_TO_COMPLEX,plan.rank,p,&buffer[0],
+                  &image_ft[0]);
+    for(size_t i=0;i<cvol;++i) {
+      image_ft[i]*=kernel_ft[i];
+    }
+    cache.Execute(FFTPlanCache::COMPLEX_TO_REAL,plan.rank,p,&image_ft[0],
+                  &buffer[0]);
+    for(int u=0;u<rows;++u) {
+      for(int v=0;v<n[1];++v) {
+        const Real* src=&buffer[(size_t(u+span[0]-1)*p[1]+v+span[1]-1)*p[2]+
+                                span[2]-1];
+        Real* dst=out+(size_t(start+u)*n[1]+v)*n[2];
+        std::copy(src,src+n[2],dst);
+      }
+    }
+  }
+  return res;
+}
+
+}}} // ns
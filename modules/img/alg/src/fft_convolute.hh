@@ -0,0 +1,226 @@
+//------------------------------------------------------------------------------
+// This file is part of the OpenStructure project <www.openstructure.org>
+//
+// Copyright (C) 2008-2020 by the OpenStructure authors
+// Copyright (C) 2003-2010 by the IPLT authors
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 3.0 of the License, or (at your option)
+// any later version.
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//------------------------------------------------------------------------------
+
+#ifndef IMG_ALG_FFT_CONVOLUTE_HH
+#define IMG_ALG_FFT_CONVOLUTE_HH
+
+#include <algorithm>
+#include <vector>
+#include <ost/img/image_state.hh>
+#include <ost/img/value_util.hh>
+#include <ost/img/alg/module_config.hh>
+
+namespace ost { namespace img { namespace alg {
+
+/*
+  Convolution and correlation of an image with a kernel, shared by
+  ExplicitConvolute and ExplicitCorrelate.
+
+  The direct sum needs one multiplication per image point and kernel point.
+  The FFT based version multiplies the transforms of the image and the kernel,
+  both padded to avoid aliasing, and its cost only depends on the padded size.
+  It is used for real spatial images and kernels if it is expected to be
+  faster, which is the case for all but the smallest kernels.
+*/
+
+typedef enum {
+  CONVOLUTION_AUTO,
+  CONVOLUTION_DIRECT,
+  CONVOLUTION_FFT
+} ConvolutionMethod;
+
+namespace detail {
+
+template <typename T>
+T ConjValue(const T& x) {return x;}
+
+inline Complex ConjValue(const Complex& x) {return std::conj(x);}
+
+// source coordinate along one axis of the image for the relative
+// coordinates -max_offset to size-1-min_offset, -1 for coordinates outside
+// of the image if wrap is false
+inline std::vector<int> source_coords(int size, int min_offset, int max_offset,
+                                      bool wrap)
+{
+  std::vector<int> coords(size+max_offset-min_offset);
+  for(size_t i=0;i<coords.size();++i) {
+    int c=static_cast<int>(i)-max_offset;
+    if(wrap) {
+      coords[i]=(c%size+size)%size;
+    } else {
+      coords[i]=(c<0 || c>=size) ? -1 : c;
+    }
+  }
+  return coords;
+}
+
+// Offsets into the image and values of the kernel points, such that the
+// result is res(p)=sum_k image(p-offsets[k])*values[k]
+template <typename T1, typename T2, class D2>
+void kernel_terms(const ImageStateImpl<T2,D2>& kernel, bool correlate,
+                  std::vector<Point>& offsets, std::vector<T1>& values,
+                  Point& min_offset, Point& max_offset)
+{
+  for(ExtentIterator it(kernel.GetExtent());!it.AtEnd();++it) {
+    Point q(it);
+    T2 v=kernel.Value(q);
+    if(correlate) {
+      q=-q;
+      v=ConjValue(v);
+    }
+    if(offsets.empty()) {
+      min_offset=q;
+      max_offset=q;
+    }
+    for(int i=0;i<3;++i) {
+      min_offset[i]=std::min(min_offset[i],q[i]);
+      max_offset[i]=std::max(max_offset[i],q[i]);
+    }
+    offsets.push_back(q);
+    values.push_back(Val2Val<T2,T1>(v));
+  }
+}
+
+// dst[w]+=src[w-offset]*val for a row of n values
+template <typename T>
+void add_row(T* dst, const T* src, int n, int offset, bool wrap, const T& val)
+{
+  int lo=std::max(0,offset);
+  int hi=std::min(n,n+offset);
+  for(int w=lo;w<hi;++w) {
+    dst[w]+=src[w-offset]*val;
+  }
+  if(wrap) {
+    // the part of the row that comes from the other end of the image
+    for(int w=0;w<lo;++w) {
+      dst[w]+=src[w-offset+n]*val;
+    }
+    for(int w=hi;w<n;++w) {
+      dst[w]+=src[w-offset-n]*val;
+    }
+  }
+}
+
+} // ns detail
+
+/// \brief direct sum for the convolution or correlation of an image with a
+///     kernel
+///
+/// The convolution is res(p)=sum_q image(p-q)*kernel(q), the correlation
+/// res(p)=sum_q image(p+q)*conj(kernel(q)), with q running over the extent of
+/// the kernel. Points outside of the image are wrapped around into the image
+/// or taken as zero.
+template <typename T1, class D1, typename T2, class D2>
+ImageStateBasePtr DirectConvolute(const ImageStateImpl<T1,D1>& image,
+                                  const ImageStateImpl<T2,D2>& kernel,
+                                  bool wrap, bool correlate)
+{
+  boost::shared_ptr<ImageStateImpl<T1,D1> > res=image.CloneState(false);
+  std::vector<Point> offsets;
+  std::vector<T1> values;
+  Point min_offset, max_offset;
+  detail::kernel_terms(kernel,correlate,offsets,values,min_offset,max_offset);
+
+  Extent ex=image.GetExtent();
+  Point start=ex.GetStart();
+  Size size=ex.GetSize();
+  std::vector<int> coords[3];
+  for(int i=0;i<3;++i) {
+    coords[i]=detail::source_coords(size[i],min_offset[i],max_offset[i],wrap);
+  }
+  for(ExtentIterator it(ex);!it.AtEnd();++it) {
+    Point p=Point(it)-start+max_offset;
+    T1 val(0);
+    for(size_t k=0;k<offsets.size();++k) {
+      Point o=p-offsets[k];
+      int a=coords[0][o[0]], b=coords[1][o[1]], c=coords[2][o[2]];
+      if(a>=0 && b>=0 && c>=0) {
+        val+=image.Value(start+Point(a,b,c))*values[k];
+      }
+    }
+    res->Value(it)=val;
+  }
+  return res;
+}
+
+/// \brief direct sum for spatial images, running along the rows of the
+///     image data
+template <typename T1, typename T2, class D2>
+ImageStateBasePtr DirectConvolute(const ImageStateImpl<T1,SpatialDomain>& image,
+                                  const ImageStateImpl<T2,D2>& kernel,
+                                  bool wrap, bool correlate)
+{
+  boost::shared_ptr<ImageStateImpl<T1,SpatialDomain> > res=image.CloneState(false);
+  std::vector<Point> offsets;
+  std::vector<T1> values;
+  Point min_offset, max_offset;
+  detail::kernel_terms(kernel,correlate,offsets,values,min_offset,max_offset);
+
+  Size size=image.GetExtent().GetSize();
+  int n[3]={static_cast<int>(size[0]),static_cast<int>(size[1]),
+            static_cast<int>(size[2])};
+  std::vector<int> coords0=detail::source_coords(n[0],min_offset[0],
+                                                 max_offset[0],wrap);
+  std::vector<int> coords1=detail::source_coords(n[1],min_offset[1],
+                                                 max_offset[1],wrap);
+  const T1* in=image.Data().GetData();
+  T1* out=res->Data().GetData();
+  std::fill(out,out+size.GetVolume(),T1(0));
+  for(int u=0;u<n[0];++u) {
+    for(int v=0;v<n[1];++v) {
+      T1* dst=out+(size_t(u)*n[1]+v)*n[2];
+      for(size_t k=0;k<offsets.size();++k) {
+        const Point& o=offsets[k];
+        int a=coords0[u-o[0]+max_offset[0]];
+        int b=coords1[v-o[1]+max_offset[1]];
+        if(a<0 || b<0) {
+          continue;
+        }
+        // wrap the offset along the row into the image
+        int offset=wrap ? o[2]%n[2] : o[2];
+        detail::add_row(dst,in+(size_t(a)*n[1]+b)*n[2],n[2],offset,wrap,
+                        values[k]);
+      }
+    }
+  }
+  return res;
+}
+
+/// \brief FFT based convolution or correlation of a real spatial image with a
+///     real spatial kernel
+///
+/// Gives the same result as DirectConvolute. The image is zero padded by the
+/// size of the kernel, or padded with the wrapped around values. Images whose
+/// padded size exceeds max_tile_volume points are processed in slabs along the
+/// first axis (overlap-save), each slab extended by the kernel size.
+ImageStateBasePtr DLLEXPORT_IMG_ALG FFTConvolute(const RealSpatialImageState& image,
+                                                 const RealSpatialImageState& kernel,
+                                                 bool wrap, bool correlate,
+                                                 size_t max_tile_volume=size_t(1)<<24);
+
+/// \brief whether the FFT based convolution of an image with the given extent
+///     with a kernel is expected to be faster than the direct sum
+bool DLLEXPORT_IMG_ALG PreferFFTConvolute(const Extent& image,
+                                          const Extent& kernel,
+                                          size_t max_tile_volume=size_t(1)<<24);
+
+}}} // ns
+
+#endif
@@ -0,0 +1,278 @@
+//------------------------------------------------------------------------------
+// This file is part of the OpenStructure project <www.openstructure.org>
+//
+// Copyright (C) 2008-2020 by the OpenStructure authors
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 3.0 of the License, or (at your option)
+// any later version.
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//------------------------------------------------------------------------------
+
+#include <algorithm>
+
+#include <boost/shared_ptr.hpp>
+#include <fftw3.h>
+#if OST_INFO_ENABLED
+#include <QThread>
+#define IDEAL_NUMBER_OF_THREADS() QThread::idealThreadCount()
+#else
+#define IDEAL_NUMBER_OF_THREADS() 1
+#endif
+#include <ost/message.hh>
+#include <ost/img/data_types.hh>
+#include "fft.hh"
+#include "fft_plan_cache.hh"
+#include <ost/img/alg/fftw_helper.hh>
+
+namespace ost { namespace img { namespace alg {
+
+namespace {
+
+int planner_flag(FFTPlanCache::PlannerMode mode)
+{
+  switch (mode) {
+    case FFTPlanCache::MEASURE:
+      return FFTW_MEASURE;
+    case FFTPlanCache::PATIENT:
+      return FFTW_PATIENT;
+    default:
+      return FFTW_ESTIMATE;
+  }
+}
+
+// frees the scratch arrays used for planning when going out of scope
+class ScratchArray {
+public:
+  ScratchArray(size_t bytes): data_(OST_FFTW_fftw_malloc(bytes))
+  {
+    if (!data_) {
+      throw FFTException("could not allocate memory for FFTW planning");
+    }
+  }
+  ~ScratchArray() { OST_FFTW_fftw_free(data_); }
+  void* Get() { return data_; }
+private:
+  ScratchArray(const ScratchArray&);
+  ScratchArray& operator=(const ScratchArray&);
+  void* data_;
+};
+
+} // anon ns
+
+bool FFTPlanCache::PlanKey::operator<(const PlanKey& rhs) const
+{
+  if (type!=rhs.type) return type<rhs.type;
+  if (rank!=rhs.rank) return rank<rhs.rank;
+  for (int i=0; i<rank; ++i) {
+    if (n[i]!=rhs.n[i]) return n[i]<rhs.n[i];
+  }
+  if (in_place!=rhs.in_place) return in_place<rhs.in_place;
+  if (aligned!=rhs.aligned) return aligned<rhs.aligned;
+  if (num_threads!=rhs.num_threads) return num_threads<rhs.num_threads;
+  return mode<rhs.mode;
+}
+
+FFTPlanCache& FFTPlanCache::Instance()
+{
+  static FFTPlanCache instance;
+  return instance;
+}
+
+FFTPlanCache::FFTPlanCache():
+  plans_(),
+  mode_(ESTIMATE),
+  num_threads_(0),
+  mutex_()
+{
+  OST_FFTW_fftw_init_threads();
+}
+
+FFTPlanCache::~FFTPlanCache()
+{
+  this->Clear();
+  OST_FFTW_fftw_cleanup();
+}
+
+void FFTPlanCache::SetPlannerMode(PlannerMode mode)
+{
+  boost::mutex::scoped_lock lock(mutex_);
+  mode_=mode;
+}
+
+FFTPlanCache::PlannerMode FFTPlanCache::GetPlannerMode() const
+{
+  boost::mutex::scoped_lock lock(mutex_);
+  return mode_;
+}
+
+void FFTPlanCache::SetThreadCount(int num_threads)
+{
+  boost::mutex::scoped_lock lock(mutex_);
+  num_threads_=std::max(0, num_threads);
+}
+
+int FFTPlanCache::GetThreadCount() const
+{
+  boost::mutex::scoped_lock lock(mutex_);
+  return num_threads_;
+}
+
+size_t FFTPlanCache::GetPlanCount() const
+{
+  boost::mutex::scoped_lock lock(mutex_);
+  return plans_.size();
+}
+
+void FFTPlanCache::Clear()
+{
+  boost::mutex::scoped_lock lock(mutex_);
+  for (PlanMap::iterator i=plans_.begin(), e=plans_.end(); i!=e; ++i) {
+    OST_FFTW_fftw_destroy_plan(static_cast<OST_FFTW_fftw_plan>(i->second));
+  }
+  plans_.clear();
+}
+
+bool FFTPlanCache::LoadWisdom(const String& filename)
+{
+  boost::mutex::scoped_lock lock(mutex_);
+  return OST_FFTW_fftw_import_wisdom_from_filename(filename.c_str())!=0;
+}
+
+void FFTPlanCache::SaveWisdom(const String& filename) const
+{
+  boost::mutex::scoped_lock lock(mutex_);
+  if (!OST_FFTW_fftw_export_wisdom_to_filename(filename.c_str())) {
+    throw Error("Could not write FFTW wisdom to "+filename);
+  }
+}
+
+void FFTPlanCache::Execute(TransformType type, int rank, const int* n,
+                           void* in, void* out)
+{
+  if (rank<1 || rank>3) {
+    throw FFTException("unexpected dimension in FFT");
+  }
+  PlanKey key;
+  key.type=type;
+  key.rank=rank;
+  for (int i=0; i<3; ++i) {
+    key.n[i]=i<rank ? n[i] : 1;
+  }
+  key.in_place=(in==out);
+  // plans created for SIMD aligned arrays must not be applied to unaligned
+  // ones, see the FFTW documentation of the new-array execute functions
+  key.aligned=OST_FFTW_fftw_alignment_of(static_cast<Real*>(in))==0 &&
+              OST_FFTW_fftw_alignment_of(static_cast<Real*>(out))==0;
+  OST_FFTW_fftw_plan plan=NULL;
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+#if OST_FFT_USE_THREADS
+    key.num_threads=num_threads_>0 ? num_threads_ :
+                    std::max<int>(1, IDEAL_NUMBER_OF_THREADS());
+#else
+    key.num_threads=1;
+#endif
+    key.mode=mode_;
+    PlanMap::iterator i=plans_.find(key);
+    if (i==plans_.end()) {
+      i=plans_.insert(std::make_pair(key, this->CreatePlan(key, in, out))).first;
+    }
+    plan=static_cast<OST_FFTW_fftw_plan>(i->second);
+  }
+  switch (type) {
+    case REAL_TO_COMPLEX:
+      OST_FFTW_fftw_execute_dft_r2c(plan, static_cast<Real*>(in),
+                           static_cast<OST_FFTW_fftw_complex*>(out));
+      break;
+    case COMPLEX_TO_REAL:
+      OST_FFTW_fftw_execute_dft_c2r(plan,
+                           static_cast<OST_FFTW_fftw_complex*>(in),
+                           static_cast<Real*>(out));
+      break;
+    default:
+      OST_FFTW_fftw_execute_dft(plan, static_cast<OST_FFTW_fftw_complex*>(in),
+                                static_cast<OST_FFTW_fftw_complex*>(out));
+  }
+}
+
+// must be called with the mutex locked
+void* FFTPlanCache::CreatePlan(const PlanKey& key, void* in, void* out) const
+{
+  int flags=planner_flag(key.mode);
+  if (!key.aligned) {
+    flags|=FFTW_UNALIGNED;
+  }
+  if (!key.in_place) {
+    flags|=(key.type==COMPLEX_TO_REAL ? FFTW_DESTROY_INPUT :
+                                        FFTW_PRESERVE_INPUT);
+  }
+  // all planner modes except ESTIMATE overwrite the arrays while planning,
+  // hence the plan is created for scratch arrays in that case.
+  boost::shared_ptr<ScratchArray> scratch_in, scratch_out;
+  if (key.mode!=ESTIMATE) {
+    size_t real_count=1, half_count=1;
+    for (int i=0; i<key.rank; ++i) {
+      real_count*=key.n[i];
+      half_count*=(i==key.rank-1 ? key.n[i]/2+1 : key.n[i]);
+    }
+    size_t in_bytes, out_bytes;
+    switch (key.type) {
+      case REAL_TO_COMPLEX:
+        in_bytes=real_count*sizeof(Real);
+        out_bytes=half_count*sizeof(Complex);
+        break;
+      case COMPLEX_TO_REAL:
+        in_bytes=half_count*sizeof(Complex);
+        out_bytes=real_count*sizeof(Real);
+        break;
+      default:
+        in_bytes=real_count*sizeof(Complex);
+        out_bytes=in_bytes;
+    }
+    scratch_in.reset(new ScratchArray(std::max(in_bytes, out_bytes)));
+    in=scratch_in->Get();
+    if (key.in_place) {
+      out=in;
+    } else {
+      scratch_out.reset(new ScratchArray(out_bytes));
+      out=scratch_out->Get();
+    }
+  }
+  OST_FFTW_fftw_plan_with_nthreads(key.num_threads);
+  OST_FFTW_fftw_plan plan=NULL;
+  switch (key.type) {
+    case REAL_TO_COMPLEX:
+      plan=OST_FFTW_fftw_plan_dft_r2c(key.rank, key.n, static_cast<Real*>(in),
+                           static_cast<OST_FFTW_fftw_complex*>(out), flags);
+      break;
+    case COMPLEX_TO_REAL:
+      plan=OST_FFTW_fftw_plan_dft_c2r(key.rank, key.n,
+                           static_cast<OST_FFTW_fftw_complex*>(in),
+                           static_cast<Real*>(out), flags);
+      break;
+    case COMPLEX_FORWARD:
+    case COMPLEX_BACKWARD:
+      plan=OST_FFTW_fftw_plan_dft(key.rank, key.n,
+                           static_cast<OST_FFTW_fftw_complex*>(in),
+                           static_cast<OST_FFTW_fftw_complex*>(out),
+                           key.type==COMPLEX_FORWARD ? FFTW_FORWARD :
+                                                       FFTW_BACKWARD,
+                           flags);
+      break;
+  }
+  if (!plan) {
+    throw FFTException("could not create FFTW plan");
+  }
+  return plan;
+}
+
+}}} // ns
@@ -0,0 +1,132 @@
+//------------------------------------------------------------------------------
+// This file is part of the OpenStructure project <www.openstructure.org>
+//
+// Copyright (C) 2008-2020 by the OpenStructure authors
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 3.0 of the License, or (at your option)
+// any later version.
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//------------------------------------------------------------------------------
+
+#ifndef IMG_ALG_FFT_PLAN_CACHE_HH
+#define IMG_ALG_FFT_PLAN_CACHE_HH
+
+#include <map>
+#include <boost/thread/mutex.hpp>
+#include <ost/base.hh>
+#include <ost/img/alg/module_config.hh>
+
+namespace ost { namespace img { namespace alg {
+
+/// \brief process-wide cache of FFTW plans
+///
+/// Creating a plan is expensive compared to executing it, in particular for
+/// the planner modes MEASURE and PATIENT, which time several algorithms. The
+/// cache creates a plan once for every combination of transform type,
+/// dimensions, in-place flag, thread count, data alignment and planner mode
+/// and applies it to new arrays with the FFTW new-array execute functions.
+///
+/// Planning is serialised with a mutex, since the FFTW planner is not thread
+/// safe, the transforms themselves run concurrently. The accumulated planner
+/// knowledge (wisdom) can be saved to and loaded from a file, so the cost of
+/// MEASURE or PATIENT planning is paid once per installation.
+class DLLEXPORT_IMG_ALG FFTPlanCache {
+public:
+  typedef enum {
+    ESTIMATE,
+    MEASURE,
+    PATIENT
+  } PlannerMode;
+
+  typedef enum {
+    REAL_TO_COMPLEX,
+    COMPLEX_TO_REAL,
+    COMPLEX_FORWARD,
+    COMPLEX_BACKWARD
+  } TransformType;
+
+  static FFTPlanCache& Instance();
+
+  ~FFTPlanCache();
+
+  /// \brief set the planner mode used for plans created from now on
+  ///
+  /// Plans created with a different planner mode remain in the cache but are
+  /// not used anymore. Defaults to ESTIMATE.
+  void SetPlannerMode(PlannerMode mode);
+
+  PlannerMode GetPlannerMode() const;
+
+  /// \brief set the number of threads used by the transforms
+  ///
+  /// A value of 0 (the default) selects the ideal number of threads of the
+  /// machine. Has no effect if FFTW is used without thread support.
+  void SetThreadCount(int num_threads);
+
+  int GetThreadCount() const;
+
+  /// \brief number of cached plans
+  size_t GetPlanCount() const;
+
+  /// \brief destroy all cached plans
+  void Clear();
+
+  /// \brief import FFTW wisdom from file
+  ///
+  /// \returns false if the file does not exist or could not be read
+  bool LoadWisdom(const String& filename);
+
+  /// \brief export FFTW wisdom to file
+  ///
+  /// \throws Error if the file could not be written
+  void SaveWisdom(const String& filename) const;
+
+  /// \brief execute transform
+  ///
+  /// n contains rank entries, the size of the last dimension is halved
+  /// for the complex side of REAL_TO_COMPLEX and COMPLEX_TO_REAL
+  /// transforms. in and out point to Real or Complex arrays depending on the
+  /// type. The input of COMPLEX_TO_REAL transforms is overwritten, the input
+  /// of all other transforms is preserved.
+  void Execute(TransformType type, int rank, const int* n, void* in,
+               void* out);
+
+private:
+  struct PlanKey {
+    TransformType type;
+    int           rank;
+    int           n[3];
+    bool          in_place;
+    bool          aligned;
+    int           num_threads;
+    PlannerMode   mode;
+
+    bool operator<(const PlanKey& rhs) const;
+  };
+  // plans are stored type-erased to keep fftw3.h out of this header
+  typedef std::map<PlanKey, void*> PlanMap;
+
+  FFTPlanCache();
+  FFTPlanCache(const FFTPlanCache&);
+  FFTPlanCache& operator=(const FFTPlanCache&);
+
+  void* CreatePlan(const PlanKey& key, void* in, void* out) const;
+
+  PlanMap              plans_;
+  PlannerMode          mode_;
+  int                  num_threads_;
+  mutable boost::mutex mutex_;
+};
+
+}}} // ns
+
+#endif
@@ -46,6 +46,15 @@ Author: Juergen Haas
 #define OST_FFTW_fftw_plan_dft fftw_plan_dft
 #define OST_FFTW_fftw_plan_dft_c2r fftw_plan_dft_c2r
 #define OST_FFTW_fftw_plan_many_dft fftw_plan_many_dft
+#define OST_FFTW_fftw_execute_dft_r2c fftw_execute_dft_r2c
+#define OST_FFTW_fftw_execute_dft_c2r fftw_execute_dft_c2r
+#define OST_FFTW_fftw_execute_dft fftw_execute_dft
+#define OST_FFTW_fftw_alignment_of fftw_alignment_of
+#define OST_FFTW_fftw_malloc fftw_malloc
+#define OST_FFTW_fftw_free fftw_free
+#define OST_FFTW_fftw_import_wisdom_from_filename fftw_import_wisdom_from_filename
+#define OST_FFTW_fftw_export_wisdom_to_filename fftw_export_wisdom_to_filename
+#define OST_FFTW_fftw_forget_wisdom fftw_forget_wisdom
 #else
 #define OST_FFTW_fftw_complex fftwf_complex
 #define OST_FFTW_fftw_plan fftwf_plan
@@ -67,6 +76,15 @@ Author: Juergen Haas
 #define OST_FFTW_fftw_plan_dft fftwf_plan_dft
 #define OST_FFTW_fftw_plan_dft_c2r fftwf_plan_dft_c2r
 #define OST_FFTW_fftw_plan_many_dft fftwf_plan_many_dft
+#define OST_FFTW_fftw_execute_dft_r2c fftwf_execute_dft_r2c
+#define OST_FFTW_fftw_execute_dft_c2r fftwf_execute_dft_c2r
+#define OST_FFTW_fftw_execute_dft fftwf_execute_dft
+#define OST_FFTW_fftw_alignment_of fftwf_alignment_of
+#define OST_FFTW_fftw_malloc fftwf_malloc
+#define OST_FFTW_fftw_free fftwf_free
+#define OST_FFTW_fftw_import_wisdom_from_filename fftwf_import_wisdom_from_filename
+#define OST_FFTW_fftw_export_wisdom_to_filename fftwf_export_wisdom_to_filename
+#define OST_FFTW_fftw_forget_wisdom fftwf_forget_wisdom
 #endif
 
 #if OST_FFT_USE_THREADS
@@ -80,7 +98,7 @@ Author: Juergen Haas
     #define OST_FFTW_fftw_plan_with_nthreads fftwf_plan_with_nthreads
   #endif
 #else
-  void fftw_noop(unsigned int i=0){}
+  inline void fftw_noop(unsigned int i=0){}
   #define OST_FFTW_fftw_init_threads fftw_noop
   #define OST_FFTW_fftw_plan_with_nthreads fftw_noop
   #if OST_DOUBLE_PRECISION
@@ -0,0 +1,104 @@
+//------------------------------------------------------------------------------
+// This file is part of the OpenStructure project <www.openstructure.org>
+//
+// Copyright (C) 2008-2020 by the OpenStructure authors
+// Copyright (C) 2003-2010 by the IPLT authors
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 3.0 of the License, or (at your option)
+// any later version.
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//------------------------------------------------------------------------------
+#include <cmath>
+
+#include <ost/message.hh>
+#include <ost/img/value_util.hh>
+
+#include "local_correlation.hh"
+#include "local_statistics.hh"
+
+namespace ost { namespace img { namespace alg {
+
+LocalCorrelationBase::LocalCorrelationBase():
+  ref_(),
+  size_(5)
+{}
+
+LocalCorrelationBase::LocalCorrelationBase(const ConstImageHandle& ref, int size):
+  ref_(ref),
+  size_(size)
+{}
+
+template <typename T, class D>
+ImageStateBasePtr LocalCorrelationBase::VisitState(const ImageStateImpl<T,D>& s) const
+{
+  Extent extent=s.GetExtent();
+  if(!ref_.IsValid() || ref_.GetExtent()!=extent) {
+    throw Error("LocalCorrelation: reference image must have the same extent");
+  }
+  boost::shared_ptr<RealSpatialImageState> out_state(new RealSpatialImageState(extent,s.GetSampling()));
+
+  // windowed sums of a, b, a*a, b*b and a*b, with a and b shifted by their
+  // global mean, which does not change the correlation
+  std::vector<Real> a=GetRealValues(s);
+  std::vector<Real> b;
+  b.reserve(a.size());
+  Real mean_a=0.0, mean_b=0.0;
+  Point start=extent.GetStart();
+  Size size=extent.GetSize();
+  for(unsigned int i=0;i<size[0];++i) {
+    for(unsigned int j=0;j<size[1];++j) {
+      for(unsigned int k=0;k<size[2];++k) {
+        b.push_back(ref_.GetReal(start+Point(i,j,k)));
+      }
+    }
+  }
+  for(size_t i=0;i<a.size();++i) {
+    mean_a+=a[i];
+    mean_b+=b[i];
+  }
+  mean_a/=a.size();
+  mean_b/=b.size();
+  std::vector<Real> aa(a.size()), bb(a.size()), ab(a.size());
+  for(size_t i=0;i<a.size();++i) {
+    a[i]-=mean_a;
+    b[i]-=mean_b;
+    aa[i]=a[i]*a[i];
+    bb[i]=b[i]*b[i];
+    ab[i]=a[i]*b[i];
+  }
+  SummedAreaTable sum_a(extent,a), sum_b(extent,b);
+  SummedAreaTable sum_aa(extent,aa), sum_bb(extent,bb), sum_ab(extent,ab);
+
+  Point radius=LocalRadius(extent,size_);
+  for(ExtentIterator it(extent);!it.AtEnd();++it) {
+    Point p(it);
+    Extent window=LocalWindow(p,radius);
+    Real n=sum_a.GetCount(window);
+    Real ma=sum_a.GetSum(window)/n;
+    Real mb=sum_b.GetSum(window)/n;
+    Real var_a=sum_aa.GetSum(window)/n-ma*ma;
+    Real var_b=sum_bb.GetSum(window)/n-mb*mb;
+    Real cov=sum_ab.GetSum(window)/n-ma*mb;
+    Real norm=var_a>0.0 && var_b>0.0 ? std::sqrt(var_a*var_b) : 0.0;
+    out_state->Value(p) = norm>0.0 ? cov/norm : 0.0;
+  }
+
+  return out_state;
+}
+
+}
+
+namespace image_state {
+
+template class TEMPLATE_DEF_EXPORT ImageStateConstModOPAlgorithm<alg::LocalCorrelationBase>;
+
+}}} // ns
@@ -0,0 +1,68 @@
+//------------------------------------------------------------------------------
+// This file is part of the OpenStructure project <www.openstructure.org>
+//
+// Copyright (C) 2008-2020 by the OpenStructure authors
+// Copyright (C) 2003-2010 by the IPLT authors
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 3.0 of the License, or (at your option)
+// any later version.
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//------------------------------------------------------------------------------
+#ifndef IMG_ALG_LOCAL_CORRELATION_HH
+#define IMG_ALG_LOCAL_CORRELATION_HH
+
+#include <ost/img/image_handle.hh>
+#include <ost/img/image_state.hh>
+#include <ost/img/image_state/image_state_algorithm.hh>
+#include <ost/img/alg/module_config.hh>
+
+namespace ost { namespace img { namespace alg {
+
+/*
+  Local correlation with a reference image of the same extent; for each
+  point, the Pearson correlation coefficient of the two images in the cubic
+  window of size*2+1 around it (a square for 2D images) is calculated.
+  Windows are cut at the image border, windows without variation in one of
+  the images get a correlation of zero.
+
+  Applied to two independent half maps of a reconstruction, this shows how
+  well the map is determined locally, which is the idea behind local
+  resolution estimates. The result is a real spatial image of the same
+  extent.
+*/
+
+class DLLEXPORT_IMG_ALG LocalCorrelationBase {
+public:
+  LocalCorrelationBase();
+  LocalCorrelationBase(const ConstImageHandle& ref, int size=5);
+
+  template <typename T, class D>
+  ImageStateBasePtr VisitState(const ImageStateImpl<T,D>& s) const;
+
+  static String GetAlgorithmName() {return "LocalCorrelation";}
+
+  void SetSize(int size) {size_=size;}
+  int GetSize() const {return size_;}
+private:
+  ConstImageHandle ref_;
+  int size_;
+};
+
+typedef ImageStateConstModOPAlgorithm<LocalCorrelationBase> LocalCorrelation;
+
+}
+
+OST_IMG_ALG_EXPLICIT_INST_DECL(class,ImageStateConstModOPAlgorithm<alg::LocalCorrelationBase>)
+
+}} // ns
+
+#endif
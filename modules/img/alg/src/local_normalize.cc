@@ -0,0 +1,60 @@
+//------------------------------------------------------------------------------
+// This file is part of the OpenStructure project <www.openstructure.org>
+//
+// Copyright (C) 2008-2020 by the OpenStructure authors
+// Copyright (C) 2003-2010 by the IPLT authors
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 3.0 of the License, or (at your option)
+// any later version.
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//------------------------------------------------------------------------------
+#include <ost/img/value_util.hh>
+
+#include "local_normalize.hh"
+#include "local_statistics.hh"
+
+namespace ost { namespace img { namespace alg {
+
+LocalNormalizeBase::LocalNormalizeBase():
+  size_(5)
+{}
+
+LocalNormalizeBase::LocalNormalizeBase(int size):
+  size_(size)
+{}
+
+template <typename T, class D>
+ImageStateBasePtr LocalNormalizeBase::VisitState(const ImageStateImpl<T,D>& s) const
+{
+  Extent extent=s.GetExtent();
+  boost::shared_ptr<RealSpatialImageState> out_state(new RealSpatialImageState(extent,s.GetSampling()));
+
+  LocalStatistics stat(s);
+  Point radius=LocalRadius(extent,size_);
+  for(ExtentIterator it(extent);!it.AtEnd();++it) {
+    Point p(it);
+    Extent window=LocalWindow(p,radius);
+    Real sigma=stat.GetStandardDeviation(window);
+    Real val=Val2Val<T,Real>(s.Value(p));
+    out_state->Value(p) = sigma>0.0 ? (val-stat.GetMean(window))/sigma : 0.0;
+  }
+
+  return out_state;
+}
+
+}
+
+namespace image_state {
+
+template class TEMPLATE_DEF_EXPORT ImageStateConstModOPAlgorithm<alg::LocalNormalizeBase>;
+
+}}} // ns
@@ -22,6 +22,7 @@
 #include <ost/img/value_util.hh>
 
 #include "local_sigma_threshold.hh"
+#include "local_statistics.hh"
 
 namespace ost { namespace img { namespace alg {
 
@@ -43,21 +44,14 @@ ImageStateBasePtr LocalSigmaThresholdBase::VisitState(const ImageStateImpl<T,D>&
 				full_extent.GetEnd()-Point(size_,size_));
   boost::shared_ptr<RealSpatialImageState> out_state(new RealSpatialImageState(search_extent,s.GetSampling()));
 
+  // the variance of each window is looked up in a summed-area table, so
+  // the cost does not grow with the window size
+  LocalStatistics stat(s);
+  Point radius(size_,size_);
   Real level2=level_*level_;
-  Real fac = 1.0/static_cast<Real>((size_*2+1)*(size_*2+1));
   for(ExtentIterator it(search_extent);!it.AtEnd();++it) {
     Point p(it);
-    Real sum=0.0;
-    Real sum2=0.0;
-    for(int a=-size_;a<=size_;++a) {
-      for(int b=-size_;b<=size_;++b) {
-	Real val=Val2Val<T,Real>(s.Value(p+Point(a,b)));
-	sum+=val;
-	sum2+=val*val;
-      }
-    }
-    Real mean=sum*fac;
-    Real var=sum2*fac-mean*mean;
+    Real var=stat.GetVariance(LocalWindow(p,radius));
     out_state->Value(p) = var>level2 ? 1.0 : 0.0;
   }
 
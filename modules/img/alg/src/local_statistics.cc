@@ -0,0 +1,273 @@
+//------------------------------------------------------------------------------
+// This file is part of the OpenStructure project <www.openstructure.org>
+//
+// Copyright (C) 2008-2020 by the OpenStructure authors
+// Copyright (C) 2003-2010 by the IPLT authors
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 3.0 of the License, or (at your option)
+// any later version.
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//------------------------------------------------------------------------------
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+#include <ost/message.hh>
+
+#include "local_statistics.hh"
+
+namespace ost { namespace img { namespace alg {
+
+namespace {
+
+void check_values(const Extent& extent, const std::vector<Real>& values)
+{
+  if(values.size()!=extent.GetSize().GetVol()) {
+    throw Error("number of values does not match the extent");
+  }
+}
+
+// running extremum of the n values in[0], in[stride], ... over windows of
+// the given radius. The queue holds the positions of the values that can
+// still become the extremum of a window, their values are ordered by cmp.
+template <class CMP>
+void running_extremum(const Real* in, Real* out, int n, size_t stride,
+                      int radius, std::vector<int>& queue, CMP cmp)
+{
+  queue.resize(n);
+  int head=0;
+  int tail=0;
+  int next=0;
+  for(int x=0;x<n;++x) {
+    for(;next<n && next<=x+radius;++next) {
+      Real val=in[next*stride];
+      while(tail>head && !cmp(in[queue[tail-1]*stride],val)) {
+        --tail;
+      }
+      queue[tail++]=next;
+    }
+    while(queue[head]<x-radius) {
+      ++head;
+    }
+    out[x*stride]=in[queue[head]*stride];
+  }
+}
+
+// apply running_extremum along all axes of data, which holds the values of
+// the extent with the last index running fastest
+template <class CMP>
+void local_extremum(const Extent& extent, const Point& radius,
+                    std::vector<Real>& data, CMP cmp)
+{
+  Size size=extent.GetSize();
+  int n[3]={static_cast<int>(size[0]),static_cast<int>(size[1]),
+            static_cast<int>(size[2])};
+  size_t strides[3]={size_t(n[1])*n[2],size_t(n[2]),1};
+  std::vector<Real> tmp(data.size());
+  std::vector<int> queue;
+  for(int axis=0;axis<3;++axis) {
+    if(radius[axis]<=0 || n[axis]<2) {
+      continue;
+    }
+    int o1=axis==0 ? 1 : 0;
+    int o2=axis==2 ? 1 : 2;
+    for(int i=0;i<n[o1];++i) {
+      for(int j=0;j<n[o2];++j) {
+        size_t start=i*strides[o1]+j*strides[o2];
+        running_extremum(&data[start],&tmp[start],n[axis],strides[axis],
+                         radius[axis],queue,cmp);
+      }
+    }
+    data.swap(tmp);
+  }
+}
+
+} // anon ns
+
+SummedAreaTable::SummedAreaTable():
+  extent_(),
+  stride_u_(0),
+  stride_v_(0),
+  table_()
+{}
+
+SummedAreaTable::SummedAreaTable(const Extent& extent,
+                                 const std::vector<Real>& values):
+  extent_(extent)
+{
+  check_values(extent,values);
+  Size size=extent.GetSize();
+  size_t nu=size[0]+1;
+  size_t nv=size[1]+1;
+  size_t nw=size[2]+1;
+  stride_v_=nw;
+  stride_u_=nv*nw;
+  table_.assign(nu*nv*nw,0.0);
+  // running sums along w, then v, then u. The first row of each axis stays
+  // zero, so that the window sums need no special cases at the border.
+  std::vector<Real>::const_iterator vit=values.begin();
+  for(size_t u=1;u<nu;++u) {
+    for(size_t v=1;v<nv;++v) {
+      double* row=&table_[u*stride_u_+v*stride_v_];
+      double sum=0.0;
+      for(size_t w=1;w<nw;++w,++vit) {
+        sum+=*vit;
+        row[w]=sum;
+      }
+    }
+  }
+  for(size_t u=1;u<nu;++u) {
+    for(size_t v=2;v<nv;++v) {
+      double* row=&table_[u*stride_u_+v*stride_v_];
+      const double* prev=row-stride_v_;
+      for(size_t w=1;w<nw;++w) {
+        row[w]+=prev[w];
+      }
+    }
+  }
+  for(size_t u=2;u<nu;++u) {
+    double* plane=&table_[u*stride_u_];
+    const double* prev=plane-stride_u_;
+    for(size_t i=0;i<stride_u_;++i) {
+      plane[i]+=prev[i];
+    }
+  }
+}
+
+int SummedAreaTable::Clip(const Extent& window, int lo[3], int hi[3]) const
+{
+  int count=1;
+  Point start=extent_.GetStart();
+  Point end=extent_.GetEnd();
+  for(int i=0;i<3;++i) {
+    lo[i]=std::max(window.GetStart()[i],start[i])-start[i];
+    hi[i]=std::min(window.GetEnd()[i],end[i])-start[i]+1;
+    count*=std::max(0,hi[i]-lo[i]);
+  }
+  return table_.empty() ? 0 : count;
+}
+
+Real SummedAreaTable::GetSum(const Extent& window) const
+{
+  int lo[3], hi[3];
+  if(this->Clip(window,lo,hi)==0) {
+    return 0.0;
+  }
+  size_t u0=lo[0]*stride_u_, u1=hi[0]*stride_u_;
+  size_t v0=lo[1]*stride_v_, v1=hi[1]*stride_v_;
+  size_t w0=lo[2], w1=hi[2];
+  double sum=table_[u1+v1+w1]-table_[u0+v1+w1]-table_[u1+v0+w1]
+            -table_[u1+v1+w0]+table_[u0+v0+w1]+table_[u0+v1+w0]
+            +table_[u1+v0+w0]-table_[u0+v0+w0];
+  return sum;
+}
+
+int SummedAreaTable::GetCount(const Extent& window) const
+{
+  int lo[3], hi[3];
+  return this->Clip(window,lo,hi);
+}
+
+LocalStatistics::LocalStatistics(const Extent& extent,
+                                 const std::vector<Real>& values)
+{
+  this->Init(extent,values);
+}
+
+void LocalStatistics::Init(const Extent& extent,
+                           const std::vector<Real>& values)
+{
+  check_values(extent,values);
+  double mean=0.0;
+  for(std::vector<Real>::const_iterator it=values.begin();
+      it!=values.end();++it) {
+    mean+=*it;
+  }
+  offset_=values.empty() ? 0.0 : mean/values.size();
+  std::vector<Real> shifted(values.size());
+  std::vector<Real> squares(values.size());
+  for(size_t i=0;i<values.size();++i) {
+    shifted[i]=values[i]-offset_;
+    squares[i]=shifted[i]*shifted[i];
+  }
+  sum_=SummedAreaTable(extent,shifted);
+  sum2_=SummedAreaTable(extent,squares);
+}
+
+int LocalStatistics::GetCount(const Extent& window) const
+{
+  return sum_.GetCount(window);
+}
+
+Real LocalStatistics::GetMean(const Extent& window) const
+{
+  int n=sum_.GetCount(window);
+  if(n==0) {
+    return 0.0;
+  }
+  return sum_.GetSum(window)/n+offset_;
+}
+
+Real LocalStatistics::GetVariance(const Extent& window) const
+{
+  int n=sum_.GetCount(window);
+  if(n==0) {
+    return 0.0;
+  }
+  Real mean=sum_.GetSum(window)/n;
+  return std::max<Real>(0.0,sum2_.GetSum(window)/n-mean*mean);
+}
+
+Real LocalStatistics::GetStandardDeviation(const Extent& window) const
+{
+  return std::sqrt(this->GetVariance(window));
+}
+
+LocalMinMax::LocalMinMax(const Extent& extent, const std::vector<Real>& values,
+                         const Point& radius)
+{
+  this->Init(extent,values,radius);
+}
+
+void LocalMinMax::Init(const Extent& extent, const std::vector<Real>& values,
+                       const Point& radius)
+{
+  check_values(extent,values);
+  extent_=extent;
+  radius_=radius;
+  min_=values;
+  local_extremum(extent,radius,min_,std::less<Real>());
+  max_=values;
+  local_extremum(extent,radius,max_,std::greater<Real>());
+}
+
+size_t LocalMinMax::ToIndex(const Point& p) const
+{
+  if(!extent_.Contains(p)) {
+    throw Error("point is not part of the image");
+  }
+  Point d=p-extent_.GetStart();
+  Size size=extent_.GetSize();
+  return (size_t(d[0])*size[1]+d[1])*size[2]+d[2];
+}
+
+Real LocalMinMax::GetMinimum(const Point& p) const
+{
+  return min_[this->ToIndex(p)];
+}
+
+Real LocalMinMax::GetMaximum(const Point& p) const
+{
+  return max_[this->ToIndex(p)];
+}
+
+}}} // ns
@@ -0,0 +1,173 @@
+//------------------------------------------------------------------------------
+// This file is part of the OpenStructure project <www.openstructure.org>
+//
+// Copyright (C) 2008-2020 by the OpenStructure authors
+// Copyright (C) 2003-2010 by the IPLT authors
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 3.0 of the License, or (at your option)
+// any later version.
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//------------------------------------------------------------------------------
+
+#ifndef IMG_ALG_LOCAL_STATISTICS_HH
+#define IMG_ALG_LOCAL_STATISTICS_HH
+
+#include <vector>
+#include <ost/img/image_state.hh>
+#include <ost/img/value_util.hh>
+#include <ost/img/alg/module_config.hh>
+
+namespace ost { namespace img { namespace alg {
+
+/*
+  Window statistics in constant time per window, independent of the window
+  size. The classes are set up once for a 1D, 2D or 3D image state and then
+  queried for box shaped windows, given as extents. Parts of a window that
+  lie outside of the image are ignored.
+
+  The values are passed as a vector with one entry per point of the extent,
+  the last index running fastest, see GetRealValues.
+*/
+
+/// \brief real values of an image state, ordered as expected by the classes
+///     below
+template <typename T, class D>
+std::vector<Real> GetRealValues(const ImageStateImpl<T,D>& s)
+{
+  Size size=s.GetSize();
+  std::vector<Real> values;
+  values.reserve(size.GetVol());
+  for(unsigned int i=0;i<size[0];++i) {
+    for(unsigned int j=0;j<size[1];++j) {
+      for(unsigned int k=0;k<size[2];++k) {
+        values.push_back(Val2Val<T,Real>(s.Value(Index(i,j,k))));
+      }
+    }
+  }
+  return values;
+}
+
+/// \brief window of the given radius around a point
+inline Extent LocalWindow(const Point& center, const Point& radius)
+{
+  return Extent(center-radius,center+radius);
+}
+
+/// \brief radius of a cubic window for the extent, zero along axes in which
+///     the extent is only one point thick (i.e. a square for 2D images)
+inline Point LocalRadius(const Extent& extent, int size)
+{
+  Size s=extent.GetSize();
+  return Point(s[0]>1 ? size : 0,s[1]>1 ? size : 0,s[2]>1 ? size : 0);
+}
+
+/// \brief summed-area table, for the sum of the values in any window
+///
+/// Entry (i,j,k) of the table is the sum of all values with indices smaller
+/// than (i,j,k), from which the sum of a window is obtained with at most
+/// eight lookups. The table is kept in double precision.
+class DLLEXPORT_IMG_ALG SummedAreaTable {
+public:
+  SummedAreaTable();
+  SummedAreaTable(const Extent& extent, const std::vector<Real>& values);
+
+  /// \brief sum of the values inside the window
+  Real GetSum(const Extent& window) const;
+
+  /// \brief number of image points inside the window
+  int GetCount(const Extent& window) const;
+
+  const Extent& GetExtent() const {return extent_;}
+
+private:
+  int Clip(const Extent& window, int lo[3], int hi[3]) const;
+
+  Extent extent_;
+  size_t stride_u_;
+  size_t stride_v_;
+  std::vector<double> table_;
+};
+
+/// \brief mean and variance of the values in any window
+///
+/// The values are shifted by their global mean before they are summed up,
+/// which keeps the cancellation in the variance small.
+class DLLEXPORT_IMG_ALG LocalStatistics {
+public:
+  template <typename T, class D>
+  explicit LocalStatistics(const ImageStateImpl<T,D>& s)
+  {
+    this->Init(s.GetExtent(),GetRealValues(s));
+  }
+
+  LocalStatistics(const Extent& extent, const std::vector<Real>& values);
+
+  /// \brief number of image points inside the window
+  int GetCount(const Extent& window) const;
+
+  /// \brief mean of the window, zero for empty windows
+  Real GetMean(const Extent& window) const;
+
+  /// \brief variance of the window (normalized by the number of points)
+  Real GetVariance(const Extent& window) const;
+
+  Real GetStandardDeviation(const Extent& window) const;
+
+private:
+  void Init(const Extent& extent, const std::vector<Real>& values);
+
+  Real offset_;
+  SummedAreaTable sum_;
+  SummedAreaTable sum2_;
+};
+
+/// \brief minimum and maximum in the window of a fixed radius around each
+///     point
+///
+/// The extrema are computed for all points at once, one axis after the other,
+/// with a running window that keeps the candidate extrema in a queue. This
+/// takes a constant amount of work per point and axis.
+class DLLEXPORT_IMG_ALG LocalMinMax {
+public:
+  template <typename T, class D>
+  LocalMinMax(const ImageStateImpl<T,D>& s, const Point& radius)
+  {
+    this->Init(s.GetExtent(),GetRealValues(s),radius);
+  }
+
+  LocalMinMax(const Extent& extent, const std::vector<Real>& values,
+              const Point& radius);
+
+  /// \brief minimum of the window around the point, which must be part of the
+  ///     image
+  Real GetMinimum(const Point& p) const;
+
+  /// \brief maximum of the window around the point, which must be part of the
+  ///     image
+  Real GetMaximum(const Point& p) const;
+
+  const Point& GetRadius() const {return radius_;}
+
+private:
+  void Init(const Extent& extent, const std::vector<Real>& values,
+            const Point& radius);
+  size_t ToIndex(const Point& p) const;
+
+  Extent extent_;
+  Point radius_;
+  std::vector<Real> min_;
+  std::vector<Real> max_;
+};
+
+}}} // ns
+
+#endif
@@ -0,0 +1,123 @@
+//------------------------------------------------------------------------------
+// This file is part of the OpenStructure project <www.openstructure.org>
+//
+// Copyright (C) 2008-2020 by the OpenStructure authors
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 3.0 of the License, or (at your option)
+// any later version.
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//------------------------------------------------------------------------------
+/*
+  Times the direct and the FFT based convolution of a cubic map with cubic
+  kernels of increasing size, to show where the FFT becomes faster and whether
+  CONVOLUTION_AUTO picks the faster method.
+
+  usage: bench_convolute [map_size] [max_radius] [max_tile_volume]
+
+  The kernels have 2*radius+1 points along each axis. The FFT is additionally
+  timed with slabs of at most max_tile_volume points (overlap-save), which
+  bounds the memory needed for large maps. The direct sum is skipped once it
+  takes more than a minute.
+*/
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <ost/img/image.hh>
+#include <ost/img/image_state.hh>
+#include <ost/img/alg/randomize.hh>
+#include <ost/img/alg/convolute.hh>
+
+using namespace ost;
+using namespace ost::img;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double seconds_since(const Clock::time_point& start)
+{
+  return std::chrono::duration<double>(Clock::now()-start).count();
+}
+
+double time_convolute(const ImageHandle& map, const ImageHandle& kernel,
+                      alg::ConvolutionMethod method, ImageHandle& res)
+{
+  alg::ExplicitConvolute conv(kernel, false);
+  conv.SetMethod(method);
+  Clock::time_point start=Clock::now();
+  res=map.Apply(conv);
+  return seconds_since(start);
+}
+
+Real max_diff(const ImageHandle& im1, const ImageHandle& im2)
+{
+  Real diff=0.0;
+  for (ExtentIterator i(im1.GetExtent()); !i.AtEnd(); ++i) {
+    diff=std::max<Real>(diff, std::fabs(im1.GetReal(i)-im2.GetReal(i)));
+  }
+  return diff;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  int map_size=argc>1 ? atoi(argv[1]) : 128;
+  int max_radius=argc>2 ? atoi(argv[2]) : 8;
+  size_t max_tile_volume=argc>3 ? atol(argv[3]) : size_t(1)<<21;
+
+  ImageHandle map=CreateImage(Extent(Point(0, 0, 0),
+                                     Size(map_size, map_size, map_size)));
+  map.ApplyIP(alg::Randomize());
+  const RealSpatialImageState* ms=
+    dynamic_cast<const RealSpatialImageState*>(map.ImageStatePtr().get());
+
+  std::cout << "map of " << map_size << "^3 points" << std::endl;
+  std::cout << std::setw(8) << "kernel" << std::setw(12) << "direct [s]"
+            << std::setw(12) << "fft [s]" << std::setw(12) << "tiled [s]"
+            << std::setw(12) << "max diff" << std::setw(8) << "auto"
+            << std::endl;
+  bool run_direct=true;
+  for (int radius=0; radius<=max_radius; ++radius) {
+    ImageHandle kernel=CreateImage(Extent(Point(-radius, -radius, -radius),
+                                          Point(radius, radius, radius)));
+    kernel.ApplyIP(alg::Randomize());
+    const RealSpatialImageState* ks=
+      dynamic_cast<const RealSpatialImageState*>(kernel.ImageStatePtr().get());
+
+    ImageHandle fft_res, direct_res;
+    double fft_time=time_convolute(map, kernel, alg::CONVOLUTION_FFT, fft_res);
+    Clock::time_point start=Clock::now();
+    alg::FFTConvolute(*ms, *ks, false, false, max_tile_volume);
+    double tiled_time=seconds_since(start);
+    std::cout << std::setw(8) << 2*radius+1;
+    if (run_direct) {
+      double direct_time=time_convolute(map, kernel, alg::CONVOLUTION_DIRECT,
+                                        direct_res);
+      std::cout << std::setw(12) << direct_time;
+      run_direct=direct_time<60.0;
+    } else {
+      std::cout << std::setw(12) << "-";
+    }
+    std::cout << std::setw(12) << fft_time << std::setw(12) << tiled_time;
+    if (direct_res.IsValid()) {
+      std::cout << std::setw(12) << max_diff(direct_res, fft_res);
+    } else {
+      std::cout << std::setw(12) << "-";
+    }
+    bool fft=alg::PreferFFTConvolute(map.GetExtent(), kernel.GetExtent());
+    std::cout << std::setw(8) << (fft ? "fft" : "direct") << std::endl;
+  }
+  return 0;
+}
@@ -23,12 +23,15 @@
 */
 
 #include <iostream>
+#include <cmath>
 
 #include "tests.hh"
 
 #include <ost/img/image.hh>
+#include <ost/img/image_state.hh>
 #include <ost/img/alg/randomize.hh>
 #include <ost/img/alg/convolute.hh>
+#include <ost/img/alg/correlate.hh>
 #include <ost/img/alg/fft.hh>
 #include <ost/img/alg/dft.hh>
 
@@ -61,6 +64,136 @@ void test()
 #endif
 }
 
+// straightforward sums, as the convolution was originally implemented
+ImageHandle reference(const ImageHandle& im, const ImageHandle& kernel,
+                      bool wrap, bool correlate)
+{
+  ImageHandle res=CreateImage(im.GetExtent());
+  Extent ex=im.GetExtent();
+  for(ExtentIterator it1(ex);!it1.AtEnd();++it1) {
+    Real val=0.0;
+    for(ExtentIterator it2(kernel.GetExtent());!it2.AtEnd();++it2) {
+      Point p=correlate ? Point(it1)+Point(it2) : Point(it1)-Point(it2);
+      if(wrap) {
+        p=ex.WrapAround(p);
+      } else if(!ex.Contains(p)) {
+        continue;
+      }
+      val+=im.GetReal(p)*kernel.GetReal(it2);
+    }
+    res.SetReal(it1,val);
+  }
+  return res;
+}
+
+Real max_diff(const ImageHandle& im1, const ImageHandle& im2)
+{
+  BOOST_REQUIRE(im1.GetExtent()==im2.GetExtent());
+  Real diff=0.0;
+  for(ExtentIterator it(im1.GetExtent());!it.AtEnd();++it) {
+    diff=std::max<Real>(diff,std::fabs(im1.GetReal(it)-im2.GetReal(it)));
+  }
+  return diff;
+}
+
+ImageHandle convolute(const ImageHandle& im, const ImageHandle& kernel,
+                      bool wrap, bool correlate, ConvolutionMethod method)
+{
+  if(correlate) {
+    ExplicitCorrelate cor(kernel,wrap);
+    cor.SetMethod(method);
+    return im.Apply(cor);
+  }
+  ExplicitConvolute conv(kernel,wrap);
+  conv.SetMethod(method);
+  return im.Apply(conv);
+}
+
+void test_methods()
+{
+  Extent images[]={Extent(Point(-3),Point(17)),
+                   Extent(Point(2,-1),Point(12,9)),
+                   Extent(Point(-1,0,2),Point(5,7,6))};
+  Extent kernels[]={Extent(Point(-2),Point(1)),
+                    Extent(Point(-1,-2),Point(2,0)),
+                    Extent(Point(0,-1,-1),Point(2,1,1))};
+  for(int i=0;i<3;++i) {
+    ImageHandle im=MakeTestImage(images[i]);
+    ImageHandle kernel=MakeTestImage(kernels[i]);
+    for(int k=0;k<4;++k) {
+      bool wrap=k%2==0;
+      bool correlate=k>=2;
+      ImageHandle ref=reference(im,kernel,wrap,correlate);
+      ImageHandle direct=convolute(im,kernel,wrap,correlate,
+                                   CONVOLUTION_DIRECT);
+      BOOST_CHECK_SMALL(max_diff(ref,direct),Real(1e-4));
+      ImageHandle fft=convolute(im,kernel,wrap,correlate,CONVOLUTION_FFT);
+      BOOST_CHECK_SMALL(max_diff(ref,fft),Real(1e-4));
+    }
+  }
+}
+
+void test_complex()
+{
+  // complex images take the direct path, also in the frequency domain
+  DataDomain domains[]={SPATIAL,FREQUENCY};
+  for(int i=0;i<2;++i) {
+    ImageHandle im=CreateImage(Extent(Point(0,0),Size(6,5)),COMPLEX,
+                               domains[i]);
+    im.ApplyIP(alg::Randomize());
+    ImageHandle kernel=CreateImage(Extent(Point(-1,-1),Point(1,1)),COMPLEX);
+    kernel.ApplyIP(alg::Randomize());
+    kernel.SetComplex(Point(0,1),Complex(0.5,-2.0));
+    for(int k=0;k<2;++k) {
+      bool correlate=k==1;
+      ImageHandle res=convolute(im,kernel,true,correlate,CONVOLUTION_AUTO);
+      BOOST_REQUIRE(res.GetType()==COMPLEX);
+      Extent ex=im.GetExtent();
+      for(ExtentIterator it1(ex);!it1.AtEnd();++it1) {
+        Complex val(0.0,0.0);
+        for(ExtentIterator it2(kernel.GetExtent());!it2.AtEnd();++it2) {
+          Complex kv=kernel.GetComplex(it2);
+          if(correlate) {
+            val+=im.GetComplex(ex.WrapAround(Point(it1)+Point(it2)))*std::conj(kv);
+          } else {
+            val+=im.GetComplex(ex.WrapAround(Point(it1)-Point(it2)))*kv;
+          }
+        }
+        BOOST_CHECK_SMALL(std::abs(res.GetComplex(it1)-val),Real(1e-4));
+      }
+    }
+    BOOST_CHECK_THROW(convolute(im,kernel,true,false,CONVOLUTION_FFT),
+                      ost::Error);
+  }
+}
+
+void test_tiles()
+{
+  // slabs of the padded transform along the first axis
+  Extent extent(Point(0,0,0),Point(14,6,5));
+  ImageHandle im=MakeTestImage(extent);
+  ImageHandle kernel=MakeTestImage(Extent(Point(-1,-2,0),Point(1,0,1)));
+  RealSpatialImageState* is=dynamic_cast<RealSpatialImageState*>(im.ImageStatePtr().get());
+  RealSpatialImageState* ks=dynamic_cast<RealSpatialImageState*>(kernel.ImageStatePtr().get());
+  BOOST_REQUIRE(is && ks);
+  for(int k=0;k<4;++k) {
+    bool wrap=k%2==0;
+    bool correlate=k>=2;
+    ImageHandle ref=reference(im,kernel,wrap,correlate);
+    ImageHandle res=CreateImage(extent);
+    res.ImageStatePtr()=FFTConvolute(*is,*ks,wrap,correlate,400);
+    BOOST_CHECK_SMALL(max_diff(ref,res),Real(1e-4));
+  }
+}
+
+void test_crossover()
+{
+  Extent map(Point(0,0,0),Size(64,64,64));
+  BOOST_CHECK(!PreferFFTConvolute(map,Extent(Point(0,0,0),Point(0,0,0))));
+  BOOST_CHECK(!PreferFFTConvolute(map,Extent(Point(-1,-1,-1),Point(1,1,1))));
+  BOOST_CHECK(PreferFFTConvolute(map,Extent(Point(-7,-7,-7),Point(7,7,7))));
+}
+
 } // ns
 
 test_suite* CreateConvoluteTest()
@@ -68,6 +201,10 @@ test_suite* CreateConvoluteTest()
   test_suite* ts=BOOST_TEST_SUITE("Convolute Alg Test");
 
   ts->add(BOOST_TEST_CASE(&test));
+  ts->add(BOOST_TEST_CASE(&test_methods));
+  ts->add(BOOST_TEST_CASE(&test_complex));
+  ts->add(BOOST_TEST_CASE(&test_tiles));
+  ts->add(BOOST_TEST_CASE(&test_crossover));
 
   return ts;
 }
@@ -21,9 +21,11 @@
 /*
   Author: Ansgar Philippsen
 */
+#include <cstdio>
 #include <ost/base.hh>
 #include <ost/img/image_state.hh>
 #include <ost/img/alg/fft.hh>
+#include <ost/img/alg/fft_plan_cache.hh>
 #include <ost/img/alg/dft.hh>
 #include <ost/img/alg/randomize.hh>
 #include <ost/img/alg/alg_shift.hh>
@@ -499,6 +501,53 @@ void Test_Memalloc()
   i4.ApplyIP(talg);
 }
 
+void Test_PlanCache()
+{
+  alg::FFTPlanCache& cache=alg::FFTPlanCache::Instance();
+  cache.Clear();
+  BOOST_CHECK_EQUAL(cache.GetPlanCount(), size_t(0));
+
+  ImageHandle im=CreateImage(Size(12,10,6));
+  im.ApplyIP(alg::Randomize());
+  ImageHandle ref=im.Apply(alg::FFT());
+  size_t plan_count=cache.GetPlanCount();
+  // one plan per alignment of the arrays at most. Plans for different
+  // alignments give the same result up to rounding errors.
+  BOOST_CHECK(plan_count>=1 && plan_count<=2);
+  for (int i=0; i<5; ++i) {
+    ImageHandle ft=im.Apply(alg::FFT());
+    for(ExtentIterator it(ft.GetExtent());!it.AtEnd();++it) {
+      BOOST_REQUIRE(std::abs(ft.GetComplex(it)-ref.GetComplex(it))<1e-3);
+    }
+  }
+  BOOST_CHECK(cache.GetPlanCount()<=2);
+
+  // plans created with MEASURE give the same result up to rounding errors
+  cache.SetPlannerMode(alg::FFTPlanCache::MEASURE);
+  BOOST_CHECK(cache.GetPlannerMode()==alg::FFTPlanCache::MEASURE);
+  ImageHandle ft=im.Apply(alg::FFT());
+  for(ExtentIterator it(ft.GetExtent());!it.AtEnd();++it) {
+    BOOST_CHECK(std::abs(ft.GetComplex(it)-ref.GetComplex(it))<1e-3);
+  }
+  ImageHandle back=ft.Apply(alg::FFT());
+  for(ExtentIterator it(im.GetExtent());!it.AtEnd();++it) {
+    BOOST_CHECK(std::abs(back.GetReal(it)-im.GetReal(it))<1e-4);
+  }
+  cache.SetPlannerMode(alg::FFTPlanCache::ESTIMATE);
+
+  String wisdom_file="test_fft_plan_cache.wisdom";
+  cache.SaveWisdom(wisdom_file);
+  BOOST_CHECK(cache.LoadWisdom(wisdom_file));
+  BOOST_CHECK(!cache.LoadWisdom("non_existing_dir/fftw.wisdom"));
+  std::remove(wisdom_file.c_str());
+
+  cache.Clear();
+  BOOST_CHECK_EQUAL(cache.GetPlanCount(), size_t(0));
+  ft=im.Apply(alg::FFT());
+  for(ExtentIterator it(ft.GetExtent());!it.AtEnd();++it) {
+    BOOST_REQUIRE(std::abs(ft.GetComplex(it)-ref.GetComplex(it))<1e-3);
+  }
+}
 
 } // namespace 
 
@@ -519,6 +568,7 @@ test_suite* CreateFFTTest()
   ts->add(BOOST_TEST_CASE(&Test_Sampling));
   ts->add(BOOST_TEST_CASE(&Test_Invalid));
   ts->add(BOOST_TEST_CASE(&Test_Memalloc));
+  ts->add(BOOST_TEST_CASE(&Test_PlanCache));
 
   return ts;
 }
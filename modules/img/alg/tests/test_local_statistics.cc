@@ -0,0 +1,175 @@
+//------------------------------------------------------------------------------
+// This file is part of the OpenStructure project <www.openstructure.org>
+//
+// Copyright (C) 2008-2020 by the OpenStructure authors
+// Copyright (C) 2003-2010 by the IPLT authors
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 3.0 of the License, or (at your option)
+// any later version.
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//------------------------------------------------------------------------------
+
+#include <cmath>
+
+#include "tests.hh"
+
+#include <ost/img/image.hh>
+#include <ost/img/image_state.hh>
+#include <ost/img/alg/local_statistics.hh>
+#include <ost/img/alg/local_sigma_threshold.hh>
+#include <ost/img/alg/local_normalize.hh>
+#include <ost/img/alg/local_correlation.hh>
+
+namespace test_local_statistics {
+
+using namespace ost::img;
+using namespace ost::img::alg;
+
+std::vector<Real> window_values(const ConstImageHandle& im, const Extent& window)
+{
+  std::vector<Real> values;
+  for(ExtentIterator it(window);!it.AtEnd();++it) {
+    if(im.GetExtent().Contains(it)) {
+      values.push_back(im.GetReal(it));
+    }
+  }
+  return values;
+}
+
+void test_statistics()
+{
+  Extent extent(Point(-2,1,3),Point(4,5,8));
+  // the large offset tests the numerical stability of the variance
+  ImageHandle im=MakeTestImage(extent,1000.0);
+  RealSpatialImageState* is=dynamic_cast<RealSpatialImageState*>(im.ImageStatePtr().get());
+  BOOST_REQUIRE(is);
+  LocalStatistics stat(*is);
+  std::vector<Real> values=GetRealValues(*is);
+  SummedAreaTable table(extent,values);
+  Extent windows[]={Extent(Point(-2,1,3),Point(4,5,8)),
+                    Extent(Point(0,2,4),Point(1,4,4)),
+                    Extent(Point(3,3,3),Point(3,3,3)),
+                    Extent(Point(-5,-5,-5),Point(0,2,4)),
+                    Extent(Point(2,4,6),Point(9,9,9)),
+                    Extent(Point(10,10,10),Point(12,12,12))};
+  for(int i=0;i<6;++i) {
+    std::vector<Real> v=window_values(im,windows[i]);
+    Real sum=0.0, sum2=0.0;
+    for(size_t k=0;k<v.size();++k) {
+      sum+=v[k];
+    }
+    Real mean=v.empty() ? 0.0 : sum/v.size();
+    for(size_t k=0;k<v.size();++k) {
+      sum2+=(v[k]-mean)*(v[k]-mean);
+    }
+    Real var=v.empty() ? 0.0 : sum2/v.size();
+    BOOST_CHECK_EQUAL(stat.GetCount(windows[i]),static_cast<int>(v.size()));
+    BOOST_CHECK_CLOSE(table.GetSum(windows[i])+1.0,sum+1.0,Real(1e-4));
+    BOOST_CHECK_CLOSE(stat.GetMean(windows[i])+1.0,mean+1.0,Real(1e-4));
+    BOOST_CHECK_SMALL(stat.GetVariance(windows[i])-var,Real(1e-4));
+  }
+  BOOST_CHECK_THROW(SummedAreaTable(extent,std::vector<Real>(3)),ost::Error);
+}
+
+void test_min_max()
+{
+  Extent extent(Point(1,-1,0),Point(9,6,4));
+  ImageHandle im=MakeTestImage(extent,1000.0);
+  std::vector<Real> values;
+  for(int u=1;u<=9;++u) {
+    for(int v=-1;v<=6;++v) {
+      for(int w=0;w<=4;++w) {
+        values.push_back(im.GetReal(Point(u,v,w)));
+      }
+    }
+  }
+  Point radii[]={Point(0,0,0),Point(1,2,0),Point(3,1,2),Point(20,20,20)};
+  for(int r=0;r<4;++r) {
+    LocalMinMax minmax(extent,values,radii[r]);
+    for(ExtentIterator it(extent);!it.AtEnd();++it) {
+      std::vector<Real> v=window_values(im,LocalWindow(it,radii[r]));
+      BOOST_CHECK_EQUAL(minmax.GetMinimum(it),*std::min_element(v.begin(),v.end()));
+      BOOST_CHECK_EQUAL(minmax.GetMaximum(it),*std::max_element(v.begin(),v.end()));
+    }
+  }
+  LocalMinMax minmax(extent,values,Point(1,1,1));
+  BOOST_CHECK_THROW(minmax.GetMinimum(Point(0,0,0)),ost::Error);
+}
+
+void test_filters()
+{
+  Extent extent(Point(0,0),Size(12,9));
+  ImageHandle im=MakeTestImage(extent,1000.0);
+  int size=2;
+
+  // brute force version of the threshold
+  ImageHandle thres=im.Apply(LocalSigmaThreshold(size,0.3));
+  BOOST_CHECK(thres.GetExtent()==Extent(Point(size,size),Point(12-1-size,9-1-size)));
+  for(ExtentIterator it(thres.GetExtent());!it.AtEnd();++it) {
+    std::vector<Real> v=window_values(im,LocalWindow(it,Point(size,size)));
+    Real sum=0.0, sum2=0.0;
+    for(size_t k=0;k<v.size();++k) {
+      sum+=v[k]-1000.0;
+      sum2+=(v[k]-1000.0)*(v[k]-1000.0);
+    }
+    Real mean=sum/v.size();
+    Real var=sum2/v.size()-mean*mean;
+    BOOST_CHECK_EQUAL(thres.GetReal(it),var>0.09 ? 1.0 : 0.0);
+  }
+
+  ImageHandle norm=im.Apply(LocalNormalize(size));
+  BOOST_CHECK(norm.GetExtent()==extent);
+  for(ExtentIterator it(extent);!it.AtEnd();++it) {
+    std::vector<Real> v=window_values(im,LocalWindow(it,Point(size,size)));
+    Real mean=0.0, var=0.0;
+    for(size_t k=0;k<v.size();++k) {
+      mean+=v[k];
+    }
+    mean/=v.size();
+    for(size_t k=0;k<v.size();++k) {
+      var+=(v[k]-mean)*(v[k]-mean);
+    }
+    var/=v.size();
+    BOOST_CHECK_SMALL(norm.GetReal(it)-(im.GetReal(it)-mean)/std::sqrt(var),
+                      Real(1e-3));
+  }
+
+  // perfect (anti-)correlation, independent of offset and scale
+  ImageHandle other=im.Copy();
+  other*=-2.0;
+  other+=5.0;
+  ImageHandle corr=im.Apply(LocalCorrelation(im,1));
+  ImageHandle anti=im.Apply(LocalCorrelation(other,1));
+  for(ExtentIterator it(extent);!it.AtEnd();++it) {
+    BOOST_CHECK_CLOSE(corr.GetReal(it),Real(1.0),Real(1e-2));
+    BOOST_CHECK_CLOSE(anti.GetReal(it),Real(-1.0),Real(1e-2));
+  }
+  ImageHandle flat=CreateImage(extent);
+  corr=im.Apply(LocalCorrelation(flat,1));
+  BOOST_CHECK_EQUAL(corr.GetReal(Point(3,3)),Real(0.0));
+  BOOST_CHECK_THROW(im.Apply(LocalCorrelation(CreateImage(Extent(Size(3,3))),1)),
+                    ost::Error);
+}
+
+} // namespace
+
+test_suite* CreateLocalStatisticsTest()
+{
+  using namespace test_local_statistics;
+  test_suite* ts=BOOST_TEST_SUITE("Local Statistics Test");
+
+  ts->add(BOOST_TEST_CASE(&test_statistics));
+  ts->add(BOOST_TEST_CASE(&test_min_max));
+  ts->add(BOOST_TEST_CASE(&test_filters));
+
+  return ts;
+}
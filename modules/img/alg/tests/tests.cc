@@ -42,6 +42,7 @@ extern test_suite* CreateFFTTest();
 extern test_suite* CreateNegateTest();
 extern test_suite* CreateConjugateTest();
 extern test_suite* CreateNormalizerTest();
+extern test_suite* CreateLocalStatisticsTest();
 
 bool init_ost_img_alg_unit_tests() {
   try {
@@ -56,6 +57,7 @@ bool init_ost_img_alg_unit_tests() {
     framework::master_test_suite().add(CreateNegateTest());
     framework::master_test_suite().add(CreateFFTTest());          
     framework::master_test_suite().add(CreateNormalizerTest());          
+    framework::master_test_suite().add(CreateLocalStatisticsTest());
   } catch(std::exception& e) {
     return false;
   }
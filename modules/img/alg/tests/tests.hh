@@ -22,6 +22,22 @@
   Author: Ansgar Philippsen
 */
 
+#include <cmath>
+
 #define BOOST_TEST_DYN_LINK
 #include <boost/test/unit_test.hpp>
+#include <ost/img/image.hh>
 using boost::unit_test_framework::test_suite;
+
+// image with irregular but reproducible values, shifted by offset
+inline ost::img::ImageHandle MakeTestImage(const ost::img::Extent& extent,
+                                           Real offset=0.0)
+{
+  ost::img::ImageHandle im=ost::img::CreateImage(extent);
+  for(ost::img::ExtentIterator it(extent);!it.AtEnd();++it) {
+    ost::img::Point p(it);
+    im.SetReal(p,offset+std::sin(p[0]*1.3+p[1]*p[1]*0.7)*std::cos(p[2]*2.1+p[0]*0.4)
+                 +0.1*((p[0]*7+p[1]*13+p[2]*29)%11));
+  }
+  return im;
+}
@@ -62,6 +62,22 @@ def _override(val1, val2):
   else:
     return val1
 
+def _LoadCached(filename, settings, load):
+  """
+  Returns the entity cached for *filename* and *settings* or calls *load* and
+  stores its result in the :class:`EntityCache`, if the cache is enabled.
+  """
+  cache=EntityCache.Instance()
+  if not cache.IsEnabled():
+    return load()
+  key=cache.GetKey(filename, settings)
+  ent=cache.Load(key)
+  if ent.IsValid():
+    return ent
+  ent=load()
+  cache.Store(key, ent)
+  return ent
+
 def LoadPDB(filename, restrict_chains="", no_hetatms=None,
             fault_tolerant=None, load_multi=False, quack_mode=None,
             join_spread_atom_records=None, calpha_only=None,
@@ -170,16 +186,20 @@ def LoadPDB(filename, restrict_chains="", no_hetatms=None,
         raise IOError("File '%s' doesn't contain any entities" % filename)
       return ent_list
     else:
-      ent=mol.CreateEntity()
-      if reader.HasNext():
-        reader.Import(ent, restrict_chains)
-        if prof.processor:
-          prof.processor.Process(ent)
-      else:
-        raise IOError("File '%s' doesn't contain any entities" % filename)
+      def _Load():
+        ent=mol.CreateEntity()
+        if reader.HasNext():
+          reader.Import(ent, restrict_chains)
+          if prof.processor:
+            prof.processor.Process(ent)
+        else:
+          raise IOError("File '%s' doesn't contain any entities" % filename)
+        return ent
       if seqres:
-        return ent, reader.seqres
-      return ent
+        return _Load(), reader.seqres
+      settings="LoadPDB(restrict_chains='%s', profile=%s)" % (restrict_chains,
+                                                            prof)
+      return _LoadCached(filename, settings, _Load)
   except:
     raise
 
@@ -241,7 +261,8 @@ LoadMapList=LoadImageList
 
 def LoadCHARMMTraj(crd, dcd_file=None, profile='CHARMM',
                    lazy_load=False, stride=1, 
-                   dialect=None, detect_swap=True,swap_bytes=False):
+                   dialect=None, detect_swap=True,swap_bytes=False,
+                   memory_map=False, cache_size=16):
   """
   Load CHARMM trajectory file.
   
@@ -264,6 +285,12 @@ def LoadCHARMMTraj(crd, dcd_file=None, profile='CHARMM',
       is attempted, otherwise the swap_bytes parameter is used
   :param swap_bytes: is detect_swap is False, this flag determines whether bytes
       are swapped upon loading or not
+  :param memory_map: Whether the trajectory file should be memory-mapped. The 
+      frames are then read directly from the mapped file in random order, which 
+      allows to analyse trajectories that do not fit into memory. Implies lazy 
+      loading.
+  :param cache_size: The number of converted frames kept in memory when 
+      *memory_map* is True.
   """
   if not isinstance(crd, mol.EntityHandle):
     if dcd_file==None:
@@ -273,6 +300,9 @@ def LoadCHARMMTraj(crd, dcd_file=None, profile='CHARMM',
   else:
     if not dcd_file:
       raise ValueError("No DCD filename given")
+  if memory_map:
+    return LoadCHARMMTrajMapped_(crd, dcd_file, stride, cache_size, detect_swap,
+                                 swap_bytes)
   return LoadCHARMMTraj_(crd, dcd_file, stride, lazy_load, detect_swap, swap_bytes)
 
 def LoadMMCIF(filename, fault_tolerant=None, calpha_only=None, profile='DEFAULT', remote=False, seqres=False, info=False):
@@ -326,6 +356,16 @@ def LoadMMCIF(filename, fault_tolerant=None, calpha_only=None, profile='DEFAULT'
     tmp_file = RemoteGet(filename, from_repo='cif')
     filename = tmp_file.name
   
+  if not (seqres or info):
+    def _Load():
+      ent = mol.CreateEntity()
+      reader = MMCifReader(filename, ent, prof)
+      reader.Parse()
+      if prof.processor:
+        prof.processor.Process(ent)
+      return ent
+    return _LoadCached(filename, "LoadMMCIF(profile=%s)" % prof, _Load)
+
   try:
     ent = mol.CreateEntity()
     reader = MMCifReader(filename, ent, prof)
@@ -122,6 +122,10 @@ void export_map_io()
     .def("GetSubformat", &MRC::GetSubformat)
     .def("SetEndianessOnSave", &MRC::SetEndianessOnSave)
     .def("GetEndianessOnSave", &MRC::GetEndianessOnSave)
+    .def("SetSubExtent", &MRC::SetSubExtent)
+    .def("GetSubExtent", &MRC::GetSubExtent)
+    .def("HasSubExtent", &MRC::HasSubExtent)
+    .def("ClearSubExtent", &MRC::ClearSubExtent)
   ;
 
   class_<CCP4, bases<MRC> >("CCP4", init<bool,Endianess,Format>
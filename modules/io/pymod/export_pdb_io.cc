@@ -20,6 +20,7 @@
 using namespace boost::python;
 
 #include <ost/io/mol/io_profile.hh>
+#include <ost/io/mol/entity_cache.hh>
 #include <ost/io/mol/pdb_reader.hh>
 #include <ost/io/mol/pdb_writer.hh>
 #include <ost/io/mol/pdb_str.hh>
@@ -74,6 +75,25 @@ void export_pdb_io()
     .def("GetDefault", &IOProfileRegistry::GetDefault,
          return_internal_reference<>())
   ;
+  class_<EntityCache, boost::noncopyable>("EntityCache", no_init)
+    .def("Instance", &EntityCache::Instance,
+         return_value_policy<reference_existing_object>()).staticmethod("Instance")
+    .def("SetDirectory", &EntityCache::SetDirectory)
+    .def("GetDirectory", &EntityCache::GetDirectory)
+    .add_property("directory", &EntityCache::GetDirectory,
+                  &EntityCache::SetDirectory)
+    .def("IsEnabled", &EntityCache::IsEnabled)
+    .def("GetKey", &EntityCache::GetKey, (arg("filename"), arg("settings")))
+    .def("Load", &EntityCache::Load, (arg("key")))
+    .def("Store", &EntityCache::Store, (arg("key"), arg("ent")))
+    .def("Clear", &EntityCache::Clear)
+    .def("GetHitCount", &EntityCache::GetHitCount)
+    .def("GetMissCount", &EntityCache::GetMissCount)
+    .add_property("hit_count", &EntityCache::GetHitCount)
+    .add_property("miss_count", &EntityCache::GetMissCount)
+    .def("ResetStatistics", &EntityCache::ResetStatistics)
+  ;
+  def("GetCacheSettings", &GetCacheSettings, (arg("profile")));
   class_<PDBReader, boost::noncopyable>("PDBReader", init<String, const IOProfile&>())
     .def("HasNext", &PDBReader::HasNext)
     .def("Import", &PDBReader::Import, 
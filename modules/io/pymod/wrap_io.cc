@@ -121,6 +121,9 @@ BOOST_PYTHON_MODULE(_ost_io)
                                            arg("stride")=1, arg("lazy_load")=false,
                                            arg("detect_swap")=true,arg("swap_bytes")=false))
 ;
+  def("LoadCHARMMTrajMapped_", &LoadCHARMMTrajMapped,
+      (arg("ent"), arg("trj_filename"), arg("stride")=1, arg("cache_size")=16,
+       arg("detect_swap")=true, arg("swap_bytes")=false));
   def("LoadMAE", &LoadMAE);
   def("LoadPQR", &LoadPQR);
 
@@ -55,6 +55,8 @@ u v w x . . .     d*c*b*a b c d   3
 */
 
 #include <cstdio>
+#include <cstring>
+#include <vector>
 #include <iostream>
 #include <sstream>
 #include <streambuf>
@@ -99,7 +101,9 @@ MRC::MRC(bool normalize_on_save, Subformat subformat,Endianess endianess_on_save
   subformat_(subformat),
   normalize_on_save_(normalize_on_save),
   endianess_on_save_(endianess_on_save),
-  bit_depth_(bit_depth)
+  bit_depth_(bit_depth),
+  sub_extent_(),
+  has_sub_extent_(false)
 {
 }
 Format MRC::GetBitDepth() const
@@ -133,6 +137,28 @@ void MRC::SetSubformat(Subformat subf)
   subformat_ = subf;
 }
 
+void MRC::SetSubExtent(const img::Extent& extent)
+{
+  sub_extent_ = extent;
+  has_sub_extent_ = true;
+}
+
+img::Extent MRC::GetSubExtent() const
+{
+  return sub_extent_;
+}
+
+bool MRC::HasSubExtent() const
+{
+  return has_sub_extent_;
+}
+
+void MRC::ClearSubExtent()
+{
+  sub_extent_ = img::Extent();
+  has_sub_extent_ = false;
+}
+
 bool MRC::GetNormalizeOnSave() const
 {
   return normalize_on_save_;
@@ -619,6 +645,70 @@ using namespace ost::img;
 using namespace ost;
 
 
+// byte swapping on integers of the value size, which compilers turn into
+// vectorized shuffles
+template <int SIZE>
+struct byte_swapper {
+  static void Swap(char* data, size_t count) {}
+};
+
+template <>
+struct byte_swapper<2> {
+  static void Swap(char* data, size_t count)
+  {
+    for (size_t i=0; i<count; ++i) {
+      uint16_t v;
+      memcpy(&v, data+2*i, 2);
+      v=static_cast<uint16_t>((v>>8) | (v<<8));
+      memcpy(data+2*i, &v, 2);
+    }
+  }
+};
+
+template <>
+struct byte_swapper<4> {
+  static void Swap(char* data, size_t count)
+  {
+    for (size_t i=0; i<count; ++i) {
+      uint32_t v;
+      memcpy(&v, data+4*i, 4);
+      v=(v>>24) | ((v>>8) & 0xff00) | ((v<<8) & 0xff0000) | (v<<24);
+      memcpy(data+4*i, &v, 4);
+    }
+  }
+};
+
+// reads count values in one go and converts them to the local byte order
+template <typename B,int CONVERSIONTYPE>
+void read_values(BinaryIStream<CONVERSIONTYPE>& f, B* values, size_t count)
+{
+  f.read(reinterpret_cast<char*>(values), count*sizeof(B));
+  if (CONVERSIONTYPE==OST_VAX_DATA) {
+    for (size_t i=0; i<count; ++i) {
+      Convert<CONVERSIONTYPE,B>::FromIP(&values[i]);
+    }
+  } else if (CONVERSIONTYPE!=OST_LOCAL_ENDIAN) {
+    byte_swapper<sizeof(B)>::Swap(reinterpret_cast<char*>(values), count);
+  }
+}
+
+// skips count bytes. Compressed streams can not seek, their data is read
+// and discarded instead.
+inline void skip_bytes(std::istream& f, size_t count, bool seekable)
+{
+  if (count==0) {
+    return;
+  }
+  if (seekable) {
+    f.seekg(count, std::ios::cur);
+  } else {
+    f.ignore(count);
+  }
+}
+
+// Reads the part of the data that falls into the extent of the image. Only
+// the rows of a section that are needed are read, everything else is skipped.
+// Values are converted in bulk and written to the image data directly.
 template <typename B,int CONVERSIONTYPE>
 void real_filler(img::image_state::RealSpatialImageState& isi,
                  BinaryIStream<CONVERSIONTYPE>& f,
@@ -628,21 +718,55 @@ void real_filler(img::image_state::RealSpatialImageState& isi,
   int mapr=header.mapr-1;
   int maps=header.maps-1;
 
-  img::Point pnt;
+  img::Extent extent=isi.GetExtent();
+  img::Size size=extent.GetSize();
+  int c0=extent.GetStart()[mapc]-header.ncstart;
+  int r0=extent.GetStart()[mapr]-header.nrstart;
+  int s0=extent.GetStart()[maps]-header.nsstart;
+  int nc=size[mapc], nr=size[mapr], ns=size[maps];
+
+  // offsets between neighbouring voxels of the image data along x, y and z
+  Real* origin=&isi.Value(img::Index(0,0,0));
+  std::ptrdiff_t stride[3]={0,0,0};
+  if (size[0]>1) stride[0]=&isi.Value(img::Index(1,0,0))-origin;
+  if (size[1]>1) stride[1]=&isi.Value(img::Index(0,1,0))-origin;
+  if (size[2]>1) stride[2]=&isi.Value(img::Index(0,0,1))-origin;
+  std::ptrdiff_t stride_c=stride[mapc];
+  std::ptrdiff_t stride_r=stride[mapr];
+  std::ptrdiff_t stride_s=stride[maps];
+
+  size_t section_size=static_cast<size_t>(header.nr)*header.nc;
+  std::vector<B> buffer(static_cast<size_t>(nr)*header.nc);
+  // position in the data block, counted in values
+  size_t pos=0;
+  bool seekable=f.tellg()!=std::streampos(-1);
+  f.clear();
   char this_dummy; //create dummy variable to give to img::Progress as this
-  img::Progress::Instance().Register(&this_dummy,header.ns*header.nr,100);
-  for(int is=0;is<header.ns;++is) {
-    pnt[maps]=header.nsstart+is;
-    std::vector<B> buffer(header.nr*header.nc);
-    f.read(&buffer[0],header.nr*header.nc);
-    for(int ir=0;ir<header.nr;++ir) {
-      pnt[mapr]=header.nrstart+ir;
-      for(int ic=0;ic<header.nc;++ic) {
-        pnt[mapc]=header.ncstart+ic;
-        isi.Value(pnt) = img::Val2Val<B,Real>(buffer[header.nc*ir+ic]);
+  img::Progress::Instance().Register(&this_dummy,ns,100);
+  for(int is=0;is<ns;++is) {
+    size_t first=(s0+is)*section_size+static_cast<size_t>(r0)*header.nc;
+    skip_bytes(f, (first-pos)*sizeof(B), seekable);
+    read_values(f, &buffer[0], buffer.size());
+    if (!f) {
+      img::Progress::Instance().DeRegister(&this_dummy);
+      throw IOException("MRC/CCP4 import: unexpected end of file");
+    }
+    pos=first+buffer.size();
+    Real* section=origin+is*stride_s;
+    for(int ir=0;ir<nr;++ir) {
+      const B* src=&buffer[static_cast<size_t>(ir)*header.nc+c0];
+      Real* dst=section+ir*stride_r;
+      if (stride_c==1) {
+        for(int ic=0;ic<nc;++ic) {
+          dst[ic]=img::Val2Val<B,Real>(src[ic]);
+        }
+      } else {
+        for(int ic=0;ic<nc;++ic) {
+          dst[ic*stride_c]=img::Val2Val<B,Real>(src[ic]);
+        }
       }
-      img::Progress::Instance().AdvanceProgress(&this_dummy);
     }
+    img::Progress::Instance().AdvanceProgress(&this_dummy);
   }
   img::Progress::Instance().DeRegister(&this_dummy);
 }
@@ -830,6 +954,9 @@ void import_helper(img::MapHandle& image, std::istream& in,const MRC& formatmrc)
     header.Print();
   }
   if(header.mode==3 || header.mode==4) {
+    if (formatmrc.HasSubExtent()) {
+      throw IOException("MRC/CCP4 import: sub extents are only supported for real maps");
+    }
     // always assume half-complex mode
     image.Reset(img::Size(header.nx,header.ny,header.nz),img::COMPLEX,img::HALF_FREQUENCY);
     if(img::image_state::ComplexHalfFrequencyImageState *cs=dynamic_cast<img::image_state::ComplexHalfFrequencyImageState*>(image.ImageStatePtr().get())) {
@@ -841,7 +968,7 @@ void import_helper(img::MapHandle& image, std::istream& in,const MRC& formatmrc)
     } else {
       throw IOException("internal error in MRC io: expected ComplexHalfFrequencyImageState");
     }
-  } else if (header.mode==0 || header.mode==2 || header.mode==5 || header.mode==6 || header.mode==7) {
+  } else if (header.mode==0 || header.mode==1 || header.mode==2 || header.mode==6 || header.mode==7) {
     img::Size msize;
     msize[header.mapc-1]=header.nc;
     msize[header.mapr-1]=header.nr;
@@ -850,7 +977,14 @@ void import_helper(img::MapHandle& image, std::istream& in,const MRC& formatmrc)
     mstart[header.mapc-1]=header.ncstart;
     mstart[header.mapr-1]=header.nrstart;
     mstart[header.maps-1]=header.nsstart;
-    image.Reset(img::Extent(mstart,msize),img::REAL,img::SPATIAL);
+    img::Extent extent(mstart,msize);
+    if (formatmrc.HasSubExtent()) {
+      if (!img::HasOverlap(extent,formatmrc.GetSubExtent())) {
+        throw IOException("MRC/CCP4 import: sub extent does not overlap with the map");
+      }
+      extent=img::Overlap(extent,formatmrc.GetSubExtent());
+    }
+    image.Reset(extent,img::REAL,img::SPATIAL);
     if(header.x>0.0 && header.y >0.0 && header.z > 0){
       image.SetSpatialSampling(geom::Vec3(static_cast<Real>(header.x)/static_cast<Real>(header.nx),
                                           static_cast<Real>(header.y)/static_cast<Real>(header.ny),
@@ -978,10 +1112,19 @@ void MapIOMrcHandler::Import(img::MapHandle& sh, const boost::filesystem::path&
   {
     throw IOException("could not open "+loc.string());
   }
-  boost::iostreams::filtering_stream<boost::iostreams::input> in;
-  if (detail::FilenameEndsWith(loc.string(),".map.gz")) {
-    in.push(boost::iostreams::gzip_decompressor());
+  is_file_=true;
+  filename_=loc.string();
+  if (!detail::FilenameEndsWith(loc.string(),".map.gz")) {
+    // plain files are read directly, which allows to seek over the parts of
+    // the data outside of a sub extent
+    infile.read(reinterpret_cast<char*>(&header_),256);
+    infile.seekg(0,std::ios::beg);
+    this->Import(sh,infile,formatstruct);
+    infile.close();
+    return;
   }
+  boost::iostreams::filtering_stream<boost::iostreams::input> in;
+  in.push(boost::iostreams::gzip_decompressor());
   in.push(infile);
   in.read(reinterpret_cast<char*>(&header_),256);
   // seekg does not work on compressed streams
@@ -995,8 +1138,6 @@ void MapIOMrcHandler::Import(img::MapHandle& sh, const boost::filesystem::path&
     throw IOException("could not open "+loc.string());
   }
   in.push(infile2);
-  is_file_=true;
-  filename_=loc.string();
   this->Import(sh,in,formatstruct);
   infile2.close();
 }
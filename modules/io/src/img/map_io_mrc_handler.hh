@@ -20,6 +20,7 @@
 #ifndef OST_IO_MAP_IO_MRC_HANDLER_HH
 #define OST_IO_MAP_IO_MRC_HANDLER_HH
 
+#include <ost/img/extent.hh>
 #include "map_io_handler.hh"
 
 namespace ost { namespace io {
@@ -42,6 +43,16 @@ class DLLEXPORT_OST_IO MRC: public ImageFormatBase
   Subformat GetSubformat() const;
   void SetSubformat(Subformat subformat);
 
+  /// \brief only load the part of the map that lies within extent
+  ///
+  /// Sections and rows outside of the extent are skipped while reading, so
+  /// the memory needed is bound by the size of the sub extent. Only
+  /// supported for real maps.
+  void SetSubExtent(const img::Extent& extent);
+  img::Extent GetSubExtent() const;
+  bool HasSubExtent() const;
+  void ClearSubExtent();
+
   static String FORMAT_STRING;
 
  private:
@@ -50,6 +61,8 @@ class DLLEXPORT_OST_IO MRC: public ImageFormatBase
   bool normalize_on_save_;
   Endianess endianess_on_save_;
   Format bit_depth_;
+  img::Extent sub_extent_;
+  bool has_sub_extent_;
 };
 
 class DLLEXPORT_OST_IO CCP4: public MRC
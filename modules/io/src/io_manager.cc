@@ -22,6 +22,7 @@
 #include <ost/io/mol/entity_io_sdf_handler.hh>
 #include <ost/io/mol/entity_io_mae_handler.hh>
 #include <ost/io/mol/entity_io_mmcif_handler.hh>
+#include <ost/io/mol/entity_io_binary_handler.hh>
 #include <ost/io/seq/fasta_io_handler.hh>
 #include <ost/io/seq/pir_io_handler.hh>
 #include <ost/io/seq/promod_io_handler.hh>
@@ -52,6 +53,7 @@ IOManager::IOManager()
   RegisterFactory(EntityIOHandlerFactoryBaseP(new EntityIOCRDHandlerFactory));
   RegisterFactory(EntityIOHandlerFactoryBaseP(new EntityIOSDFHandlerFactory));
   RegisterFactory(EntityIOHandlerFactoryBaseP(new EntityIOMAEHandlerFactory));
+  RegisterFactory(EntityIOHandlerFactoryBaseP(new EntityIOBinaryHandlerFactory));
   RegisterFactory(SequenceIOHandlerFactoryBasePtr(new FastaIOHandlerFactory));
   RegisterFactory(SequenceIOHandlerFactoryBasePtr(new PirIOHandlerFactory));
   RegisterFactory(SequenceIOHandlerFactoryBasePtr(new ClustalIOHandlerFactory));
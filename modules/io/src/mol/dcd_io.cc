@@ -23,6 +23,7 @@
 
 #include <fstream>
 #include <algorithm>
+#include <cstring>
 
 #include <boost/iostreams/filter/gzip.hpp>
 #include <boost/filesystem/convenience.hpp>
@@ -377,6 +378,164 @@ typedef boost::shared_ptr<DCDCoordSource> DCDCoordSourcePtr;
 
 } // anon ns
 
+DCDMappedCoordSource::DCDMappedCoordSource(const mol::AtomHandleList& atoms,
+                                           const String& filename,
+                                           uint stride, uint cache_size,
+                                           bool detect_swap, bool byte_swap):
+  mol::CoordSource(atoms), atom_count_(0), ucell_flag_(false),
+  swap_flag_(false), frame_start_(0), frame_size_(0), frame_count_(0),
+  stride_(std::max(stride, uint(1))), cache_size_(cache_size)
+{
+  this->SetMutable(false);
+  std::ifstream stream(filename.c_str(), std::ios::binary);
+  if (!stream) {
+    std::ostringstream msg;
+    msg << "LoadCHARMMTraj: cannot open " << filename;
+    throw IOException(msg.str());
+  }
+  DCDHeader header;
+  bool gap_flag=false;
+  if (!read_dcd_header(stream, header, swap_flag_, ucell_flag_, gap_flag,
+                       detect_swap, byte_swap) || !stream) {
+    throw IOException("LoadCHARMMTraj: premature end of file in header");
+  }
+  if (atoms.size()!=static_cast<size_t>(header.t_atom_count)) {
+    LOG_ERROR("LoadCHARMMTraj: atom count missmatch: " << atoms.size() 
+               << " in coordinate file, " << header.t_atom_count 
+               << " in each traj frame");
+    throw IOException("invalid trajectory");
+  }
+  frame_start_=stream.tellg();
+  stream.close();
+  atom_count_=header.t_atom_count;
+  frame_size_=calc_frame_size(ucell_flag_, gap_flag, atom_count_);
+  try {
+    file_.open(filename);
+  } catch (std::exception& e) {
+    std::ostringstream msg;
+    msg << "LoadCHARMMTraj: cannot map " << filename << ": " << e.what();
+    throw IOException(msg.str());
+  }
+  // the number of frames in the header is not reliable for trajectories that
+  // are still being written, hence it is derived from the file size.
+  size_t available=0;
+  if (file_.size()>frame_start_) {
+    available=(file_.size()-frame_start_)/frame_size_;
+  }
+  if (available!=static_cast<size_t>(header.num)) {
+    LOG_VERBOSE("LoadCHARMMTraj: header claims " << header.num 
+                << " frames, file contains " << available);
+  }
+  frame_count_=(available+stride_-1)/stride_;
+  LOG_VERBOSE("LoadCHARMMTraj: mapped " << frame_count_ << " frames with "
+              << atom_count_ << " atoms each");
+}
+
+const char* DCDMappedCoordSource::FrameData(uint frame_id) const
+{
+  if (frame_id>=frame_count_) {
+    std::ostringstream msg;
+    msg << "LoadCHARMMTraj: frame index " << frame_id << " out of range";
+    throw IOException(msg.str());
+  }
+  return file_.data()+frame_start_+size_t(frame_id)*stride_*frame_size_;
+}
+
+DCDFrameView DCDMappedCoordSource::GetFrameView(uint frame_id) const
+{
+  if (swap_flag_) {
+    throw IOException("LoadCHARMMTraj: frame views are not available for "
+                      "byte-swapped trajectories");
+  }
+  // each coordinate block is bracketed by 4 byte record markers, the
+  // unit cell block is 6 doubles plus its markers.
+  const char* data=this->FrameData(frame_id)+(ucell_flag_ ? 56 : 0);
+  size_t block_size=sizeof(float)*atom_count_+2*sizeof(int);
+  DCDFrameView view;
+  view.x=reinterpret_cast<const float*>(data+sizeof(int));
+  view.y=reinterpret_cast<const float*>(data+block_size+sizeof(int));
+  view.z=reinterpret_cast<const float*>(data+2*block_size+sizeof(int));
+  view.count=atom_count_;
+  return view;
+}
+
+void DCDMappedCoordSource::GetFrameCell(uint frame_id, geom::Vec3& cell_size,
+                                        geom::Vec3& cell_angles) const
+{
+  const char* data=this->FrameData(frame_id);
+  if (!ucell_flag_) {
+    cell_size=geom::Vec3();
+    cell_angles=geom::Vec3();
+    return;
+  }
+  double tmp[6];
+  memcpy(tmp, data+sizeof(int), sizeof(double)*6);
+  if (swap_flag_) swap_double(tmp, 6);
+  // a,alpha,b,beta,gamma,c (don't ask)
+  cell_size=geom::Vec3(tmp[0], tmp[2], tmp[5]);
+  cell_angles=geom::Vec3(acos(tmp[1]), acos(tmp[3]), acos(tmp[4]));
+}
+
+mol::CoordFramePtr DCDMappedCoordSource::ConvertFrame(uint frame_id) const
+{
+  mol::CoordFramePtr frame(new mol::CoordFrame(atom_count_));
+  geom::Vec3 cell_size, cell_angles;
+  this->GetFrameCell(frame_id, cell_size, cell_angles);
+  frame->SetCellSize(cell_size);
+  frame->SetCellAngles(cell_angles);
+  const char* data=this->FrameData(frame_id)+(ucell_flag_ ? 56 : 0);
+  size_t block_size=sizeof(float)*atom_count_+2*sizeof(int);
+  std::vector<float> xlist(atom_count_);
+  for (int k=0; k<3; ++k) {
+    if (atom_count_==0) break;
+    memcpy(&xlist[0], data+k*block_size+sizeof(int), 
+           sizeof(float)*atom_count_);
+    if (swap_flag_) swap_float(&xlist[0], atom_count_);
+    for (uint j=0; j<atom_count_; ++j) {
+      (*frame)[j][k]=xlist[j];
+    }
+  }
+  return frame;
+}
+
+mol::CoordFramePtr DCDMappedCoordSource::GetFrame(uint frame_id) const
+{
+  if (cache_size_==0) {
+    return this->ConvertFrame(frame_id);
+  }
+  {
+    boost::mutex::scoped_lock lock(cache_mutex_);
+    std::map<uint, FrameCache::iterator>::iterator i=cache_index_.find(frame_id);
+    if (i!=cache_index_.end()) {
+      cache_.splice(cache_.begin(), cache_, i->second);
+      return i->second->second;
+    }
+  }
+  // conversion happens outside of the lock, so multiple threads can convert
+  // different frames at the same time.
+  mol::CoordFramePtr frame=this->ConvertFrame(frame_id);
+  boost::mutex::scoped_lock lock(cache_mutex_);
+  if (cache_index_.find(frame_id)==cache_index_.end()) {
+    cache_.push_front(std::make_pair(frame_id, frame));
+    cache_index_[frame_id]=cache_.begin();
+    while (cache_.size()>cache_size_) {
+      cache_index_.erase(cache_.back().first);
+      cache_.pop_back();
+    }
+  }
+  return frame;
+}
+
+void DCDMappedCoordSource::SetCacheSize(uint cache_size)
+{
+  boost::mutex::scoped_lock lock(cache_mutex_);
+  cache_size_=cache_size;
+  while (cache_.size()>cache_size_) {
+    cache_index_.erase(cache_.back().first);
+    cache_.pop_back();
+  }
+}
+
 
 mol::CoordGroupHandle LoadCHARMMTraj(const mol::EntityHandle& ent,
                                      const String& trj_fn,
@@ -396,6 +555,22 @@ mol::CoordGroupHandle LoadCHARMMTraj(const mol::EntityHandle& ent,
   return load_dcd(alist, trj_fn, stride, detect_swap, byte_swap);
 }
 
+mol::CoordGroupHandle LoadCHARMMTrajMapped(const mol::EntityHandle& ent,
+                                           const String& trj_fn,
+                                           unsigned int stride,
+                                           unsigned int cache_size,
+                                           bool detect_swap,
+                                           bool byte_swap)
+{
+  mol::AtomHandleList alist(ent.GetAtomList());
+  std::sort(alist.begin(),alist.end(),less_index);
+  DCDMappedCoordSourcePtr source(new DCDMappedCoordSource(alist, trj_fn, stride,
+                                                          cache_size,
+                                                          detect_swap,
+                                                          byte_swap));
+  return mol::CoordGroupHandle(source);
+}
+
 namespace {
 
 void write_dcd_hdr(std::ofstream& out,
@@ -24,11 +24,91 @@
   Authors: Ansgar Philippsen, Marco Biasini
  */
 
+#include <list>
+#include <map>
+#include <boost/thread/mutex.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
 #include <ost/io/module_config.hh>
 #include <ost/mol/coord_group.hh>
+#include <ost/mol/coord_source.hh>
 #include <ost/io/mol/io_profile.hh>
 namespace ost { namespace io {
 
+/// \brief read-only view of the coordinates of one trajectory frame
+///
+/// The pointers point directly into the memory-mapped trajectory file and stay
+/// valid as long as the coord source they were obtained from is alive.
+struct DLLEXPORT_OST_IO DCDFrameView {
+  DCDFrameView(): x(NULL), y(NULL), z(NULL), count(0) { }
+  const float* x;
+  const float* y;
+  const float* z;
+  uint         count;
+};
+
+/*! \brief memory-mapped CHARMM trajectory
+
+    The frame offsets are calculated from the header once, the frames are then
+    accessed in random order directly from the mapped file without reading the
+    trajectory into memory. Converted frames are kept in a least-recently-used
+    cache of cache_size frames.
+*/
+class DLLEXPORT_OST_IO DCDMappedCoordSource : public mol::CoordSource {
+public:
+  DCDMappedCoordSource(const mol::AtomHandleList& atoms,
+                       const String& filename, uint stride=1,
+                       uint cache_size=16, bool detect_swap=true,
+                       bool byte_swap=false);
+
+  virtual uint GetFrameCount() const { return frame_count_; }
+
+  virtual mol::CoordFramePtr GetFrame(uint frame_id) const;
+
+  /// \brief zero-copy view of the x, y and z coordinates of a frame
+  ///
+  /// Not available for byte-swapped trajectories, since the coordinates would
+  /// have to be converted.
+  DCDFrameView GetFrameView(uint frame_id) const;
+
+  /// \brief unit cell size and angles of the given frame
+  void GetFrameCell(uint frame_id, geom::Vec3& cell_size,
+                    geom::Vec3& cell_angles) const;
+
+  bool IsByteSwapped() const { return swap_flag_; }
+
+  uint GetCacheSize() const { return cache_size_; }
+
+  /// \brief set the maximal number of converted frames kept in memory
+  void SetCacheSize(uint cache_size);
+
+  virtual void AddFrame(const std::vector<geom::Vec3>& coords) {}
+  virtual void AddFrame(const std::vector<geom::Vec3>& coords,
+                        const geom::Vec3& box_size,
+                        const geom::Vec3& box_angles) {}
+  virtual void InsertFrame(int pos, const std::vector<geom::Vec3>& coords) {}
+private:
+  typedef std::list<std::pair<uint, mol::CoordFramePtr> > FrameCache;
+
+  const char* FrameData(uint frame_id) const;
+
+  mol::CoordFramePtr ConvertFrame(uint frame_id) const;
+
+  boost::iostreams::mapped_file_source file_;
+  uint                                 atom_count_;
+  bool                                 ucell_flag_;
+  bool                                 swap_flag_;
+  size_t                               frame_start_;
+  size_t                               frame_size_;
+  uint                                 frame_count_;
+  uint                                 stride_;
+  uint                                 cache_size_;
+  mutable FrameCache                   cache_;
+  mutable std::map<uint, FrameCache::iterator> cache_index_;
+  mutable boost::mutex                 cache_mutex_;
+};
+
+typedef boost::shared_ptr<DCDMappedCoordSource> DCDMappedCoordSourcePtr;
+
 
 
 /*! \brief import a CHARMM trajectory in dcd format with an existing entity
@@ -42,6 +122,17 @@ mol::CoordGroupHandle DLLEXPORT_OST_IO LoadCHARMMTraj(const mol::EntityHandle& e
                                                       bool detect_swap=true,
                                                       bool byte_swap=false);
 
+/*! \brief import a CHARMM trajectory through a memory-mapped coord source
+  
+    The frames are read on demand from the mapped file, see
+    DCDMappedCoordSource.
+*/
+mol::CoordGroupHandle DLLEXPORT_OST_IO LoadCHARMMTrajMapped(const mol::EntityHandle& ent,
+                                                            const String& trj_filename,
+                                                            unsigned int stride=1,
+                                                            unsigned int cache_size=16,
+                                                            bool detect_swap=true,
+                                                            bool byte_swap=false);
 
 /*! \brief export coord group as PDB file and DCD trajectory
     if the pdb filename is an empty string, it won't be exported
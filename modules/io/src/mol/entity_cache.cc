@@ -0,0 +1,243 @@
+//------------------------------------------------------------------------------
+// This file is part of the OpenStructure project <www.openstructure.org>
+//
+// Copyright (C) 2008-2020 by the OpenStructure authors
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 3.0 of the License, or (at your option)
+// any later version.
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//------------------------------------------------------------------------------
+#include <cstdlib>
+#include <sstream>
+#include <iomanip>
+#include <boost/version.hpp>
+#include <boost/uuid/detail/sha1.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+#include <ost/log.hh>
+#include <ost/mol/mol.hh>
+#include <ost/io/io_exception.hh>
+#include <ost/io/mol/entity_io_binary_handler.hh>
+
+#include "entity_cache.hh"
+
+namespace fs=boost::filesystem;
+
+namespace ost { namespace io {
+
+namespace {
+
+const char* CACHE_SUFFIX=".ostbin";
+
+String hex_digest(boost::uuids::detail::sha1& sha)
+{
+  std::stringstream ss;
+  ss << std::hex << std::setfill('0');
+#if BOOST_VERSION >= 108600
+  boost::uuids::detail::sha1::digest_type digest;
+  sha.get_digest(digest);
+  for (int i=0; i<20; ++i) {
+    ss << std::setw(2) << static_cast<int>(digest[i]);
+  }
+#else
+  unsigned int digest[5];
+  sha.get_digest(digest);
+  for (int i=0; i<5; ++i) {
+    ss << std::setw(8) << digest[i];
+  }
+#endif
+  return ss.str();
+}
+
+}
+
+EntityCache& EntityCache::Instance()
+{
+  static EntityCache instance;
+  return instance;
+}
+
+EntityCache::EntityCache():
+  directory_(), hits_(0), misses_(0), mutex_()
+{
+  const char* directory=getenv("OST_ENTITY_CACHE");
+  if (directory && directory[0]) {
+    try {
+      this->SetDirectory(directory);
+    } catch (IOException& e) {
+      LOG_ERROR("entity cache disabled: " << e.what());
+    }
+  }
+}
+
+void EntityCache::SetDirectory(const String& directory)
+{
+  if (!directory.empty()) {
+    try {
+      fs::create_directories(directory);
+    } catch (fs::filesystem_error& e) {
+      throw IOException("could not create entity cache directory "+
+                        directory+": "+e.what());
+    }
+  }
+  boost::mutex::scoped_lock lock(mutex_);
+  directory_=directory;
+}
+
+String EntityCache::GetDirectory() const
+{
+  boost::mutex::scoped_lock lock(mutex_);
+  return directory_;
+}
+
+bool EntityCache::IsEnabled() const
+{
+  boost::mutex::scoped_lock lock(mutex_);
+  return !directory_.empty();
+}
+
+String EntityCache::GetKey(const String& filename,
+                           const String& settings) const
+{
+  fs::ifstream stream(filename, std::ios::binary);
+  if (!stream) {
+    throw IOException("could not open "+filename);
+  }
+  boost::uuids::detail::sha1 sha;
+  char buffer[1<<16];
+  while (stream) {
+    stream.read(buffer, sizeof(buffer));
+    sha.process_bytes(buffer, stream.gcount());
+  }
+  // entries written with an older format version are not reused
+  std::stringstream ss;
+  ss << '\0' << settings << '\0' << EntityIOBinaryHandler::VERSION;
+  String suffix=ss.str();
+  sha.process_bytes(suffix.data(), suffix.size());
+  return hex_digest(sha);
+}
+
+String EntityCache::GetPath(const String& key) const
+{
+  return (fs::path(directory_) / (key+CACHE_SUFFIX)).string();
+}
+
+mol::EntityHandle EntityCache::Load(const String& key)
+{
+  String path;
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    if (directory_.empty()) {
+      return mol::EntityHandle();
+    }
+    path=this->GetPath(key);
+  }
+  mol::EntityHandle ent;
+  if (fs::exists(path)) {
+    try {
+      ent=mol::CreateEntity();
+      EntityIOBinaryHandler().Import(ent, path);
+    } catch (IOException& e) {
+      LOG_WARNING("removing corrupt entity cache entry " << path << ": "
+                  << e.what());
+      ent=mol::EntityHandle();
+      boost::system::error_code ec;
+      fs::remove(path, ec);
+    }
+  }
+  boost::mutex::scoped_lock lock(mutex_);
+  if (ent.IsValid()) {
+    ++hits_;
+  } else {
+    ++misses_;
+  }
+  return ent;
+}
+
+void EntityCache::Store(const String& key, const mol::EntityHandle& ent)
+{
+  // OstBin doesn't store alternative locations, the cached entity would
+  // differ from the loaded one
+  mol::ResidueHandleList residues=ent.GetResidueList();
+  for (mol::ResidueHandleList::const_iterator i=residues.begin(),
+       e=residues.end(); i!=e; ++i) {
+    if (i->HasAltAtoms()) {
+      LOG_VERBOSE("not caching entity with alternative locations");
+      return;
+    }
+  }
+  String path;
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    if (directory_.empty()) {
+      return;
+    }
+    path=this->GetPath(key);
+  }
+  fs::path tmp_path=fs::unique_path(path+".%%%%-%%%%-%%%%");
+  try {
+    EntityIOBinaryHandler().Export(ent.CreateFullView(), tmp_path);
+    fs::rename(tmp_path, path);
+  } catch (std::exception& e) {
+    LOG_WARNING("could not write entity cache entry " << path << ": "
+                << e.what());
+    boost::system::error_code ec;
+    fs::remove(tmp_path, ec);
+  }
+}
+
+void EntityCache::Clear()
+{
+  String directory=this->GetDirectory();
+  if (directory.empty() || !fs::exists(directory)) {
+    return;
+  }
+  std::vector<fs::path> entries;
+  for (fs::directory_iterator i(directory), e; i!=e; ++i) {
+    if (i->path().extension()==CACHE_SUFFIX) {
+      entries.push_back(i->path());
+    }
+  }
+  for (size_t i=0; i<entries.size(); ++i) {
+    boost::system::error_code ec;
+    fs::remove(entries[i], ec);
+  }
+}
+
+size_t EntityCache::GetHitCount() const
+{
+  boost::mutex::scoped_lock lock(mutex_);
+  return hits_;
+}
+
+size_t EntityCache::GetMissCount() const
+{
+  boost::mutex::scoped_lock lock(mutex_);
+  return misses_;
+}
+
+void EntityCache::ResetStatistics()
+{
+  boost::mutex::scoped_lock lock(mutex_);
+  hits_=0;
+  misses_=0;
+}
+
+String GetCacheSettings(const IOProfile& profile)
+{
+  std::stringstream ss;
+  ss << profile;
+  return ss.str();
+}
+
+}}
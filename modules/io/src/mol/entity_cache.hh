@@ -0,0 +1,104 @@
+//------------------------------------------------------------------------------
+// This file is part of the OpenStructure project <www.openstructure.org>
+//
+// Copyright (C) 2008-2020 by the OpenStructure authors
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 3.0 of the License, or (at your option)
+// any later version.
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//------------------------------------------------------------------------------
+#ifndef OST_IO_ENTITY_CACHE_HH
+#define OST_IO_ENTITY_CACHE_HH
+
+#include <boost/thread/mutex.hpp>
+#include <ost/mol/entity_handle.hh>
+#include <ost/io/module_config.hh>
+#include <ost/io/mol/io_profile.hh>
+
+namespace ost { namespace io {
+
+/// \brief on-disk cache of processed entities
+///
+/// Loading a structure consists of parsing the file and running the processor
+/// of the IOProfile, which easily dominates the runtime of jobs that read the
+/// same structures over and over again. The cache stores the processed entity
+/// in the OstBin format, keyed by a SHA-1 hash of the file content and of the
+/// settings used for loading. Since the cache lives on disk, it is shared by
+/// all processes using the same cache directory.
+///
+/// The cache is disabled by default. It is enabled by setting a directory,
+/// either with SetDirectory() or with the OST_ENTITY_CACHE environment
+/// variable. Cached entities are not invalidated when the compound library
+/// changes, call Clear() in that case.
+class DLLEXPORT_OST_IO EntityCache {
+public:
+  static EntityCache& Instance();
+
+  /// \brief set cache directory, an empty string disables the cache
+  ///
+  /// The directory is created if it does not exist.
+  void SetDirectory(const String& directory);
+
+  String GetDirectory() const;
+
+  bool IsEnabled() const;
+
+  /// \brief key for a file loaded with the given settings
+  ///
+  /// \param settings describes everything besides the file content that
+  ///     affects the loaded entity, e.g. the loader and its options.
+  /// \throws IOException if the file can not be read
+  String GetKey(const String& filename, const String& settings) const;
+
+  /// \brief look up cached entity
+  ///
+  /// \returns an invalid handle if the cache is disabled or the key is not
+  ///     cached. Corrupt entries are removed and count as miss.
+  mol::EntityHandle Load(const String& key);
+
+  /// \brief store entity
+  ///
+  /// The entry is written to a temporary file and moved into place, so
+  /// concurrent processes never see partially written entries. Failing to
+  /// write is not an error, the entity is just not cached. Entities with
+  /// alternative atom locations are not cached, since they are not preserved
+  /// by the OstBin format.
+  void Store(const String& key, const mol::EntityHandle& ent);
+
+  /// \brief remove all cached entities
+  void Clear();
+
+  size_t GetHitCount() const;
+
+  size_t GetMissCount() const;
+
+  void ResetStatistics();
+
+private:
+  EntityCache();
+  EntityCache(const EntityCache&);
+  EntityCache& operator=(const EntityCache&);
+
+  String GetPath(const String& key) const;
+
+  String               directory_;
+  size_t               hits_;
+  size_t               misses_;
+  mutable boost::mutex mutex_;
+};
+
+/// \brief settings string of profile for use as part of a cache key
+String DLLEXPORT_OST_IO GetCacheSettings(const IOProfile& profile);
+
+}}
+
+#endif
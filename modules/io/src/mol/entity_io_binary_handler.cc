@@ -0,0 +1,797 @@
+//------------------------------------------------------------------------------
+// This file is part of the OpenStructure project <www.openstructure.org>
+//
+// Copyright (C) 2008-2020 by the OpenStructure authors
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 3.0 of the License, or (at your option)
+// any later version.
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//------------------------------------------------------------------------------
+
+/*
+  Layout of the binary entity format, version 1
+
+  The file starts with the magic bytes "OSTB" followed by the format version
+  as little endian uint32. Integers are stored as LEB128 variable length
+  integers, signed ones zigzag encoded. Floating point numbers are stored as
+  IEEE single precision, little endian. Strings are stored once in a string
+  table and referenced by index.
+
+    string table    count, (length, bytes)*
+    entity          name, properties
+    chains          count, (name, type, description, residue count)*
+    residues        one column per attribute: name, residue number delta,
+                    insertion code, one letter code, secondary structure,
+                    chem class, chem type, flags, atom count
+    atoms           one column per attribute: name, element, flags, x, y, z,
+                    occupancy, b-factor, charge, mass, radius
+    bonds           count, first atom delta, second-first, bond order
+    torsions        count, (name, atom indices)*
+    properties      for chains, residues and atoms: count, (index, props)*
+
+  Generic properties are stored as count, (key, type, value)*.
+*/
+
+#include <cstring>
+#include <map>
+#include <sstream>
+#include <boost/algorithm/string.hpp>
+#include <boost/filesystem/convenience.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/copy.hpp>
+
+#include <ost/log.hh>
+#include <ost/profile.hh>
+#include <ost/mol/mol.hh>
+#include <ost/mol/xcs_editor.hh>
+#include <ost/io/io_exception.hh>
+#include <ost/io/swap_util.hh>
+
+#include "entity_io_binary_handler.hh"
+
+namespace ost { namespace io {
+
+namespace {
+
+const char* MAGIC="OSTB";
+
+enum {
+  RES_PROTEIN=1,
+  RES_LIGAND=2
+};
+
+enum {
+  ATOM_HETATM=1
+};
+
+enum {
+  PROP_STRING=0,
+  PROP_FLOAT,
+  PROP_INT,
+  PROP_BOOL,
+  PROP_VEC3
+};
+
+bool is_little_endian()
+{
+  uint32_t probe=1;
+  return *reinterpret_cast<char*>(&probe)==1;
+}
+
+class BinaryWriter {
+public:
+  BinaryWriter() { }
+
+  void WriteUInt(uint64_t value)
+  {
+    while (value>=0x80) {
+      buffer_.push_back(static_cast<char>((value & 0x7f) | 0x80));
+      value>>=7;
+    }
+    buffer_.push_back(static_cast<char>(value));
+  }
+
+  void WriteInt(int64_t value)
+  {
+    this->WriteUInt((static_cast<uint64_t>(value) << 1) ^
+                    static_cast<uint64_t>(value >> 63));
+  }
+
+  void WriteChar(char value) { buffer_.push_back(value); }
+
+  void WriteFloat(float value)
+  {
+    if (!is_little_endian()) {
+      swap_float(&value, 1);
+    }
+    buffer_.append(reinterpret_cast<const char*>(&value), sizeof(float));
+  }
+
+  void WriteString(const String& str)
+  {
+    this->WriteUInt(str.size());
+    buffer_.append(str);
+  }
+
+  // index of the string in the string table
+  void WriteStringIndex(const String& str)
+  {
+    std::map<String, uint32_t>::iterator i=string_index_.find(str);
+    if (i==string_index_.end()) {
+      i=string_index_.insert(std::make_pair(str,
+                                            uint32_t(strings_.size()))).first;
+      strings_.push_back(str);
+    }
+    this->WriteUInt(i->second);
+  }
+
+  void WriteProps(const std::map<String, GenericPropValue>& props)
+  {
+    this->WriteUInt(props.size());
+    for (std::map<String, GenericPropValue>::const_iterator i=props.begin(),
+         e=props.end(); i!=e; ++i) {
+      this->WriteStringIndex(i->first);
+      this->WriteChar(static_cast<char>(i->second.which()));
+      switch (i->second.which()) {
+        case PROP_STRING:
+          this->WriteStringIndex(boost::get<String>(i->second));
+          break;
+        case PROP_FLOAT:
+          this->WriteFloat(boost::get<Real>(i->second));
+          break;
+        case PROP_INT:
+          this->WriteInt(boost::get<int>(i->second));
+          break;
+        case PROP_BOOL:
+          this->WriteChar(boost::get<bool>(i->second));
+          break;
+        case PROP_VEC3: {
+          const geom::Vec3& v=boost::get<geom::Vec3>(i->second);
+          this->WriteFloat(v[0]);
+          this->WriteFloat(v[1]);
+          this->WriteFloat(v[2]);
+          break;
+        }
+      }
+    }
+  }
+
+  // writes header, string table and body to the stream
+  void Flush(std::ostream& stream)
+  {
+    BinaryWriter header;
+    header.buffer_.append(MAGIC, 4);
+    uint32_t version=EntityIOBinaryHandler::VERSION;
+    if (!is_little_endian()) {
+      swap_int(reinterpret_cast<int*>(&version), 1);
+    }
+    header.buffer_.append(reinterpret_cast<const char*>(&version),
+                          sizeof(uint32_t));
+    header.WriteUInt(strings_.size());
+    for (std::vector<String>::const_iterator i=strings_.begin(),
+         e=strings_.end(); i!=e; ++i) {
+      header.WriteString(*i);
+    }
+    stream.write(header.buffer_.data(), header.buffer_.size());
+    stream.write(buffer_.data(), buffer_.size());
+  }
+
+private:
+  String                     buffer_;
+  std::vector<String>        strings_;
+  std::map<String, uint32_t> string_index_;
+};
+
+class BinaryReader {
+public:
+  BinaryReader(const String& buffer):
+    ptr_(buffer.data()), end_(buffer.data()+buffer.size())
+  { }
+
+  void ReadHeader()
+  {
+    this->Require(4+sizeof(uint32_t));
+    if (std::memcmp(ptr_, MAGIC, 4)!=0) {
+      throw IOException("not an OstBin file");
+    }
+    ptr_+=4;
+    uint32_t version;
+    std::memcpy(&version, ptr_, sizeof(uint32_t));
+    ptr_+=sizeof(uint32_t);
+    if (!is_little_endian()) {
+      swap_int(reinterpret_cast<int*>(&version), 1);
+    }
+    if (version<1 || version>EntityIOBinaryHandler::VERSION) {
+      std::stringstream ss;
+      ss << "unsupported OstBin format version " << version;
+      throw IOException(ss.str());
+    }
+    uint64_t num_strings=this->ReadUInt();
+    strings_.resize(this->CheckCount(num_strings));
+    for (uint64_t i=0; i<num_strings; ++i) {
+      uint64_t len=this->ReadUInt();
+      this->Require(len);
+      strings_[i].assign(ptr_, len);
+      ptr_+=len;
+    }
+  }
+
+  uint64_t ReadUInt()
+  {
+    uint64_t value=0;
+    for (int shift=0; shift<64; shift+=7) {
+      this->Require(1);
+      unsigned char byte=static_cast<unsigned char>(*ptr_++);
+      value|=static_cast<uint64_t>(byte & 0x7f) << shift;
+      if (!(byte & 0x80)) {
+        return value;
+      }
+    }
+    throw IOException("corrupted OstBin file");
+  }
+
+  int64_t ReadInt()
+  {
+    uint64_t value=this->ReadUInt();
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+  }
+
+  char ReadChar()
+  {
+    this->Require(1);
+    return *ptr_++;
+  }
+
+  float ReadFloat()
+  {
+    this->Require(sizeof(float));
+    float value;
+    std::memcpy(&value, ptr_, sizeof(float));
+    ptr_+=sizeof(float);
+    if (!is_little_endian()) {
+      swap_float(&value, 1);
+    }
+    return value;
+  }
+
+  void ReadFloats(std::vector<float>& values, size_t count)
+  {
+    this->Require(count*sizeof(float));
+    values.resize(count);
+    if (count>0) {
+      std::memcpy(&values[0], ptr_, count*sizeof(float));
+    }
+    ptr_+=count*sizeof(float);
+    if (!is_little_endian() && count>0) {
+      swap_float(&values[0], count);
+    }
+  }
+
+  const String& ReadString()
+  {
+    uint64_t index=this->ReadUInt();
+    if (index>=strings_.size()) {
+      throw IOException("corrupted OstBin file");
+    }
+    return strings_[index];
+  }
+
+  // returns count if the remaining data can possibly hold count entries
+  size_t CheckCount(uint64_t count) const
+  {
+    if (count>static_cast<uint64_t>(end_-ptr_)) {
+      throw IOException("corrupted OstBin file");
+    }
+    return static_cast<size_t>(count);
+  }
+
+  template <typename H>
+  void ReadProps(H handle)
+  {
+    uint64_t num_props=this->ReadUInt();
+    for (uint64_t i=0; i<num_props; ++i) {
+      const String& key=this->ReadString();
+      switch (this->ReadChar()) {
+        case PROP_STRING:
+          handle.SetStringProp(key, this->ReadString());
+          break;
+        case PROP_FLOAT:
+          handle.SetFloatProp(key, this->ReadFloat());
+          break;
+        case PROP_INT:
+          handle.SetIntProp(key, static_cast<int>(this->ReadInt()));
+          break;
+        case PROP_BOOL:
+          handle.SetBoolProp(key, this->ReadChar()!=0);
+          break;
+        case PROP_VEC3: {
+          Real x=this->ReadFloat();
+          Real y=this->ReadFloat();
+          Real z=this->ReadFloat();
+          handle.SetVec3Prop(key, geom::Vec3(x, y, z));
+          break;
+        }
+        default:
+          throw IOException("corrupted OstBin file");
+      }
+    }
+  }
+
+private:
+  void Require(uint64_t num_bytes) const
+  {
+    if (num_bytes>static_cast<uint64_t>(end_-ptr_)) {
+      throw IOException("unexpected end of OstBin file");
+    }
+  }
+
+  const char*         ptr_;
+  const char*         end_;
+  std::vector<String> strings_;
+};
+
+template <typename H>
+void write_sparse_props(BinaryWriter& writer, const std::vector<H>& handles)
+{
+  std::vector<size_t> with_props;
+  for (size_t i=0; i<handles.size(); ++i) {
+    if (!handles[i].GetPropList().empty()) {
+      with_props.push_back(i);
+    }
+  }
+  writer.WriteUInt(with_props.size());
+  for (size_t i=0; i<with_props.size(); ++i) {
+    writer.WriteUInt(with_props[i]);
+    writer.WriteProps(handles[with_props[i]].GetPropMap());
+  }
+}
+
+template <typename H>
+void read_sparse_props(BinaryReader& reader, const std::vector<H>& handles)
+{
+  uint64_t count=reader.ReadUInt();
+  for (uint64_t i=0; i<count; ++i) {
+    uint64_t index=reader.ReadUInt();
+    if (index>=handles.size()) {
+      throw IOException("corrupted OstBin file");
+    }
+    reader.ReadProps(handles[index]);
+  }
+}
+
+void write_entity(const mol::EntityView& ent, std::ostream& stream)
+{
+  BinaryWriter writer;
+  std::vector<mol::ChainHandle> chains;
+  std::vector<mol::ResidueHandle> residues;
+  std::vector<mol::AtomHandle> atoms;
+  std::vector<uint64_t> res_atom_counts;
+  std::map<long, uint64_t> atom_index;
+  writer.WriteStringIndex(ent.GetName());
+  writer.WriteProps(ent.GetHandle().GetPropMap());
+  mol::ChainViewList chain_views=ent.GetChainList();
+  writer.WriteUInt(chain_views.size());
+  for (mol::ChainViewList::const_iterator c=chain_views.begin(),
+       ce=chain_views.end(); c!=ce; ++c) {
+    mol::ChainHandle chain=c->GetHandle();
+    chains.push_back(chain);
+    writer.WriteStringIndex(chain.GetName());
+    writer.WriteUInt(chain.GetType());
+    writer.WriteStringIndex(chain.GetDescription());
+    mol::ResidueViewList res_views=c->GetResidueList();
+    writer.WriteUInt(res_views.size());
+    for (mol::ResidueViewList::const_iterator r=res_views.begin(),
+         re=res_views.end(); r!=re; ++r) {
+      residues.push_back(r->GetHandle());
+      mol::AtomViewList atom_views=r->GetAtomList();
+      res_atom_counts.push_back(atom_views.size());
+      for (mol::AtomViewList::const_iterator a=atom_views.begin(),
+           ae=atom_views.end(); a!=ae; ++a) {
+        atom_index[a->GetHandle().GetHashCode()]=atoms.size();
+        atoms.push_back(a->GetHandle());
+      }
+    }
+  }
+
+  // residue columns
+  for (size_t i=0; i<residues.size(); ++i) {
+    writer.WriteStringIndex(residues[i].GetName());
+  }
+  int prev_num=0;
+  for (size_t i=0; i<residues.size(); ++i) {
+    int num=residues[i].GetNumber().GetNum();
+    writer.WriteInt(static_cast<int64_t>(num)-prev_num);
+    prev_num=num;
+  }
+  for (size_t i=0; i<residues.size(); ++i) {
+    writer.WriteChar(residues[i].GetNumber().GetInsCode());
+  }
+  for (size_t i=0; i<residues.size(); ++i) {
+    writer.WriteChar(residues[i].GetOneLetterCode());
+  }
+  for (size_t i=0; i<residues.size(); ++i) {
+    writer.WriteChar(residues[i].GetSecStructure());
+  }
+  for (size_t i=0; i<residues.size(); ++i) {
+    writer.WriteChar(residues[i].GetChemClass());
+  }
+  for (size_t i=0; i<residues.size(); ++i) {
+    writer.WriteChar(residues[i].GetChemType());
+  }
+  for (size_t i=0; i<residues.size(); ++i) {
+    writer.WriteChar((residues[i].IsProtein() ? RES_PROTEIN : 0) |
+                     (residues[i].IsLigand() ? RES_LIGAND : 0));
+  }
+  for (size_t i=0; i<residues.size(); ++i) {
+    writer.WriteUInt(res_atom_counts[i]);
+  }
+
+  // atom columns
+  for (size_t i=0; i<atoms.size(); ++i) {
+    writer.WriteStringIndex(atoms[i].GetName());
+  }
+  for (size_t i=0; i<atoms.size(); ++i) {
+    writer.WriteStringIndex(atoms[i].GetElement());
+  }
+  for (size_t i=0; i<atoms.size(); ++i) {
+    writer.WriteChar(atoms[i].IsHetAtom() ? ATOM_HETATM : 0);
+  }
+  for (int k=0; k<3; ++k) {
+    for (size_t i=0; i<atoms.size(); ++i) {
+      writer.WriteFloat(atoms[i].GetPos()[k]);
+    }
+  }
+  for (size_t i=0; i<atoms.size(); ++i) {
+    writer.WriteFloat(atoms[i].GetOccupancy());
+  }
+  for (size_t i=0; i<atoms.size(); ++i) {
+    writer.WriteFloat(atoms[i].GetBFactor());
+  }
+  for (size_t i=0; i<atoms.size(); ++i) {
+    writer.WriteFloat(atoms[i].GetCharge());
+  }
+  for (size_t i=0; i<atoms.size(); ++i) {
+    writer.WriteFloat(atoms[i].GetMass());
+  }
+  for (size_t i=0; i<atoms.size(); ++i) {
+    writer.WriteFloat(atoms[i].GetRadius());
+  }
+
+  // bonds, sorted by atom index for the delta encoding
+  std::vector<std::pair<std::pair<uint64_t, uint64_t>, char> > bonds;
+  const mol::BondHandleList& bond_list=ent.GetBondList();
+  for (mol::BondHandleList::const_iterator b=bond_list.begin(),
+       be=bond_list.end(); b!=be; ++b) {
+    std::map<long, uint64_t>::const_iterator i1, i2;
+    i1=atom_index.find(b->GetFirst().GetHashCode());
+    i2=atom_index.find(b->GetSecond().GetHashCode());
+    if (i1==atom_index.end() || i2==atom_index.end()) {
+      continue;
+    }
+    std::pair<uint64_t, uint64_t> p=std::make_pair(i1->second, i2->second);
+    if (p.first>p.second) {
+      std::swap(p.first, p.second);
+    }
+    bonds.push_back(std::make_pair(p, static_cast<char>(b->GetBondOrder())));
+  }
+  std::sort(bonds.begin(), bonds.end());
+  writer.WriteUInt(bonds.size());
+  uint64_t prev_first=0;
+  for (size_t i=0; i<bonds.size(); ++i) {
+    writer.WriteUInt(bonds[i].first.first-prev_first);
+    prev_first=bonds[i].first.first;
+  }
+  for (size_t i=0; i<bonds.size(); ++i) {
+    writer.WriteUInt(bonds[i].first.second-bonds[i].first.first);
+  }
+  for (size_t i=0; i<bonds.size(); ++i) {
+    writer.WriteChar(bonds[i].second);
+  }
+
+  // torsions where all atoms are part of the view
+  std::vector<std::pair<String, std::vector<uint64_t> > > torsions;
+  for (size_t i=0; i<residues.size(); ++i) {
+    mol::TorsionHandleList torsion_list=residues[i].GetTorsionList();
+    for (mol::TorsionHandleList::const_iterator t=torsion_list.begin(),
+         te=torsion_list.end(); t!=te; ++t) {
+      mol::AtomHandle torsion_atoms[]={ t->GetFirst(), t->GetSecond(),
+                                        t->GetThird(), t->GetFourth() };
+      std::vector<uint64_t> indices;
+      for (int k=0; k<4; ++k) {
+        std::map<long, uint64_t>::const_iterator j;
+        j=atom_index.find(torsion_atoms[k].GetHashCode());
+        if (j==atom_index.end()) {
+          break;
+        }
+        indices.push_back(j->second);
+      }
+      if (indices.size()==4) {
+        torsions.push_back(std::make_pair(t->GetName(), indices));
+      }
+    }
+  }
+  writer.WriteUInt(torsions.size());
+  for (size_t i=0; i<torsions.size(); ++i) {
+    writer.WriteStringIndex(torsions[i].first);
+    for (int k=0; k<4; ++k) {
+      writer.WriteUInt(torsions[i].second[k]);
+    }
+  }
+
+  write_sparse_props(writer, chains);
+  write_sparse_props(writer, residues);
+  write_sparse_props(writer, atoms);
+  writer.Flush(stream);
+}
+
+void read_entity(mol::EntityHandle& ent, const String& buffer)
+{
+  BinaryReader reader(buffer);
+  reader.ReadHeader();
+  mol::XCSEditor editor=ent.EditXCS(mol::BUFFERED_EDIT);
+  ent.SetName(reader.ReadString());
+  reader.ReadProps(ent);
+
+  std::vector<mol::ChainHandle> chains(reader.CheckCount(reader.ReadUInt()));
+  std::vector<size_t> chain_res_counts(chains.size());
+  size_t num_residues=0;
+  for (size_t i=0; i<chains.size(); ++i) {
+    chains[i]=editor.InsertChain(reader.ReadString());
+    uint64_t type=reader.ReadUInt();
+    if (type>=mol::CHAINTYPE_N_CHAINTYPES) {
+      throw IOException("corrupted OstBin file");
+    }
+    editor.SetChainType(chains[i], static_cast<mol::ChainType>(type));
+    editor.SetChainDescription(chains[i], reader.ReadString());
+    chain_res_counts[i]=reader.CheckCount(reader.ReadUInt());
+    num_residues+=chain_res_counts[i];
+  }
+
+  // residue columns
+  reader.CheckCount(num_residues);
+  std::vector<String> res_names(num_residues);
+  for (size_t i=0; i<num_residues; ++i) {
+    res_names[i]=reader.ReadString();
+  }
+  std::vector<int> res_nums(num_residues);
+  int64_t num=0;
+  for (size_t i=0; i<num_residues; ++i) {
+    num+=reader.ReadInt();
+    res_nums[i]=static_cast<int>(num);
+  }
+  std::vector<mol::ResidueHandle> residues;
+  residues.reserve(num_residues);
+  for (size_t c=0; c<chains.size(); ++c) {
+    for (size_t i=0; i<chain_res_counts[c]; ++i) {
+      size_t r=residues.size();
+      mol::ResNum res_num(res_nums[r], reader.ReadChar());
+      residues.push_back(editor.AppendResidue(chains[c], res_names[r],
+                                              res_num));
+    }
+  }
+  for (size_t i=0; i<num_residues; ++i) {
+    residues[i].SetOneLetterCode(reader.ReadChar());
+  }
+  for (size_t i=0; i<num_residues; ++i) {
+    residues[i].SetSecStructure(mol::SecStructure(reader.ReadChar()));
+  }
+  for (size_t i=0; i<num_residues; ++i) {
+    residues[i].SetChemClass(mol::ChemClass(reader.ReadChar()));
+  }
+  for (size_t i=0; i<num_residues; ++i) {
+    residues[i].SetChemType(mol::ChemType(reader.ReadChar()));
+  }
+  for (size_t i=0; i<num_residues; ++i) {
+    char flags=reader.ReadChar();
+    residues[i].SetIsProtein(flags & RES_PROTEIN);
+    residues[i].SetIsLigand(flags & RES_LIGAND);
+  }
+  std::vector<size_t> res_atom_counts(num_residues);
+  size_t num_atoms=0;
+  for (size_t i=0; i<num_residues; ++i) {
+    res_atom_counts[i]=reader.CheckCount(reader.ReadUInt());
+    num_atoms+=res_atom_counts[i];
+  }
+
+  // atom columns
+  reader.CheckCount(num_atoms);
+  std::vector<String> atom_names(num_atoms), elements(num_atoms);
+  for (size_t i=0; i<num_atoms; ++i) {
+    atom_names[i]=reader.ReadString();
+  }
+  for (size_t i=0; i<num_atoms; ++i) {
+    elements[i]=reader.ReadString();
+  }
+  std::vector<char> atom_flags(num_atoms);
+  for (size_t i=0; i<num_atoms; ++i) {
+    atom_flags[i]=reader.ReadChar();
+  }
+  std::vector<float> x, y, z, occupancy, b_factor;
+  reader.ReadFloats(x, num_atoms);
+  reader.ReadFloats(y, num_atoms);
+  reader.ReadFloats(z, num_atoms);
+  reader.ReadFloats(occupancy, num_atoms);
+  reader.ReadFloats(b_factor, num_atoms);
+  std::vector<mol::AtomHandle> atoms;
+  atoms.reserve(num_atoms);
+  for (size_t r=0; r<num_residues; ++r) {
+    for (size_t i=0; i<res_atom_counts[r]; ++i) {
+      size_t a=atoms.size();
+      atoms.push_back(editor.InsertAtom(residues[r], atom_names[a],
+                                        geom::Vec3(x[a], y[a], z[a]),
+                                        elements[a], occupancy[a],
+                                        b_factor[a],
+                                        atom_flags[a] & ATOM_HETATM));
+    }
+  }
+  std::vector<float> values;
+  reader.ReadFloats(values, num_atoms);
+  for (size_t i=0; i<num_atoms; ++i) {
+    atoms[i].SetCharge(values[i]);
+  }
+  reader.ReadFloats(values, num_atoms);
+  for (size_t i=0; i<num_atoms; ++i) {
+    atoms[i].SetMass(values[i]);
+  }
+  reader.ReadFloats(values, num_atoms);
+  for (size_t i=0; i<num_atoms; ++i) {
+    atoms[i].SetRadius(values[i]);
+  }
+
+  // bonds
+  size_t num_bonds=reader.CheckCount(reader.ReadUInt());
+  std::vector<uint64_t> first(num_bonds), second(num_bonds);
+  uint64_t prev_first=0;
+  for (size_t i=0; i<num_bonds; ++i) {
+    first[i]=prev_first+reader.ReadUInt();
+    prev_first=first[i];
+  }
+  for (size_t i=0; i<num_bonds; ++i) {
+    second[i]=first[i]+reader.ReadUInt();
+    if (second[i]>=num_atoms) {
+      throw IOException("corrupted OstBin file");
+    }
+  }
+  for (size_t i=0; i<num_bonds; ++i) {
+    editor.Connect(atoms[first[i]], atoms[second[i]],
+                   static_cast<unsigned char>(reader.ReadChar()));
+  }
+
+  // torsions
+  size_t num_torsions=reader.CheckCount(reader.ReadUInt());
+  for (size_t i=0; i<num_torsions; ++i) {
+    String name=reader.ReadString();
+    uint64_t indices[4];
+    for (int k=0; k<4; ++k) {
+      indices[k]=reader.ReadUInt();
+      if (indices[k]>=num_atoms) {
+        throw IOException("corrupted OstBin file");
+      }
+    }
+    editor.AddTorsion(name, atoms[indices[0]], atoms[indices[1]],
+                      atoms[indices[2]], atoms[indices[3]]);
+  }
+
+  read_sparse_props(reader, chains);
+  read_sparse_props(reader, residues);
+  read_sparse_props(reader, atoms);
+}
+
+void read_stream(std::istream& stream, String& buffer)
+{
+  std::stringstream ss;
+  ss << stream.rdbuf();
+  buffer=ss.str();
+}
+
+// reads the whole stream into buffer, decompressing it if necessary
+void read_buffer(std::istream& stream, String& buffer)
+{
+  // gzip magic bytes
+  if (stream.peek()==0x1f) {
+    boost::iostreams::filtering_stream<boost::iostreams::input> in;
+    in.push(boost::iostreams::gzip_decompressor());
+    in.push(stream);
+    read_stream(in, buffer);
+  } else {
+    read_stream(stream, buffer);
+  }
+}
+
+}
+
+bool EntityIOBinaryHandler::RequiresProcessor() const
+{
+  return false;
+}
+
+void EntityIOBinaryHandler::Import(mol::EntityHandle& ent,
+                                   std::istream& stream)
+{
+  Profile profile_import("EntityIOBinaryHandler::Import");
+  String buffer;
+  try {
+    read_buffer(stream, buffer);
+  } catch (boost::iostreams::gzip_error&) {
+    throw IOException("could not decompress OstBin file");
+  }
+  read_entity(ent, buffer);
+}
+
+void EntityIOBinaryHandler::Import(mol::EntityHandle& ent,
+                                   const boost::filesystem::path& loc)
+{
+  boost::filesystem::ifstream stream(loc, std::ios::binary);
+  if (!stream) {
+    throw IOException("could not open "+loc.string());
+  }
+  this->Import(ent, stream);
+}
+
+void EntityIOBinaryHandler::Export(const mol::EntityView& ent,
+                                   std::ostream& stream) const
+{
+  write_entity(ent, stream);
+}
+
+void EntityIOBinaryHandler::Export(const mol::EntityView& ent,
+                                   const boost::filesystem::path& loc) const
+{
+  boost::filesystem::ofstream stream(loc, std::ios::binary);
+  if (!stream) {
+    throw IOException("could not open "+loc.string()+" for writing");
+  }
+  if (boost::iequals(".gz", boost::filesystem::extension(loc))) {
+    boost::iostreams::filtering_stream<boost::iostreams::output> out;
+    out.push(boost::iostreams::gzip_compressor());
+    out.push(stream);
+    write_entity(ent, out);
+  } else {
+    write_entity(ent, stream);
+  }
+}
+
+namespace {
+
+bool binary_handler_is_responsible_for(const boost::filesystem::path& loc,
+                                       const String& type) {
+  if (type=="auto") {
+    String match_suf_string=loc.string();
+    std::transform(match_suf_string.begin(), match_suf_string.end(),
+                   match_suf_string.begin(), tolower);
+    if (detail::FilenameEndsWith(match_suf_string, ".ostbin") ||
+        detail::FilenameEndsWith(match_suf_string, ".ostbin.gz")) {
+      return true;
+    }
+  } else if (type=="ostbin") {
+    return true;
+  }
+  return false;
+}
+
+}
+
+bool EntityIOBinaryHandler::ProvidesImport(const boost::filesystem::path& loc,
+                                           const String& type)
+{
+  return binary_handler_is_responsible_for(loc, type);
+}
+
+bool EntityIOBinaryHandler::ProvidesExport(const boost::filesystem::path& loc,
+                                           const String& type)
+{
+  return binary_handler_is_responsible_for(loc, type);
+}
+
+}} // ns
@@ -0,0 +1,73 @@
+//------------------------------------------------------------------------------
+// This file is part of the OpenStructure project <www.openstructure.org>
+//
+// Copyright (C) 2008-2020 by the OpenStructure authors
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 3.0 of the License, or (at your option)
+// any later version.
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//------------------------------------------------------------------------------
+#ifndef OST_IO_ENTITY_IO_PLUGIN_BINARY_H
+#define OST_IO_ENTITY_IO_PLUGIN_BINARY_H
+
+#include <ost/stdint.hh>
+#include <ost/io/mol/entity_io_handler.hh>
+
+namespace ost { namespace io {
+
+/// \brief compact binary entity format
+///
+/// Stores an entity including everything the text formats only provide after
+/// running a processor: bonds with bond orders, torsions, chemical classes
+/// and types, secondary structure and generic properties. Loading therefore
+/// does not require a processor.
+///
+/// Names are dictionary encoded, residue numbers delta encoded and atom
+/// properties as well as coordinates stored column by column, which keeps the
+/// files small and fast to parse. Files ending in .gz are gzip compressed,
+/// compressed files are recognised independent of their suffix on import.
+///
+/// Every file starts with a magic number and a format version. Files written
+/// by newer versions of OpenStructure are rejected. Alternative atom
+/// positions are not stored.
+class DLLEXPORT_OST_IO EntityIOBinaryHandler: public EntityIOHandler {
+public:
+  static const uint32_t VERSION=1;
+
+  virtual void Import(mol::EntityHandle& ent,
+                      const boost::filesystem::path& loc);
+  virtual void Export(const mol::EntityView& ent,
+                      const boost::filesystem::path& loc) const;
+  virtual void Import(mol::EntityHandle& ent,
+                      std::istream& stream);
+  virtual void Export(const mol::EntityView& ent,
+                      std::ostream& stream) const;
+  static bool ProvidesImport(const boost::filesystem::path& loc,
+                             const String& format="auto");
+  static bool ProvidesExport(const boost::filesystem::path& loc,
+                             const String& format="auto");
+
+  virtual bool RequiresProcessor() const;
+
+  static String GetFormatName() { return String("OstBin"); }
+  static String GetFormatDescription()
+  {
+    return String("Compact binary entity format of OpenStructure");
+  }
+};
+
+typedef EntityIOHandlerFactory<EntityIOBinaryHandler>
+        EntityIOBinaryHandlerFactory;
+
+}} // ns
+
+#endif
@@ -24,6 +24,7 @@
 #include <ost/io/io_manager.hh>
 #include <ost/io/mol/io_profile.hh>
 #include <ost/io/mol/entity_io_handler.hh>
+#include <ost/io/mol/entity_cache.hh>
 #include <ost/profile.hh>
 
 namespace ost { namespace io {
@@ -55,10 +56,26 @@ void Import(mol::EntityHandle& eh, const String& filename, const String& format)
 
 mol::EntityHandle LoadEntity(const String& filename, const String& format)
 {
+  EntityCache& cache=EntityCache::Instance();
+  String key;
+  if (cache.IsEnabled()) {
+    IOProfile& prof=IOProfileRegistry::Instance().GetDefault();
+    key=cache.GetKey(filename, "LoadEntity(format='"+format+"', profile="+
+                               GetCacheSettings(prof)+")");
+    mol::EntityHandle eh=cache.Load(key);
+    if (eh.IsValid()) {
+      return eh;
+    }
+  }
   LOG_DEBUG("creating emtpy entity");
   mol::EntityHandle eh=mol::CreateEntity();
-  mol::XCSEditor xcs_lock=eh.EditXCS(mol::BUFFERED_EDIT);
-  Import(eh, filename, format);
+  {
+    mol::XCSEditor xcs_lock=eh.EditXCS(mol::BUFFERED_EDIT);
+    Import(eh, filename, format);
+  }
+  if (!key.empty()) {
+    cache.Store(key, eh);
+  }
   return eh;
 }
 
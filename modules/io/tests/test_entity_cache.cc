@@ -0,0 +1,104 @@
+//------------------------------------------------------------------------------
+// This file is part of the OpenStructure project <www.openstructure.org>
+//
+// Copyright (C) 2008-2020 by the OpenStructure authors
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 3.0 of the License, or (at your option)
+// any later version.
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//------------------------------------------------------------------------------
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+#include <ost/mol/mol.hh>
+#include <ost/io/io_exception.hh>
+#include <ost/io/mol/entity_cache.hh>
+
+using namespace ost;
+using namespace ost::io;
+
+BOOST_AUTO_TEST_SUITE( io );
+
+BOOST_AUTO_TEST_CASE(test_entity_cache)
+{
+  const String dir("testfiles/entity_cache_out");
+  const String fname("testfiles/pdb/1AKE.pdb");
+  EntityCache& cache=EntityCache::Instance();
+  String old_dir=cache.GetDirectory();
+
+  cache.SetDirectory("");
+  BOOST_CHECK(!cache.IsEnabled());
+  String key=cache.GetKey(fname, "settings");
+  BOOST_CHECK_EQUAL(key.size(), size_t(40));
+  BOOST_CHECK_EQUAL(key, cache.GetKey(fname, "settings"));
+  BOOST_CHECK(key!=cache.GetKey(fname, "other settings"));
+  BOOST_CHECK(key!=cache.GetKey("testfiles/pdb/1oax.pdb", "settings"));
+  BOOST_CHECK_THROW(cache.GetKey("testfiles/does_not_exist", "settings"),
+                    IOException);
+  BOOST_CHECK(!cache.Load(key).IsValid());
+
+  cache.SetDirectory(dir);
+  BOOST_CHECK(cache.IsEnabled());
+  cache.Clear();
+  cache.ResetStatistics();
+  BOOST_CHECK(!cache.Load(key).IsValid());
+  BOOST_CHECK_EQUAL(cache.GetMissCount(), size_t(1));
+
+  mol::EntityHandle ent=mol::CreateEntity();
+  mol::XCSEditor edi=ent.EditXCS();
+  mol::ChainHandle ch=edi.InsertChain("A");
+  mol::ResidueHandle res=edi.AppendResidue(ch, "GLY");
+  mol::AtomHandle n=edi.InsertAtom(res, "N", geom::Vec3(1, 2, 3), "N");
+  mol::AtomHandle ca=edi.InsertAtom(res, "CA", geom::Vec3(2, 2, 3), "C");
+  edi.Connect(n, ca);
+  cache.Store(key, ent);
+
+  mol::EntityHandle cached=cache.Load(key);
+  BOOST_REQUIRE(cached.IsValid());
+  BOOST_CHECK_EQUAL(cached.GetAtomCount(), 2);
+  BOOST_CHECK_EQUAL(cached.GetBondCount(), 1);
+  BOOST_CHECK_EQUAL(cache.GetHitCount(), size_t(1));
+  BOOST_CHECK_EQUAL(cache.GetMissCount(), size_t(1));
+
+  // corrupt entries are removed and count as miss
+  {
+    boost::filesystem::ofstream corrupt(dir+"/"+key+".ostbin");
+    corrupt << "garbage";
+  }
+  BOOST_CHECK(!cache.Load(key).IsValid());
+  BOOST_CHECK(!boost::filesystem::exists(dir+"/"+key+".ostbin"));
+  BOOST_CHECK_EQUAL(cache.GetMissCount(), size_t(2));
+
+  // alternative locations are not preserved by OstBin, such entities are not
+  // stored
+  mol::ResidueHandle alt_res=edi.AppendResidue(ch, "SER");
+  mol::AtomHandle og=edi.InsertAltAtom(alt_res, "OG", "A",
+                                       geom::Vec3(3, 2, 3), "O");
+  edi.AddAltAtomPos("B", og, geom::Vec3(3, 3, 3));
+  cache.Store(key, ent);
+  BOOST_CHECK(!boost::filesystem::exists(dir+"/"+key+".ostbin"));
+  edi.DeleteResidue(alt_res);
+
+  cache.Store(key, ent);
+  cache.Clear();
+  BOOST_CHECK(!cache.Load(key).IsValid());
+  cache.ResetStatistics();
+  BOOST_CHECK_EQUAL(cache.GetHitCount(), size_t(0));
+  BOOST_CHECK_EQUAL(cache.GetMissCount(), size_t(0));
+
+  cache.SetDirectory(old_dir);
+  boost::filesystem::remove_all(dir);
+}
+
+BOOST_AUTO_TEST_SUITE_END();
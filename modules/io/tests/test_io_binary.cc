@@ -0,0 +1,210 @@
+//------------------------------------------------------------------------------
+// This file is part of the OpenStructure project <www.openstructure.org>
+//
+// Copyright (C) 2008-2020 by the OpenStructure authors
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 3.0 of the License, or (at your option)
+// any later version.
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//------------------------------------------------------------------------------
+#define BOOST_TEST_DYN_LINK
+#include <sstream>
+#include <boost/test/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+#include <boost/filesystem/operations.hpp>
+
+#include <ost/mol/mol.hh>
+#include <ost/io/io_exception.hh>
+#include <ost/io/mol/entity_io_binary_handler.hh>
+
+using namespace ost;
+using namespace ost::io;
+
+namespace {
+
+mol::EntityHandle make_test_entity()
+{
+  mol::EntityHandle ent=mol::CreateEntity();
+  ent.SetName("test");
+  ent.SetStringProp("source", "unit test");
+  mol::XCSEditor edi=ent.EditXCS();
+  mol::ChainHandle ch=edi.InsertChain("A");
+  edi.SetChainType(ch, mol::CHAINTYPE_POLY_PEPTIDE_L);
+  edi.SetChainDescription(ch, "some protein");
+  ch.SetIntProp("copies", 2);
+  mol::ResidueHandle r1=edi.AppendResidue(ch, "ALA", mol::ResNum(10));
+  mol::ResidueHandle r2=edi.AppendResidue(ch, "GLY", mol::ResNum(10, 'A'));
+  mol::ResidueHandle r3=edi.AppendResidue(ch, "SER", mol::ResNum(-3));
+  r1.SetOneLetterCode('A');
+  r1.SetChemClass(mol::ChemClass(mol::ChemClass::L_PEPTIDE_LINKING));
+  r1.SetSecStructure(mol::SecStructure(mol::SecStructure::ALPHA_HELIX));
+  r1.SetIsProtein(true);
+  r2.SetIsLigand(true);
+  r2.SetFloatProp("score", 0.5);
+  r3.SetVec3Prop("center", geom::Vec3(1, 2, 3));
+  mol::AtomHandle n1=edi.InsertAtom(r1, "N", geom::Vec3(0.125, 1.5, -2.0),
+                                    "N", 0.5, 20.0);
+  mol::AtomHandle ca1=edi.InsertAtom(r1, "CA", geom::Vec3(1.0, 1.5, -2.0),
+                                     "C");
+  mol::AtomHandle c1=edi.InsertAtom(r1, "C", geom::Vec3(2.0, 1.5, -2.0), "C");
+  mol::AtomHandle n2=edi.InsertAtom(r2, "N", geom::Vec3(3.0, 1.5, -2.0), "N");
+  mol::AtomHandle o3=edi.InsertAtom(r3, "O", geom::Vec3(4.0, 1.5, -2.0), "O",
+                                    1.0, 0.0, true);
+  n1.SetCharge(-0.5);
+  ca1.SetBoolProp("flag", true);
+  o3.SetRadius(1.25);
+  edi.Connect(n1, ca1);
+  edi.Connect(ca1, c1, 2);
+  edi.Connect(c1, n2);
+  edi.AddTorsion("X", n1, ca1, c1, n2);
+  return ent;
+}
+
+void compare_entities(const mol::EntityHandle& a, const mol::EntityHandle& b)
+{
+  BOOST_CHECK_EQUAL(a.GetName(), b.GetName());
+  BOOST_CHECK_EQUAL(a.GetStringProp("source"), b.GetStringProp("source"));
+  BOOST_REQUIRE_EQUAL(a.GetChainCount(), b.GetChainCount());
+  BOOST_REQUIRE_EQUAL(a.GetResidueCount(), b.GetResidueCount());
+  BOOST_REQUIRE_EQUAL(a.GetAtomCount(), b.GetAtomCount());
+  BOOST_REQUIRE_EQUAL(a.GetBondCount(), b.GetBondCount());
+  mol::ChainHandleList ca=a.GetChainList(), cb=b.GetChainList();
+  for (size_t i=0; i<ca.size(); ++i) {
+    BOOST_CHECK_EQUAL(ca[i].GetName(), cb[i].GetName());
+    BOOST_CHECK_EQUAL(ca[i].GetType(), cb[i].GetType());
+    BOOST_CHECK_EQUAL(ca[i].GetDescription(), cb[i].GetDescription());
+    BOOST_CHECK_EQUAL(ca[i].GetIntProp("copies", 0),
+                      cb[i].GetIntProp("copies", 0));
+  }
+  mol::ResidueHandleList ra=a.GetResidueList(), rb=b.GetResidueList();
+  for (size_t i=0; i<ra.size(); ++i) {
+    BOOST_CHECK_EQUAL(ra[i].GetName(), rb[i].GetName());
+    BOOST_CHECK_EQUAL(ra[i].GetNumber(), rb[i].GetNumber());
+    BOOST_CHECK_EQUAL(ra[i].GetOneLetterCode(), rb[i].GetOneLetterCode());
+    BOOST_CHECK_EQUAL(char(ra[i].GetChemClass()), char(rb[i].GetChemClass()));
+    BOOST_CHECK_EQUAL(char(ra[i].GetSecStructure()),
+                      char(rb[i].GetSecStructure()));
+    BOOST_CHECK_EQUAL(ra[i].IsProtein(), rb[i].IsProtein());
+    BOOST_CHECK_EQUAL(ra[i].IsLigand(), rb[i].IsLigand());
+    BOOST_CHECK_EQUAL(ra[i].GetPropList().size(), rb[i].GetPropList().size());
+  }
+  BOOST_CHECK_CLOSE(rb[1].GetFloatProp("score"), Real(0.5), Real(1e-4));
+  BOOST_CHECK_EQUAL(rb[2].GetVec3Prop("center"), geom::Vec3(1, 2, 3));
+  mol::AtomHandleList aa=a.GetAtomList(), ab=b.GetAtomList();
+  for (size_t i=0; i<aa.size(); ++i) {
+    BOOST_CHECK_EQUAL(aa[i].GetQualifiedName(), ab[i].GetQualifiedName());
+    BOOST_CHECK_EQUAL(aa[i].GetElement(), ab[i].GetElement());
+    BOOST_CHECK_EQUAL(aa[i].GetPos(), ab[i].GetPos());
+    BOOST_CHECK_EQUAL(aa[i].GetOccupancy(), ab[i].GetOccupancy());
+    BOOST_CHECK_EQUAL(aa[i].GetBFactor(), ab[i].GetBFactor());
+    BOOST_CHECK_EQUAL(aa[i].GetCharge(), ab[i].GetCharge());
+    BOOST_CHECK_EQUAL(aa[i].GetRadius(), ab[i].GetRadius());
+    BOOST_CHECK_EQUAL(aa[i].IsHetAtom(), ab[i].IsHetAtom());
+    BOOST_CHECK_EQUAL(aa[i].GetBondCount(), ab[i].GetBondCount());
+    BOOST_CHECK_EQUAL(aa[i].GetPropList().size(), ab[i].GetPropList().size());
+  }
+  mol::BondHandleList ba=a.GetBondList(), bb=b.GetBondList();
+  for (size_t i=0; i<bb.size(); ++i) {
+    mol::AtomHandle a1=a.FindAtom("A", bb[i].GetFirst().GetResidue().GetNumber(),
+                                  bb[i].GetFirst().GetName());
+    mol::AtomHandle a2=a.FindAtom("A", bb[i].GetSecond().GetResidue().GetNumber(),
+                                  bb[i].GetSecond().GetName());
+    mol::BondHandle bond=a1.FindBondToAtom(a2);
+    BOOST_CHECK(bond.IsValid());
+    BOOST_CHECK_EQUAL(bond.GetBondOrder(), bb[i].GetBondOrder());
+  }
+  mol::TorsionHandle t=rb[0].FindTorsion("X");
+  BOOST_REQUIRE(t.IsValid());
+  BOOST_CHECK_EQUAL(t.GetFirst().GetName(), "N");
+  BOOST_CHECK_EQUAL(t.GetFourth().GetResidue().GetName(), "GLY");
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE( io );
+
+BOOST_AUTO_TEST_CASE(test_io_binary_provides)
+{
+  BOOST_CHECK(EntityIOBinaryHandler::ProvidesImport("", "ostbin"));
+  BOOST_CHECK(EntityIOBinaryHandler::ProvidesImport("test.ostbin"));
+  BOOST_CHECK(EntityIOBinaryHandler::ProvidesImport("test.OSTBIN.gz"));
+  BOOST_CHECK(!EntityIOBinaryHandler::ProvidesImport("test.pdb"));
+  BOOST_CHECK(EntityIOBinaryHandler::ProvidesExport("", "ostbin"));
+  BOOST_CHECK(EntityIOBinaryHandler::ProvidesExport("test.ostbin"));
+  BOOST_CHECK(!EntityIOBinaryHandler::ProvidesExport("test.pdb"));
+}
+
+BOOST_AUTO_TEST_CASE(test_io_binary_stream_roundtrip)
+{
+  mol::EntityHandle ent=make_test_entity();
+  EntityIOBinaryHandler handler;
+  std::stringstream ss;
+  handler.Export(ent.CreateFullView(), ss);
+  mol::EntityHandle loaded=mol::CreateEntity();
+  handler.Import(loaded, ss);
+  compare_entities(ent, loaded);
+}
+
+BOOST_AUTO_TEST_CASE(test_io_binary_file_roundtrip)
+{
+  mol::EntityHandle ent=make_test_entity();
+  EntityIOBinaryHandler handler;
+  const char* names[]={ "testfiles/test_out.ostbin",
+                        "testfiles/test_out.ostbin.gz" };
+  for (int i=0; i<2; ++i) {
+    handler.Export(ent.CreateFullView(), names[i]);
+    mol::EntityHandle loaded=mol::CreateEntity();
+    handler.Import(loaded, names[i]);
+    compare_entities(ent, loaded);
+    boost::filesystem::remove(names[i]);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_io_binary_view)
+{
+  // bonds and torsions to atoms outside of the view are dropped
+  mol::EntityHandle ent=make_test_entity();
+  EntityIOBinaryHandler handler;
+  std::stringstream ss;
+  handler.Export(ent.Select("rname=ALA"), ss);
+  mol::EntityHandle loaded=mol::CreateEntity();
+  handler.Import(loaded, ss);
+  BOOST_CHECK_EQUAL(loaded.GetResidueCount(), 1);
+  BOOST_CHECK_EQUAL(loaded.GetAtomCount(), 3);
+  BOOST_CHECK_EQUAL(loaded.GetBondCount(), 2);
+  BOOST_CHECK(!loaded.GetResidueList()[0].FindTorsion("X").IsValid());
+}
+
+BOOST_AUTO_TEST_CASE(test_io_binary_invalid)
+{
+  mol::EntityHandle ent=make_test_entity();
+  EntityIOBinaryHandler handler;
+  std::stringstream ss;
+  handler.Export(ent.CreateFullView(), ss);
+  String data=ss.str();
+  // truncated file
+  std::stringstream truncated(data.substr(0, data.size()/2));
+  mol::EntityHandle loaded=mol::CreateEntity();
+  BOOST_CHECK_THROW(handler.Import(loaded, truncated), IOException);
+  // newer format version
+  String newer=data;
+  newer[4]=static_cast<char>(EntityIOBinaryHandler::VERSION+1);
+  std::stringstream newer_stream(newer);
+  loaded=mol::CreateEntity();
+  BOOST_CHECK_THROW(handler.Import(loaded, newer_stream), IOException);
+  // no magic number
+  std::stringstream garbage("ATOM      1  N   ALA A   1");
+  loaded=mol::CreateEntity();
+  BOOST_CHECK_THROW(handler.Import(loaded, garbage), IOException);
+}
+
+BOOST_AUTO_TEST_SUITE_END();
@@ -27,6 +27,7 @@
 #include <ost/mol/atom_handle.hh>
 #include <ost/mol/xcs_editor.hh>
 #include <ost/mol/coord_group.hh>
+#include <ost/io/io_exception.hh>
 
 using namespace ost;
 using namespace ost::io;
@@ -86,4 +87,66 @@ BOOST_AUTO_TEST_CASE(test_io_dcd_charmm_frames)
   }
 }
 
+BOOST_AUTO_TEST_CASE(test_io_dcd_mapped)
+{
+  mol::EntityHandle eh=mol::CreateEntity();
+  mol::XCSEditor ed=eh.EditXCS();
+  mol::ChainHandle chain=ed.InsertChain("A");
+  mol::ResidueHandle res=ed.AppendResidue(chain,mol::ResidueKey("UNK"));
+
+  static unsigned int natoms=7;
+  static unsigned int nframes=5;
+
+  mol::AtomHandleList atoms(natoms);
+  std::ostringstream aname;
+  for(size_t i=0;i<natoms;++i) {
+    aname.str("");
+    aname << "X" << i;
+    atoms[i]=ed.InsertAtom(res,aname.str(),geom::Vec3());
+  }
+  mol::CoordGroupHandle cg=mol::CreateCoordGroup(atoms);
+  for(size_t f=0;f<nframes;++f) {
+    geom::Vec3List atom_pos(natoms);
+    for(size_t i=0;i<natoms;++i) {
+      for(size_t k=0;k<3;++k) {
+        atom_pos[i][k]=UniformRandom();
+      }
+    }
+    geom::Vec3 cell_size(UniformRandom(),UniformRandom(),UniformRandom());
+    cg.AddFrame(atom_pos,cell_size,geom::Vec3(0.5*M_PI,0.5*M_PI,0.5*M_PI));
+  }
+  SaveCHARMMTraj(cg,"","test_io_dcd_mapped.dcd");
+
+  DCDMappedCoordSource source(cg.GetAtomList(),"test_io_dcd_mapped.dcd",1,2);
+  BOOST_CHECK_EQUAL(source.GetFrameCount(),nframes);
+  BOOST_CHECK(!source.IsByteSwapped());
+  // access frames in random order, more than the cache can hold
+  unsigned int order[]={3,0,4,3,1,2,0};
+  for(size_t n=0;n<7;++n) {
+    unsigned int f=order[n];
+    mol::CoordFramePtr cf=source.GetFrame(f);
+    mol::CoordFramePtr ref=cg.GetFrame(f);
+    BOOST_CHECK(geom::Distance(cf->GetCellSize(),ref->GetCellSize())<1e-5);
+    DCDFrameView view=source.GetFrameView(f);
+    BOOST_CHECK_EQUAL(view.count,natoms);
+    for(size_t i=0;i<natoms;++i) {
+      BOOST_CHECK(geom::Distance((*cf)[i],(*ref)[i])<1e-5);
+      BOOST_CHECK_EQUAL(view.x[i],(*cf)[i][0]);
+      BOOST_CHECK_EQUAL(view.y[i],(*cf)[i][1]);
+      BOOST_CHECK_EQUAL(view.z[i],(*cf)[i][2]);
+    }
+  }
+  // cached frames are shared
+  BOOST_CHECK(source.GetFrame(0)==source.GetFrame(0));
+  BOOST_CHECK_THROW(source.GetFrame(nframes),IOException);
+
+  mol::CoordGroupHandle cg2=LoadCHARMMTrajMapped(eh,"test_io_dcd_mapped.dcd",2);
+  BOOST_CHECK_EQUAL(cg2.GetFrameCount(),uint(3));
+  geom::Vec3List atom_pos2=cg2.GetFramePositions(2);
+  geom::Vec3List atom_pos4=cg.GetFramePositions(4);
+  for(size_t i=0;i<natoms;++i) {
+    BOOST_CHECK(geom::Distance(atom_pos2[i],atom_pos4[i])<1e-5);
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END();
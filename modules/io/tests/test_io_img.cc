@@ -27,6 +27,7 @@
 
 #include <map>
 #include <ost/io/img/load_map.hh>
+#include <ost/io/io_exception.hh>
 #include <ost/img/image_factory.hh>
 #include <ost/img/alg/randomize.hh>
 #include  <ost/io/img/map_io_df3_handler.hh>
@@ -169,6 +170,38 @@ BOOST_AUTO_TEST_CASE(test_io_img)
   }
 }
 
+BOOST_AUTO_TEST_CASE(test_io_img_mrc_sub_extent)
+{
+  ost::img::ImageHandle testimage=ost::img::CreateImage(ost::img::Extent(ost::img::Point(-2,0,1),ost::img::Point(5,6,4)));
+  int counter=0;
+  for (img::ExtentIterator i(testimage.GetExtent()); !i.AtEnd(); ++i, ++counter) {
+   testimage.SetReal(i, counter);
+  }
+  const String fname("temp_img.ccp4");
+  std::vector<Endianess> endianesses;
+  endianesses.push_back(OST_BIG_ENDIAN);
+  endianesses.push_back(OST_LITTLE_ENDIAN);
+  for (size_t i=0; i<endianesses.size(); ++i) {
+    ost::io::SaveImage(testimage,fname,CCP4(false,endianesses[i]));
+    MRC format(false,MRC_NEW_FORMAT);
+    ost::img::Extent sub_extent(ost::img::Point(-1,2,0),ost::img::Point(3,4,2));
+    format.SetSubExtent(sub_extent);
+    BOOST_CHECK(format.HasSubExtent());
+    ost::img::ImageHandle loadedimage=ost::io::LoadImage(fname,format);
+    ost::img::Extent expected=ost::img::Overlap(testimage.GetExtent(),sub_extent);
+    BOOST_CHECK_EQUAL(loadedimage.GetExtent(),expected);
+    for(ost::img::ExtentIterator eit(expected);!eit.AtEnd();++eit) {
+      BOOST_CHECK_EQUAL(testimage.GetReal(eit),loadedimage.GetReal(eit));
+    }
+    format.SetSubExtent(ost::img::Extent(ost::img::Point(10,10,10),ost::img::Point(12,12,12)));
+    BOOST_CHECK_THROW(ost::io::LoadImage(fname,format),IOException);
+    format.ClearSubExtent();
+    BOOST_CHECK(!format.HasSubExtent());
+    loadedimage=ost::io::LoadImage(fname,format);
+    BOOST_CHECK_EQUAL(loadedimage.GetExtent(),testimage.GetExtent());
+  }
+}
+
 BOOST_AUTO_TEST_CASE(test_io_img_dat)
 {
   // test for the dat file format using a square image (non square images not supported by dat)
@@ -1,6 +1,7 @@
 import unittest
 from ost import *
 import subprocess
+import shutil
 
 class TestPDB(unittest.TestCase):
   def setUp(self):
@@ -36,6 +37,27 @@ class TestPDB(unittest.TestCase):
     self.assertTrue(mol.BondExists(res2.FindAtom("CA"),res2.FindAtom("CB")))
     self.assertTrue(mol.BondExists(resd.FindAtom("CA"),resd.FindAtom("CB")))
 
+  def test_cached_alt_loc(self):
+    # alternative locations are not stored by OstBin, such entities must not
+    # be returned from the cache
+    cache=io.EntityCache.Instance()
+    old_dir=cache.GetDirectory()
+    cache.SetDirectory('testfiles/entity_cache_alt_loc')
+    cache.Clear()
+    cache.ResetStatistics()
+    try:
+      for i in range(2):
+        ent=io.LoadPDB('testfiles/pdb/alt-loc.pdb')
+        res=ent.residues[0]
+        self.assertTrue(res.HasAltAtoms())
+        self.assertEqual(sorted(res.GetAltAtomGroupNames()), ['A', 'B'])
+      self.assertEqual(cache.hit_count, 0)
+      self.assertEqual(cache.miss_count, 2)
+    finally:
+      cache.SetDirectory(old_dir)
+      cache.ResetStatistics()
+      shutil.rmtree('testfiles/entity_cache_alt_loc', ignore_errors=True)
+
   def test_remote_loading(self):
 
     if subprocess.call(['ping google.com -c 1'], shell=True,
@@ -0,0 +1,57 @@
+//------------------------------------------------------------------------------
+// This file is part of the OpenStructure project <www.openstructure.org>
+//
+// Copyright (C) 2008-2020 by the OpenStructure authors
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 3.0 of the License, or (at your option)
+// any later version.
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//------------------------------------------------------------------------------
+#include <boost/python.hpp>
+#include <ost/mol/alg/pairwise_scores.hh>
+
+using namespace boost::python;
+using namespace ost;
+using namespace ost::mol::alg;
+
+namespace {
+
+SimilarityMatrix pairwise_scores_list(list& structures, PairwiseScore score,
+                                      int num_threads)
+{
+  std::vector<geom::Vec3List> v;
+  for (int i=0; i<len(structures); ++i) {
+    v.push_back(extract<geom::Vec3List>(structures[i]));
+  }
+  return PairwiseScores(v, score, num_threads);
+}
+
+SimilarityMatrix (*pairwise_scores_cg)(const mol::CoordGroupHandle&,
+                                       const mol::EntityView&, PairwiseScore,
+                                       int, int, int)=&PairwiseScores;
+
+}
+
+void export_pairwise_scores()
+{
+  enum_<PairwiseScore>("PairwiseScore")
+    .value("PS_RMSD", PS_RMSD)
+    .value("PS_GDT_TS", PS_GDT_TS)
+    .value("PS_TM_SCORE", PS_TM_SCORE)
+    .export_values()
+  ;
+  def("PairwiseScores", &pairwise_scores_list,
+      (arg("structures"), arg("score")=PS_RMSD, arg("num_threads")=1));
+  def("PairwiseScores", pairwise_scores_cg,
+      (arg("source"), arg("sel")=mol::EntityView(), arg("score")=PS_RMSD,
+       arg("begin")=0, arg("end")=-1, arg("num_threads")=1));
+}
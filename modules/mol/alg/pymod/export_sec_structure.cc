@@ -26,18 +26,20 @@ using namespace boost::python;
 
 namespace{
 
-void AssignSecStructView(ost::mol::EntityView& view) {
-  ost::mol::alg::AssignSecStruct(view);
+void AssignSecStructView(ost::mol::EntityView& view, int num_threads) {
+  ost::mol::alg::AssignSecStruct(view, num_threads);
 }
 
-void AssignSecStructHandle(ost::mol::EntityHandle& handle) {
-  ost::mol::alg::AssignSecStruct(handle);
+void AssignSecStructHandle(ost::mol::EntityHandle& handle, int num_threads) {
+  ost::mol::alg::AssignSecStruct(handle, num_threads);
 }
 
 } // ns
 
 void export_sec_struct() {
-  def("AssignSecStruct", &AssignSecStructView, (arg("ent")));
-  def("AssignSecStruct", &AssignSecStructHandle, (arg("ent")));
+  def("AssignSecStruct", &AssignSecStructView, (arg("ent"),
+                                                 arg("num_threads")=1));
+  def("AssignSecStruct", &AssignSecStructHandle, (arg("ent"),
+                                                   arg("num_threads")=1));
 }
 
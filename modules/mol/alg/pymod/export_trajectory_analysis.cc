@@ -20,6 +20,7 @@
 using namespace boost::python;
 
 #include <ost/mol/alg/trajectory_analysis.hh>
+#include <ost/mol/alg/trajectory_pipeline.hh>
 
 using namespace ost;
 using namespace ost::mol::alg;
@@ -52,4 +53,22 @@ void export_TrajectoryAnalysis()
   def("AnalyzeBestFitPlane", &AnalyzeBestFitPlane, (arg("traj"), arg("protein_segment"), arg("normals"), arg("origins"), arg("stride")=1));
   def("AnalyzeHelicity", &AnalyzeHelicity, (arg("traj"), arg("protein_segment"), arg("stride")=1));
   def("CreateMeanStructure", &CreateMeanStructure, (arg("traj"), arg("selection"), arg("from")=0, arg("to")=-1, arg("stride")=1 ));
+
+  class_<TrajectoryPipeline>("TrajectoryPipeline",
+                             init<const mol::CoordGroupHandle&, optional<unsigned int, int, unsigned int> >(
+                             (arg("traj"), arg("stride")=1, arg("num_threads")=1, arg("batch_size")=64)))
+    .def("AddAtomPos", &TrajectoryPipeline::AddAtomPos, (arg("atom")))
+    .def("AddCenterOfMassPos", &TrajectoryPipeline::AddCenterOfMassPos, (arg("selection")))
+    .def("AddDistanceBetwAtoms", &TrajectoryPipeline::AddDistanceBetwAtoms, (arg("atom1"), arg("atom2")))
+    .def("AddAngle", &TrajectoryPipeline::AddAngle, (arg("atom1"), arg("atom2"), arg("atom3")))
+    .def("AddDihedralAngle", &TrajectoryPipeline::AddDihedralAngle, (arg("atom1"), arg("atom2"), arg("atom3"), arg("atom4")))
+    .def("AddDistanceBetwCenterOfMass", &TrajectoryPipeline::AddDistanceBetwCenterOfMass, (arg("sele1"), arg("sele2")))
+    .def("AddRMSD", &TrajectoryPipeline::AddRMSD, (arg("reference_view"), arg("sele_view")))
+    .def("AddMinDistance", &TrajectoryPipeline::AddMinDistance, (arg("view1"), arg("view2")))
+    .def("AddMinDistanceBetwCenterOfMassAndView", &TrajectoryPipeline::AddMinDistanceBetwCenterOfMassAndView, (arg("view_cm"), arg("view_atoms")))
+    .def("Run", &TrajectoryPipeline::Run)
+    .def("GetFrameCount", &TrajectoryPipeline::GetFrameCount)
+    .def("GetResult", &TrajectoryPipeline::GetResult, return_value_policy<copy_const_reference>(), (arg("analyzer")))
+    .def("GetVec3Result", &TrajectoryPipeline::GetVec3Result, (arg("analyzer")))
+  ;
 }
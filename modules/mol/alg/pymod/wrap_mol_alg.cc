@@ -48,13 +48,14 @@ void export_contact_overlap();
 void export_accessibility();
 void export_sec_struct();
 void export_find_membrane();
+void export_pairwise_scores();
 #if OST_IMG_ENABLED
 void export_entity_to_density();
 #endif
 
 namespace {
   
-std::pair<long int,long int> (*lddt_a)(const mol::EntityView&, const mol::alg::GlobalRDMap& , std::vector<Real>, int, const String&)=&mol::alg::LocalDistDiffTest;
+std::pair<long int,long int> (*lddt_a)(const mol::EntityView&, const mol::alg::GlobalRDMap& , std::vector<Real>, int, const String&, int)=&mol::alg::LocalDistDiffTest;
 Real (*lddt_c)(const mol::EntityView&, const mol::EntityView& , Real, Real, const String&)=&mol::alg::LocalDistDiffTest;
 // Real (*lddt_d)(const mol::EntityView&, std::vector<mol::EntityView>&, const mol::alg::GlobalRDMap&, mol::alg::lDDTSettings&)=&mol::alg::LocalDistDiffTest;
 Real (*lddt_b)(const seq::AlignmentHandle&,Real, Real, int, int)=&mol::alg::LocalDistDiffTest;
@@ -62,8 +63,8 @@ std::pair<mol::EntityView,mol::alg::ClashingInfo> (*fc_a)(const mol::EntityView&
 std::pair<mol::EntityView,mol::alg::ClashingInfo> (*fc_b)(const mol::EntityHandle&, const mol::alg::ClashingDistances&, bool)=&mol::alg::FilterClashes;
 std::pair<mol::EntityView,mol::alg::StereoChemistryInfo> (*csc_a)(const mol::EntityView&, const mol::alg::StereoChemicalParams&, const mol::alg::StereoChemicalParams&, Real, Real, bool)=&mol::alg::CheckStereoChemistry;
 std::pair<mol::EntityView,mol::alg::StereoChemistryInfo> (*csc_b)(const mol::EntityHandle&, const mol::alg::StereoChemicalParams&, const mol::alg::StereoChemicalParams&, Real, Real, bool)=&mol::alg::CheckStereoChemistry;
-mol::CoordGroupHandle (*superpose_frames1)(mol::CoordGroupHandle&, mol::EntityView&, int, int, int)=&mol::alg::SuperposeFrames;
-mol::CoordGroupHandle (*superpose_frames2)(mol::CoordGroupHandle&,  mol::EntityView&, mol::EntityView&, int, int)=&mol::alg::SuperposeFrames;
+mol::CoordGroupHandle (*superpose_frames1)(mol::CoordGroupHandle&, mol::EntityView&, int, int, int, int)=&mol::alg::SuperposeFrames;
+mol::CoordGroupHandle (*superpose_frames2)(mol::CoordGroupHandle&,  mol::EntityView&, mol::EntityView&, int, int, int)=&mol::alg::SuperposeFrames;
 
 
 Real lddt_d(const mol::EntityView& model, list& reference_list, const mol::alg::GlobalRDMap& distance_list, mol::alg::lDDTSettings& settings){
@@ -101,7 +102,7 @@ ost::mol::alg::ClashingDistances fill_clashing_distances_wrapper (const list& st
  return ost::mol::alg::FillClashingDistances(stereo_chemical_props_file_vector);
 }
 
-ost::mol::alg::GlobalRDMap create_distance_list_from_multiple_references(const list& reference_list, const list& cutoff_list, int sequence_separation, Real max_dist)
+ost::mol::alg::GlobalRDMap create_distance_list_from_multiple_references(const list& reference_list, const list& cutoff_list, int sequence_separation, Real max_dist, int num_threads)
 {
   int reference_list_length = boost::python::extract<int>(reference_list.attr("__len__")());
   std::vector<ost::mol::EntityView> reference_list_vector(reference_list_length);
@@ -116,7 +117,7 @@ ost::mol::alg::GlobalRDMap create_distance_list_from_multiple_references(const l
   for (int i=0; i<cutoff_list_length; i++) {
     cutoff_list_vector[i] = boost::python::extract<Real>(cutoff_list[i]);
   }
-  return ost::mol::alg::CreateDistanceListFromMultipleReferences(reference_list_vector, cutoff_list_vector, sequence_separation, max_dist);  	
+  return ost::mol::alg::CreateDistanceListFromMultipleReferences(reference_list_vector, cutoff_list_vector, sequence_separation, max_dist, num_threads);  	
 }
 
 object lDDTSettingsInitWrapper(tuple args, dict kwargs){
@@ -157,20 +158,27 @@ object lDDTSettingsInitWrapper(tuple args, dict kwargs){
     kwargs["label"].del();
   }
 
+  int num_threads = 1;
+  if(kwargs.contains("num_threads")){
+    num_threads = extract<int>(kwargs["num_threads"]);
+    kwargs["num_threads"].del();
+  }
+
   if(len(kwargs) > 0){
     std::stringstream ss;
     ss << "Invalid keywords observed when setting up lDDTSettings! ";
     ss << "Or did you pass the same keyword twice? ";
     ss << "Valid keywords are: radius, ";
     ss << "sequence_separation, parameter_file_path, ";
-    ss << "cutoffs, label!";
+    ss << "cutoffs, label, num_threads!";
     throw std::invalid_argument(ss.str());
   }
 
   return self.attr("__init__")(radius, 
                                sequence_separation,
                                cutoffs,
-                               label);
+                               label,
+                               num_threads);
 }
 
 object lDDTScorerInitWrapper(tuple args, dict kwargs){
@@ -235,7 +243,8 @@ void clean_lddt_references_wrapper(const list& reference_list)
 ost::mol::alg::GlobalRDMap prepare_lddt_global_rdmap_wrapper(const list& reference_list,
                                                              list& cutoff_list,
                                                              int sequence_separation,
-                                                             Real max_dist)
+                                                             Real max_dist,
+                                                             int num_threads)
 {
   int reference_list_length = boost::python::extract<int>(reference_list.attr("__len__")());
   std::vector<ost::mol::EntityView> reference_list_vector(reference_list_length);
@@ -251,7 +260,7 @@ ost::mol::alg::GlobalRDMap prepare_lddt_global_rdmap_wrapper(const list& referen
     cutoff_list_vector[i] = boost::python::extract<Real>(cutoff_list[i]);
   }
  
- return mol::alg::PreparelDDTGlobalRDMap(reference_list_vector, cutoff_list_vector, sequence_separation, max_dist);
+ return mol::alg::PreparelDDTGlobalRDMap(reference_list_vector, cutoff_list_vector, sequence_separation, max_dist, num_threads);
 }
 
 list get_lddt_per_residue_stats_wrapper(mol::EntityView& model,
@@ -320,11 +329,12 @@ BOOST_PYTHON_MODULE(_ost_mol_alg)
   export_accessibility();
   export_sec_struct();
   export_find_membrane();
+  export_pairwise_scores();
   #if OST_IMG_ENABLED
   export_entity_to_density();
   #endif
   
-  def("LocalDistDiffTest", lddt_a, (arg("sequence_separation")=0,arg("local_lddt_property_string")=""));
+  def("LocalDistDiffTest", lddt_a, (arg("sequence_separation")=0,arg("local_lddt_property_string")="",arg("num_threads")=1));
   def("LocalDistDiffTest", lddt_c, (arg("local_lddt_property_string")=""));
   def("LocalDistDiffTest", lddt_b, (arg("ref_index")=0, arg("mdl_index")=1));
   def("LocalDistDiffTest", &lddt_d, (arg("model"), arg("reference_list"), ("distance_list"), arg("settings")));
@@ -333,14 +343,16 @@ BOOST_PYTHON_MODULE(_ost_mol_alg)
   def("CheckStereoChemistry", csc_a, (arg("ent"), arg("bonds"), arg("angles"), arg("bond_tolerance"), arg("angle_tolerance"), arg("always_remove_bb")=false));
   def("CheckStereoChemistry", csc_b, (arg("ent"), arg("bonds"), arg("angles"), arg("bond_tolerance"), arg("angle_tolerance"), arg("always_remove_bb")=false));
   def("LDDTHA",&mol::alg::LDDTHA, (arg("sequence_separation")=0));
-  def("CreateDistanceList",&mol::alg::CreateDistanceList);
-  def("CreateDistanceListFromMultipleReferences",&create_distance_list_from_multiple_references);
+  def("CreateDistanceList",&mol::alg::CreateDistanceList, (arg("ref"), arg("max_dist"), arg("num_threads")=1));
+  def("CreateDistanceListFromMultipleReferences",&create_distance_list_from_multiple_references,
+      (arg("ref_list"), arg("cutoff_list"), arg("sequence_separation"), arg("max_dist"), arg("num_threads")=1));
 
   def("SuperposeFrames", superpose_frames1, 
       (arg("source"), arg("sel")=ost::mol::EntityView(), arg("begin")=0, 
-       arg("end")=-1, arg("ref")=-1));
+       arg("end")=-1, arg("ref")=-1, arg("num_threads")=1));
   def("SuperposeFrames", superpose_frames2, 
-  (arg("source"), arg("sel"), arg("ref_view"),arg("begin")=0, arg("end")=-1));
+  (arg("source"), arg("sel"), arg("ref_view"),arg("begin")=0, arg("end")=-1,
+   arg("num_threads")=1));
 
   
   class_<mol::alg::ClashingDistances> ("ClashingDistances",init<>())
@@ -373,7 +385,7 @@ BOOST_PYTHON_MODULE(_ost_mol_alg)
 
   class_<mol::alg::lDDTSettings>("lDDTSettings", no_init)
     .def("__init__", raw_function(lDDTSettingsInitWrapper))
-    .def(init<Real, int, std::vector<Real>&, String>())
+    .def(init<Real, int, std::vector<Real>&, String, optional<int> >())
     .def("ToString", &mol::alg::lDDTSettings::ToString)
     .def("PrintParameters", &mol::alg::lDDTSettings::PrintParameters)
     .def("__repr__", &mol::alg::lDDTSettings::ToString)
@@ -381,7 +393,8 @@ BOOST_PYTHON_MODULE(_ost_mol_alg)
     .def_readwrite("radius", &mol::alg::lDDTSettings::radius)
     .def_readwrite("sequence_separation", &mol::alg::lDDTSettings::sequence_separation)
     .def_readwrite("cutoffs", &mol::alg::lDDTSettings::cutoffs)
-    .def_readwrite("label", &mol::alg::lDDTSettings::label);
+    .def_readwrite("label", &mol::alg::lDDTSettings::label)
+    .def_readwrite("num_threads", &mol::alg::lDDTSettings::num_threads);
 
   class_<mol::alg::lDDTLocalScore>("lDDTLocalScore", init<String, String, int, String, String, Real, int, int>())
     .def("ToString", &mol::alg::lDDTLocalScore::ToString)
@@ -404,6 +417,7 @@ BOOST_PYTHON_MODULE(_ost_mol_alg)
       .add_property("conserved_contacts", &mol::alg::lDDTScorer::GetNumConservedContacts)
       .add_property("total_contacts", &mol::alg::lDDTScorer::GetNumTotalContacts)
       .def("PrintPerResidueStats", &mol::alg::lDDTScorer::PrintPerResidueStats)
+      .def("ScoreCoordinates", &mol::alg::lDDTScorer::ScoreCoordinates)
       .add_property("local_scores", &get_local_scores_wrapper)
       .def_readonly("model", &mol::alg::lDDTScorer::model_view)
       .add_property("references", &get_references_wrapper)
@@ -425,7 +439,8 @@ BOOST_PYTHON_MODULE(_ost_mol_alg)
   def("CleanlDDTReferences", &clean_lddt_references_wrapper);
   def("PreparelDDTGlobalRDMap",
       &prepare_lddt_global_rdmap_wrapper,
-      (arg("reference_list"), arg("cutoffs"), arg("sequence_separation"), arg("radius")));
+      (arg("reference_list"), arg("cutoffs"), arg("sequence_separation"), arg("radius"),
+       arg("num_threads")=1));
   def("CheckStructure",
       &mol::alg::CheckStructure,
       (arg("ent"), arg("bond_table"), arg("angle_table"), arg("nonbonded_table"),
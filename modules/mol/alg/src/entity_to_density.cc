@@ -1,6 +1,9 @@
 #include <sstream>
 #include <cmath>
+#include <map>
 
+#include <boost/thread/thread.hpp>
+#include <boost/bind.hpp>
 #include <boost/filesystem/fstream.hpp>
 #include <boost/filesystem/convenience.hpp>
 #include <boost/algorithm/string.hpp>
@@ -86,6 +89,96 @@ Real ScatteringFactor (Real frequency, const AtomScatteringProps& props,
 }
 
 
+// Gaussian placed on the pixel grid. The box of pixels covered by the
+// Gaussian starts at the zero-based index start and the center is given
+// relative to the start pixel.
+struct GaussianSplat {
+  int        start[3];
+  int        size[3];
+  geom::Vec3 center;
+  Real       amplitude;
+};
+
+int WrapIndex(int i, int n)
+{
+  i%=n;
+  return i<0 ? i+n : i;
+}
+
+// Adds amplitude*exp(-k*d^2) of every splat to all pixels within the cutoff
+// distance. The exponential is separable, so it only has to be evaluated
+// along the three axes of the box. Planes of the first axis are distributed
+// among the threads, which hence never write to the same pixel. For periodic
+// grids, pixels outside of the grid are wrapped around.
+void SplatGaussianPlanes(img::RealSpatialImageState* is,
+                         const std::vector<GaussianSplat>* splats,
+                         const geom::Vec3& sampling, Real k, Real cutoff2,
+                         bool periodic, int first, int num_threads)
+{
+  img::Size size=is->GetExtent().GetSize();
+  std::vector<Real> d2[3], factor[3];
+  for (std::vector<GaussianSplat>::const_iterator i=splats->begin(),
+       e=splats->end(); i!=e; ++i) {
+    bool have_tables=false;
+    for (int x=0; x<i->size[0]; ++x) {
+      int u=periodic ? WrapIndex(i->start[0]+x, size[0]) : i->start[0]+x;
+      if (u%num_threads!=first) {
+        continue;
+      }
+      if (!have_tables) {
+        for (int a=0; a<3; ++a) {
+          d2[a].resize(i->size[a]);
+          factor[a].resize(i->size[a]);
+          for (int j=0; j<i->size[a]; ++j) {
+            Real d=j*sampling[a]-i->center[a];
+            d2[a][j]=d*d;
+            factor[a][j]=std::exp(-k*d2[a][j]);
+          }
+        }
+        have_tables=true;
+      }
+      if (d2[0][x]>cutoff2) {
+        continue;
+      }
+      Real value_x=i->amplitude*factor[0][x];
+      for (int y=0; y<i->size[1]; ++y) {
+        Real d2_xy=d2[0][x]+d2[1][y];
+        if (d2_xy>cutoff2) {
+          continue;
+        }
+        int v=periodic ? WrapIndex(i->start[1]+y, size[1]) : i->start[1]+y;
+        Real value_xy=value_x*factor[1][y];
+        for (int z=0; z<i->size[2]; ++z) {
+          if (d2_xy+d2[2][z]<=cutoff2) {
+            int w=periodic ? WrapIndex(i->start[2]+z, size[2]) : i->start[2]+z;
+            is->Value(img::Index(u, v, w))+=value_xy*factor[2][z];
+          }
+        }
+      }
+    }
+  }
+}
+
+void SplatGaussians(img::RealSpatialImageState& is,
+                    const std::vector<GaussianSplat>& splats,
+                    const geom::Vec3& sampling, Real k, Real cutoff2,
+                    bool periodic, int num_threads)
+{
+  int planes=is.GetExtent().GetSize()[0];
+  num_threads=std::max(1, std::min(num_threads, planes));
+  if (num_threads==1) {
+    SplatGaussianPlanes(&is, &splats, sampling, k, cutoff2, periodic, 0, 1);
+    return;
+  }
+  boost::thread_group tg;
+  for (int i=0; i<num_threads; ++i) {
+    tg.create_thread(boost::bind(&SplatGaussianPlanes, &is, &splats, sampling,
+                                 k, cutoff2, periodic, i, num_threads));
+  }
+  tg.join_all();
+}
+
+
 class EntityToDensityHelperBase
 {
 
@@ -236,6 +329,200 @@ typedef img::ImageStateConstModIPAlgorithm<EntityToDensityHelperBase>
         EntityToDensityHelper;
 
 
+// Same as the EntityToDensityHelperBase, but instead of summing the
+// contributions of every atom to every frequency directly, the atoms of each
+// element are spread onto a real space grid with a narrow Gaussian, which is
+// then Fourier transformed and divided by the transform of the Gaussian. The
+// width of the Gaussian and the kernel radius are chosen such that aliasing
+// and truncation errors stay in the order of 1e-4 relative to the amplitude
+// within the falloff. If the falloff extends beyond 2/3 of the Nyquist
+// frequency, the grid is oversampled by a factor of two.
+class EntityToDensityGriddingHelperBase
+{
+
+public:
+
+  EntityToDensityGriddingHelperBase (const ost::mol::EntityView entity_view,
+                                     Real falloff_start,
+                                     Real falloff_end,
+                                     Real source_wavelength,
+                                     geom::Vec3 map_start,
+                                     geom::Vec3 map_end,
+                                     geom::Vec3 sampling,
+                                     int num_threads):
+      entity_view_(entity_view),
+      falloff_start_frequency_(1.0/falloff_start),
+      falloff_end_frequency_(1.0/falloff_end),
+      source_wavelength_(source_wavelength),
+      map_start_(map_start), map_end_(map_end), sampling_(sampling),
+      num_threads_(num_threads)
+  {
+    if (scattering_props_table_loaded_ == false)
+    {
+      FillAtomScatteringPropsTable(scatt_props_table_);
+      scattering_props_table_loaded_ = true;
+    }
+  }
+
+  void VisitState(img::ComplexHalfFrequencyImageState& is) const
+  {
+    geom::Vec3 frequency_sampling =
+             is.GetSampling().GetFrequencySampling();
+    img::Size size = is.GetLogicalExtent().GetSize();
+
+    uint x_limit = ceil(falloff_end_frequency_ / frequency_sampling[0]);
+    uint y_limit = ceil(falloff_end_frequency_ / frequency_sampling[1]);
+    uint z_limit = ceil(falloff_end_frequency_ / frequency_sampling[2]);
+    img::Extent reduced_extent = img::Overlap(img::Extent
+             (img::Point(-static_cast<int>(x_limit),-static_cast<int>(y_limit),0),
+              img::Point(x_limit,y_limit,z_limit)), is.GetExtent());
+
+    int oversampling = 1;
+    for (int a = 0; a < 3; ++a) {
+      if (falloff_end_frequency_*sampling_[a] > 1.0/3.0) {
+        oversampling = 2;
+      }
+    }
+    geom::Vec3 grid_sampling = sampling_/oversampling;
+    img::Size grid_size(oversampling*size[0], oversampling*size[1],
+                        oversampling*size[2]);
+
+    // aliased frequencies are attenuated by the Gaussian relative to the
+    // frequencies within the falloff by at least exp(-9.2)=1e-4
+    Real sigma2 = 0.0;
+    for (int a = 0; a < 3; ++a) {
+      Real max_frequency = std::min(falloff_end_frequency_,
+                                    Real(0.5/sampling_[a]));
+      Real grid_frequency = 1.0/grid_sampling[a];
+      sigma2 = std::max(sigma2, Real(9.2/(2.0*M_PI*M_PI*grid_frequency*
+                                 (grid_frequency-2.0*max_frequency))));
+    }
+    Real radius = 5.0*sqrt(sigma2);
+
+    std::map<String, int> element_indices;
+    for (size_t i = 0; i < scatt_props_table_.size(); ++i) {
+      element_indices.insert(std::make_pair(scatt_props_table_[i].element,
+                                            static_cast<int>(i)));
+    }
+    std::vector<std::vector<GaussianSplat> > splats(scatt_props_table_.size());
+    for (ChainViewList::const_iterator ci = entity_view_.GetChainList().begin(),
+        ce = entity_view_.GetChainList().end(); ci != ce; ++ci) {
+    for (ResidueViewList::const_iterator ri = ci->GetResidueList().begin(),
+          re = ci->GetResidueList().end(); ri != re; ++ri) {
+    for (AtomViewList::const_iterator ai = ri->GetAtomList().begin(),
+          ae = ri->GetAtomList().end(); ai!= ae; ++ai) {
+      std::map<String, int>::const_iterator element =
+                                   element_indices.find(ai->GetElement());
+      if (element==element_indices.end()) {
+        continue;
+      }
+      geom::Vec3 coord = ai->GetPos();
+      if (coord[0] >= map_start_[0] &&
+          coord[0] <= map_end_[0] &&
+          coord[1] >= map_start_[1] &&
+          coord[1] <= map_end_[1] &&
+          coord[2] >= map_start_[2] &&
+          coord[2] <= map_end_[2])
+      {
+        geom::Vec3 adjusted_coord = coord-map_start_;
+        GaussianSplat splat;
+        for (int a = 0; a < 3; ++a) {
+          int first = ceil((adjusted_coord[a]-radius)/grid_sampling[a]);
+          int last = floor((adjusted_coord[a]+radius)/grid_sampling[a]);
+          splat.start[a] = first;
+          splat.size[a] = std::min(last-first+1,
+                                   static_cast<int>(grid_size[a]));
+          splat.center[a] = adjusted_coord[a]-first*grid_sampling[a];
+        }
+        splat.amplitude = 1.0;
+        splats[element->second].push_back(splat);
+      }
+    }}}
+
+    Real pixel_volume = grid_sampling[0]*grid_sampling[1]*grid_sampling[2];
+    Real norm = pixel_volume/pow(2.0*M_PI*sigma2, 1.5);
+    Real sigma = (falloff_end_frequency_ - falloff_start_frequency_)/3.0;
+    for (size_t e = 0; e < splats.size(); ++e) {
+      if (splats[e].empty()) {
+        continue;
+      }
+      img::ImageHandle grid = img::CreateImage(img::Extent(img::Point(0,0,0),
+                                                           grid_size));
+      img::RealSpatialImageState* grid_state =
+        dynamic_cast<img::RealSpatialImageState*>(grid.ImageStatePtr().get());
+      if (!grid_state) {
+        throw Error("unexpected image state in EntityToDensityScattering");
+      }
+      SplatGaussians(*grid_state, splats[e], grid_sampling, 0.5/sigma2,
+                     radius*radius, true, num_threads_);
+      grid.ApplyIP(img::alg::DFT());
+      const img::ComplexHalfFrequencyImageState* transform =
+        dynamic_cast<img::ComplexHalfFrequencyImageState*>(
+                                                grid.ImageStatePtr().get());
+      if (!transform) {
+        throw Error("unexpected image state in EntityToDensityScattering");
+      }
+      for (img::ExtentIterator mp_it(reduced_extent);
+         !mp_it.AtEnd();++mp_it)
+      {
+        img::Point mp_it_point = img::Point(mp_it);
+        geom::Vec3 mp_it_vec = geom::Vec3(
+          (mp_it_point[0]*frequency_sampling[0]),
+          (mp_it_point[1]*frequency_sampling[1]),
+          (mp_it_point[2]*frequency_sampling[2])
+        );
+        Real frequency = Length(mp_it_vec);
+        if (frequency <= falloff_end_frequency_)
+        {
+          Real falloff_term = 1.0;
+          if (sigma!=0 && frequency >= falloff_start_frequency_)
+          {
+            falloff_term=exp(-(frequency-falloff_start_frequency_)*
+                                  (frequency-falloff_start_frequency_)/
+                                  (2.0*sigma*sigma));
+          }
+          Real scatt_fact = ScatteringFactor(frequency,
+                                             scatt_props_table_[e],
+                                             source_wavelength_);
+          Real deconvolution = norm*exp(2.0*M_PI*M_PI*sigma2*
+                                        frequency*frequency);
+          is.Value(mp_it) = is.Value(mp_it) +
+            scatt_fact*falloff_term*deconvolution*transform->Value(mp_it_point);
+        }
+      }
+    }
+  }
+
+  template <typename T, class D>
+  void VisitState(img::ImageStateImpl<T,D>& is) const
+  {
+    assert(false);
+  }
+
+  static String GetAlgorithmName() {return "EntityToDensityGriddingHelper"; }
+
+private:
+
+  ost::mol::EntityView entity_view_;
+  Real falloff_start_frequency_;
+  Real falloff_end_frequency_;
+  static AtomScatteringPropsTable scatt_props_table_;
+  static bool scattering_props_table_loaded_;
+  Real source_wavelength_;
+  geom::Vec3 map_start_;
+  geom::Vec3 map_end_;
+  geom::Vec3 sampling_;
+  int num_threads_;
+};
+
+AtomScatteringPropsTable EntityToDensityGriddingHelperBase::scatt_props_table_ =
+          AtomScatteringPropsTable();
+bool EntityToDensityGriddingHelperBase::scattering_props_table_loaded_ = false;
+
+typedef img::ImageStateConstModIPAlgorithm<EntityToDensityGriddingHelperBase>
+        EntityToDensityGriddingHelper;
+
+
 
 class EntityToDensityRosettaHelperBase
 {
@@ -244,9 +531,9 @@ public:
 
   EntityToDensityRosettaHelperBase (const ost::mol::EntityView entity_view,
                              const ost::mol::alg::DensityType& density_type,
-                             Real resolution):
+                             Real resolution, int num_threads):
       density_type_(density_type), entity_view_(entity_view),
-      resolution_(resolution)
+      resolution_(resolution), num_threads_(num_threads)
   {
     if (scattering_props_table_loaded_ == false)
     {
@@ -283,71 +570,64 @@ public:
     geom::Vec3 sampling = is.GetSampling().GetPixelSampling();
     img::Extent is_extent = is.GetExtent();
 
+    uint x_limit = ceil(2.0*four_sigma/sampling[0])+1;
+    uint y_limit = ceil(2.0*four_sigma/sampling[1])+1;
+    uint z_limit = ceil(2.0*four_sigma/sampling[2])+1;
+
+    std::map<String, Real> atomic_weights;
+    for (AtomScatteringPropsTable::const_iterator
+         i=scatt_props_table_.begin(), e=scatt_props_table_.end(); i!=e; ++i) {
+      atomic_weights.insert(std::make_pair(i->element, i->atomic_weight));
+    }
+
+    // collect the Gaussians first and add them to the map in parallel
+    std::vector<GaussianSplat> splats;
     for (ChainViewList::const_iterator ci = effective_entity_view.GetChainList().begin(),
         ce = effective_entity_view.GetChainList().end(); ci != ce; ++ci) {
     for (ResidueViewList::const_iterator ri = ci->GetResidueList().begin(),
         re = ci->GetResidueList().end(); ri != re; ++ri) {
     for (AtomViewList::const_iterator ai = ri->GetAtomList().begin(),
         ae = ri->GetAtomList().end(); ai!= ae; ++ai) {
-      AtomScatteringPropsTable::iterator table_iter =
-                                             scatt_props_table_.begin();
-      bool found = false;
-      while (found != true && table_iter!=scatt_props_table_.end()) {
-        if ((*table_iter).element == ai->GetElement()) {
-          found = true;
-          Real a = (*table_iter).atomic_weight;
-          geom::Vec3 coord = ai->GetPos();
-          if (coord[0] >= map_start[0] &&
-              coord[0] <= map_end[0] &&
-              coord[1] >= map_start[1] &&
-              coord[1] <= map_end[1] &&
-              coord[2] >= map_start[2] &&
-              coord[2] <= map_end[2])
-          {
-
-            geom::Vec3 adjusted_coord  = coord-map_start;
-            geom::Vec3 pixel_coord=is.CoordToIndex(coord);
-            img::Point rounded_pixel_coord(round(pixel_coord[0]),
-                                            round(pixel_coord[1]),
-                                            round(pixel_coord[2]));
-
-            uint x_limit = ceil(2.0*four_sigma/sampling[0])+1;
-            uint y_limit = ceil(2.0*four_sigma/sampling[1])+1;
-            uint z_limit = ceil(2.0*four_sigma/sampling[2])+1;
-
-            img::Extent reduced_extent = img::Extent
-                                      (img::Size(x_limit,y_limit,z_limit),
-                                      rounded_pixel_coord);
-
-            img::Extent iteration_extent=
-                                  img::Overlap(is_extent,reduced_extent);
-
-            for (img::ExtentIterator mp_it(iteration_extent);
-              !mp_it.AtEnd();++mp_it)
-            {
-
-              img::Point mp_it_point = img::Point(mp_it);
-
-              geom::Vec3 mp_it_vec = geom::Vec3(
-                (mp_it_point[0]*sampling[0]),
-                (mp_it_point[1]*sampling[1]),
-                (mp_it_point[2]*sampling[2])
-              );
-
-              Real distance_squared = Length2(mp_it_vec-adjusted_coord);
+      std::map<String, Real>::const_iterator weight =
+                                       atomic_weights.find(ai->GetElement());
+      if (weight==atomic_weights.end()) {
+        continue;
+      }
+      geom::Vec3 coord = ai->GetPos();
+      if (coord[0] >= map_start[0] &&
+          coord[0] <= map_end[0] &&
+          coord[1] >= map_start[1] &&
+          coord[1] <= map_end[1] &&
+          coord[2] >= map_start[2] &&
+          coord[2] <= map_end[2])
+      {
 
-              if (distance_squared <= four_sigma_squared)
-              {
-                Real exp_term = exp(-k*distance_squared);
-                Real value = C * a * exp_term;
-                is.Value(mp_it_point) = is.Value(mp_it_point) + value;
-              }
-            }
-          }
+        geom::Vec3 adjusted_coord  = coord-map_start;
+        geom::Vec3 pixel_coord=is.CoordToIndex(coord);
+        img::Point rounded_pixel_coord(round(pixel_coord[0]),
+                                        round(pixel_coord[1]),
+                                        round(pixel_coord[2]));
+
+        img::Extent reduced_extent = img::Extent
+                                  (img::Size(x_limit,y_limit,z_limit),
+                                  rounded_pixel_coord);
+
+        img::Extent iteration_extent=
+                              img::Overlap(is_extent,reduced_extent);
+
+        GaussianSplat splat;
+        img::Point start = iteration_extent.GetStart();
+        for (int a = 0; a < 3; ++a) {
+          splat.start[a] = start[a]-is_extent.GetStart()[a];
+          splat.size[a] = iteration_extent.GetSize()[a];
+          splat.center[a] = adjusted_coord[a]-start[a]*sampling[a];
         }
-        ++table_iter;
+        splat.amplitude = C * weight->second;
+        splats.push_back(splat);
       }
     }}}
+    SplatGaussians(is, splats, sampling, k, four_sigma_squared, false,
+                   num_threads_);
   }
 
   template <typename T, class D>
@@ -363,6 +643,7 @@ private:
   ost::mol::alg::DensityType density_type_;
   ost::mol::EntityView entity_view_;
   Real resolution_;
+  int num_threads_;
   static AtomScatteringPropsTable scatt_props_table_;
   static bool scattering_props_table_loaded_;
 };
@@ -382,11 +663,15 @@ void EntityToDensityScattering(const mol::EntityView& entity_view,
                                      Real falloff_start,
                                      Real falloff_end,
                                      bool clear_map_flag,
-                                     Real source_wavelength)
+                                     Real source_wavelength,
+                                     bool gridding,
+                                     int num_threads)
 {
   if(falloff_start<=0.0) throw ost::Error("Invalid falloff start");
   if(falloff_end<=0.0 || falloff_end>falloff_start)
      throw ost::Error("Invalid falloff end");
+  if(gridding && map.GetExtent().GetDim()!=3)
+     throw ost::Error("Gridding requires a 3D map");
 
  geom ::Vec3 rs_sampl = map.GetSpatialSampling();
   geom ::Vec3 abs_orig = map.GetAbsoluteOrigin();
@@ -401,6 +686,13 @@ void EntityToDensityScattering(const mol::EntityView& entity_view,
                                               falloff_start,
                                               falloff_end,
                                               source_wavelength, map_start,map_end);
+  detail::EntityToDensityGriddingHelper e_to_d_g_helper(entity_view,
+                                                        falloff_start,
+                                                        falloff_end,
+                                                        source_wavelength,
+                                                        map_start,map_end,
+                                                        rs_sampl,
+                                                        num_threads);
   if (clear_map_flag==true) {
     img::MapHandle mm=img::CreateImage(img::Extent(map.GetSize(),
                                        img::Point(0,0)),
@@ -413,7 +705,11 @@ void EntityToDensityScattering(const mol::EntityView& entity_view,
     map.ApplyIP(img::alg::DFT());
   }
 
-  map.ApplyIP(e_to_d_helper);
+  if (gridding) {
+    map.ApplyIP(e_to_d_g_helper);
+  } else {
+    map.ApplyIP(e_to_d_helper);
+  }
   map.ApplyIP(img::alg::DFT());
 }
 
@@ -423,7 +719,8 @@ void EntityToDensityRosetta(const mol::EntityView& entity_view,
                             const DensityType& density_type,
                             Real resolution,
                             bool clear_map_flag,
-                            Real source_wavelength)
+                            Real source_wavelength,
+                            int num_threads)
 
 {
   if(resolution <=0.0) throw ost::Error("Invalid resolution");
@@ -438,7 +735,7 @@ void EntityToDensityRosetta(const mol::EntityView& entity_view,
 
   detail::EntityToDensityRosettaHelper e_to_d_r_helper
                                                 (entity_view,density_type,
-                                                resolution);
+                                                resolution,num_threads);
   map.ApplyIP(e_to_d_r_helper);
 }
 
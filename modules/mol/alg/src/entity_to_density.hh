@@ -36,12 +36,23 @@ enum DensityType
 /// The user must take care that this condition is verified for all
 /// entities for which he wants a representation.
 ///
+/// By default, the contribution of every atom is summed up for every
+/// frequency within the falloff, which scales with the number of atoms times
+/// the number of frequencies. With gridding enabled, the atoms are instead
+/// spread onto a real space grid with a narrow Gaussian kernel, which is
+/// Fourier transformed once per element and corrected for the kernel. The
+/// deviation from the direct summation stays below 1e-4 of the maximum
+/// density. Gridding is only available for 3D maps. num_threads is the number
+/// of threads used for spreading the atoms.
+///
 void DLLEXPORT_OST_MOL_ALG EntityToDensityScattering(const mol::EntityView& entity_view,
                                         img::MapHandle& map,
                                         Real falloff_start,
                                         Real falloff_end,
                                         bool clear_map_flag = false,
-                                        Real source_wavelength = 1.5418);
+                                        Real source_wavelength = 1.5418,
+                                        bool gridding = false,
+                                        int num_threads = 1);
 
 /// \brief create a density representation of an entity in a density map
 ///
@@ -68,12 +79,16 @@ void DLLEXPORT_OST_MOL_ALG EntityToDensityScattering(const mol::EntityView& enti
 /// The user must take care that this condition is verified for all
 /// entities for which he wants a representation.
 ///
+/// The Gaussians are truncated at four sigma and added to the map by
+/// num_threads threads, each of which writes to a separate set of planes.
+///
 void DLLEXPORT_OST_MOL_ALG EntityToDensityRosetta(const mol::EntityView& entity_view,
                                         img::MapHandle& map,
                                         const DensityType& density_type,
                                         Real resolution,
                                         bool clear_map_flag = false,
-                                        Real source_wavelength = 1.5418);
+                                        Real source_wavelength = 1.5418,
+                                        int num_threads = 1);
 }}} // ns
 
 #endif // OST_ENTITY_TO_DENSITY
@@ -23,6 +23,7 @@
 #include <math.h>
 #include "filter_clashes.hh"
 #include <ost/units.hh>
+#include <ost/mol/cell_list_organizer.hh>
 
 
 
@@ -46,18 +47,11 @@ String bond_string(const ost::mol::AtomView& atom1, const ost::mol::AtomHandle&
 }
 
 // helper function
-String bond_string_elems(String& ele1, String ele2) {
-  String string1,string2;
+String bond_string_elems(const String& ele1, const String& ele2) {
   if (ele1 < ele2) {
-    string1 = ele1;
-    string2 = ele2;
-  } else {
-    string1 = ele2;
-    string2 = ele1;
+    return ele1+"-"+ele2;
   }
-  std::stringstream stkey;
-  stkey << string1 << "-" << string2;
-  return stkey.str();  
+  return ele2+"-"+ele1;
 }
 
 // helper function
@@ -78,6 +72,21 @@ String angle_string(const ost::mol::AtomHandle& atom1, const ost::mol::AtomView&
 }
 
 
+// heavy atom bonded to the atom being checked, with its indices in the
+// compiled bond and angle tables
+struct BondPartner {
+  BondPartner(const ost::mol::BondHandle& b, const ost::mol::AtomHandle& a,
+              const String& ele, const String& n, int bid, int aid):
+    bond(b), atom(a), element(ele), name(n), bond_id(bid), angle_id(aid)
+  { }
+  ost::mol::BondHandle bond;
+  ost::mol::AtomHandle atom;
+  String element;
+  String name;
+  int bond_id;
+  int angle_id;
+};
+
 }  
 
 namespace ost { namespace mol { namespace alg {
@@ -104,6 +113,44 @@ void ClashingDistances::SetClashingDistance(const String& ele1,const String& ele
   stkey << ele1 << "--" << ele2;
   String key=stkey.str();
   min_distance_[key]=std::make_pair(min_distance,tolerance);
+  int index1=this->AddElement(ele1);
+  int index2=this->AddElement(ele2);
+  // entries are looked up with the element names in sorted order, entries
+  // stored the other way round can not be found.
+  if (!(ele2<ele1)) {
+    size_t n=element_ids_.size();
+    adjusted_distances_[index1*n+index2]=min_distance-tolerance;
+    adjusted_distances_[index2*n+index1]=min_distance-tolerance;
+  }
+  max_adjusted_distance_=0.0;
+  for (std::map <String,std::pair<Real,Real> >::const_iterator index = min_distance_.begin();index != min_distance_.end();++index) {
+    max_adjusted_distance_=std::max(max_adjusted_distance_,
+                                    index->second.first-index->second.second);
+  }
+}
+
+int ClashingDistances::AddElement(const String& ele)
+{
+  std::map<String,int>::const_iterator i=element_ids_.find(ele);
+  if (i!=element_ids_.end()) {
+    return i->second;
+  }
+  size_t n=element_ids_.size();
+  std::vector<Real> adjusted_distances((n+1)*(n+1), -1.0);
+  for (size_t j=0; j<n; ++j) {
+    for (size_t k=0; k<n; ++k) {
+      adjusted_distances[j*(n+1)+k]=adjusted_distances_[j*n+k];
+    }
+  }
+  adjusted_distances_.swap(adjusted_distances);
+  element_ids_[ele]=n;
+  return n;
+}
+
+int ClashingDistances::GetElementIndex(const String& ele) const
+{
+  std::map<String,int>::const_iterator i=element_ids_.find(ele);
+  return i==element_ids_.end() ? -1 : i->second;
 }
 
 std::pair<Real,Real> ClashingDistances::GetClashingDistance(const String& ele1,const String& ele2) const
@@ -139,15 +186,7 @@ void ClashingDistances::PrintAllDistances() const
 
 Real ClashingDistances::GetMaxAdjustedDistance() const
 {
-  Real max_adjusted_distance=0;
-  for (std::map <String,std::pair<Real,Real> >::const_iterator index = min_distance_.begin();index != min_distance_.end();++index) {
-    Real distance = index->second.first; 
-    Real tolerance = index->second.second; 
-    if ((distance-tolerance) > max_adjusted_distance) {
-      max_adjusted_distance=distance-tolerance;
-    }
-  }  
-  return max_adjusted_distance;  
+  return max_adjusted_distance_;
 }
 
 bool ClashingDistances::IsEmpty() const
@@ -162,6 +201,113 @@ void StereoChemicalParams::SetParam(const String& param, const String& residue,
 {
   std::pair<String,String> key = std::make_pair(param,residue);
   params_[key]=std::make_pair(value,st_dev);
+  std::vector<StringRef> names=StringRef(param.data(), param.length()).split('-');
+  if (names.size()!=2 && names.size()!=3) {
+    return;
+  }
+  std::map<String,int>::const_iterator r=residue_ids_.find(residue);
+  int res_index;
+  if (r==residue_ids_.end()) {
+    res_index=residue_params_.size();
+    residue_ids_[residue]=res_index;
+    residue_params_.push_back(ResidueParams());
+  } else {
+    res_index=r->second;
+  }
+  ResidueParams& res_params=residue_params_[res_index];
+  std::vector<int> ids;
+  for (size_t i=0; i<names.size(); ++i) {
+    ids.push_back(this->AddAtom(res_params, names[i].str()));
+  }
+  size_t n=res_params.atom_ids.size();
+  if (ids.size()==2) {
+    if (res_params.bonds.empty()) {
+      res_params.bonds.resize(n*n, std::make_pair(Real(0.0), Real(-1.0)));
+    }
+    res_params.bonds[ids[0]*n+ids[1]]=std::make_pair(value, st_dev);
+  } else {
+    if (res_params.angles.empty()) {
+      res_params.angles.resize(n*n*n, std::make_pair(Real(0.0), Real(-1.0)));
+    }
+    res_params.angles[(ids[0]*n+ids[1])*n+ids[2]]=std::make_pair(value, st_dev);
+  }
+}
+
+int StereoChemicalParams::AddAtom(ResidueParams& params, const String& atom)
+{
+  std::map<String,int>::const_iterator i=params.atom_ids.find(atom);
+  if (i!=params.atom_ids.end()) {
+    return i->second;
+  }
+  size_t n=params.atom_ids.size();
+  std::pair<Real,Real> missing(0.0, -1.0);
+  if (!params.bonds.empty()) {
+    std::vector<std::pair<Real,Real> > bonds((n+1)*(n+1), missing);
+    for (size_t j=0; j<n; ++j) {
+      for (size_t k=0; k<n; ++k) {
+        bonds[j*(n+1)+k]=params.bonds[j*n+k];
+      }
+    }
+    params.bonds.swap(bonds);
+  }
+  if (!params.angles.empty()) {
+    std::vector<std::pair<Real,Real> > angles((n+1)*(n+1)*(n+1), missing);
+    for (size_t j=0; j<n; ++j) {
+      for (size_t k=0; k<n; ++k) {
+        for (size_t l=0; l<n; ++l) {
+          angles[(j*(n+1)+k)*(n+1)+l]=params.angles[(j*n+k)*n+l];
+        }
+      }
+    }
+    params.angles.swap(angles);
+  }
+  params.atom_ids[atom]=n;
+  return n;
+}
+
+int StereoChemicalParams::GetResidueIndex(const String& residue) const
+{
+  std::map<String,int>::const_iterator i=residue_ids_.find(residue);
+  return i==residue_ids_.end() ? -1 : i->second;
+}
+
+int StereoChemicalParams::GetAtomIndex(int residue, const String& atom) const
+{
+  if (residue<0) {
+    return -1;
+  }
+  const std::map<String,int>& atom_ids=residue_params_[residue].atom_ids;
+  std::map<String,int>::const_iterator i=atom_ids.find(atom);
+  return i==atom_ids.end() ? -1 : i->second;
+}
+
+const std::pair<Real,Real>* StereoChemicalParams::FindBond(int residue,
+                                                           int atom1,
+                                                           int atom2) const
+{
+  if (residue<0 || atom1<0 || atom2<0 ||
+      residue_params_[residue].bonds.empty()) {
+    return NULL;
+  }
+  const ResidueParams& params=residue_params_[residue];
+  const std::pair<Real,Real>& entry=params.bonds[atom1*params.atom_ids.size()+
+                                                 atom2];
+  return entry.second<0.0 ? NULL : &entry;
+}
+
+const std::pair<Real,Real>* StereoChemicalParams::FindAngle(int residue,
+                                                            int atom1,
+                                                            int atom,
+                                                            int atom2) const
+{
+  if (residue<0 || atom1<0 || atom<0 || atom2<0 ||
+      residue_params_[residue].angles.empty()) {
+    return NULL;
+  }
+  const ResidueParams& params=residue_params_[residue];
+  size_t n=params.atom_ids.size();
+  const std::pair<Real,Real>& entry=params.angles[(atom1*n+atom)*n+atom2];
+  return entry.second<0.0 ? NULL : &entry;
 }
 
 std::pair<Real,Real> StereoChemicalParams::GetParam(const String& param,const String& residue) const
@@ -383,6 +529,9 @@ std::pair<EntityView,StereoChemistryInfo> CheckStereoChemistry(const EntityView&
       continue;
     }  
     String residue_str = res.GetName();
+    int bond_res=bond_table.GetResidueIndex(residue_str);
+    int angle_res=angle_table.GetResidueIndex(residue_str);
+    ResidueHandle res_handle=res.GetHandle();
     const AtomViewList& atoms=res.GetAtomList();
     for (AtomViewList::const_iterator j=atoms.begin(), e2=atoms.end(); j!=e2; ++j) {
       AtomView atom=*j;
@@ -390,22 +539,42 @@ std::pair<EntityView,StereoChemistryInfo> CheckStereoChemistry(const EntityView&
       if (ele1=="H" || ele1=="D") {
         continue;
       }
+      AtomHandle atom_handle=atom.GetHandle();
+      String atom_name=atom.GetName();
+      int atom_bond_id=bond_table.GetAtomIndex(bond_res, atom_name);
+      int atom_angle_id=angle_table.GetAtomIndex(angle_res, atom_name);
       BondHandleList bonds = atom.GetBondList();
-      
+      // heavy atoms bonded to atom within the same residue
+      std::vector<BondPartner> partners;
+      partners.reserve(bonds.size());
       for (BondHandeList::const_iterator bi = bonds.begin();bi!=bonds.end();++bi) {
-          BondHandle bond = *bi;          
-          AtomHandle other_atom = bond.GetOther(atom.GetHandle());    
-          if (other_atom.GetResidue()!=res.GetHandle()) {
-            continue;     
-          }         
-          String ele2 = other_atom.GetElement();
-          if (ele2=="H" || ele2=="D") {
-            continue;
-          }      
-          if (other_atom.GetHashCode() > atom.GetHandle().GetHashCode()) {
-            Real blength = bond.GetLength();
-            String bond_str = bond_string(atom, other_atom);
-            std::pair<Real,Real> length_stddev = bond_table.GetParam(bond_str, residue_str);
+        AtomHandle other_atom = bi->GetOther(atom_handle);
+        if (other_atom.GetResidue()!=res_handle) {
+          continue;
+        }
+        String ele2 = other_atom.GetElement();
+        if (ele2=="H" || ele2=="D") {
+          continue;
+        }
+        String name=other_atom.GetName();
+        partners.push_back(BondPartner(*bi, other_atom, ele2, name,
+                                       bond_table.GetAtomIndex(bond_res, name),
+                                       angle_table.GetAtomIndex(angle_res, name)));
+      }
+      
+      for (std::vector<BondPartner>::const_iterator p=partners.begin();p!=partners.end();++p) {
+          const AtomHandle& other_atom = p->atom;
+          if (other_atom.GetHashCode() > atom_handle.GetHashCode()) {
+            Real blength = p->bond.GetLength();
+            const std::pair<Real,Real>* found;
+            if (atom_name<p->name) {
+              found=bond_table.FindBond(bond_res, atom_bond_id, p->bond_id);
+            } else {
+              found=bond_table.FindBond(bond_res, p->bond_id, atom_bond_id);
+            }
+            // GetParam throws with a meaningful message for missing entries
+            std::pair<Real,Real> length_stddev = found ? *found :
+                bond_table.GetParam(bond_string(atom, other_atom), residue_str);
             Real ref_length = length_stddev.first;
             Real ref_stddev = length_stddev.second;           
             Real min_length = ref_length - bond_tolerance*ref_stddev;
@@ -414,8 +583,9 @@ std::pair<EntityView,StereoChemistryInfo> CheckStereoChemistry(const EntityView&
             if (blength < min_length || blength > max_length) {
               LOG_INFO("BOND:" << " " << res.GetChain() << " "
                        << res.GetName() << " " << res.GetNumber() << " "
-                       << bond_str << " " << min_length << " " << max_length
-                       << " " << blength << " " << zscore << " " << "FAIL")
+                       << bond_string(atom, other_atom) << " " << min_length
+                       << " " << max_length << " " << blength << " "
+                       << zscore << " " << "FAIL")
               bad_bond_count++;
               UniqueAtomIdentifier atom_ui(atom.GetResidue().GetChain().GetName(),
                                            atom.GetResidue().GetNumber(),
@@ -433,8 +603,8 @@ std::pair<EntityView,StereoChemistryInfo> CheckStereoChemistry(const EntityView&
               } else {
                 // we need to check both atom names since the order is random!
                 // -> for angles and clashes this is not needed
-                String name1 = atom.GetName();
-                String name2 = other_atom.GetName();
+                const String& name1 = atom_name;
+                const String& name2 = p->name;
                 if (name1=="CA" || name1=="N" || name1=="O" || name1=="C" ||
                     name2=="CA" || name2=="N" || name2=="O" || name2=="C") {
                   remove_bb=true;
@@ -443,55 +613,45 @@ std::pair<EntityView,StereoChemistryInfo> CheckStereoChemistry(const EntityView&
             } else {
               LOG_VERBOSE("BOND:" << " " << res.GetChain() << " "
                           << res.GetName() << " " << res.GetNumber() << " "
-                          << bond_str << " " << min_length << " " << max_length
-                          << " " << blength << " " << zscore << " " << "PASS")
+                          << bond_string(atom, other_atom) << " " << min_length
+                          << " " << max_length << " " << blength << " "
+                          << zscore << " " << "PASS")
             }
             bond_count++;
             running_sum_zscore_bonds+=zscore;
-            String bond_elems=bond_string_elems(ele1,ele2);
-            std::map<String,Real>::const_iterator find_be = bond_length_sum.find(bond_elems);  
+            String bond_elems=bond_string_elems(ele1,p->element);
+            std::map<String,Real>::iterator find_be = bond_length_sum.find(bond_elems);  
             if (find_be==bond_length_sum.end()) {
                 bond_length_sum[bond_elems]=blength;
                 bond_zscore_sum[bond_elems]=zscore;
                 bond_counter_sum[bond_elems]=1;
             } else {
-                bond_length_sum[bond_elems]+=blength;
+                find_be->second+=blength;
                 bond_zscore_sum[bond_elems]+=zscore;
                 bond_counter_sum[bond_elems]+=1;
             }
           }  
       }
       
-      for (BondHandeList::const_iterator bond_iter1=bonds.begin(); bond_iter1!=bonds.end(); ++bond_iter1) {
-        BondHandle bond1=*bond_iter1;
-        AtomHandle atom1= bond1.GetOther(atom.GetHandle());
-        String ele_atom1=atom1.GetElement();
-        if (ele_atom1=="H" || ele_atom1=="D") {
-          continue;
-        }
-        if (atom1.GetResidue()!=res.GetHandle()) {
-          continue;        
-        }        
-        for (BondHandeList::const_iterator bond_iter2=bonds.begin(); bond_iter2!=bonds.end(); ++bond_iter2) {
-          BondHandle bond2=*bond_iter2;
-          AtomHandle atom2 = bond2.GetOther(atom.GetHandle());
-          String ele_atom2=atom2.GetElement();
-          if (ele_atom2=="H" || ele_atom2=="D") {
-            continue;
-          }
-          if (atom2.GetResidue()!=res.GetHandle()) {
-            continue;        
-          }
+      for (std::vector<BondPartner>::const_iterator p1=partners.begin(); p1!=partners.end(); ++p1) {
+        const AtomHandle& atom1=p1->atom;
+        for (std::vector<BondPartner>::const_iterator p2=partners.begin(); p2!=partners.end(); ++p2) {
+          const AtomHandle& atom2 = p2->atom;
           if (atom1.GetHashCode() > atom2.GetHashCode()) {
             Real awidth;
-            if (atom1.GetName()<atom2.GetName()) {
-              awidth = ent.GetAngle(atom1,atom.GetHandle(),atom2);
+            const std::pair<Real,Real>* found;
+            if (p1->name<p2->name) {
+              awidth = ent.GetAngle(atom1,atom_handle,atom2);
+              found = angle_table.FindAngle(angle_res, p1->angle_id,
+                                            atom_angle_id, p2->angle_id);
             } else {
-              awidth = ent.GetAngle(atom2,atom.GetHandle(),atom1);
+              awidth = ent.GetAngle(atom2,atom_handle,atom1);
+              found = angle_table.FindAngle(angle_res, p2->angle_id,
+                                            atom_angle_id, p1->angle_id);
             }    
             awidth/=(ost::Units::deg);
-            String angle_str = angle_string(atom1,atom,atom2);
-            std::pair<Real,Real> width_stddev = angle_table.GetParam(angle_str,residue_str);
+            std::pair<Real,Real> width_stddev = found ? *found :
+                angle_table.GetParam(angle_string(atom1,atom,atom2),residue_str);
             Real ref_width = width_stddev.first;  
             Real ref_stddev = width_stddev.second;           
             Real min_width = ref_width - angle_tolerance*ref_stddev;
@@ -500,8 +660,9 @@ std::pair<EntityView,StereoChemistryInfo> CheckStereoChemistry(const EntityView&
             if (awidth < min_width || awidth > max_width) {
               LOG_INFO("ANGLE:" << " " << res.GetChain() << " "
                        << res.GetName() << " " << res.GetNumber() << " "
-                       << angle_str << " " << min_width << " " << max_width
-                       << " " << awidth << " " << zscore << " " << "FAIL")
+                       << angle_string(atom1,atom,atom2) << " " << min_width
+                       << " " << max_width << " " << awidth << " " << zscore
+                       << " " << "FAIL")
               bad_angle_count++;
               UniqueAtomIdentifier atom1_ui(atom1.GetResidue().GetChain().GetName(),
                                             atom1.GetResidue().GetNumber(),
@@ -522,15 +683,15 @@ std::pair<EntityView,StereoChemistryInfo> CheckStereoChemistry(const EntityView&
               if (always_remove_bb==true) {
                 remove_bb=true;
               }
-              String name=atom.GetName();
-              if (name=="CA" || name=="N" || name=="O" || name=="C") {
+              if (atom_name=="CA" || atom_name=="N" || atom_name=="O" || atom_name=="C") {
                 remove_bb=true;
               }
             } else {
               LOG_VERBOSE("ANGLE:" << " " << res.GetChain() << " "
                           << res.GetName() << " " << res.GetNumber() << " "
-                          << angle_str << " " << min_width << " " << max_width
-                          << " " << awidth << " " << zscore << " " << "PASS")
+                          << angle_string(atom1,atom,atom2) << " " << min_width
+                          << " " << max_width << " " << awidth << " " << zscore
+                          << " " << "PASS")
             }
             angle_count++;
             running_sum_zscore_angles+=zscore;  
@@ -595,34 +756,51 @@ std::pair<EntityView,ClashingInfo> FilterClashes(const EntityView& ent, const Cl
   LOG_INFO("Filtering non-bonded clashes")
   EntityView filtered=ent.CreateEmptyView();
   ResidueViewList residues=ent.GetResidueList();
+  // all heavy atoms of the view go into one cell list. Each residue covers a
+  // contiguous range of it.
+  Real max_distance=min_distances.GetMaxAdjustedDistance();
+  CellListOrganizer<int> organizer(max_distance>0.0 ? max_distance : 1.0);
+  std::vector<AtomView> heavy_atoms;
+  std::vector<String> heavy_elements;
+  std::vector<int> heavy_element_ids;
+  std::vector<int> residue_begin;
   for (ResidueViewList::iterator 
        i=residues.begin(), e=residues.end(); i!=e; ++i) {
+    residue_begin.push_back(heavy_atoms.size());
+    const AtomViewList& atoms=i->GetAtomList();
+    for (AtomViewList::const_iterator 
+         j=atoms.begin(), e2=atoms.end(); j!=e2; ++j) {
+      String ele=j->GetElement();
+      if (ele=="H" || ele=="D") {
+        continue;
+      }
+      organizer.Add(heavy_atoms.size(), j->GetPos());
+      heavy_atoms.push_back(*j);
+      heavy_elements.push_back(ele);
+      heavy_element_ids.push_back(min_distances.GetElementIndex(ele));
+    }
+  }
+  residue_begin.push_back(heavy_atoms.size());
+  organizer.Build();
+  for (size_t r=0; r<residues.size(); ++r) {
     bool remove_sc=false, remove_bb=false;
-    ResidueView res=*i;
+    ResidueView res=residues[r];
     if (res.GetOneLetterCode()=='?') {
       filtered.AddResidue(res, ViewAddFlag::INCLUDE_ATOMS);
       continue;
     }  
     const AtomViewList& atoms=res.GetAtomList();
-    for (AtomViewList::const_iterator 
-         j=atoms.begin(), e2=atoms.end(); j!=e2; ++j) {
-      AtomView atom=*j;
-
-      String ele1=atom.GetElement();
-      if (ele1=="H" || ele1=="D") {
-        continue;
-      }
-      AtomViewList within=ent.FindWithin(atom.GetPos(),min_distances.GetMaxAdjustedDistance());
-      for (AtomViewList::iterator 
+    for (int a=residue_begin[r]; a<residue_begin[r+1]; ++a) {
+      const AtomView& atom=heavy_atoms[a];
+      const String& ele1=heavy_elements[a];
+      std::vector<int> within=organizer.FindWithin(atom.GetPos(), max_distance);
+      for (std::vector<int>::const_iterator 
            k=within.begin(), e3=within.end(); k!=e3; ++k) {
-        AtomView atom2=*k;
-        if (atom2==atom) {
-          continue;
-        }
-        String ele2=atom2.GetElement();
-        if (ele2=="H" || ele2=="D") {
+        if (*k==a) {
           continue;
         }
+        const AtomView& atom2=heavy_atoms[*k];
+        const String& ele2=heavy_elements[*k];
 
         // In theory, this should also trigger for disulfide bonds, but 
         // since we don't detect disulfides correctly, we can't count on that 
@@ -632,10 +810,15 @@ std::pair<EntityView,ClashingInfo> FilterClashes(const EntityView& ent, const Cl
         }
 
         Real d=geom::Length2(atom.GetPos()-atom2.GetPos());
-        std::pair <Real,Real> distance_tolerance=min_distances.GetClashingDistance(ele1, ele2);
-        Real distance=distance_tolerance.first;
-        Real tolerance=distance_tolerance.second;
-        Real threshold=distance-tolerance;
+        Real threshold=-1.0;
+        if (heavy_element_ids[a]>=0 && heavy_element_ids[*k]>=0) {
+          threshold=min_distances.GetAdjustedClashingDistanceByIndex(
+                                     heavy_element_ids[a], heavy_element_ids[*k]);
+        }
+        if (threshold<0.0) {
+          // throws for missing entries
+          threshold=min_distances.GetAdjustedClashingDistance(ele1, ele2);
+        }
 
         if (d<threshold*threshold) {
           LOG_INFO("CLASH:" << " " << atom.GetResidue().GetChain() << " "
@@ -176,7 +176,7 @@ class DLLEXPORT_OST_MOL_ALG ClashingDistances
 
 public:
   /// \brief Default constructor (creates an empty list)
-  ClashingDistances(): valid_flag_(true) {}
+  ClashingDistances(): max_adjusted_distance_(0.0), valid_flag_(true) {}
 
   /// \brief Adds or replaces an entry 
   ///
@@ -197,10 +197,31 @@ public:
   
   /// \brief Prints all distances in the list to standard output
   void PrintAllDistances() const;
+
+  /// \brief Index of an element in the compiled distance table
+  ///
+  /// Returns -1 if the element does not occur in the list.
+  int GetElementIndex(const String& ele) const;
+
+  /// \brief Adjusted clashing distance for two element indices
+  ///
+  /// Same as GetAdjustedClashingDistance(), but a table lookup without string
+  /// handling. Returns a negative value if the list has no entry for the pair.
+  Real GetAdjustedClashingDistanceByIndex(int ele1, int ele2) const
+  {
+    return adjusted_distances_[ele1*element_ids_.size()+ele2];
+  }
   
 private:
 
+  int AddElement(const String& ele);
+
   std::map <String,std::pair<Real,Real> > min_distance_;
+  // compiled representation: element names are mapped to consecutive indices,
+  // adjusted distances are stored in a dense square matrix.
+  std::map<String,int> element_ids_;
+  std::vector<Real> adjusted_distances_;
+  Real max_adjusted_distance_;
   Real default_min_distance_;
   Real default_min_distance_tolerance_;
   bool valid_flag_;
@@ -234,10 +255,45 @@ public:
   
   /// \brief Prints all distances in the list to standard output
   void PrintAllParameters() const;
+
+  /// \brief Index of a residue in the compiled parameter tables
+  ///
+  /// Returns -1 if there are no parameters for the residue.
+  int GetResidueIndex(const String& residue) const;
+
+  /// \brief Index of an atom name within the compiled tables of a residue
+  ///
+  /// Returns -1 if the atom does not occur in any parameter of the residue.
+  int GetAtomIndex(int residue, const String& atom) const;
+
+  /// \brief Mean and standard deviation of a bond by residue and atom indices
+  ///
+  /// Same as GetParam() for the item atom1-atom2, but a table lookup without
+  /// string handling. Returns NULL if there is no such entry.
+  const std::pair<Real,Real>* FindBond(int residue, int atom1, int atom2) const;
+
+  /// \brief Mean and standard deviation of an angle by residue and atom indices
+  ///
+  /// Same as GetParam() for the item atom1-atom-atom2. Returns NULL if there
+  /// is no such entry.
+  const std::pair<Real,Real>* FindAngle(int residue, int atom1, int atom,
+                                        int atom2) const;
   
 private:
 
+  // bonds and angles of one residue, indexed by the atom indices. Missing
+  // entries have a negative standard deviation.
+  struct ResidueParams {
+    std::map<String,int> atom_ids;
+    std::vector<std::pair<Real,Real> > bonds;
+    std::vector<std::pair<Real,Real> > angles;
+  };
+
+  int AddAtom(ResidueParams& params, const String& atom);
+
   std::map<std::pair<String,String>,std::pair<Real,Real> >  params_;
+  std::map<String,int> residue_ids_;
+  std::vector<ResidueParams> residue_params_;
  
 };
 
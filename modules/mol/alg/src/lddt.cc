@@ -97,6 +97,7 @@ void usage()
   std::cerr << "   -a <value> tolerance in stddevs for angles" << std::endl;
   std::cerr << "   -r <value> distance inclusion radius" << std::endl;
   std::cerr << "   -i <value> sequence separation" << std::endl;
+  std::cerr << "   -n <value> number of threads" << std::endl;
   std::cerr << "   -e         print version" << std::endl;
   std::cerr << "   -x         ignore residue name consistency checks" << std::endl;
   std::cerr << "   -l <path>  location of the compound library file" << std::endl;
@@ -182,6 +183,7 @@ int main (int argc, char **argv)
     ("angle_tolerance,a", po::value<Real>(), "tolerance in stddev for angles")
     ("inclusion_radius,r", po::value<Real>(), "distance inclusion radius")
     ("sequence_separation,i", po::value<int>(), "sequence separation")
+    ("threads,n", po::value<int>(), "number of threads")
     ("files", po::value< std::vector<String> >(), "input file(s)")
     ("reference",po::value<String>(),"reference(s)")
   ;
@@ -264,6 +266,9 @@ int main (int argc, char **argv)
   if (vm.count("sequence_separation")) {
     settings.sequence_separation=vm["sequence_separation"].as<int>();
   }
+  if (vm.count("threads")) {
+    settings.num_threads=vm["threads"].as<int>();
+  }
 
   std::vector<EntityView> ref_list;  
     
@@ -303,7 +308,8 @@ int main (int argc, char **argv)
   glob_dist_list = PreparelDDTGlobalRDMap(ref_list,
                                           settings.cutoffs,
                                           settings.sequence_separation,
-                                          settings.radius);
+                                          settings.radius,
+                                          settings.num_threads);
   files.pop_back();
 
   // prints out parameters used in the lddt calculation
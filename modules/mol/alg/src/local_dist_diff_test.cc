@@ -2,11 +2,14 @@
 #include <sstream>
 #include <ost/log.hh>
 #include <ost/mol/mol.hh>
+#include <ost/mol/neighbor_search.hh>
 #include <ost/platform.hh>
 #include "local_dist_diff_test.hh"
 #include <boost/concept_check.hpp>
 #include <boost/filesystem/convenience.hpp>
 #include <ost/mol/alg/consistency_checks.hh>
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
 
 namespace ost { namespace mol { namespace alg {
 
@@ -115,6 +118,97 @@ std::pair<long int, long int> calc_overlap1(const ResidueRDMap& res_distance_lis
   return overlap;
 }  
 
+// number of thresholds for which a model distance is conserved, counted from
+// the largest threshold down to the first one that fails
+int count_conserved(Real mdl_dist, const std::pair<Real,Real>& values,
+                    const std::vector<Real>& tol_list)
+{
+  int conserved=0;
+  for (std::vector<Real>::const_reverse_iterator tol_list_it=tol_list.rbegin(),
+       rend_it=tol_list.rend(); tol_list_it!=rend_it; ++tol_list_it) {
+    if (!within_tolerance(mdl_dist, values, *tol_list_it)) {
+      break;
+    }
+    ++conserved;
+  }
+  return conserved;
+}
+
+// residues for which the naming of side-chain atoms is ambiguous
+bool has_ambiguous_naming(const String& rname)
+{
+  return rname=="GLU" || rname=="ASP" || rname=="VAL" || rname=="TYR" ||
+         rname=="PHE" || rname=="LEU" || rname=="ARG";
+}
+
+// index of the atom with the given name in the model atom list, and the index
+// of the atom it corresponds to when the naming convention of the residue is
+// swapped. -1 if the atom doesn't exist.
+void lookup_atom(const ResidueView& res, const String& name,
+                 const std::map<long, int>& atom_index, int& index,
+                 int& swapped_index)
+{
+  index=-1;
+  swapped_index=-1;
+  if (!res) {
+    return;
+  }
+  AtomView atom=res.FindAtom(name);
+  if (atom) {
+    index=atom_index.find(atom.GetHandle().GetHashCode())->second;
+  }
+  swapped_index=index;
+  if (Swappable(res.GetName(), name)) {
+    AtomView swapped=res.FindAtom(SwappedName(name));
+    swapped_index=swapped ? atom_index.find(swapped.GetHandle().GetHashCode())->second : -1;
+  }
+}
+
+// builds the residue distance lists for a range of residues from the pairs of
+// atoms found by the neighbour search
+struct build_residue_rd_maps_mt {
+  build_residue_rd_maps_mt(const NeighborPairList& p,
+                           const std::vector<UniqueAtomIdentifier>& ids,
+                           const std::vector<size_t>& fa,
+                           const std::vector<size_t>& rfa,
+                           size_t b, size_t e, std::vector<ResidueRDMap>& m):
+    pairs(p), chain_ids(ids), first_atoms(fa), res_first_atom(rfa),
+    begin(b), end(e), res_dist_lists(m)
+  { }
+
+  void operator()() {
+    NeighborPairList::const_iterator pair_it=std::lower_bound(pairs.begin(),
+                                                              pairs.end(),
+                                                              res_first_atom[begin],
+                                                              less_first);
+    for (size_t r=begin; r<end; ++r) {
+      ResidueRDMap& res_dist_list=res_dist_lists[r];
+      for (size_t i=res_first_atom[r]; i<res_first_atom[r+1]; ++i) {
+        const UniqueAtomIdentifier& first_atom=chain_ids[first_atoms[i]];
+        for (; pair_it!=pairs.end() && pair_it->first==i; ++pair_it) {
+          Real dist=std::sqrt(pair_it->dist2);
+          UAtomIdentifiers atoms = std::make_pair(first_atom,chain_ids[pair_it->second]); 
+          std::pair<Real,Real> values = std::make_pair(dist,dist);  
+          res_dist_list[atoms]=values;
+        }
+      }
+    }
+  }
+
+  static bool less_first(const NeighborPair& pair, size_t index)
+  {
+    return pair.first<index;
+  }
+
+  const NeighborPairList&                   pairs;
+  const std::vector<UniqueAtomIdentifier>&  chain_ids;
+  const std::vector<size_t>&                first_atoms;
+  const std::vector<size_t>&                res_first_atom;
+  size_t                                    begin;
+  size_t                                    end;
+  std::vector<ResidueRDMap>&                res_dist_lists;
+};
+
 // helper function used by the alignment-based Local Distance Difference Test
 std::pair<Real, Real> calc_overlap2(const seq::ConstSequenceHandle& ref_seq,
                                     const seq::ConstSequenceHandle& mdl_seq,
@@ -217,8 +311,7 @@ void check_and_swap(const GlobalRDMap& glob_dist_list, const EntityView& mdl, st
       continue;
     }
     String rname = mdl_res.GetName();
-    if (!(rname=="GLU" || rname=="ASP" || rname=="VAL" || rname=="TYR" ||
-          rname=="PHE" || rname=="LEU" || rname=="ARG")) {
+    if (!has_ambiguous_naming(rname)) {
       continue;
     }
     std::pair<long int, long int> ov1=calc_overlap1(i->second, rnum,mdl_chain, sequence_separation,
@@ -361,13 +454,7 @@ std::pair<int,int> ComputeCoverage(const EntityView& v,const GlobalRDMap& glob_d
 
 bool IsResnumInGlobalRDMap(const ResNum& resnum, const GlobalRDMap& glob_dist_list)
 {
-  for (GlobalRDMap::const_iterator i=glob_dist_list.begin(), e=glob_dist_list.end(); i!=e; ++i) {
-    ResNum rn = i->first;
-    if (rn==resnum) {
-      return true;
-    }
-  }
-  return false;
+  return glob_dist_list.find(resnum)!=glob_dist_list.end();
 }
 
 
@@ -415,7 +502,8 @@ StereoChemicalProps::StereoChemicalProps(
 
 lDDTSettings::lDDTSettings(): radius(15.0), 
                               sequence_separation(0),
-                              label("locallddt") {
+                              label("locallddt"),
+                              num_threads(1) {
     cutoffs.push_back(0.5);
     cutoffs.push_back(1.0);
     cutoffs.push_back(2.0);
@@ -425,11 +513,13 @@ lDDTSettings::lDDTSettings(): radius(15.0),
 lDDTSettings::lDDTSettings(Real init_radius, 
                            int init_sequence_separation,
                            std::vector<Real>& init_cutoffs,
-                           String init_label):
+                           String init_label,
+                           int init_num_threads):
                     radius(init_radius), 
                     sequence_separation(init_sequence_separation),
                     cutoffs(init_cutoffs),
-                    label(init_label) {}
+                    label(init_label),
+                    num_threads(init_num_threads) {}
 
 std::string lDDTSettings::ToString() {
   std::ostringstream rep;
@@ -437,6 +527,7 @@ std::string lDDTSettings::ToString() {
   rep << "Sequence separation: " << sequence_separation << "\n";
   rep << "Cutoffs: " << vector_to_string(cutoffs) << "\n";
   rep << "Residue properties label: " << label << "\n";
+  rep << "Number of threads: " << num_threads << "\n";
 
   return rep.str();
 }
@@ -501,6 +592,279 @@ String lDDTLocalScore::GetHeader(bool structural_checks, int cutoffs_length) {
   return outstr.str();
 }
 
+CompiledRDList::CompiledRDList(): atom_count_(0), residue_count_(0) {}
+
+CompiledRDList::CompiledRDList(const GlobalRDMap& glob_dist_list,
+                               const EntityView& mdl,
+                               int sequence_separation,
+                               int num_threads):
+  mdl_(mdl), atom_count_(mdl.GetAtomCount()),
+  residue_count_(mdl.GetResidueCount())
+{
+  if (!mdl.GetChainCount()) {
+    return;
+  }
+  AtomViewList atoms=mdl.GetAtomList();
+  std::map<long, int> atom_index;
+  for (size_t i=0; i<atoms.size(); ++i) {
+    atom_index[atoms[i].GetHandle().GetHashCode()]=i;
+  }
+  ChainView mdl_chain=mdl.GetChainList()[0];
+  RDMapIterList residues;
+  for (GlobalRDMap::const_iterator i=glob_dist_list.begin(), 
+       e=glob_dist_list.end(); i!=e; ++i) {
+    residues.push_back(i);
+  }
+  num_threads=std::max(1, std::min(num_threads, int(residues.size())));
+  if (num_threads==1) {
+    CompileResidues(residues, mdl_chain, atom_index, sequence_separation, 0,
+                    residues.size(), entries_, ambiguous_);
+    return;
+  }
+  // every thread compiles a contiguous range of residues, the ranges are
+  // concatenated in order afterwards.
+  std::vector<std::vector<Entry> > entries(num_threads);
+  std::vector<std::vector<AmbiguousResidue> > ambiguous(num_threads);
+  size_t chunk_size=(residues.size()+num_threads-1)/num_threads;
+  boost::thread_group tg;
+  for (int i=0; i<num_threads; ++i) {
+    size_t begin=std::min(residues.size(), i*chunk_size);
+    size_t end=std::min(residues.size(), (i+1)*chunk_size);
+    tg.create_thread(boost::bind(&CompiledRDList::CompileResidues,
+                                 boost::cref(residues), boost::cref(mdl_chain),
+                                 boost::cref(atom_index), sequence_separation,
+                                 begin, end, boost::ref(entries[i]),
+                                 boost::ref(ambiguous[i])));
+  }
+  tg.join_all();
+  for (int i=0; i<num_threads; ++i) {
+    size_t offset=entries_.size();
+    entries_.insert(entries_.end(), entries[i].begin(), entries[i].end());
+    for (std::vector<AmbiguousResidue>::iterator j=ambiguous[i].begin(),
+         e=ambiguous[i].end(); j!=e; ++j) {
+      j->begin+=offset;
+      j->end+=offset;
+      ambiguous_.push_back(*j);
+    }
+  }
+}
+
+void CompiledRDList::CompileResidues(const RDMapIterList& residues,
+                                     const ChainView& mdl_chain,
+                                     const std::map<long, int>& atom_index,
+                                     int sequence_separation,
+                                     size_t begin, size_t end,
+                                     std::vector<Entry>& entries,
+                                     std::vector<AmbiguousResidue>& ambiguous)
+{
+  for (size_t r=begin; r<end; ++r) {
+    GlobalRDMap::const_iterator i=residues[r];
+    ResidueView mdl_res=mdl_chain.FindResidue(i->first);
+    size_t res_begin=entries.size();
+    for (ResidueRDMap::const_iterator j=i->second.begin(), 
+         e2=i->second.end(); j!=e2; ++j) {
+      const UniqueAtomIdentifier& first_atom=j->first.first;
+      const UniqueAtomIdentifier& second_atom=j->first.second;
+      int rnum_a=first_atom.GetResNum().GetNum();
+      int rnum_b=second_atom.GetResNum().GetNum();
+      Entry entry;
+      entry.flags=0;
+      if (rnum_a>rnum_b+sequence_separation) {
+        entry.flags|=COUNTED;
+      }
+      if (std::abs(rnum_a-rnum_b)>sequence_separation &&
+          !Swappable(second_atom.GetResidueName(), second_atom.GetAtomName())) {
+        entry.flags|=FIXED;
+      }
+      if (!entry.flags) {
+        continue;
+      }
+      ResidueView mdl_res_b=mdl_chain.FindResidue(second_atom.GetResNum());
+      entry.res_a=mdl_res ? mdl_res.GetIndex() : -1;
+      entry.res_b=mdl_res_b ? mdl_res_b.GetIndex() : -1;
+      lookup_atom(mdl_res, first_atom.GetAtomName(), atom_index,
+                  entry.atom_a, entry.atom_a_swapped);
+      lookup_atom(mdl_res_b, second_atom.GetAtomName(), atom_index,
+                  entry.atom_b, entry.atom_b_swapped);
+      entry.min_dist=j->second.first;
+      entry.max_dist=j->second.second;
+      entries.push_back(entry);
+    }
+    if (mdl_res && has_ambiguous_naming(mdl_res.GetName()) && 
+        entries.size()>res_begin) {
+      AmbiguousResidue amb_res;
+      amb_res.res=mdl_res.GetIndex();
+      amb_res.begin=res_begin;
+      amb_res.end=entries.size();
+      ambiguous.push_back(amb_res);
+    }
+  }
+}
+
+std::pair<long int,long int> 
+CompiledRDList::Evaluate(const geom::Vec3List& positions,
+                         const std::vector<Real>& cutoff_list,
+                         int num_threads) const
+{
+  std::vector<std::pair<long int, long int> > per_residue;
+  std::vector<bool> swapped;
+  return this->Evaluate(positions, cutoff_list, per_residue, swapped, 
+                        num_threads);
+}
+
+std::pair<long int,long int>
+CompiledRDList::Evaluate(const geom::Vec3List& positions,
+                         const std::vector<Real>& cutoff_list,
+                         std::vector<std::pair<long int, long int> >& per_residue,
+                         std::vector<bool>& swapped,
+                         int num_threads) const
+{
+  if (positions.size()!=atom_count_) {
+    std::stringstream ss;
+    ss << "Expected " << atom_count_ << " positions, got " << positions.size();
+    throw Error(ss.str());
+  }
+  per_residue.assign(residue_count_, std::pair<long int, long int>(0, 0));
+  std::pair<long int, long int> total_ov(0, 0);
+  // the naming convention of all ambiguous residues has to be known before
+  // counting. char instead of bool, since the threads write to it.
+  std::vector<char> swapped_res(residue_count_, 0);
+  num_threads=std::max(1, num_threads);
+  if (num_threads==1 || entries_.size()<size_t(num_threads)) {
+    this->ChooseNaming(positions, cutoff_list, 0, ambiguous_.size(), 
+                       swapped_res);
+    this->CountConserved(positions, cutoff_list, swapped_res, 0, 
+                         entries_.size(), per_residue, total_ov);
+  } else {
+    // every residue is only part of one range, the threads never write to the
+    // same element of swapped_res.
+    size_t chunk_size=(ambiguous_.size()+num_threads-1)/num_threads;
+    boost::thread_group tg;
+    for (int i=0; i<num_threads; ++i) {
+      size_t begin=std::min(ambiguous_.size(), i*chunk_size);
+      size_t end=std::min(ambiguous_.size(), (i+1)*chunk_size);
+      tg.create_thread(boost::bind(&CompiledRDList::ChooseNaming, this,
+                                   boost::cref(positions), 
+                                   boost::cref(cutoff_list), begin, end,
+                                   boost::ref(swapped_res)));
+    }
+    tg.join_all();
+    // the counts are integers, summing them up in any order gives the same
+    // result
+    std::vector<std::vector<std::pair<long int, long int> > > thread_res(num_threads);
+    std::vector<std::pair<long int, long int> > thread_ov(num_threads);
+    chunk_size=(entries_.size()+num_threads-1)/num_threads;
+    for (int i=0; i<num_threads; ++i) {
+      size_t begin=std::min(entries_.size(), i*chunk_size);
+      size_t end=std::min(entries_.size(), (i+1)*chunk_size);
+      thread_res[i].assign(residue_count_, std::pair<long int, long int>(0, 0));
+      thread_ov[i]=std::pair<long int, long int>(0, 0);
+      tg.create_thread(boost::bind(&CompiledRDList::CountConserved, this,
+                                   boost::cref(positions),
+                                   boost::cref(cutoff_list),
+                                   boost::cref(swapped_res), begin, end,
+                                   boost::ref(thread_res[i]),
+                                   boost::ref(thread_ov[i])));
+    }
+    tg.join_all();
+    for (int i=0; i<num_threads; ++i) {
+      total_ov.first+=thread_ov[i].first;
+      total_ov.second+=thread_ov[i].second;
+      for (size_t j=0; j<residue_count_; ++j) {
+        per_residue[j].first+=thread_res[i][j].first;
+        per_residue[j].second+=thread_res[i][j].second;
+      }
+    }
+  }
+  swapped.assign(swapped_res.begin(), swapped_res.end());
+  return total_ov;
+}
+
+// pick the naming convention which conserves more distances to fixed atoms
+void CompiledRDList::ChooseNaming(const geom::Vec3List& positions,
+                                  const std::vector<Real>& cutoff_list,
+                                  size_t begin, size_t end,
+                                  std::vector<char>& swapped) const
+{
+  long int num_cutoffs=cutoff_list.size();
+  for (size_t i=begin; i<end; ++i) {
+    const AmbiguousResidue& amb_res=ambiguous_[i];
+    long int total=0, ov1=0, ov2=0;
+    for (size_t j=amb_res.begin; j<amb_res.end; ++j) {
+      const Entry& entry=entries_[j];
+      if (!(entry.flags & FIXED)) {
+        continue;
+      }
+      total+=num_cutoffs;
+      if (entry.atom_b<0) {
+        continue;
+      }
+      std::pair<Real,Real> values(entry.min_dist, entry.max_dist);
+      if (entry.atom_a>=0) {
+        Real mdl_dist=geom::Length(positions[entry.atom_a]-positions[entry.atom_b]);
+        ov1+=count_conserved(mdl_dist, values, cutoff_list);
+      }
+      if (entry.atom_a_swapped>=0) {
+        Real mdl_dist=geom::Length(positions[entry.atom_a_swapped]-positions[entry.atom_b]);
+        ov2+=count_conserved(mdl_dist, values, cutoff_list);
+      }
+    }
+    if (static_cast<Real>(ov1)/total<static_cast<Real>(ov2)/total) {
+      swapped[amb_res.res]=1;
+    }
+  }
+}
+
+void CompiledRDList::CountConserved(const geom::Vec3List& positions,
+                                    const std::vector<Real>& cutoff_list,
+                                    const std::vector<char>& swapped,
+                                    size_t begin, size_t end,
+                                    std::vector<std::pair<long int, long int> >& per_residue,
+                                    std::pair<long int, long int>& total_ov) const
+{
+  long int num_cutoffs=cutoff_list.size();
+  for (size_t j=begin; j<end; ++j) {
+    const Entry& entry=entries_[j];
+    if (!(entry.flags & COUNTED)) {
+      continue;
+    }
+    total_ov.second+=num_cutoffs;
+    if (entry.res_a>=0) {
+      per_residue[entry.res_a].second+=num_cutoffs;
+    }
+    if (entry.res_b<0) {
+      continue;
+    }
+    per_residue[entry.res_b].second+=num_cutoffs;
+    int atom_a=entry.res_a>=0 && swapped[entry.res_a] ? entry.atom_a_swapped : entry.atom_a;
+    int atom_b=swapped[entry.res_b] ? entry.atom_b_swapped : entry.atom_b;
+    if (atom_a<0 || atom_b<0) {
+      continue;
+    }
+    Real mdl_dist=geom::Length(positions[atom_a]-positions[atom_b]);
+    int conserved=count_conserved(mdl_dist, 
+                                  std::make_pair(entry.min_dist, entry.max_dist),
+                                  cutoff_list);
+    total_ov.first+=conserved;
+    per_residue[entry.res_a].first+=conserved;
+    per_residue[entry.res_b].first+=conserved;
+  }
+}
+
+geom::Vec3List CompiledRDList::GetPositions() const
+{
+  geom::Vec3List positions;
+  if (!mdl_.IsValid()) {
+    return positions;
+  }
+  AtomViewList atoms=mdl_.GetAtomList();
+  positions.reserve(atoms.size());
+  for (AtomViewList::const_iterator i=atoms.begin(), e=atoms.end(); i!=e; ++i) {
+    positions.push_back(i->GetPos());
+  }
+  return positions;
+}
+
 lDDTScorer::lDDTScorer(std::vector<EntityView>& init_references,
                        ost::mol::EntityView& init_model,
                        lDDTSettings& init_settings):
@@ -511,6 +875,7 @@ lDDTScorer::lDDTScorer(std::vector<EntityView>& init_references,
     _score_calculated = false;
     _score_valid = false;
     _has_local_scores = false;
+    _dist_list_compiled = false;
     _num_cons_con = -1;
     _num_tot_con = -1;
     _global_score = -1.0;
@@ -563,13 +928,30 @@ void lDDTScorer::_PrepareGlobalRDMap(){
   glob_dist_list = PreparelDDTGlobalRDMap(references_view,
                                           settings.cutoffs,
                                           settings.sequence_separation,
-                                          settings.radius);
+                                          settings.radius,
+                                          settings.num_threads);
 }
 
 bool lDDTScorer::IsValid(){
   return _score_valid;
 }
 
+const CompiledRDList& lDDTScorer::GetCompiledDistanceList(){
+  if (!_dist_list_compiled) {
+    _compiled_dist_list = CompiledRDList(glob_dist_list,
+                                         model_view,
+                                         settings.sequence_separation,
+                                         settings.num_threads);
+    _dist_list_compiled = true;
+  }
+  return _compiled_dist_list;
+}
+
+Real lDDTScorer::ScoreCoordinates(const geom::Vec3List& positions){
+  std::pair<long int,long int> total_ov = GetCompiledDistanceList().Evaluate(positions, settings.cutoffs, settings.num_threads);
+  return static_cast<Real>(total_ov.first)/(static_cast<Real>(total_ov.second) ? static_cast<Real>(total_ov.second) : 1);
+}
+
 void lDDTScorer::_ComputelDDT(){
   std::pair<int,int> cov = ComputeCoverage(model_view,glob_dist_list);
   if (cov.second == -1) {
@@ -588,7 +970,7 @@ void lDDTScorer::_ComputelDDT(){
     _score_valid = false;
   }
 
-  std::pair<int,int> total_ov=alg::LocalDistDiffTest(model_view, glob_dist_list, settings.cutoffs, settings.sequence_separation, settings.label);
+  std::pair<int,int> total_ov=alg::LocalDistDiffTest(model_view, glob_dist_list, settings.cutoffs, settings.sequence_separation, settings.label, settings.num_threads);
   Real lddt = static_cast<Real>(total_ov.first)/(static_cast<Real>(total_ov.second) ? static_cast<Real>(total_ov.second) : 1);
   _num_tot_con = total_ov.second ? total_ov.second : 1;
   _num_cons_con = total_ov.first;
@@ -609,58 +991,89 @@ void lDDTScorer::_GetLocallDDT(){
 }
 
 
-GlobalRDMap CreateDistanceList(const EntityView& ref,Real max_dist)
+GlobalRDMap CreateDistanceList(const EntityView& ref,Real max_dist,
+                               int num_threads)
 {
  GlobalRDMap dist_list; 
  if (!ref.GetChainCount()) {
    return dist_list;
  }
- ResidueViewList ref_residues=ref.GetChainList()[0].GetResidueList(); 
+ // only distances between non-hydrogen atoms of the first chain are
+ // considered. The identifiers of all these atoms are built once and the
+ // neighbours are found in one pass over all atoms.
+ ChainView ref_chain=ref.GetChainList()[0];
+ ResidueViewList ref_residues=ref_chain.GetResidueList(); 
+ std::vector<UniqueAtomIdentifier> chain_ids;
+ geom::Vec3List chain_pos;
+ std::vector<size_t> first_atoms;
+ std::vector<size_t> res_first_atom(1, 0);
  for (ResidueViewList::iterator i=ref_residues.begin(), e=ref_residues.end(); i!=e; ++i) {
-   if (IsStandardResidue(i->GetName())) {
-     ResidueRDMap res_dist_list;
-     ResNum rnum = i->GetNumber();  
-     AtomViewList ref_atoms=i->GetAtomList();
-     AtomViewList within;
-     if (max_dist<0){
-       within=ref.GetAtomList();
-     }  
-     for (AtomViewList::iterator ai=ref_atoms.begin(), ae=ref_atoms.end(); ai!=ae; ++ai) {
-       UniqueAtomIdentifier first_atom(ai->GetResidue().GetChain().GetName(),ai->GetResidue().GetNumber(),ai->GetResidue().GetName(),ai->GetName());
-       if (ai->GetElement()=="H") { continue; }
-       if (max_dist>=0){ 
-         within=ref.FindWithin(ai->GetPos(), max_dist);
-       }
-       for (AtomViewList::iterator aj=within.begin(), ae2=within.end(); aj!=ae2; ++aj) {      
-         UniqueAtomIdentifier second_atom(aj->GetResidue().GetChain().GetName(),aj->GetResidue().GetNumber(),aj->GetResidue().GetName(),aj->GetName());
-         if (aj->GetElement()=="H" ||
-             aj->GetResidue().GetChain()!=ai->GetResidue().GetChain()) {
-             continue;
-         }
-         Real dist=geom::Length(ai->GetPos()-aj->GetPos());
-         UAtomIdentifiers atoms = std::make_pair(first_atom,second_atom); 
-         std::pair<Real,Real> values = std::make_pair(dist,dist);  
-         res_dist_list[atoms]=values;
-       }
-     }   
-     dist_list[rnum]=res_dist_list;
+   bool standard=IsStandardResidue(i->GetName());
+   AtomViewList ref_atoms=i->GetAtomList();
+   for (AtomViewList::iterator ai=ref_atoms.begin(), ae=ref_atoms.end(); ai!=ae; ++ai) {
+     if (ai->GetElement()=="H") { continue; }
+     if (standard) {
+       first_atoms.push_back(chain_ids.size());
+     }
+     chain_ids.push_back(UniqueAtomIdentifier(ref_chain.GetName(),i->GetNumber(),i->GetName(),ai->GetName()));
+     chain_pos.push_back(ai->GetPos());
+   }
+   res_first_atom.push_back(first_atoms.size());
+ }
+ geom::Vec3List first_pos;
+ first_pos.reserve(first_atoms.size());
+ for (size_t i=0; i<first_atoms.size(); ++i) {
+   first_pos.push_back(chain_pos[first_atoms[i]]);
+ }
+ NeighborPairList pairs;
+ if (max_dist>=0) {
+   pairs=FindAllPairsWithin(first_pos, chain_pos, max_dist, num_threads);
+ } else {
+   for (size_t i=0; i<first_pos.size(); ++i) {
+     for (size_t j=0; j<chain_pos.size(); ++j) {
+       pairs.push_back(NeighborPair(i, j, geom::Length2(first_pos[i]-chain_pos[j])));
+     }
    }
+ }
+ // the residue distance lists are independent of each other, every thread
+ // builds the ones of a contiguous range of residues
+ std::vector<ResidueRDMap> res_dist_lists(ref_residues.size());
+ num_threads=std::max(1, std::min(num_threads, int(ref_residues.size())));
+ if (num_threads==1) {
+   build_residue_rd_maps_mt(pairs, chain_ids, first_atoms, res_first_atom, 0,
+                            ref_residues.size(), res_dist_lists)();
+ } else {
+   size_t chunk_size=(ref_residues.size()+num_threads-1)/num_threads;
+   boost::thread_group tg;
+   for (int i=0; i<num_threads; ++i) {
+     size_t begin=std::min(ref_residues.size(), i*chunk_size);
+     size_t end=std::min(ref_residues.size(), (i+1)*chunk_size);
+     tg.create_thread(build_residue_rd_maps_mt(pairs, chain_ids, first_atoms,
+                                               res_first_atom, begin, end,
+                                               res_dist_lists));
+   }
+   tg.join_all();
+ }
+ for (size_t r=0; r<ref_residues.size(); ++r) {
+   if (!IsStandardResidue(ref_residues[r].GetName())) { continue; }
+   dist_list[ref_residues[r].GetNumber()].swap(res_dist_lists[r]);
  } 
  return dist_list;
 } 
 
-GlobalRDMap CreateDistanceListFromMultipleReferences(const std::vector<EntityView>& ref_list, std::vector<Real>& cutoff_list, int sequence_separation, Real max_dist)
+GlobalRDMap CreateDistanceListFromMultipleReferences(const std::vector<EntityView>& ref_list, std::vector<Real>& cutoff_list, int sequence_separation, Real max_dist,
+                                                     int num_threads)
 {
   int ref_counter=0;  
   ExistenceMap ex_map;  
-  GlobalRDMap glob_dist_list = CreateDistanceList(ref_list[0],max_dist);
+  GlobalRDMap glob_dist_list = CreateDistanceList(ref_list[0],max_dist,num_threads);
   update_existence_map (ex_map,ref_list[0],ref_counter);
   ref_counter++;  
   for (std::vector<EntityView>::const_iterator ref_list_it=ref_list.begin()+1;ref_list_it!=ref_list.end();++ref_list_it) {
        EntityView ref = *ref_list_it;
        std::vector<std::pair<long int, long int> > overlap_list(ref.GetResidueCount(), std::pair<long int, long int>(0, 0));
        check_and_swap(glob_dist_list,ref,cutoff_list,sequence_separation,overlap_list);
-       GlobalRDMap new_dist_list=CreateDistanceList(ref,max_dist);
+       GlobalRDMap new_dist_list=CreateDistanceList(ref,max_dist,num_threads);
        merge_distance_lists(glob_dist_list,new_dist_list,ex_map,ref,ref_counter);
        update_existence_map (ex_map,ref,ref_counter); 
        ref_counter++;
@@ -691,7 +1104,8 @@ void PrintGlobalRDMap(const GlobalRDMap& glob_dist_list){
 
 
 std::pair<long int,long int> LocalDistDiffTest(const EntityView& mdl, const GlobalRDMap& glob_dist_list,
-                   std::vector<Real> cutoff_list, int sequence_separation, const String& local_lddt_property_string)
+                   std::vector<Real> cutoff_list, int sequence_separation, const String& local_lddt_property_string,
+                   int num_threads)
 {
   if (!mdl.GetResidueCount()) {
     LOG_WARNING("model structures doesn't contain any residues");
@@ -702,19 +1116,42 @@ std::pair<long int,long int> LocalDistDiffTest(const EntityView& mdl, const Glob
     return std::make_pair(0,0);
   }
   std::vector<std::pair<long int, long int> > overlap_list(mdl.GetResidueCount(), std::pair<long int, long int>(0, 0));
-  check_and_swap(glob_dist_list,mdl,cutoff_list,sequence_separation,overlap_list);
   ChainView mdl_chain=mdl.GetChainList()[0];  
-  overlap_list.clear();
   std::pair<long int, long int> total_ov(0, 0);
-  for (GlobalRDMap::const_iterator i=glob_dist_list.begin(), e=glob_dist_list.end(); i!=e; ++i) {
-    ResNum rn = i->first;
-    if (i->second.size()!=0) {
-      std::pair<long int, long int> ov1=calc_overlap1(i->second, rn, mdl_chain, sequence_separation, cutoff_list, 
-                                            false, false, overlap_list,true);
-      total_ov.first+=ov1.first;
-      total_ov.second+=ov1.second;
+  // the compiled list doesn't log the individual distances, the single
+  // threaded version is used when they are requested
+  bool log_distances=Logger::Instance().GetVerbosityLevel()>=Logger::VERBOSE;
+  if (num_threads>1 && !log_distances) {
+    CompiledRDList compiled(glob_dist_list, mdl, sequence_separation, num_threads);
+    std::vector<bool> swapped;
+    total_ov=compiled.Evaluate(compiled.GetPositions(), cutoff_list,
+                               overlap_list, swapped, num_threads);
+    // rename the atoms of the residues for which the swapped naming convention
+    // has been chosen, as check_and_swap does
+    XCSEditor edi=mdl.GetHandle().EditXCS(BUFFERED_EDIT);
+    ResidueViewList residues=mdl_chain.GetResidueList();
+    for (ResidueViewList::iterator i=residues.begin(), e=residues.end(); i!=e; ++i) {
+      if (!swapped[i->GetIndex()]) {
+        continue;
+      }
+      AtomViewList atoms=i->GetAtomList();
+      for (AtomViewList::iterator j=atoms.begin(), e2=atoms.end(); j!=e2; ++j) {
+        if (Swappable(i->GetName(), j->GetName())) {
+          edi.RenameAtom(j->GetHandle(), SwappedName(j->GetName()));
+        }
+      }
+    }
+  } else {
+    check_and_swap(glob_dist_list,mdl,cutoff_list,sequence_separation,overlap_list);
+    for (GlobalRDMap::const_iterator i=glob_dist_list.begin(), e=glob_dist_list.end(); i!=e; ++i) {
+      ResNum rn = i->first;
+      if (i->second.size()!=0) {
+        std::pair<long int, long int> ov1=calc_overlap1(i->second, rn, mdl_chain, sequence_separation, cutoff_list, 
+                                              false, false, overlap_list,true);
+        total_ov.first+=ov1.first;
+        total_ov.second+=ov1.second;
+      }
     }
-
   }
   for (GlobalRDMap::const_iterator i=glob_dist_list.begin(),
        e=glob_dist_list.end();i!=e; ++i) {
@@ -730,7 +1167,6 @@ std::pair<long int,long int> LocalDistDiffTest(const EntityView& mdl, const Glob
       }
     }
   }
-  overlap_list.clear();
   return std::make_pair(total_ov.first,total_ov.second);
 }
 
@@ -761,7 +1197,7 @@ Real LocalDistDiffTest(const EntityView& v,
     return 0.0;
   }
 
-  std::pair<int,int> total_ov=alg::LocalDistDiffTest(v, glob_dist_list, settings.cutoffs, settings.sequence_separation, settings.label);
+  std::pair<int,int> total_ov=alg::LocalDistDiffTest(v, glob_dist_list, settings.cutoffs, settings.sequence_separation, settings.label, settings.num_threads);
   Real lddt = static_cast<Real>(total_ov.first)/(static_cast<Real>(total_ov.second) ? static_cast<Real>(total_ov.second) : 1);
   std::cout << "Global LDDT score: " << std::setprecision(4) << lddt << std::endl;
   std::cout << "(" << std::fixed << total_ov.first << " conserved distances out of " << total_ov.second
@@ -845,15 +1281,17 @@ void CleanlDDTReferences(std::vector<EntityView>& ref_list){
 GlobalRDMap PreparelDDTGlobalRDMap(const std::vector<EntityView>& ref_list,
                                    std::vector<Real>& cutoff_list,
                                    int sequence_separation,
-                                   Real max_dist){
+                                   Real max_dist,
+                                   int num_threads){
   GlobalRDMap glob_dist_list;
   if (ref_list.size()==1) {
-    glob_dist_list = CreateDistanceList(ref_list[0], max_dist);
+    glob_dist_list = CreateDistanceList(ref_list[0], max_dist, num_threads);
   } else {
     glob_dist_list = CreateDistanceListFromMultipleReferences(ref_list,
                                                               cutoff_list,
                                                               sequence_separation,
-                                                              max_dist);
+                                                              max_dist,
+                                                              num_threads);
   }
 
   return glob_dist_list;
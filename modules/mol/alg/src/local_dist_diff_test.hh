@@ -19,6 +19,7 @@
 #ifndef OST_MOL_ALG_LOCAL_DIST_TEST_HH
 #define OST_MOL_ALG_LOCAL_DIST_TEST_HH
 
+#include <map>
 #include <ost/mol/alg/module_config.hh>
 #include <ost/mol/entity_handle.hh>
 #include <ost/seq/alignment_handle.hh>
@@ -45,12 +46,16 @@ struct lDDTSettings {
   int sequence_separation;
   std::vector<Real> cutoffs;
   String label;
+  // number of threads used to build the distance list and to count the
+  // conserved distances. The result doesn't depend on the number of threads.
+  int num_threads;
 
   lDDTSettings();
   lDDTSettings(Real init_radius, 
                int init_sequence_separation,
                std::vector<Real>& init_cutoffs,
-               String init_label);
+               String init_label,
+               int init_num_threads=1);
   void PrintParameters();
   std::string ToString();
 };
@@ -82,6 +87,109 @@ struct lDDTLocalScore {
   static String GetHeader(bool structural_checks, int cutoffs_length);
 };
 
+/// \brief Flat, index based version of a GlobalRDMap
+///
+/// The distances of a GlobalRDMap are resolved once against the topology of a
+/// model. Every distance is stored as a pair of indices into the atom list of
+/// the model (as returned by EntityView::GetAtomList()) together with the
+/// minimal and maximal reference distance. Distances that are excluded by the
+/// sequence separation are dropped. A set of model coordinates can then be
+/// evaluated in a single linear pass, without any name lookups.
+///
+/// The evaluation gives the same result as LocalDistDiffTest() on the model
+/// with its atoms moved to the given positions. The naming convention of
+/// residues with ambiguous side-chain atoms is resolved for every set of
+/// positions, but neither are atoms renamed nor are residue properties set.
+class DLLEXPORT_OST_MOL_ALG CompiledRDList
+{
+public:
+  CompiledRDList();
+
+  CompiledRDList(const GlobalRDMap& glob_dist_list, const EntityView& mdl,
+                 int sequence_separation=0, int num_threads=1);
+
+  /// \brief number of conserved distances and number of total distances
+  ///
+  /// \p positions must be in the order of the model atom list
+  std::pair<long int,long int> Evaluate(const geom::Vec3List& positions,
+                                        const std::vector<Real>& cutoff_list,
+                                        int num_threads=1) const;
+
+  /// \brief same as above, additionally fills the per residue counts and the
+  ///     residues for which the swapped naming convention has been chosen.
+  ///
+  /// Both vectors are indexed by residue index of the model.
+  std::pair<long int,long int> Evaluate(const geom::Vec3List& positions,
+                                        const std::vector<Real>& cutoff_list,
+                                        std::vector<std::pair<long int, long int> >& per_residue,
+                                        std::vector<bool>& swapped,
+                                        int num_threads=1) const;
+
+  /// \brief atom positions of the model the list has been compiled for
+  geom::Vec3List GetPositions() const;
+
+  size_t GetAtomCount() const { return atom_count_; }
+
+  size_t GetResidueCount() const { return residue_count_; }
+
+  /// \brief number of distances in the list
+  size_t GetSize() const { return entries_.size(); }
+
+private:
+  enum {
+    // distance between two residues beyond the sequence separation, used for
+    // the final score
+    COUNTED=1,
+    // distance to a fixed (not ambiguously named) atom, used to decide on the
+    // naming convention of ambiguous residues
+    FIXED=2
+  };
+
+  struct Entry {
+    int           atom_a;
+    int           atom_a_swapped;
+    int           atom_b;
+    int           atom_b_swapped;
+    int           res_a;
+    int           res_b;
+    Real          min_dist;
+    Real          max_dist;
+    unsigned char flags;
+  };
+
+  // range of entries starting at an ambiguously named model residue
+  struct AmbiguousResidue {
+    int    res;
+    size_t begin;
+    size_t end;
+  };
+
+  typedef std::vector<GlobalRDMap::const_iterator> RDMapIterList;
+
+  static void CompileResidues(const RDMapIterList& residues,
+                              const ChainView& mdl_chain,
+                              const std::map<long, int>& atom_index,
+                              int sequence_separation, size_t begin, size_t end,
+                              std::vector<Entry>& entries,
+                              std::vector<AmbiguousResidue>& ambiguous);
+
+  void ChooseNaming(const geom::Vec3List& positions,
+                    const std::vector<Real>& cutoff_list,
+                    size_t begin, size_t end, std::vector<char>& swapped) const;
+
+  void CountConserved(const geom::Vec3List& positions,
+                      const std::vector<Real>& cutoff_list,
+                      const std::vector<char>& swapped, size_t begin, size_t end,
+                      std::vector<std::pair<long int, long int> >& per_residue,
+                      std::pair<long int, long int>& total_ov) const;
+
+  std::vector<Entry>            entries_;
+  std::vector<AmbiguousResidue> ambiguous_;
+  EntityView                    mdl_;
+  size_t                        atom_count_;
+  size_t                        residue_count_;
+};
+
 class lDDTScorer
 {
   public:
@@ -100,11 +208,22 @@ class lDDTScorer
     std::vector<EntityView> GetReferences();
     void PrintPerResidueStats();
     bool IsValid();
+    /// \brief global lDDT score of the model with its atoms moved to
+    ///     \p positions
+    ///
+    /// \p positions must be in the order of model_view.GetAtomList(). The
+    /// distance list is compiled on the first call and reused afterwards, which
+    /// makes this cheap for scoring many frames or models sharing the topology
+    /// of model_view. The model is not modified.
+    Real ScoreCoordinates(const geom::Vec3List& positions);
+    const CompiledRDList& GetCompiledDistanceList();
 
   private:
     bool _score_calculated;
     bool _score_valid;
     bool _has_local_scores;
+    bool _dist_list_compiled;
+    CompiledRDList _compiled_dist_list;
     // number of conserved distances in the model and
     // the number of total distances in the reference structure
     int _num_cons_con;
@@ -141,10 +260,17 @@ bool DLLEXPORT_OST_MOL_ALG IsResnumInGlobalRDMap(const ResNum& resnum, const Glo
 /// residue properties. Specifically, the local residue-based lddt score is stored in a float property named
 /// as the provided string, while the residue-based number of conserved and total distances are saved in two 
 /// int properties named [string]_conserved and [string]_total.
+///
+/// With num_threads larger than one, the distance list is compiled into a 
+/// CompiledRDList and the distances are counted in parallel. The results are
+/// the same as for the single threaded version. If the verbosity level is
+/// Logger::VERBOSE or higher, the single threaded version is used, since it
+/// logs every distance as PASS or FAIL.
 std::pair<long int,long int> DLLEXPORT_OST_MOL_ALG 
 LocalDistDiffTest(const EntityView& mdl, const GlobalRDMap& dist_list,
                   std::vector<Real> cutoff_list, int sequence_separation = 0, 
-                  const String& local_ldt_property_string="");
+                  const String& local_ldt_property_string="",
+                  int num_threads=1);
 
 /// \brief Calculates the Local Distance Difference Score for a given model with respect to a given target
 ///
@@ -199,8 +325,11 @@ Real DLLEXPORT_OST_MOL_ALG LDDTHA(EntityView& v, const GlobalRDMap& global_dist_
 
 /// \brief Creates a list of distances to check during a Local Difference Distance Test
 ///
-/// Requires a reference structure and an inclusion radius (max_dist)
-GlobalRDMap DLLEXPORT_OST_MOL_ALG CreateDistanceList(const EntityView& ref,Real max_dist);
+/// Requires a reference structure and an inclusion radius (max_dist). The
+/// neighbour search and the construction of the residue distance lists are
+/// distributed over num_threads threads.
+GlobalRDMap DLLEXPORT_OST_MOL_ALG CreateDistanceList(const EntityView& ref,Real max_dist,
+                                                     int num_threads=1);
 
 /// \brief Creates a list of distances to check during a Local Difference Distance Test starting from multiple reference structures
 ///
@@ -224,7 +353,8 @@ GlobalRDMap DLLEXPORT_OST_MOL_ALG CreateDistanceList(const EntityView& ref,Real
 /// must be passed to the function. These parameters do not influence the output distance list, which always includes all distances
 /// within the provided max_dist (to make it consistent with the single-reference corresponding function). However, the parameters are used when
 /// dealing with the naming convention of residues with ambiguous nomenclature. 
-GlobalRDMap DLLEXPORT_OST_MOL_ALG CreateDistanceListFromMultipleReferences(const std::vector<EntityView>& ref_list,std::vector<Real>& cutoff_list, int sequence_separation, Real max_dist);
+GlobalRDMap DLLEXPORT_OST_MOL_ALG CreateDistanceListFromMultipleReferences(const std::vector<EntityView>& ref_list,std::vector<Real>& cutoff_list, int sequence_separation, Real max_dist,
+                                                                           int num_threads=1);
 
 /// \brief Prints all distances in a global distance list to standard output
 void DLLEXPORT_OST_MOL_ALG PrintGlobalRDMap(const GlobalRDMap& glob_dist_list);
@@ -243,7 +373,8 @@ GlobalRDMap DLLEXPORT_OST_MOL_ALG PreparelDDTGlobalRDMap(
     const std::vector<EntityView>& ref_list,
     std::vector<Real>& cutoff_list,
     int sequence_separation,
-    Real max_dist);
+    Real max_dist,
+    int num_threads=1);
 
 void DLLEXPORT_OST_MOL_ALG CheckStructure(EntityView& ent,
                                           StereoChemicalParams& bond_table,
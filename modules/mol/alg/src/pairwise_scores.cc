@@ -0,0 +1,190 @@
+//------------------------------------------------------------------------------
+// This file is part of the OpenStructure project <www.openstructure.org>
+//
+// Copyright (C) 2008-2020 by the OpenStructure authors
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 3.0 of the License, or (at your option)
+// any later version.
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <boost/thread/thread.hpp>
+#include <boost/bind.hpp>
+#include <ost/message.hh>
+#include <ost/mol/alg/svd_superpose.hh>
+#include <ost/mol/alg/pairwise_scores.hh>
+
+namespace ost { namespace mol { namespace alg {
+
+namespace {
+
+// coordinates of all structures in one contiguous block, so a tile of
+// structures occupies a contiguous range of memory.
+struct PairwiseInput {
+  std::vector<geom::Vec3> coords;
+  int num_structures;
+  int num_atoms;
+  PairwiseScore score;
+
+  const geom::Vec3* Structure(int i) const
+  {
+    return &coords[static_cast<size_t>(i)*num_atoms];
+  }
+};
+
+Real compare(const PairwiseInput& input, int i, int j)
+{
+  const geom::Vec3* a=input.Structure(i);
+  const geom::Vec3* b=input.Structure(j);
+  int n=input.num_atoms;
+  Real rmsd=0.0;
+  geom::Mat4 tf=SuperposeQCP(a, b, n, &rmsd);
+  if (input.score==PS_RMSD) {
+    return rmsd;
+  }
+  if (input.score==PS_GDT_TS) {
+    int counts[4]={0, 0, 0, 0};
+    for (int k=0; k<n; ++k) {
+      Real d2=geom::Length2(geom::Vec3(tf*geom::Vec4(a[k]))-b[k]);
+      counts[0]+=d2<=1.0;
+      counts[1]+=d2<=4.0;
+      counts[2]+=d2<=16.0;
+      counts[3]+=d2<=64.0;
+    }
+    return Real(counts[0]+counts[1]+counts[2]+counts[3])/(4*n);
+  }
+  Real d0=std::max(Real(0.5), Real(1.24*std::cbrt(std::max(n-15, 1))-1.8));
+  Real inv_d02=1.0/(d0*d0);
+  Real sum=0.0;
+  for (int k=0; k<n; ++k) {
+    Real d2=geom::Length2(geom::Vec3(tf*geom::Vec4(a[k]))-b[k]);
+    sum+=1.0/(1.0+d2*inv_d02);
+  }
+  return sum/n;
+}
+
+// Compares all pairs of structures of every num_threads-th pair of tiles
+void CompareTiles(const PairwiseInput& input, int tile_size,
+                  const std::vector<std::pair<int, int> >& tiles,
+                  int first, int num_threads, SimilarityMatrix& result)
+{
+  for (size_t t=first; t<tiles.size(); t+=num_threads) {
+    int i_begin=tiles[t].first*tile_size;
+    int i_end=std::min(i_begin+tile_size, input.num_structures);
+    int j_begin=tiles[t].second*tile_size;
+    int j_end=std::min(j_begin+tile_size, input.num_structures);
+    for (int i=i_begin; i<i_end; ++i) {
+      for (int j=std::max(j_begin, i+1); j<j_end; ++j) {
+        result.Set(i, j, compare(input, i, j));
+      }
+    }
+  }
+}
+
+SimilarityMatrix pairwise_scores(const PairwiseInput& input, int num_threads)
+{
+  int n=input.num_structures;
+  SimilarityMatrix result(n, input.score==PS_RMSD ? 0.0 : 1.0);
+  if (n<2) {
+    return result;
+  }
+  // two tiles of structures should fit into the L2 cache
+  int bytes=input.num_atoms*sizeof(geom::Vec3);
+  int tile_size=std::max(1, (128*1024)/bytes);
+  int num_tiles=(n+tile_size-1)/tile_size;
+  std::vector<std::pair<int, int> > tiles;
+  for (int i=0; i<num_tiles; ++i) {
+    for (int j=i; j<num_tiles; ++j) {
+      tiles.push_back(std::make_pair(i, j));
+    }
+  }
+  num_threads=std::max(1, std::min(num_threads, int(tiles.size())));
+  if (num_threads==1) {
+    CompareTiles(input, tile_size, tiles, 0, 1, result);
+  } else {
+    boost::thread_group tg;
+    for (int i=0; i<num_threads; ++i) {
+      tg.create_thread(boost::bind(&CompareTiles, boost::cref(input), tile_size,
+                                   boost::cref(tiles), i, num_threads,
+                                   boost::ref(result)));
+    }
+    tg.join_all();
+  }
+  return result;
+}
+
+}
+
+SimilarityMatrix PairwiseScores(const std::vector<geom::Vec3List>& structures,
+                                PairwiseScore score, int num_threads)
+{
+  PairwiseInput input;
+  input.num_structures=structures.size();
+  input.num_atoms=structures.empty() ? 0 : structures[0].size();
+  input.score=score;
+  if (!structures.empty() && input.num_atoms<3) {
+    throw Error("at least 3 atoms are required for superposition");
+  }
+  input.coords.reserve(static_cast<size_t>(input.num_structures)*
+                       input.num_atoms);
+  for (size_t i=0; i<structures.size(); ++i) {
+    if (int(structures[i].size())!=input.num_atoms) {
+      std::stringstream ss;
+      ss << "structure " << i << " has " << structures[i].size()
+         << " atoms, expected " << input.num_atoms;
+      throw Error(ss.str());
+    }
+    input.coords.insert(input.coords.end(), structures[i].begin(),
+                        structures[i].end());
+  }
+  return pairwise_scores(input, num_threads);
+}
+
+SimilarityMatrix PairwiseScores(const CoordGroupHandle& cg,
+                                const EntityView& sel, PairwiseScore score,
+                                int begin, int end, int num_threads)
+{
+  int real_end=end==-1 ? cg.GetFrameCount() : end;
+  std::vector<unsigned long> indices;
+  if (!sel.IsValid()) {
+    for (size_t i=0; i<cg.GetAtomCount(); ++i) {
+      indices.push_back(i);
+    }
+  } else {
+    AtomViewList atoms=sel.GetAtomList();
+    for (AtomViewList::const_iterator i=atoms.begin(),
+         e=atoms.end(); i!=e; ++i) {
+      indices.push_back(i->GetIndex());
+    }
+  }
+  if (indices.size()<3) {
+    throw Error("at least 3 atoms are required for superposition");
+  }
+  PairwiseInput input;
+  input.num_structures=std::max(0, real_end-begin);
+  input.num_atoms=indices.size();
+  input.score=score;
+  input.coords.reserve(static_cast<size_t>(input.num_structures)*
+                       input.num_atoms);
+  for (int i=begin; i<real_end; ++i) {
+    CoordFramePtr frame=cg.GetFrame(i);
+    for (size_t j=0; j<indices.size(); ++j) {
+      input.coords.push_back((*frame)[indices[j]]);
+    }
+  }
+  return pairwise_scores(input, num_threads);
+}
+
+}}}
@@ -0,0 +1,64 @@
+//------------------------------------------------------------------------------
+// This file is part of the OpenStructure project <www.openstructure.org>
+//
+// Copyright (C) 2008-2020 by the OpenStructure authors
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 3.0 of the License, or (at your option)
+// any later version.
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//------------------------------------------------------------------------------
+#ifndef OST_MOL_ALG_PAIRWISE_SCORES_HH
+#define OST_MOL_ALG_PAIRWISE_SCORES_HH
+
+#include <ost/geom/geom.hh>
+#include <ost/mol/coord_group.hh>
+#include <ost/mol/entity_view.hh>
+#include <ost/mol/alg/module_config.hh>
+#include <ost/mol/alg/similarity_matrix.hh>
+
+namespace ost { namespace mol { namespace alg {
+
+/// \brief score determined for every pair of structures by PairwiseScores
+///
+/// All scores are evaluated on the superposition minimizing the RMSD. The
+/// GDT_TS and TM-score are therefore lower bounds of the values obtained by
+/// programs that search for the superposition maximizing the score.
+typedef enum {
+  PS_RMSD,
+  PS_GDT_TS,
+  PS_TM_SCORE
+} PairwiseScore;
+
+/// \brief all-against-all comparison of structures with equal atom count
+///
+/// The structures are processed in tiles, so the coordinates of a tile stay in
+/// cache while its pairs are compared. Tiles are distributed among num_threads
+/// threads.
+///
+/// \throws Error if the structures differ in size or contain less than 3
+///     atoms
+SimilarityMatrix DLLEXPORT_OST_MOL_ALG
+PairwiseScores(const std::vector<geom::Vec3List>& structures,
+               PairwiseScore score=PS_RMSD, int num_threads=1);
+
+/// \brief all-against-all comparison of frames begin to end (exclusive) of a
+///     coord group, using the atoms of sel
+///
+/// If sel is invalid, all atoms of the coord group are used.
+SimilarityMatrix DLLEXPORT_OST_MOL_ALG
+PairwiseScores(const CoordGroupHandle& cg, const EntityView& sel,
+               PairwiseScore score=PS_RMSD, int begin=0, int end=-1,
+               int num_threads=1);
+
+}}}
+
+#endif
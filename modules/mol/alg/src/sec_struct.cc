@@ -1,9 +1,13 @@
 #include <ost/mol/alg/sec_struct.hh>
 
 #include <ost/mol/sec_structure.hh>
+#include <ost/mol/cell_list_organizer.hh>
 
 #include <limits>
 #include <iostream>
+#include <algorithm>
+#include <boost/thread/thread.hpp>
+#include <boost/bind.hpp>
 
 namespace {
 
@@ -445,6 +449,106 @@ void AssignTurns(int start_idx, int size,
   }
 }
 
+// residues are only considered for hydrogen bonds if their CA atoms are
+// closer than this
+const Real CA_CUTOFF = 9.0;
+
+struct HBondInput {
+
+  HBondInput(const std::vector<geom::Vec3>& n,
+             const std::vector<geom::Vec3>& c,
+             const std::vector<geom::Vec3>& o,
+             const std::vector<geom::Vec3>& h,
+             const std::vector<geom::Vec3>& ca,
+             const std::vector<int>& valid_h,
+             const ost::mol::CellListOrganizer<int>& org):
+    n_positions(n), c_positions(c), o_positions(o), h_positions(h),
+    ca_positions(ca), valid_hydrogens(valid_h), ca_organizer(org) { }
+
+  const std::vector<geom::Vec3>& n_positions;
+  const std::vector<geom::Vec3>& c_positions;
+  const std::vector<geom::Vec3>& o_positions;
+  const std::vector<geom::Vec3>& h_positions;
+  const std::vector<geom::Vec3>& ca_positions;
+  const std::vector<int>& valid_hydrogens;
+  const ost::mol::CellListOrganizer<int>& ca_organizer;
+};
+
+// Determines the two lowest energy acceptors for every num_threads-th donor,
+// starting at first.
+//
+// The result is identical to evaluating all residue pairs (i < j) in order:
+// candidates pass the same CA distance check and are visited in increasing
+// index order, so ties resolve the same way. As in that pair loop, the
+// residue preceding the donor is never considered as acceptor.
+void AssignAcceptors(const HBondInput& input, int first, int num_threads,
+                     std::vector<std::pair<Real,Real> >& donor_energies,
+                     std::vector<std::pair<int,int> >& acceptors) {
+
+  int num_residues = input.ca_positions.size();
+  std::vector<int> candidates;
+  std::vector<geom::Vec3> c_positions;
+  std::vector<geom::Vec3> o_positions;
+  std::vector<Real> energies;
+
+  for(int d = first; d < num_residues; d += num_threads) {
+
+    if(!input.valid_hydrogens[d]) continue;
+
+    // the cell list uses a slightly larger radius, the exact cutoff is 
+    // applied below with the same expression as in the pairwise check
+    std::vector<int> neighbours = 
+    input.ca_organizer.FindWithin(input.ca_positions[d], CA_CUTOFF + 0.01);
+    candidates.clear();
+    for(std::vector<int>::const_iterator it = neighbours.begin();
+        it != neighbours.end(); ++it) {
+      int a = *it;
+      if(a == d || a == d - 1) continue;
+      int i = std::min(a, d);
+      int j = std::max(a, d);
+      if(geom::Length2(input.ca_positions[i] - input.ca_positions[j]) < 81.0) {
+        candidates.push_back(a);
+      }
+    }
+    std::sort(candidates.begin(), candidates.end());
+
+    // energies are evaluated on contiguous copies, which allows the compiler
+    // to vectorize the loop
+    int num_candidates = candidates.size();
+    c_positions.resize(num_candidates);
+    o_positions.resize(num_candidates);
+    energies.resize(num_candidates);
+    for(int k = 0; k < num_candidates; ++k) {
+      c_positions[k] = input.c_positions[candidates[k]];
+      o_positions[k] = input.o_positions[candidates[k]];
+    }
+    const geom::Vec3 h_pos = input.h_positions[d];
+    const geom::Vec3 n_pos = input.n_positions[d];
+    for(int k = 0; k < num_candidates; ++k) {
+      Real e = ost::mol::alg::DSSPHBondEnergy(h_pos, n_pos, c_positions[k],
+                                              o_positions[k]);
+      // stupid rounding to be consistent with dssp
+      energies[k] = std::floor(e * 1000 + 0.5) * 0.001;
+    }
+
+    std::pair<Real,Real>& donor_e = donor_energies[d];
+    std::pair<int,int>& acc = acceptors[d];
+    for(int k = 0; k < num_candidates; ++k) {
+      Real e = energies[k];
+      if(e < donor_e.first) {
+        donor_e.second = donor_e.first;
+        acc.second = acc.first;
+        donor_e.first = e;
+        acc.first = candidates[k];
+      }
+      else if(e < donor_e.second) {
+        donor_e.second = e;
+        acc.second = candidates[k];
+      }
+    }
+  }
+}
+
 } // anon ns
 
 namespace ost{ namespace mol{ namespace alg{
@@ -491,7 +595,8 @@ void PrepareSSData(const ost::mol::ResidueViewList& res_list,
                    std::vector<geom::Vec3>& ca_positions,
                    std::vector<int>& donor_for_one,
                    std::vector<int>& donor_for_two,
-                   std::vector<int>& connected_to_next) {
+                   std::vector<int>& connected_to_next,
+                   int num_threads) {
 
   res_indices.clear();
   ca_positions.clear();
@@ -569,53 +674,30 @@ void PrepareSSData(const ost::mol::ResidueViewList& res_list,
 
   std::vector<std::pair<Real,Real> > donor_energies(num_residues, max_e_pair);
   std::vector<std::pair<int,int> > acceptors(num_residues, std::make_pair(-1, -1));
-  Real e;
-
-  for(int i = 0; i < num_residues - 1; ++i){
-    for(int j = i + 1; j < num_residues; ++j){
-      if(geom::Length2(ca_positions[i] - ca_positions[j]) < 81.0){
-
-        //i as acceptor, j as donor
-        if(j > i + 1 && valid_hydrogens[j]){
-          e = DSSPHBondEnergy(h_positions[j], n_positions[j],
-                              c_positions[i], o_positions[i]);
-          // stupid rounding to be consistent with dssp
-          e = std::floor(e * 1000 + 0.5) * 0.001;
-
-          if(e < donor_energies[j].first) {
-            donor_energies[j].second = donor_energies[j].first;
-            acceptors[j].second = acceptors[j].first;
-            donor_energies[j].first = e;
-            acceptors[j].first = i;
-          }
-          else if(e < donor_energies[j].second) {
-            donor_energies[j].second = e;
-            acceptors[j].second = i;
-          }
-        }
 
-        //i as donor, j as acceptor
-        if(valid_hydrogens[i]){
-
-          e = DSSPHBondEnergy(h_positions[i], n_positions[i],
-                              c_positions[j], o_positions[j]);
-          // stupid rounding to be consistent with dssp
-          e = std::floor(e * 1000 + 0.5) * 0.001;
-
-          if(e < donor_energies[i].first) {
-            donor_energies[i].second = donor_energies[i].first;
-            acceptors[i].second = acceptors[i].first;
-            donor_energies[i].first = e;
-            acceptors[i].first = j;
-          }
-          else if(e < donor_energies[i].second) {
-            donor_energies[i].second = e;
-            acceptors[i].second = j; 
-          }
-        }
-      }
+  // only residues with CA atoms closer than 9A are considered. The cell list
+  // has to be built before it is queried concurrently.
+  ost::mol::CellListOrganizer<int> ca_organizer(CA_CUTOFF);
+  for(int i = 0; i < num_residues; ++i) {
+    ca_organizer.Add(i, ca_positions[i]);
+  }
+  ca_organizer.Build();
+
+  HBondInput input(n_positions, c_positions, o_positions, h_positions,
+                   ca_positions, valid_hydrogens, ca_organizer);
+  num_threads = std::max(1, std::min(num_threads, num_residues));
+  if(num_threads == 1) {
+    AssignAcceptors(input, 0, 1, donor_energies, acceptors);
+  }
+  else {
+    boost::thread_group tg;
+    for(int i = 0; i < num_threads; ++i) {
+      tg.create_thread(boost::bind(&AssignAcceptors, boost::cref(input), i,
+                                   num_threads, boost::ref(donor_energies),
+                                   boost::ref(acceptors)));
     }
-  } 
+    tg.join_all();
+  }
 
   donor_for_one.assign(num_residues, -1);
   donor_for_two.assign(num_residues, -1);
@@ -630,7 +712,7 @@ void PrepareSSData(const ost::mol::ResidueViewList& res_list,
   }
 }
 
-void AssignSecStruct(ost::mol::EntityView& ent) {
+void AssignSecStruct(ost::mol::EntityView& ent, int num_threads) {
 
   ost::mol::ResidueViewList res_list = ent.GetResidueList();
 
@@ -646,7 +728,8 @@ void AssignSecStruct(ost::mol::EntityView& ent) {
   std::vector<int> connected_to_next;
 
   PrepareSSData(res_list, res_indices, ca_positions, 
-                donor_for_one, donor_for_two, connected_to_next);
+                donor_for_one, donor_for_two, connected_to_next,
+                num_threads);
 
   String ss = RawEstimateSS(ca_positions, 0, ca_positions.size(),
                             donor_for_one, donor_for_two,
@@ -657,9 +740,9 @@ void AssignSecStruct(ost::mol::EntityView& ent) {
   }
 }
 
-void AssignSecStruct(ost::mol::EntityHandle& ent) {
+void AssignSecStruct(ost::mol::EntityHandle& ent, int num_threads) {
   ost::mol::EntityView view = ent.CreateFullView();
-  AssignSecStruct(view);
+  AssignSecStruct(view, num_threads);
 }
 
 }}} //ns
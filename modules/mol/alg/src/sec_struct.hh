@@ -58,6 +58,10 @@ inline Real DSSPHBondEnergy(const geom::Vec3& h_pos, const geom::Vec3& n_pos,
 // full structure but only estimate the secondary structure for a small
 // stretch, that gets defined by start_idx and size.
 // For an example usage have a look at the AssignSecStruct functions.
+//
+// PrepareSSData only evaluates hydrogen bonds between residues with CA atoms
+// closer than 9A, found with a cell list. The donors can be distributed over
+// num_threads threads, the result does not depend on the number of threads.
 
 String RawEstimateSS(const std::vector<geom::Vec3>& ca_positions, 
                      int start_idx, int size,
@@ -70,11 +74,12 @@ void PrepareSSData(const ost::mol::ResidueViewList& res_list,
                    std::vector<geom::Vec3>& ca_positions,
                    std::vector<int>& donor_for_one,
                    std::vector<int>& donor_for_two,
-                   std::vector<int>& connected_to_next);
+                   std::vector<int>& connected_to_next,
+                   int num_threads=1);
 
-void AssignSecStruct(ost::mol::EntityView& ent);
+void AssignSecStruct(ost::mol::EntityView& ent, int num_threads=1);
 
-void AssignSecStruct(ost::mol::EntityHandle& ent);
+void AssignSecStruct(ost::mol::EntityHandle& ent, int num_threads=1);
 
 }}} //ns
 
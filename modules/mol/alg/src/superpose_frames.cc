@@ -17,9 +17,12 @@
 // 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 //------------------------------------------------------------------------------
 
-#include <Eigen/Eigenvalues>
+#include <algorithm>
+#include <boost/thread/thread.hpp>
+#include <boost/bind.hpp>
 #include <ost/message.hh>
 #include <ost/mol/mol.hh>
+#include <ost/mol/alg/svd_superpose.hh>
 #include <ost/mol/alg/superpose_frames.hh>
 
 namespace ost { namespace mol { namespace alg {
@@ -30,166 +33,166 @@ bool less_index(const mol::AtomHandle& a1, const mol::AtomHandle& a2)
   return a1.GetIndex()<a2.GetIndex();
 }
 
-}
-
-typedef Eigen::Matrix<Real, 3, 3> EMat3;
-typedef Eigen::Matrix<Real, 1, 3> ECVec3;
-typedef Eigen::Matrix<Real, 3, 1> ERVec3;
-typedef Eigen::Matrix<Real, 3, Eigen::Dynamic> EMat3X;
-typedef Eigen::Matrix<Real, Eigen::Dynamic, 3> EMatX3;
-
-
-inline geom::Vec3 rvec_to_gvec(const ERVec3 &vec) {
-  return geom::Vec3(vec.data());
-}
-
-inline geom::Vec3 cvec_to_gvec(const ECVec3 &vec) {
-  return geom::Vec3(vec.data());
-}
-
-inline geom::Mat3 emat_to_gmat(const EMat3 &mat)
+std::vector<unsigned long> get_indices(CoordGroupHandle& cg, EntityView& sel)
 {
-  return geom::Mat3(mat.data());
+  std::vector<unsigned long> indices;
+  if (!sel.IsValid()) {
+    indices.reserve(cg.GetAtomCount());
+    for (size_t i=0;i<cg.GetAtomCount(); ++i) {
+      indices.push_back(i);
+    }
+  } else {
+    AtomViewList atoms=sel.GetAtomList();
+    indices.reserve(atoms.size());
+    for (AtomViewList::const_iterator i=atoms.begin(), 
+         e=atoms.end(); i!=e; ++i) {
+      indices.push_back(i->GetIndex());
+    }
+  }
+  return indices;
 }
 
-inline ERVec3 gvec_to_rvec(const geom::Vec3 &vec)
+void gather(const CoordFrame& frame, const std::vector<unsigned long>& indices,
+            std::vector<geom::Vec3>& points)
 {
-  return ERVec3(&vec[0]);
+  points.resize(indices.size());
+  for (size_t j=0; j<indices.size(); ++j) {
+    points[j]=frame[indices[j]];
+  }
 }
 
-inline ECVec3 gvec_to_cvec(const geom::Vec3 &vec)
+// Determines the transformation of every num_threads-th frame, starting at
+// first. If ref_pos is empty, every frame is superposed onto its predecessor.
+// The frame at index skip is left untouched.
+void SuperposeRange(const std::vector<CoordFramePtr>& frames,
+                    const std::vector<unsigned long>& indices,
+                    const std::vector<geom::Vec3>& ref_pos, int skip,
+                    int first, int num_threads,
+                    std::vector<geom::Mat4>& transformations)
 {
-  return ECVec3(&vec[0]);
+  std::vector<geom::Vec3> pos, prev_pos;
+  for (int i=first; i<static_cast<int>(frames.size()); i+=num_threads) {
+    if (i==skip) {
+      continue;
+    }
+    gather(*frames[i], indices, pos);
+    if (ref_pos.empty()) {
+      gather(*frames[i-1], indices, prev_pos);
+      transformations[i]=SuperposeQCP(&pos[0], &prev_pos[0], pos.size());
+    } else {
+      transformations[i]=SuperposeQCP(&pos[0], &ref_pos[0], pos.size());
+    }
+  }
 }
 
-inline EMat3X row_sub(const EMat3X& m, const ERVec3& s)
+void TransformRange(const std::vector<CoordFramePtr>& frames,
+                    const std::vector<geom::Mat4>& transformations,
+                    int offset, int first, int num_threads,
+                    std::vector<CoordFrame>& transformed)
 {
-  EMat3X r(m);
-  for (int col=0;  col<m.cols();++col) {
-    r.col(col)-=s;
+  for (int i=first; i<static_cast<int>(transformed.size()); i+=num_threads) {
+    const CoordFrame& frame=*frames[offset+i];
+    const geom::Mat4& tf=transformations[offset+i];
+    transformed[i].resize(frame.size());
+    for (size_t j=0; j<frame.size(); ++j) {
+      transformed[i][j]=geom::Vec3(tf*geom::Vec4(frame[j]));
+    }
   }
-  return r;
 }
 
-inline EMatX3 col_sub(const EMatX3& m, const ECVec3& s)
+// Superposes the frames with the given reference and adds them to
+// superposed. The transformations are determined first, then the frames are
+// transformed in blocks to limit the amount of memory held at once.
+CoordGroupHandle SuperposeFramePtrs(CoordGroupHandle& cg,
+                                    const std::vector<CoordFramePtr>& frames,
+                                    const std::vector<unsigned long>& indices,
+                                    const std::vector<geom::Vec3>& ref_pos,
+                                    int skip, int num_threads)
 {
-  EMatX3 r(m);
-  for (int row=0;  row<m.rows();++row) {
-    r.row(row)-=s;
+  mol::AtomHandleList alist(cg.GetEntity().GetAtomList());
+  std::sort(alist.begin(), alist.end(),less_index);
+  CoordGroupHandle superposed=CreateCoordGroup(alist);
+  int num_frames=frames.size();
+  if (num_frames==0) {
+    return superposed;
+  }
+  num_threads=std::max(1, std::min(num_threads, num_frames));
+  std::vector<geom::Mat4> transformations(num_frames);
+  if (num_threads==1) {
+    SuperposeRange(frames, indices, ref_pos, skip, 0, 1, transformations);
+  } else {
+    boost::thread_group tg;
+    for (int i=0; i<num_threads; ++i) {
+      tg.create_thread(boost::bind(&SuperposeRange, boost::cref(frames),
+                                   boost::cref(indices), boost::cref(ref_pos),
+                                   skip, i, num_threads,
+                                   boost::ref(transformations)));
+    }
+    tg.join_all();
   }
-  return r;
+  if (ref_pos.empty()) {
+    // the transformations superpose every frame onto its predecessor in its
+    // original position. Chaining them yields the superposition onto the
+    // already superposed predecessor.
+    for (int i=1; i<num_frames; ++i) {
+      transformations[i]=transformations[i-1]*transformations[i];
+    }
+  }
+  int block_size=16*num_threads;
+  std::vector<CoordFrame> transformed;
+  for (int offset=0; offset<num_frames; offset+=block_size) {
+    transformed.resize(std::min(block_size, num_frames-offset));
+    if (num_threads==1) {
+      TransformRange(frames, transformations, offset, 0, 1, transformed);
+    } else {
+      boost::thread_group tg;
+      for (int i=0; i<num_threads; ++i) {
+        tg.create_thread(boost::bind(&TransformRange, boost::cref(frames),
+                                     boost::cref(transformations), offset, i,
+                                     num_threads, boost::ref(transformed)));
+      }
+      tg.join_all();
+    }
+    for (size_t i=0; i<transformed.size(); ++i) {
+      superposed.AddFrame(transformed[i]);
+    }
+  }
+  return superposed;
 }
 
-  
-void AddSuperposedFrame(CoordGroupHandle& superposed, EMatX3& ref_mat,EMatX3& ref_centered,ECVec3& ref_center,CoordFramePtr frame,std::vector<unsigned long>& indices)
+std::vector<CoordFramePtr> get_frames(CoordGroupHandle& cg, int begin, int end)
 {
-  // This function superposes and then adds a CoordFrame (frame) to a CoordGroup (superposed).
-  // ref_mat, ref_centered and ref_center contain respectively the positions, centered positions and
-  // vector to center of the reference points for superposition.
-  // indices is a vector of the indices of the atoms to be superposed on the reference positions
-  EMat3X frame_centered=EMat3X::Zero(3, indices.size());
-  EMat3X frame_mat=EMat3X::Zero(3, indices.size());
-  ERVec3 frame_center;
-  for (size_t j=0; j<indices.size(); ++j) {
-    frame_mat.col(j)=gvec_to_rvec((*frame)[indices[j]]);
-  }
-  std::vector<geom::Vec3> frame_data=*frame;
-  frame_center=frame_mat.rowwise().sum()/frame_mat.cols();
-  frame_centered=row_sub(frame_mat, frame_center);
-  //single value decomposition
-  Eigen::JacobiSVD<EMat3> svd(frame_centered*ref_centered,Eigen::ComputeFullU | Eigen::ComputeFullV);
-  EMat3 matrixVT=svd.matrixV().transpose();
-  //determine rotation
-  Real detv=matrixVT.determinant();
-  Real dett=svd.matrixU().determinant();
-  Real det=detv*dett;
-  EMat3 e_rot;
-  if (det<0) {
-    EMat3 tmat=EMat3::Identity();
-    tmat(2,2)=-1;
-    e_rot=(svd.matrixU()*tmat)*matrixVT;
-  }else{
-    e_rot=svd.matrixU()*matrixVT;
+  // frames are fetched upfront, coord sources reading from disk are not
+  // thread-safe.
+  std::vector<CoordFramePtr> frames;
+  for (int i=begin; i<end; ++i) {
+    frames.push_back(cg.GetFrame(i));
   }
-  //  prepare rmsd calculation
-  geom::Vec3 shift=rvec_to_gvec(ref_center);
-  geom::Vec3 com_vec=-cvec_to_gvec(frame_center);
-  geom::Mat3 rot=emat_to_gmat(e_rot);
-  geom::Mat4 mat4_com, mat4_rot, mat4_shift;
-  mat4_rot.PasteRotation(rot);
-  mat4_shift.PasteTranslation(shift);
-  mat4_com.PasteTranslation(com_vec);
-  geom::Mat4 tf=geom::Mat4(mat4_shift*mat4_rot*mat4_com);
-  for (std::vector<geom::Vec3>::iterator c=frame_data.begin(), 
-       e2=frame_data.end(); c!=e2; ++c) {
-    *c=geom::Vec3(tf*geom::Vec4(*c));
-  }
-  superposed.AddFrame(frame_data);
-}  
+  return frames;
+}
 
+}
 
 CoordGroupHandle SuperposeFrames(CoordGroupHandle& cg, EntityView& sel,
-                                 int begin, int end, int ref)
+                                 int begin, int end, int ref, int num_threads)
 {
   //This function superposes the frames of a CoordGroup (cg) with indices between begin and end
   //onto the frame with index ref. The superposition is done on a selection of atoms given by the EntityView sel.
   int real_end=end==-1 ? cg.GetFrameCount() : end;
-  CoordFramePtr ref_frame;
-  std::vector<unsigned long> indices;
-  if (!sel.IsValid()) {
-    indices.reserve(cg.GetAtomCount());
-    for (size_t i=0;i<cg.GetAtomCount(); ++i) {
-      indices.push_back(i);
-    }
-  } else {
-    AtomViewList atoms=sel.GetAtomList();
-    indices.reserve(atoms.size());
-    for (AtomViewList::const_iterator i=atoms.begin(), 
-         e=atoms.end(); i!=e; ++i) {
-      indices.push_back(i->GetIndex());
-    }
-  }
-  mol::AtomHandleList alist(cg.GetEntity().GetAtomList());
-  std::sort(alist.begin(), alist.end(),less_index);
-  CoordGroupHandle superposed=CreateCoordGroup(alist);
-  EMatX3 ref_mat=EMatX3::Zero(indices.size(), 3);
-  EMatX3 ref_centered=EMatX3::Zero(indices.size(), 3);
-  ECVec3 ref_center;
+  std::vector<unsigned long> indices=get_indices(cg, sel);
+  std::vector<geom::Vec3> ref_pos;
   if (ref!=-1) {
-    ref_frame=cg.GetFrame(ref);
-    for (size_t i=0; i<indices.size(); ++i) {
-      ref_mat.row(i)=gvec_to_cvec((*ref_frame)[indices[i]]);
-    }
-    ref_center=ref_mat.colwise().sum()/ref_mat.rows();
-    ref_centered=col_sub(ref_mat, ref_center);
-  } else {
-    ref_frame=cg.GetFrame(begin);
-  }
-  for (int i=begin; i<real_end; ++i) {
-    if (ref==i || (ref==-1 && i==begin)) {
-      superposed.AddFrame(*ref_frame);
-      ref_frame=superposed.GetFrame(superposed.GetFrameCount()-1);
-      continue;
-    }
-    if (ref==-1) {
-      for (size_t j=0; j<indices.size(); ++j) {
-        ref_mat.row(j)=gvec_to_cvec((*ref_frame)[indices[j]]);
-      }
-      ref_center=ref_mat.colwise().sum()/ref_mat.rows();
-      ref_centered=col_sub(ref_mat, ref_center);
-    }
-    CoordFramePtr frame=cg.GetFrame(i);
-    AddSuperposedFrame(superposed,ref_mat,ref_centered,ref_center,frame,indices);    
-    if (ref==-1) {
-      ref_frame=superposed.GetFrame(superposed.GetFrameCount()-1);
-    }
+    gather(*cg.GetFrame(ref), indices, ref_pos);
   }
-  return superposed;
+  std::vector<CoordFramePtr> frames=get_frames(cg, begin, real_end);
+  return SuperposeFramePtrs(cg, frames, indices, ref_pos,
+                            ref==-1 ? 0 : ref-begin, num_threads);
 }
   
   
 CoordGroupHandle SuperposeFrames(CoordGroupHandle& cg, EntityView& sel,
-                                  EntityView& ref_view, int begin, int end)
+                                 EntityView& ref_view, int begin, int end,
+                                 int num_threads)
 {
   //This function superposes the frames of a CoordGroup (cg) with indices between begin and end,
   //using a selection of atoms (sel), onto an EntityView (ref_view).
@@ -197,43 +200,18 @@ CoordGroupHandle SuperposeFrames(CoordGroupHandle& cg, EntityView& sel,
     throw ost::Error("Invalid reference view");
   }
   int real_end=end==-1 ? cg.GetFrameCount() : end;
-  CoordFramePtr ref_frame;
-  std::vector<unsigned long> indices;
-  if (!sel.IsValid()) {
-    indices.reserve(cg.GetAtomCount());
-    for (size_t i=0;i<cg.GetAtomCount(); ++i) {
-      indices.push_back(i);
-    }
-  } else {
-    AtomViewList atoms=sel.GetAtomList();
-    indices.reserve(atoms.size());
-    for (AtomViewList::const_iterator i=atoms.begin(), 
-         e=atoms.end(); i!=e; ++i) {
-      indices.push_back(i->GetIndex());
-    }
-  }
+  std::vector<unsigned long> indices=get_indices(cg, sel);
   if (int(indices.size())!=ref_view.GetAtomCount()){
     throw ost::Error("atom counts of the two views are not equal");
   }
-  mol::AtomHandleList alist(cg.GetEntity().GetAtomList());
-  std::sort(alist.begin(), alist.end(),less_index);
-  CoordGroupHandle superposed=CreateCoordGroup(alist);
-  EMatX3 ref_mat=EMatX3::Zero(indices.size(), 3);
-  EMatX3 ref_centered=EMatX3::Zero(indices.size(), 3);
-  ECVec3 ref_center;
+  std::vector<geom::Vec3> ref_pos;
   AtomViewList atoms=ref_view.GetAtomList();
-  int i=0;
   for (AtomViewList::const_iterator a=atoms.begin(), 
-       e=atoms.end(); a!=e; a++, i++) {
-    ref_mat.row(i)=gvec_to_cvec((*a).GetPos());
+       e=atoms.end(); a!=e; a++) {
+    ref_pos.push_back(a->GetPos());
   }
-  ref_center=ref_mat.colwise().sum()/ref_mat.rows();
-  ref_centered=col_sub(ref_mat, ref_center);
-  for (int i=begin; i<real_end; ++i) {
-    CoordFramePtr frame=cg.GetFrame(i);
-    AddSuperposedFrame(superposed,ref_mat,ref_centered,ref_center,frame,indices);    
-  }
-  return superposed;
+  std::vector<CoordFramePtr> frames=get_frames(cg, begin, real_end);
+  return SuperposeFramePtrs(cg, frames, indices, ref_pos, -1, num_threads);
 }
   
 }}}
@@ -25,14 +25,18 @@
 namespace ost { namespace mol { namespace alg {
 
 /// \brief returns a superposed version of coord group, superposed on a reference frame
+///
+/// The superpositions of the frames are determined by num_threads threads.
 CoordGroupHandle DLLEXPORT_OST_MOL_ALG SuperposeFrames(CoordGroupHandle& cg, 
                                                        EntityView& sel,
                                                        int begin=0, int end=-1, 
-                                                       int ref=-1);
+                                                       int ref=-1,
+                                                       int num_threads=1);
 /// \brief returns a superposed version of coord group, superposed on a reference view
 CoordGroupHandle DLLEXPORT_OST_MOL_ALG SuperposeFrames(CoordGroupHandle& cg, 
                                                        EntityView& sel, EntityView& ref_view,
-                                                       int begin=0, int end=-1);
+                                                       int begin=0, int end=-1,
+                                                       int num_threads=1);
 }}}
 
 #endif
@@ -19,10 +19,10 @@
 
 #include <stdexcept>
 #include <iostream>
-#include <boost/bind.hpp>
+#include <cmath>
 
 #include <Eigen/SVD>
-#include <Eigen/Geometry>
+#include <Eigen/LU>
 
 #include <ost/base.hh>
 #include <ost/geom/vec3.hh>
@@ -39,17 +39,190 @@
 namespace ost { namespace mol { namespace alg {
 
 
-using boost::bind;
-typedef Eigen::Matrix<Real,3,1> EVec3;
-typedef Eigen::Matrix<Real,3,3> EMat3;
-typedef Eigen::Matrix<Real,4,4> EMat4;
-typedef Eigen::Matrix<Real,1,3> ERVec3;
-typedef Eigen::Matrix<Real,Eigen::Dynamic,Eigen::Dynamic> EMatX;
-typedef Eigen::Matrix<Real,1,Eigen::Dynamic> ERVecX;
+typedef Eigen::Matrix<double,3,3> EMat3d;
 
+namespace {
 
+// rotation superposing the centered points onto the centered reference points
+// from their covariance matrix cov=sum(ref*point^T). Used when QCP can not
+// determine the rotation, which only happens for degenerate input.
+geom::Mat3 rotation_from_svd(const double cov[9])
+{
+  EMat3d m;
+  for (int i=0; i<3; ++i) {
+    for (int j=0; j<3; ++j) {
+      m(i, j)=cov[3*i+j];
+    }
+  }
+  Eigen::JacobiSVD<EMat3d> svd(m, Eigen::ComputeFullU | Eigen::ComputeFullV);
+  EMat3d tmat=EMat3d::Identity();
+  if (svd.matrixU().determinant()*svd.matrixV().determinant()<0) {
+    tmat(2,2)=-1;
+  }
+  EMat3d r=svd.matrixU()*tmat*svd.matrixV().transpose();
+  return geom::Mat3(r(0,0), r(0,1), r(0,2),
+                    r(1,0), r(1,1), r(1,2),
+                    r(2,0), r(2,1), r(2,2));
+}
 
+// largest eigenvalue of the key matrix and the corresponding rotation, see
+// Theobald, Acta Cryst. A61 (2005) and Liu et al., J. Comput. Chem. 31 (2010).
+// Returns false if the eigenvalue or eigenvector can not be determined.
+bool rotation_from_qcp(const double cov[9], double e0, double& max_eigen,
+                       geom::Mat3& rot)
+{
+  const double eval_prec=1e-11;
+  const double evec_prec=1e-6;
+  double sxx=cov[0], sxy=cov[1], sxz=cov[2];
+  double syx=cov[3], syy=cov[4], syz=cov[5];
+  double szx=cov[6], szy=cov[7], szz=cov[8];
+  double sxx2=sxx*sxx, syy2=syy*syy, szz2=szz*szz;
+  double sxy2=sxy*sxy, syz2=syz*syz, sxz2=sxz*sxz;
+  double syx2=syx*syx, szy2=szy*szy, szx2=szx*szx;
+
+  double syzszymsyyszz2=2.0*(syz*szy-syy*szz);
+  double sxx2syy2szz2syz2szy2=syy2+szz2-sxx2+syz2+szy2;
+  double c2=-2.0*(sxx2+syy2+szz2+sxy2+syx2+sxz2+szx2+syz2+szy2);
+  double c1=8.0*(sxx*syz*szy+syy*szx*sxz+szz*sxy*syx-
+                 sxx*syy*szz-syz*szx*sxy-szy*syx*sxz);
+  double sxzpszx=sxz+szx, syzpszy=syz+szy, sxypsyx=sxy+syx;
+  double syzmszy=syz-szy, sxzmszx=sxz-szx, sxymsyx=sxy-syx;
+  double sxxpsyy=sxx+syy, sxxmsyy=sxx-syy;
+  double sxy2sxz2syx2szx2=sxy2+sxz2-syx2-szx2;
+  double c0=sxy2sxz2syx2szx2*sxy2sxz2syx2szx2+
+            (sxx2syy2szz2syz2szy2+syzszymsyyszz2)*
+            (sxx2syy2szz2syz2szy2-syzszymsyyszz2)+
+            (-sxzpszx*syzmszy+sxymsyx*(sxxmsyy-szz))*
+            (-sxzmszx*syzpszy+sxymsyx*(sxxmsyy+szz))+
+            (-sxzpszx*syzpszy-sxypsyx*(sxxpsyy-szz))*
+            (-sxzmszx*syzmszy-sxypsyx*(sxxpsyy+szz))+
+            (sxypsyx*syzpszy+sxzpszx*(sxxmsyy+szz))*
+            (-sxymsyx*syzmszy+sxzpszx*(sxxpsyy+szz))+
+            (sxypsyx*syzmszy+sxzmszx*(sxxmsyy-szz))*
+            (-sxymsyx*syzpszy+sxzmszx*(sxxpsyy-szz));
+
+  // Newton-Raphson, starting from the upper bound e0
+  max_eigen=e0;
+  for (int i=0; i<50; ++i) {
+    double old=max_eigen;
+    double x2=max_eigen*max_eigen;
+    double b=(x2+c2)*max_eigen;
+    double a=b+c1;
+    double deriv=2.0*x2*max_eigen+b+a;
+    if (deriv==0.0) {
+      break;
+    }
+    max_eigen-=(a*max_eigen+c0)/deriv;
+    if (std::abs(max_eigen-old)<std::abs(eval_prec*max_eigen)) {
+      break;
+    }
+  }
 
+  if (!std::isfinite(max_eigen)) {
+    return false;
+  }
+  // the eigenvector is any non-vanishing column of the adjoint matrix
+  double a11=sxxpsyy+szz-max_eigen, a12=syzmszy, a13=-sxzmszx, a14=sxymsyx;
+  double a21=syzmszy, a22=sxxmsyy-szz-max_eigen, a23=sxypsyx, a24=sxzpszx;
+  double a31=a13, a32=a23, a33=syy-sxx-szz-max_eigen, a34=syzpszy;
+  double a41=a14, a42=a24, a43=a34, a44=szz-sxxpsyy-max_eigen;
+  double a3344_4334=a33*a44-a43*a34, a3244_4234=a32*a44-a42*a34;
+  double a3243_4233=a32*a43-a42*a33, a3143_4133=a31*a43-a41*a33;
+  double a3144_4134=a31*a44-a41*a34, a3142_4132=a31*a42-a41*a32;
+  double q1=a22*a3344_4334-a23*a3244_4234+a24*a3243_4233;
+  double q2=-a21*a3344_4334+a23*a3144_4134-a24*a3143_4133;
+  double q3=a21*a3244_4234-a22*a3144_4134+a24*a3142_4132;
+  double q4=-a21*a3243_4233+a22*a3143_4133-a23*a3142_4132;
+  double qsqr=q1*q1+q2*q2+q3*q3+q4*q4;
+  if (qsqr<evec_prec) {
+    q1=a12*a3344_4334-a13*a3244_4234+a14*a3243_4233;
+    q2=-a11*a3344_4334+a13*a3144_4134-a14*a3143_4133;
+    q3=a11*a3244_4234-a12*a3144_4134+a14*a3142_4132;
+    q4=-a11*a3243_4233+a12*a3143_4133-a13*a3142_4132;
+    qsqr=q1*q1+q2*q2+q3*q3+q4*q4;
+  }
+  if (qsqr<evec_prec) {
+    double a1324_1423=a13*a24-a14*a23, a1224_1422=a12*a24-a14*a22;
+    double a1223_1322=a12*a23-a13*a22, a1124_1421=a11*a24-a14*a21;
+    double a1123_1321=a11*a23-a13*a21, a1122_1221=a11*a22-a12*a21;
+    q1=a42*a1324_1423-a43*a1224_1422+a44*a1223_1322;
+    q2=-a41*a1324_1423+a43*a1124_1421-a44*a1123_1321;
+    q3=a41*a1224_1422-a42*a1124_1421+a44*a1122_1221;
+    q4=-a41*a1223_1322+a42*a1123_1321-a43*a1122_1221;
+    qsqr=q1*q1+q2*q2+q3*q3+q4*q4;
+    if (qsqr<evec_prec) {
+      q1=a32*a1324_1423-a33*a1224_1422+a34*a1223_1322;
+      q2=-a31*a1324_1423+a33*a1124_1421-a34*a1123_1321;
+      q3=a31*a1224_1422-a32*a1124_1421+a34*a1122_1221;
+      q4=-a31*a1223_1322+a32*a1123_1321-a33*a1122_1221;
+      qsqr=q1*q1+q2*q2+q3*q3+q4*q4;
+    }
+  }
+  if (qsqr<evec_prec) {
+    return false;
+  }
+  double norm=std::sqrt(qsqr);
+  q1/=norm; q2/=norm; q3/=norm; q4/=norm;
+  double a2=q1*q1, x2=q2*q2, y2=q3*q3, z2=q4*q4;
+  double xy=q2*q3, az=q1*q4, zx=q4*q2, ax=q1*q2, yz=q3*q4, ay=q1*q3;
+  rot=geom::Mat3(a2+x2-y2-z2, 2*(xy+az), 2*(zx-ay),
+                 2*(xy-az), a2-x2+y2-z2, 2*(yz+ax),
+                 2*(zx+ay), 2*(yz-ax), a2-x2-y2+z2);
+  return true;
+}
+
+}
+
+geom::Mat4 SuperposeQCP(const geom::Vec3* points, const geom::Vec3* points_ref,
+                        size_t count, Real* rmsd)
+{
+  if (count<3) {
+    throw Error("at least 3 points are required for superposition");
+  }
+  double c[3]={0.0, 0.0, 0.0}, c_ref[3]={0.0, 0.0, 0.0};
+  for (size_t i=0; i<count; ++i) {
+    for (int k=0; k<3; ++k) {
+      c[k]+=points[i][k];
+      c_ref[k]+=points_ref[i][k];
+    }
+  }
+  for (int k=0; k<3; ++k) {
+    c[k]/=count;
+    c_ref[k]/=count;
+  }
+  double cov[9]={0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+  double g=0.0;
+  for (size_t i=0; i<count; ++i) {
+    double p[3], q[3];
+    for (int k=0; k<3; ++k) {
+      p[k]=points[i][k]-c[k];
+      q[k]=points_ref[i][k]-c_ref[k];
+    }
+    g+=p[0]*p[0]+p[1]*p[1]+p[2]*p[2]+q[0]*q[0]+q[1]*q[1]+q[2]*q[2];
+    for (int j=0; j<3; ++j) {
+      cov[3*j+0]+=q[j]*p[0];
+      cov[3*j+1]+=q[j]*p[1];
+      cov[3*j+2]+=q[j]*p[2];
+    }
+  }
+  double e0=0.5*g, max_eigen=e0;
+  geom::Mat3 rot;
+  if (!rotation_from_qcp(cov, e0, max_eigen, rot)) {
+    rot=rotation_from_svd(cov);
+    max_eigen=0.0;
+    for (int i=0; i<9; ++i) {
+      max_eigen+=rot.Data()[i]*cov[i];
+    }
+  }
+  if (rmsd) {
+    *rmsd=std::sqrt(std::abs(2.0*(e0-max_eigen)/count));
+  }
+  geom::Vec3 com(c[0], c[1], c[2]), com_ref(c_ref[0], c_ref[1], c_ref[2]);
+  geom::Mat4 tf;
+  tf.PasteRotation(rot);
+  tf.PasteTranslation(com_ref-rot*com);
+  return tf;
+}
 
 Real calc_rmsd_for_point_lists(const std::vector<geom::Vec3>& points1,
                               const std::vector<geom::Vec3>& points2,
@@ -88,27 +261,6 @@ Real calc_rmsd_for_atom_lists(const mol::AtomViewList& atoms1,
   return rmsd;
 }
 
-Real calc_rmsd_for_ematx(const EMatX& atoms1,
-                         const EMatX& atoms2,
-                         const EMat4& transformation)
-{
-  EMatX transformed = EMatX::Zero(atoms1.rows(), 3);
-
-  EMatX vector = EMatX::Zero(4,1);
-  EMatX transformed_vector = EMatX::Zero(4,1);
-  vector(3,0)=1;
-
-  for(int i=0;i<atoms1.rows();++i){
-    vector.block<3,1>(0,0)=atoms1.block<1,3>(i,0).transpose();
-    transformed_vector = transformation*vector;
-    transformed.block<1,3>(i,0)=transformed_vector.block<3,1>(0,0).transpose();
-  }
-
-  transformed = transformed - atoms2;
-  transformed = transformed.array()*transformed.array();
-  return sqrt(transformed.rowwise().sum().sum()/atoms1.rows());
-}
-
 Real CalculateRMSD(const mol::EntityView& ev1,
                    const mol::EntityView& ev2,
                    const geom::Mat4& transformation) {
@@ -124,98 +276,37 @@ Real CalculateRMSD(const mol::EntityView& ev1,
                                   transformation);
 }
 
-geom::Vec3 EigenVec3ToVec3(const EVec3 &vec)
-{
-  return geom::Vec3(vec.data());
-}
-
-geom::Mat3 EigenMat3ToMat3(const EMat3 &mat)
-{
-  geom::Mat3 return_mat;
-  for(int i=0;i<3;++i){
-    for(int j=0;j<3;++j){
-      return_mat(i,j) = mat(i,j);
-    }
-  }
-  return return_mat;
-}
-
-geom::Mat4 EigenMat4ToMat4(const EMat4 &mat)
-{ 
-  geom::Mat4 return_mat;
-  for(int i=0;i<4;++i){
-    for(int j=0;j<4;++j){
-      return_mat(i,j) = mat(i,j);
-    }
-  }
-  return return_mat;
-}
-
-EMatX Mat4ToEigenMat4(const geom::Mat4 &mat){
-  EMat4 res = EMat4::Zero();
-  for(int i=0;i<4;++i){
-    for(int j=0;j<4;++j){
-      res(i,j)=mat.At(i,j);
-    }
-  }
-  return res;
-}
-
-EVec3 Vec3ToEigenRVec(const geom::Vec3 &vec)
-{
-  return EVec3(&vec[0]);
-}
-
-EVec3 Vec3ToEigenVec(const geom::Vec3 &vec)
-{
-  return EVec3(&vec[0]);
-}
-
-EMatX MatrixShiftedBy(EMatX mat, ERVecX vec)
-{
-  EMatX result = mat;
-  for (int row=0;  row<mat.rows();++row) {
-    result.row(row) -= vec;
-  }
-  return result;
-}
-
 
 class MeanSquareMinimizerImpl {
 public:
-  MeanSquareMinimizerImpl(int n_atoms, bool alloc_atoms):
-    n_atoms_(n_atoms), alloc_atoms_(alloc_atoms) 
-  {
-    if (alloc_atoms_) {
-      atoms1_=EMatX::Zero(n_atoms_, 3);
-      atoms2_=EMatX::Zero(n_atoms_, 3);
-    }
-  }
+  MeanSquareMinimizerImpl(int n_atoms):
+    atoms1_(n_atoms), atoms2_(n_atoms)
+  { }
 
   void SetRefPos(size_t index, const geom::Vec3& pos) {
-    atoms2_.row(index) = ERVec3(Vec3ToEigenVec(pos));
+    atoms2_[index]=pos;
   }
 
   void SetPos(size_t index, const geom::Vec3& pos) {
-    atoms1_.row(index) = ERVec3(Vec3ToEigenVec(pos));
+    atoms1_[index]=pos;
   }
 
-  SuperpositionResult Minimize(const EMatX& atoms, const EMatX& atoms_ref) const;
+  SuperpositionResult Minimize(const std::vector<geom::Vec3>& atoms,
+                               const std::vector<geom::Vec3>& atoms_ref) const;
 
-  EMatX TransformEMatX(const EMatX& mat, const EMat4& transformation) const;
-
-  void CreateMatchingSubsets(std::vector<int>& matching_subset, const EMatX& atoms, 
-                             const EMatX& atoms_ref, Real distance_threshold) const;
+  void CreateMatchingSubsets(std::vector<int>& matching_subset,
+                             const std::vector<geom::Vec3>& atoms,
+                             const geom::Mat4& transformation,
+                             const std::vector<geom::Vec3>& atoms_ref,
+                             Real distance_threshold) const;
 
   SuperpositionResult IterativeMinimize(int ncycles, Real distance_threshold) const;
 
   SuperpositionResult MinimizeOnce() const;
 
 private:
-  int   n_atoms_;
-  bool  alloc_atoms_;
-  EMatX atoms1_;
-  EMatX atoms2_;
+  std::vector<geom::Vec3> atoms1_;
+  std::vector<geom::Vec3> atoms2_;
 };
 
 
@@ -231,7 +322,7 @@ MeanSquareMinimizer MeanSquareMinimizer::FromAtomLists(const AtomViewList& atoms
     throw Error("at least 3 atoms are required for superposition");
   }
   MeanSquareMinimizer msm;
-  msm.impl_ = new MeanSquareMinimizerImpl(n_atoms, true);
+  msm.impl_ = new MeanSquareMinimizerImpl(n_atoms);
 
   for (size_t i = 0; i < atoms.size(); ++i ) {
     msm.impl_->SetRefPos(i, atoms_ref[i].GetPos());
@@ -252,7 +343,7 @@ MeanSquareMinimizer MeanSquareMinimizer::FromPointLists(const std::vector<geom::
     throw Error("at least 3 points are required for superposition");
   }
   MeanSquareMinimizer msm;
-  msm.impl_ = new MeanSquareMinimizerImpl(n_points, true);
+  msm.impl_ = new MeanSquareMinimizerImpl(n_points);
 
   for (size_t i = 0; i < points.size(); ++i ) {
     msm.impl_->SetRefPos(i, points_ref[i]);
@@ -267,19 +358,17 @@ SuperpositionResult MeanSquareMinimizerImpl::MinimizeOnce() const{
 
 SuperpositionResult MeanSquareMinimizerImpl::IterativeMinimize(int max_cycles, Real distance_threshold) const{
 
-  EMat4 transformation_matrix_old;
-  EMat4 transformation_matrix;
-  EMatX transformed_atoms;
-  EMatX subset1 = atoms1_;
-  EMatX subset2 = atoms2_;
+  geom::Mat4 transformation_matrix_old;
+  geom::Mat4 transformation_matrix;
+  std::vector<geom::Vec3> subset1 = atoms1_;
+  std::vector<geom::Vec3> subset2 = atoms2_;
   SuperpositionResult res;
-  EMat4 diff;
   std::vector<int> matching_indices;
 
   //do initial superposition
 
   res = this->Minimize(atoms1_, atoms2_);
-  transformation_matrix = Mat4ToEigenMat4(res.transformation);
+  transformation_matrix = res.transformation;
   transformation_matrix_old = transformation_matrix;
 
   //note, that the initial superposition is the first cycle...
@@ -287,8 +376,8 @@ SuperpositionResult MeanSquareMinimizerImpl::IterativeMinimize(int max_cycles, R
 
   for(;cycles<max_cycles;++cycles){
 
-    transformed_atoms = this->TransformEMatX(atoms1_, transformation_matrix);
-    this->CreateMatchingSubsets(matching_indices, transformed_atoms, atoms2_, distance_threshold);
+    this->CreateMatchingSubsets(matching_indices, atoms1_, transformation_matrix,
+                                atoms2_, distance_threshold);
 
     if(matching_indices.size()<3){
       std::stringstream ss;
@@ -297,23 +386,28 @@ SuperpositionResult MeanSquareMinimizerImpl::IterativeMinimize(int max_cycles, R
       throw Error(ss.str());
     }
 
-    subset1 = EMatX::Zero(matching_indices.size(),3);
-    subset2 = EMatX::Zero(matching_indices.size(),3);
+    subset1.resize(matching_indices.size());
+    subset2.resize(matching_indices.size());
 
     int i = 0;
     std::vector<int>::iterator it = matching_indices.begin();
 
     for(; it!=matching_indices.end(); ++it, ++i){
-      subset1.row(i) = atoms1_.row(*it);
-      subset2.row(i) = atoms2_.row(*it);
+      subset1[i] = atoms1_[*it];
+      subset2[i] = atoms2_[*it];
     }
 
     res = this->Minimize(subset1,subset2);
-    transformation_matrix = Mat4ToEigenMat4(res.transformation);
+    transformation_matrix = res.transformation;
 
-    diff = transformation_matrix_old-transformation_matrix;
+    Real diff=0.0;
+    for (int r=0; r<4; ++r) {
+      for (int c=0; c<4; ++c) {
+        diff+=std::abs(transformation_matrix_old(r,c)-transformation_matrix(r,c));
+      }
+    }
 
-    if(diff.array().abs().sum()<0.0001){
+    if(diff<0.0001){
       ++cycles;
       break;
     }
@@ -322,94 +416,40 @@ SuperpositionResult MeanSquareMinimizerImpl::IterativeMinimize(int max_cycles, R
 
   }
   
-  res.rmsd_superposed_atoms = calc_rmsd_for_ematx(subset1, subset2, transformation_matrix);
-  res.fraction_superposed = float(subset1.rows())/atoms1_.rows();
+  res.rmsd_superposed_atoms = calc_rmsd_for_point_lists(subset1, subset2,
+                                                        transformation_matrix);
+  res.fraction_superposed = float(subset1.size())/atoms1_.size();
 
-  res.transformation = EigenMat4ToMat4(transformation_matrix);
+  res.transformation = transformation_matrix;
   res.ncycles=cycles;
 
   return res;
 
 }
 
-EMatX MeanSquareMinimizerImpl::TransformEMatX(const EMatX& mat, const EMat4& transformation) const {
-
-  EMatX transformed_mat = EMatX::Zero(mat.rows(), 3);
-
-  EMatX vector = EMatX::Zero(4,1);
-  EMatX transformed_vector = EMatX::Zero(4,1);
-  vector(3,0)=1;
-
-  for(int i=0;i<mat.rows();++i){
-    vector.block<3,1>(0,0)=mat.block<1,3>(i,0).transpose();
-    transformed_vector = transformation*vector;
-    transformed_mat.block<1,3>(i,0)=transformed_vector.block<3,1>(0,0).transpose();
-  }
-
-  return transformed_mat;
-}
-
 void MeanSquareMinimizerImpl::CreateMatchingSubsets(std::vector<int>& matching_subset, 
-                                                    const EMatX& atoms, const EMatX& atoms_ref, 
+                                                    const std::vector<geom::Vec3>& atoms,
+                                                    const geom::Mat4& transformation,
+                                                    const std::vector<geom::Vec3>& atoms_ref, 
                                                     Real distance_threshold) const{
 
 
   matching_subset.clear();
-  EMatX diff = EMatX::Zero(atoms.rows(),atoms.cols());
-  EMatX dist = EMatX::Zero(atoms.rows(),1);
-
-  diff = atoms-atoms_ref;
-  dist = (diff.array()*diff.array()).rowwise().sum(); 
-
   Real squared_dist_threshold = distance_threshold * distance_threshold;
   
-  for(int i=0; i<dist.rows(); ++i){
-    if(dist(i,0) <= squared_dist_threshold){
+  for(size_t i=0; i<atoms.size(); ++i){
+    geom::Vec3 transformed(transformation*geom::Vec4(atoms[i]));
+    if(geom::Length2(transformed-atoms_ref[i]) <= squared_dist_threshold){
       matching_subset.push_back(i);
     }
   }
 }
 
 
-SuperpositionResult MeanSquareMinimizerImpl::Minimize(const EMatX& atoms, const EMatX& atoms_ref) const {
-  ERVec3 avg = atoms.colwise().sum()/atoms.rows();
-  ERVec3 avg_ref = atoms_ref.colwise().sum()/atoms_ref.rows();
-
-  // SVD only determines the rotational component of the superposition
-  // we need to manually shift the centers of the two point sets on onto 
-  // origin
-
-  EMatX atoms_shifted = MatrixShiftedBy(atoms, avg);
-  EMatX atoms_ref_shifted = MatrixShiftedBy(atoms_ref, avg_ref).transpose();
-
-  // determine rotational component
-  Eigen::JacobiSVD<EMat3> svd(atoms_ref_shifted*atoms_shifted,Eigen::ComputeFullU | Eigen::ComputeFullV);
-  EMatX matrixVT=svd.matrixV().transpose();
-
-  //determine rotation
-  Real detv=matrixVT.determinant();
-  Real dett=svd.matrixU().determinant();
-  Real det=detv*dett;
-  EMat3 rotation;
-  if (det<0) {
-    EMat3 tmat=EMat3::Identity();
-    tmat(2,2)=-1;
-    rotation = (svd.matrixU()*tmat)*matrixVT;
-  } else {
-    rotation = svd.matrixU()*matrixVT;
-  }
-  
+SuperpositionResult MeanSquareMinimizerImpl::Minimize(const std::vector<geom::Vec3>& atoms,
+                                                      const std::vector<geom::Vec3>& atoms_ref) const {
   SuperpositionResult res;
-
-  geom::Vec3 shift = EigenVec3ToVec3(avg_ref);
-  geom::Vec3 com_vec = -EigenVec3ToVec3(avg);
-  geom::Mat3 rot = EigenMat3ToMat3(rotation);
-  geom::Mat4 mat4_com, mat4_rot, mat4_shift;
-  mat4_rot.PasteRotation(rot);
-  mat4_shift.PasteTranslation(shift);
-  mat4_com.PasteTranslation(com_vec);
-  //save whole transformation
-  res.transformation = geom::Mat4(mat4_shift*mat4_rot*mat4_com);
+  res.transformation=SuperposeQCP(&atoms[0], &atoms_ref[0], atoms.size());
   return res;
 }
 
@@ -53,8 +53,8 @@ struct DLLEXPORT_OST_MOL_ALG SuperpositionResult {
 };
 
 
-// the mean square minimizer is split into a private and a public class to avoid 
-// exposing the lib Eigen classes to the outside world
+// the mean square minimizer is split into a private and a public class to keep
+// the point storage out of the interface
 class MeanSquareMinimizerImpl;
 
 
@@ -82,6 +82,23 @@ protected:
   MeanSquareMinimizerImpl* impl_;
 };
 
+/// \brief optimal superposition of two point sets
+///
+/// Determines the rigid transformation minimizing the RMSD between points and
+/// points_ref with the quaternion characteristic polynomial (QCP) method. The
+/// covariance is accumulated in double precision and no memory is allocated,
+/// which makes the function suitable for superposing large numbers of small
+/// point sets, e.g. the frames of a trajectory. Degenerate input, for which
+/// the rotation is not uniquely determined, is handled by falling back to a
+/// singular value decomposition.
+///
+/// \param count number of points, must be at least 3
+/// \param rmsd if not NULL, receives the RMSD after superposition
+/// \returns the transformation superposing points onto points_ref
+geom::Mat4 DLLEXPORT_OST_MOL_ALG SuperposeQCP(const geom::Vec3* points,
+                                              const geom::Vec3* points_ref,
+                                              size_t count, Real* rmsd=NULL);
+
 /// \brief takes the corresponding atoms and superposes them
 SuperpositionResult DLLEXPORT_OST_MOL_ALG SuperposeAtoms(const mol::AtomViewList& atoms1,
                                                     const mol::AtomViewList& atoms2,
@@ -0,0 +1,374 @@
+//------------------------------------------------------------------------------
+// This file is part of the OpenStructure project <www.openstructure.org>
+//
+// Copyright (C) 2008-2020 by the OpenStructure authors
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 3.0 of the License, or (at your option)
+// any later version.
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//------------------------------------------------------------------------------
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+#include <ost/message.hh>
+#include <ost/mol/mol.hh>
+#include "trajectory_pipeline.hh"
+
+namespace ost { namespace mol { namespace alg {
+
+namespace {
+
+// the index and mass lists are mutable because the CoordFrame API takes them
+// by non-const reference, they are never modified.
+
+class AtomPosAnalyzer : public FrameAnalyzer {
+public:
+  AtomPosAnalyzer(const AtomHandle& a1): i1_(a1.GetIndex()) { }
+  virtual size_t GetValueCount() const { return 3; }
+  virtual void Analyze(const CoordFrame& frame, Real* values) const
+  {
+    geom::Vec3 pos=frame.GetAtomPos(i1_);
+    values[0]=pos[0];
+    values[1]=pos[1];
+    values[2]=pos[2];
+  }
+private:
+  int i1_;
+};
+
+class CenterOfMassPosAnalyzer : public FrameAnalyzer {
+public:
+  CenterOfMassPosAnalyzer(const EntityView& sele)
+  {
+    GetIndicesAndMasses(sele, indices_, masses_);
+  }
+  virtual size_t GetValueCount() const { return 3; }
+  virtual void Analyze(const CoordFrame& frame, Real* values) const
+  {
+    geom::Vec3 pos=frame.GetCenterOfMassPos(indices_, masses_);
+    values[0]=pos[0];
+    values[1]=pos[1];
+    values[2]=pos[2];
+  }
+private:
+  mutable std::vector<unsigned long> indices_;
+  mutable std::vector<Real>          masses_;
+};
+
+class DistanceBetwAtomsAnalyzer : public FrameAnalyzer {
+public:
+  DistanceBetwAtomsAnalyzer(const AtomHandle& a1, const AtomHandle& a2):
+    i1_(a1.GetIndex()), i2_(a2.GetIndex()) { }
+  virtual void Analyze(const CoordFrame& frame, Real* values) const
+  {
+    values[0]=frame.GetDistanceBetwAtoms(i1_, i2_);
+  }
+private:
+  int i1_, i2_;
+};
+
+class AngleAnalyzer : public FrameAnalyzer {
+public:
+  AngleAnalyzer(const AtomHandle& a1, const AtomHandle& a2,
+                const AtomHandle& a3):
+    i1_(a1.GetIndex()), i2_(a2.GetIndex()), i3_(a3.GetIndex()) { }
+  virtual void Analyze(const CoordFrame& frame, Real* values) const
+  {
+    values[0]=frame.GetAngle(i1_, i2_, i3_);
+  }
+private:
+  int i1_, i2_, i3_;
+};
+
+class DihedralAngleAnalyzer : public FrameAnalyzer {
+public:
+  DihedralAngleAnalyzer(const AtomHandle& a1, const AtomHandle& a2,
+                        const AtomHandle& a3, const AtomHandle& a4):
+    i1_(a1.GetIndex()), i2_(a2.GetIndex()), i3_(a3.GetIndex()),
+    i4_(a4.GetIndex()) { }
+  virtual void Analyze(const CoordFrame& frame, Real* values) const
+  {
+    values[0]=frame.GetDihedralAngle(i1_, i2_, i3_, i4_);
+  }
+private:
+  int i1_, i2_, i3_, i4_;
+};
+
+class DistanceBetwCenterOfMassAnalyzer : public FrameAnalyzer {
+public:
+  DistanceBetwCenterOfMassAnalyzer(const EntityView& sele1,
+                                   const EntityView& sele2)
+  {
+    GetIndicesAndMasses(sele1, indices1_, masses1_);
+    GetIndicesAndMasses(sele2, indices2_, masses2_);
+  }
+  virtual void Analyze(const CoordFrame& frame, Real* values) const
+  {
+    values[0]=frame.GetDistanceBetwCenterOfMass(indices1_, masses1_,
+                                                indices2_, masses2_);
+  }
+private:
+  mutable std::vector<unsigned long> indices1_, indices2_;
+  mutable std::vector<Real>          masses1_, masses2_;
+};
+
+class RMSDAnalyzer : public FrameAnalyzer {
+public:
+  RMSDAnalyzer(const EntityView& reference_view, const EntityView& sele_view)
+  {
+    if (reference_view.GetAtomCount()!=sele_view.GetAtomCount()) {
+      throw Error("atom counts of the two views are not equal");
+    }
+    GetIndices(sele_view, indices_);
+    GetPositions(reference_view, ref_pos_);
+  }
+  virtual void Analyze(const CoordFrame& frame, Real* values) const
+  {
+    values[0]=frame.GetRMSD(ref_pos_, indices_);
+  }
+private:
+  std::vector<unsigned long> indices_;
+  std::vector<geom::Vec3>    ref_pos_;
+};
+
+class MinDistanceAnalyzer : public FrameAnalyzer {
+public:
+  MinDistanceAnalyzer(const EntityView& view1, const EntityView& view2)
+  {
+    if (!view1.HasAtoms()){
+      throw Error("first EntityView is empty");
+    }
+    if (!view2.HasAtoms()){
+      throw Error("second EntityView is empty");
+    }
+    GetIndices(view1, indices1_);
+    GetIndices(view2, indices2_);
+  }
+  virtual void Analyze(const CoordFrame& frame, Real* values) const
+  {
+    values[0]=frame.GetMinDistance(indices1_, indices2_);
+  }
+private:
+  mutable std::vector<unsigned long> indices1_, indices2_;
+};
+
+class MinDistanceBetwCenterOfMassAndViewAnalyzer : public FrameAnalyzer {
+public:
+  MinDistanceBetwCenterOfMassAndViewAnalyzer(const EntityView& view_cm,
+                                             const EntityView& view_atoms)
+  {
+    if (!view_cm.HasAtoms()){
+      throw Error("first EntityView is empty");
+    }
+    if (!view_atoms.HasAtoms()){
+      throw Error("second EntityView is empty");
+    }
+    GetIndicesAndMasses(view_cm, indices_cm_, masses_cm_);
+    GetIndices(view_atoms, indices_atoms_);
+  }
+  virtual void Analyze(const CoordFrame& frame, Real* values) const
+  {
+    values[0]=frame.GetMinDistBetwCenterOfMassAndView(indices_cm_, masses_cm_,
+                                                      indices_atoms_);
+  }
+private:
+  mutable std::vector<unsigned long> indices_cm_, indices_atoms_;
+  mutable std::vector<Real>          masses_cm_;
+};
+
+}
+
+TrajectoryPipeline::TrajectoryPipeline(const CoordGroupHandle& traj,
+                                       unsigned int stride, int num_threads,
+                                       unsigned int batch_size):
+  traj_(traj), stride_(std::max(stride, 1u)),
+  num_threads_(std::max(num_threads, 1)),
+  batch_size_(std::max(batch_size, 1u))
+{
+  CheckHandleValidity(traj_);
+}
+
+size_t TrajectoryPipeline::AddAnalyzer(FrameAnalyzerPtr analyzer)
+{
+  analyzers_.push_back(analyzer);
+  results_.push_back(std::vector<Real>());
+  return analyzers_.size()-1;
+}
+
+size_t TrajectoryPipeline::AddAtomPos(const AtomHandle& a1)
+{
+  return this->AddAnalyzer(FrameAnalyzerPtr(new AtomPosAnalyzer(a1)));
+}
+
+size_t TrajectoryPipeline::AddCenterOfMassPos(const EntityView& sele)
+{
+  return this->AddAnalyzer(FrameAnalyzerPtr(new CenterOfMassPosAnalyzer(sele)));
+}
+
+size_t TrajectoryPipeline::AddDistanceBetwAtoms(const AtomHandle& a1,
+                                                const AtomHandle& a2)
+{
+  return this->AddAnalyzer(FrameAnalyzerPtr(new DistanceBetwAtomsAnalyzer(a1,
+                                                                          a2)));
+}
+
+size_t TrajectoryPipeline::AddAngle(const AtomHandle& a1, const AtomHandle& a2,
+                                    const AtomHandle& a3)
+{
+  return this->AddAnalyzer(FrameAnalyzerPtr(new AngleAnalyzer(a1, a2, a3)));
+}
+
+size_t TrajectoryPipeline::AddDihedralAngle(const AtomHandle& a1,
+                                            const AtomHandle& a2,
+                                            const AtomHandle& a3,
+                                            const AtomHandle& a4)
+{
+  return this->AddAnalyzer(FrameAnalyzerPtr(new DihedralAngleAnalyzer(a1, a2,
+                                                                      a3, a4)));
+}
+
+size_t TrajectoryPipeline::AddDistanceBetwCenterOfMass(const EntityView& sele1,
+                                                       const EntityView& sele2)
+{
+  FrameAnalyzerPtr analyzer(new DistanceBetwCenterOfMassAnalyzer(sele1, sele2));
+  return this->AddAnalyzer(analyzer);
+}
+
+size_t TrajectoryPipeline::AddRMSD(const EntityView& reference_view,
+                                   const EntityView& sele_view)
+{
+  return this->AddAnalyzer(FrameAnalyzerPtr(new RMSDAnalyzer(reference_view,
+                                                             sele_view)));
+}
+
+size_t TrajectoryPipeline::AddMinDistance(const EntityView& view1,
+                                          const EntityView& view2)
+{
+  return this->AddAnalyzer(FrameAnalyzerPtr(new MinDistanceAnalyzer(view1,
+                                                                    view2)));
+}
+
+size_t TrajectoryPipeline::AddMinDistanceBetwCenterOfMassAndView(const EntityView& view_cm,
+                                                                 const EntityView& view_atoms)
+{
+  FrameAnalyzerPtr analyzer(new MinDistanceBetwCenterOfMassAndViewAnalyzer(view_cm,
+                                                                           view_atoms));
+  return this->AddAnalyzer(analyzer);
+}
+
+size_t TrajectoryPipeline::GetFrameCount() const
+{
+  return (traj_.GetFrameCount()+stride_-1)/stride_;
+}
+
+const std::vector<Real>& TrajectoryPipeline::GetResult(size_t analyzer) const
+{
+  if (analyzer>=results_.size()) {
+    throw Error("invalid analyzer index");
+  }
+  return results_[analyzer];
+}
+
+geom::Vec3List TrajectoryPipeline::GetVec3Result(size_t analyzer) const
+{
+  const std::vector<Real>& values=this->GetResult(analyzer);
+  if (analyzers_[analyzer]->GetValueCount()!=3) {
+    throw Error("analyzer does not calculate vectors");
+  }
+  geom::Vec3List result(values.size()/3);
+  for (size_t i=0; i<result.size(); ++i) {
+    result[i]=geom::Vec3(values[3*i], values[3*i+1], values[3*i+2]);
+  }
+  return result;
+}
+
+void TrajectoryPipeline::LoadFrames(std::vector<CoordFrame>& frames,
+                                    size_t first, size_t count)
+{
+  // the frames are copied, since lazily loaded coord sources reuse the same
+  // frame for every call to GetFrame.
+  frames.resize(count);
+  for (size_t i=0; i<count; ++i) {
+    frames[i]=*traj_.GetFrame((first+i)*stride_);
+  }
+}
+
+void TrajectoryPipeline::AnalyzeFrames(const std::vector<CoordFrame>* frames,
+                                       size_t first, size_t begin, size_t end,
+                                       String* error)
+{
+  try {
+    for (size_t i=begin; i<end; ++i) {
+      for (size_t j=0; j<analyzers_.size(); ++j) {
+        size_t n=analyzers_[j]->GetValueCount();
+        analyzers_[j]->Analyze((*frames)[i], &results_[j][(first+i)*n]);
+      }
+    }
+  } catch (std::exception& e) {
+    *error=e.what();
+  }
+}
+
+void TrajectoryPipeline::Run()
+{
+  size_t frame_count=this->GetFrameCount();
+  for (size_t j=0; j<analyzers_.size(); ++j) {
+    results_[j].assign(frame_count*analyzers_[j]->GetValueCount(), 0.0);
+  }
+  if (analyzers_.empty() || frame_count==0) {
+    return;
+  }
+  // double buffering: while the threads analyze one batch, the next batch is
+  // read from the coord source.
+  std::vector<CoordFrame> batches[2];
+  std::vector<String> errors(num_threads_);
+  this->LoadFrames(batches[0], 0, std::min(size_t(batch_size_), frame_count));
+  for (size_t first=0, b=0; first<frame_count; first+=batch_size_, ++b) {
+    const std::vector<CoordFrame>* batch=&batches[b%2];
+    size_t next=first+batch_size_;
+    if (num_threads_==1) {
+      this->AnalyzeFrames(batch, first, 0, batch->size(), &errors[0]);
+      if (next<frame_count) {
+        this->LoadFrames(batches[(b+1)%2], next,
+                         std::min(size_t(batch_size_), frame_count-next));
+      }
+    } else {
+      size_t chunk_size=(batch->size()+num_threads_-1)/num_threads_;
+      boost::thread_group tg;
+      for (int i=0; i<num_threads_; ++i) {
+        size_t begin=std::min(batch->size(), i*chunk_size);
+        size_t end=std::min(batch->size(), (i+1)*chunk_size);
+        if (begin==end) {
+          continue;
+        }
+        tg.create_thread(boost::bind(&TrajectoryPipeline::AnalyzeFrames, this,
+                                     batch, first, begin, end, &errors[i]));
+      }
+      try {
+        if (next<frame_count) {
+          this->LoadFrames(batches[(b+1)%2], next,
+                           std::min(size_t(batch_size_), frame_count-next));
+        }
+      } catch (...) {
+        tg.join_all();
+        throw;
+      }
+      tg.join_all();
+    }
+    for (int i=0; i<num_threads_; ++i) {
+      if (!errors[i].empty()) {
+        throw Error(errors[i]);
+      }
+    }
+  }
+}
+
+}}} // ns
@@ -0,0 +1,115 @@
+//------------------------------------------------------------------------------
+// This file is part of the OpenStructure project <www.openstructure.org>
+//
+// Copyright (C) 2008-2020 by the OpenStructure authors
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 3.0 of the License, or (at your option)
+// any later version.
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//------------------------------------------------------------------------------
+#ifndef OST_MOL_ALG_TRAJECTORY_PIPELINE_HH
+#define OST_MOL_ALG_TRAJECTORY_PIPELINE_HH
+
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include <ost/mol/alg/module_config.hh>
+#include <ost/geom/geom.hh>
+#include <ost/mol/entity_view.hh>
+#include <ost/mol/coord_group.hh>
+
+namespace ost { namespace mol { namespace alg {
+
+/// \brief observable calculated for each frame of a trajectory
+///
+/// Analyze is called concurrently for different frames and must not modify
+/// the state of the analyzer.
+class DLLEXPORT_OST_MOL_ALG FrameAnalyzer {
+public:
+  virtual ~FrameAnalyzer() { }
+
+  /// \brief number of values calculated per frame
+  virtual size_t GetValueCount() const { return 1; }
+
+  /// \brief calculate the observable for frame and write GetValueCount()
+  ///     values to values
+  virtual void Analyze(const CoordFrame& frame, Real* values) const = 0;
+};
+
+typedef boost::shared_ptr<FrameAnalyzer> FrameAnalyzerPtr;
+
+/// \brief calculates several observables in one pass over a trajectory
+///
+/// The analyzers are registered with the Add methods, which return the index
+/// of the analyzer. Run() then reads the frames in batches and distributes the
+/// frames of a batch over num_threads threads, while the next batch is read.
+/// The trajectory is traversed once, independent of the number of analyzers,
+/// which is particularly useful for lazily loaded trajectories. The results
+/// are stored in frame order.
+class DLLEXPORT_OST_MOL_ALG TrajectoryPipeline {
+public:
+  TrajectoryPipeline(const CoordGroupHandle& traj, unsigned int stride=1,
+                     int num_threads=1, unsigned int batch_size=64);
+
+  size_t AddAnalyzer(FrameAnalyzerPtr analyzer);
+
+  /// \brief see AnalyzeAtomPos
+  size_t AddAtomPos(const AtomHandle& a1);
+  /// \brief see AnalyzeCenterOfMassPos
+  size_t AddCenterOfMassPos(const EntityView& sele);
+  /// \brief see AnalyzeDistanceBetwAtoms
+  size_t AddDistanceBetwAtoms(const AtomHandle& a1, const AtomHandle& a2);
+  /// \brief see AnalyzeAngle
+  size_t AddAngle(const AtomHandle& a1, const AtomHandle& a2,
+                  const AtomHandle& a3);
+  /// \brief see AnalyzeDihedralAngle
+  size_t AddDihedralAngle(const AtomHandle& a1, const AtomHandle& a2,
+                          const AtomHandle& a3, const AtomHandle& a4);
+  /// \brief see AnalyzeDistanceBetwCenterOfMass
+  size_t AddDistanceBetwCenterOfMass(const EntityView& sele1,
+                                     const EntityView& sele2);
+  /// \brief see AnalyzeRMSD
+  size_t AddRMSD(const EntityView& reference_view, const EntityView& sele_view);
+  /// \brief see AnalyzeMinDistance
+  size_t AddMinDistance(const EntityView& view1, const EntityView& view2);
+  /// \brief see AnalyzeMinDistanceBetwCenterOfMassAndView
+  size_t AddMinDistanceBetwCenterOfMassAndView(const EntityView& view_cm,
+                                               const EntityView& view_atoms);
+
+  /// \brief run all registered analyzers over the trajectory
+  void Run();
+
+  /// \brief number of analyzed frames
+  size_t GetFrameCount() const;
+
+  /// \brief values of the given analyzer, GetValueCount() values per frame
+  const std::vector<Real>& GetResult(size_t analyzer) const;
+
+  /// \brief values of an analyzer with 3 values per frame as list of vectors
+  geom::Vec3List GetVec3Result(size_t analyzer) const;
+
+private:
+  void AnalyzeFrames(const std::vector<CoordFrame>* frames, size_t first,
+                     size_t begin, size_t end, String* error);
+
+  void LoadFrames(std::vector<CoordFrame>& frames, size_t first, size_t count);
+
+  CoordGroupHandle               traj_;
+  unsigned int                   stride_;
+  int                            num_threads_;
+  unsigned int                   batch_size_;
+  std::vector<FrameAnalyzerPtr>  analyzers_;
+  std::vector<std::vector<Real> > results_;
+};
+
+}}} // ns
+
+#endif
@@ -0,0 +1,138 @@
+//------------------------------------------------------------------------------
+// This file is part of the OpenStructure project <www.openstructure.org>
+//
+// Copyright (C) 2008-2020 by the OpenStructure authors
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 3.0 of the License, or (at your option)
+// any later version.
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//------------------------------------------------------------------------------
+/*
+  Compares the density simulation modes of EntityToDensityScattering and
+  EntityToDensityRosetta for accuracy and speed.
+
+  usage: bench_entity_to_density [pdb_file] [sampling] [falloff_end]
+                                 [max_threads]
+
+  The map covers the structure with 5 Angstrom padding. The density obtained
+  by gridding is compared to the direct summation, and the Rosetta densities
+  computed with more than one thread to the single-threaded density. The
+  direct summation scales with the number of atoms times the number of
+  voxels, so it is only feasible for small structures.
+*/
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdlib>
+#include <ost/mol/mol.hh>
+#include <ost/img/image.hh>
+#include <ost/io/mol/pdb_reader.hh>
+#include <ost/mol/alg/entity_to_density.hh>
+
+using namespace ost;
+using namespace ost::mol;
+using namespace ost::mol::alg;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double seconds_since(const Clock::time_point& start)
+{
+  return std::chrono::duration<double>(Clock::now()-start).count();
+}
+
+EntityHandle load_structure(const String& filepath)
+{
+  io::PDBReader reader(filepath, io::IOProfile());
+  EntityHandle ent=CreateEntity();
+  reader.Import(ent);
+  return ent;
+}
+
+img::MapHandle create_map(const EntityView& ent, Real sampling)
+{
+  geom::AlignedCuboid bounds=ent.GetBounds();
+  geom::Vec3 start=bounds.GetMin()-geom::Vec3(5.0, 5.0, 5.0);
+  geom::Vec3 size=bounds.GetSize()+geom::Vec3(10.0, 10.0, 10.0);
+  img::Size map_size(ceil(size[0]/sampling), ceil(size[1]/sampling),
+                     ceil(size[2]/sampling));
+  img::MapHandle map=img::CreateImage(img::Extent(img::Point(0, 0, 0),
+                                                  map_size));
+  map.SetSpatialSampling(sampling);
+  map.SetAbsoluteOrigin(start);
+  return map;
+}
+
+// maximum difference relative to the maximum absolute value of the reference
+Real max_rel_diff(const img::MapHandle& ref, const img::MapHandle& map)
+{
+  Real max_value=0.0, max_diff=0.0;
+  for (img::ExtentIterator i(ref.GetExtent()); !i.AtEnd(); ++i) {
+    max_value=std::max(max_value, std::abs(ref.GetReal(i)));
+    max_diff=std::max(max_diff, std::abs(ref.GetReal(i)-map.GetReal(i)));
+  }
+  return max_value>0.0 ? max_diff/max_value : max_diff;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  String filepath=argc>1 ? argv[1] : "testfiles/1aho.pdb";
+  Real sampling=argc>2 ? atof(argv[2]) : 1.0;
+  Real falloff_end=argc>3 ? atof(argv[3]) : 3.0;
+  int max_threads=argc>4 ? atoi(argv[4]) : 8;
+  EntityView ent=load_structure(filepath).CreateFullView();
+  img::MapHandle ref=create_map(ent, sampling);
+  std::cout << filepath << ": " << ent.GetAtomCount() << " atoms, map of "
+            << ref.GetSize() << " voxels, times in seconds" << std::endl;
+
+  Clock::time_point start=Clock::now();
+  EntityToDensityScattering(ent, ref, 10.0, falloff_end, true);
+  double t_direct=seconds_since(start);
+  std::cout << std::setw(24) << "scattering, direct" << std::setw(12)
+            << t_direct << std::endl;
+  for (int num_threads=1; num_threads<=max_threads; num_threads*=2) {
+    img::MapHandle map=create_map(ent, sampling);
+    start=Clock::now();
+    EntityToDensityScattering(ent, map, 10.0, falloff_end, true, 1.5418, true,
+                              num_threads);
+    double t_gridding=seconds_since(start);
+    Real diff=max_rel_diff(ref, map);
+    std::cout << std::setw(20) << "gridding, threads " << std::setw(4)
+              << num_threads << std::setw(12) << t_gridding
+              << "  max. rel. difference " << diff << std::endl;
+    if (diff>1e-3) {
+      std::cerr << "ERROR: gridding deviates from direct summation" << std::endl;
+      return 1;
+    }
+  }
+
+  img::MapHandle rosetta_ref;
+  for (int num_threads=1; num_threads<=max_threads; num_threads*=2) {
+    img::MapHandle map=create_map(ent, sampling);
+    start=Clock::now();
+    EntityToDensityRosetta(ent, map, HIGH_RESOLUTION, falloff_end, true,
+                           1.5418, num_threads);
+    double t_rosetta=seconds_since(start);
+    std::cout << std::setw(20) << "rosetta, threads " << std::setw(4)
+              << num_threads << std::setw(12) << t_rosetta << std::endl;
+    if (!rosetta_ref.IsValid()) {
+      rosetta_ref=map;
+    } else if (max_rel_diff(rosetta_ref, map)!=0.0) {
+      std::cerr << "ERROR: result depends on the number of threads" << std::endl;
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,131 @@
+//------------------------------------------------------------------------------
+// This file is part of the OpenStructure project <www.openstructure.org>
+//
+// Copyright (C) 2008-2020 by the OpenStructure authors
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 3.0 of the License, or (at your option)
+// any later version.
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//------------------------------------------------------------------------------
+
+
+/*
+  Measures how the lDDT calculation scales with the number of threads.
+
+  usage: bench_lddt [pdb_file] [max_threads]
+
+  The model is the reference with randomly displaced atoms. For every number of
+  threads, the distance list is built and the model is scored with
+  LocalDistDiffTest and CompiledRDList::Evaluate. The scores must not depend on
+  the number of threads.
+*/
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdlib>
+#include <boost/random.hpp>
+#include <ost/mol/mol.hh>
+#include <ost/io/mol/pdb_reader.hh>
+#include <ost/mol/alg/local_dist_diff_test.hh>
+
+using namespace ost;
+using namespace ost::mol;
+using namespace ost::mol::alg;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double seconds_since(const Clock::time_point& start)
+{
+  return std::chrono::duration<double>(Clock::now()-start).count();
+}
+
+EntityHandle load_structure(const String& filepath)
+{
+  io::PDBReader reader(filepath, io::IOProfile());
+  EntityHandle ent=CreateEntity();
+  reader.Import(ent);
+  return ent;
+}
+
+EntityHandle create_model(const String& filepath)
+{
+  EntityHandle mdl=load_structure(filepath);
+  boost::mt19937 rng(42);
+  boost::uniform_real<Real> dist(-1.5, 1.5);
+  boost::variate_generator<boost::mt19937&, boost::uniform_real<Real> > gen(rng, dist);
+  XCSEditor edi=mdl.EditXCS(BUFFERED_EDIT);
+  AtomHandleList atoms=mdl.GetAtomList();
+  for (AtomHandleList::iterator i=atoms.begin(); i!=atoms.end(); ++i) {
+    Real x=gen();
+    Real y=gen();
+    Real z=gen();
+    edi.SetAtomPos(*i, i->GetPos()+geom::Vec3(x, y, z));
+  }
+  return mdl;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  String filepath=argc>1 ? argv[1] : "testfiles/1aho.pdb";
+  int max_threads=argc>2 ? atoi(argv[2]) : 8;
+  EntityView ref=load_structure(filepath).CreateFullView();
+  std::vector<Real> cutoffs;
+  cutoffs.push_back(0.5);
+  cutoffs.push_back(1.0);
+  cutoffs.push_back(2.0);
+  cutoffs.push_back(4.0);
+  std::cout << filepath << ": " << ref.GetAtomCount() << " atoms, "
+            << "times in seconds" << std::endl;
+  std::cout << std::setw(8) << "threads" << std::setw(14) << "dist. list"
+            << std::setw(14) << "lDDT" << std::setw(14) << "compile"
+            << std::setw(14) << "evaluate" << std::setw(12) << "conserved"
+            << std::setw(12) << "total" << std::endl;
+  std::pair<long int, long int> expected(-1, -1);
+  for (int num_threads=1; num_threads<=max_threads; num_threads*=2) {
+    Clock::time_point start=Clock::now();
+    GlobalRDMap glob_dist_list=CreateDistanceList(ref, 15.0, num_threads);
+    double t_list=seconds_since(start);
+
+    EntityView mdl=create_model(filepath).CreateFullView();
+    start=Clock::now();
+    std::pair<long int, long int> ov=LocalDistDiffTest(mdl, glob_dist_list, 
+                                                        cutoffs, 0, "lddt",
+                                                        num_threads);
+    double t_lddt=seconds_since(start);
+
+    EntityView mdl2=create_model(filepath).CreateFullView();
+    start=Clock::now();
+    CompiledRDList compiled(glob_dist_list, mdl2, 0, num_threads);
+    double t_compile=seconds_since(start);
+    geom::Vec3List positions=compiled.GetPositions();
+    start=Clock::now();
+    std::pair<long int, long int> ov2=compiled.Evaluate(positions, cutoffs, 
+                                                        num_threads);
+    double t_eval=seconds_since(start);
+    std::cout << std::setw(8) << num_threads << std::setw(14) << t_list
+              << std::setw(14) << t_lddt << std::setw(14) << t_compile
+              << std::setw(14) << t_eval << std::setw(12) << ov.first
+              << std::setw(12) << ov.second << std::endl;
+    if (expected.first<0) {
+      expected=ov;
+    }
+    if (ov!=expected || ov2!=expected) {
+      std::cerr << "ERROR: result depends on the number of threads" << std::endl;
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,148 @@
+//------------------------------------------------------------------------------
+// This file is part of the OpenStructure project <www.openstructure.org>
+//
+// Copyright (C) 2008-2020 by the OpenStructure authors
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 3.0 of the License, or (at your option)
+// any later version.
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//------------------------------------------------------------------------------
+
+#define BOOST_TEST_DYN_LINK
+#include <cstdlib>
+#include <boost/test/unit_test.hpp>
+#include <ost/platform.hh>
+#include <ost/mol/mol.hh>
+#include <ost/img/image.hh>
+#include <ost/io/mol/pdb_reader.hh>
+#include <ost/mol/alg/entity_to_density.hh>
+
+using namespace ost;
+using namespace ost::mol;
+using namespace ost::mol::alg;
+
+namespace {
+
+// the atom scattering properties are read from the shared data path
+bool set_prefix_path()
+{
+  char* ost_root=getenv("OST_ROOT");
+  if (!ost_root) {
+    std::cout << "WARNING: skipping entity to density unit test. OST_ROOT "
+              << "is required to find the atom scattering properties"
+              << std::endl;
+    return false;
+  }
+  SetPrefixPath(ost_root);
+  return true;
+}
+
+// the first residues of 1aho, which keeps the direct summation fast
+EntityView load_structure()
+{
+  io::PDBReader reader("testfiles/1aho.pdb", io::IOProfile());
+  EntityHandle ent=CreateEntity();
+  reader.Import(ent);
+  ResidueHandleList residues=ent.GetResidueList();
+  for (ResidueHandleList::iterator i=residues.begin(); i!=residues.end(); ++i) {
+    i->SetChemClass(ChemClass(ChemClass::L_PEPTIDE_LINKING));
+  }
+  return ent.Select("rnum<=6");
+}
+
+// map covering the structure with 4 Angstrom padding
+img::MapHandle create_map(const EntityView& ent, Real sampling)
+{
+  geom::AlignedCuboid bounds=ent.GetBounds();
+  geom::Vec3 start=bounds.GetMin()-geom::Vec3(4.0, 4.0, 4.0);
+  geom::Vec3 size=bounds.GetSize()+geom::Vec3(8.0, 8.0, 8.0);
+  img::Size map_size(ceil(size[0]/sampling), ceil(size[1]/sampling),
+                     ceil(size[2]/sampling));
+  img::MapHandle map=img::CreateImage(img::Extent(img::Point(0, 0, 0),
+                                                  map_size));
+  map.SetSpatialSampling(sampling);
+  map.SetAbsoluteOrigin(start);
+  return map;
+}
+
+Real max_abs_value(const img::MapHandle& map)
+{
+  Real max_value=0.0;
+  for (img::ExtentIterator i(map.GetExtent()); !i.AtEnd(); ++i) {
+    max_value=std::max(max_value, std::abs(map.GetReal(i)));
+  }
+  return max_value;
+}
+
+Real max_abs_diff(const img::MapHandle& a, const img::MapHandle& b)
+{
+  Real max_diff=0.0;
+  for (img::ExtentIterator i(a.GetExtent()); !i.AtEnd(); ++i) {
+    max_diff=std::max(max_diff, std::abs(a.GetReal(i)-b.GetReal(i)));
+  }
+  return max_diff;
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE( mol_alg );
+
+BOOST_AUTO_TEST_CASE(entity_to_density_gridding)
+{
+  if (!set_prefix_path()) {
+    return;
+  }
+  EntityView ent=load_structure();
+  BOOST_REQUIRE(ent.GetAtomCount()>20);
+  img::MapHandle direct=create_map(ent, 1.0);
+  EntityToDensityScattering(ent, direct, 10.0, 3.0, true);
+  Real max_value=max_abs_value(direct);
+  BOOST_CHECK(max_value>0.0);
+  img::MapHandle single;
+  for (int num_threads=1; num_threads<=3; ++num_threads) {
+    img::MapHandle map=create_map(ent, 1.0);
+    EntityToDensityScattering(ent, map, 10.0, 3.0, true, 1.5418, true,
+                              num_threads);
+    BOOST_CHECK_SMALL(max_abs_diff(direct, map)/max_value, Real(1e-4));
+    if (num_threads==1) {
+      single=map;
+    } else {
+      BOOST_CHECK_EQUAL(max_abs_diff(single, map), Real(0.0));
+    }
+  }
+  // the map is only cleared on request
+  img::MapHandle map=direct.Copy();
+  EntityToDensityScattering(ent, map, 10.0, 3.0, false, 1.5418, true);
+  BOOST_CHECK_SMALL(max_abs_diff(map, direct)/max_value-Real(1.0), Real(1e-4));
+}
+
+BOOST_AUTO_TEST_CASE(entity_to_density_rosetta_threads)
+{
+  if (!set_prefix_path()) {
+    return;
+  }
+  EntityView ent=load_structure();
+  DensityType types[]={HIGH_RESOLUTION, LOW_RESOLUTION};
+  for (int t=0; t<2; ++t) {
+    img::MapHandle single=create_map(ent, 0.8);
+    EntityToDensityRosetta(ent, single, types[t], 3.0, true, 1.5418, 1);
+    BOOST_CHECK(max_abs_value(single)>0.0);
+    for (int num_threads=2; num_threads<=4; ++num_threads) {
+      img::MapHandle map=create_map(ent, 0.8);
+      EntityToDensityRosetta(ent, map, types[t], 3.0, true, 1.5418,
+                             num_threads);
+      BOOST_CHECK_EQUAL(max_abs_diff(single, map), Real(0.0));
+    }
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END();
@@ -0,0 +1,460 @@
+//------------------------------------------------------------------------------
+// This file is part of the OpenStructure project <www.openstructure.org>
+//
+// Copyright (C) 2008-2020 by the OpenStructure authors
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 3.0 of the License, or (at your option)
+// any later version.
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//------------------------------------------------------------------------------
+
+#define BOOST_TEST_DYN_LINK
+#include <fstream>
+#include <algorithm>
+#include <boost/test/unit_test.hpp>
+#include <boost/random.hpp>
+#include <ost/units.hh>
+#include <ost/mol/mol.hh>
+#include <ost/conop/heuristic.hh>
+#include <ost/io/mol/pdb_reader.hh>
+#include <ost/mol/alg/filter_clashes.hh>
+
+using namespace ost;
+using namespace ost::mol;
+using namespace ost::mol::alg;
+
+namespace {
+
+std::vector<String> load_parameter_file()
+{
+  std::ifstream in("../src/stereo_chemical_props.txt");
+  BOOST_REQUIRE(in);
+  std::vector<String> lines;
+  String line;
+  while (std::getline(in, line)) {
+    lines.push_back(line);
+  }
+  return lines;
+}
+
+EntityHandle load_structure(const String& filename)
+{
+  io::PDBReader reader("testfiles/"+filename, io::IOProfile());
+  EntityHandle ent=CreateEntity();
+  reader.Import(ent);
+  conop::HeuristicProcessor heu_proc;
+  heu_proc.Process(ent);
+  return ent;
+}
+
+// copy of ent with randomly displaced atoms
+EntityHandle displace_atoms(const EntityHandle& ent, Real max_shift,
+                            unsigned int seed)
+{
+  EntityHandle copy=ent.Copy();
+  boost::mt19937 rng(seed);
+  boost::uniform_real<Real> dist(-max_shift, max_shift);
+  boost::variate_generator<boost::mt19937&, boost::uniform_real<Real> > gen(rng, dist);
+  XCSEditor edi=copy.EditXCS(BUFFERED_EDIT);
+  AtomHandleList atoms=copy.GetAtomList();
+  for (AtomHandleList::iterator i=atoms.begin(); i!=atoms.end(); ++i) {
+    Real x=gen();
+    Real y=gen();
+    Real z=gen();
+    edi.SetAtomPos(*i, i->GetPos()+geom::Vec3(x, y, z));
+  }
+  return copy;
+}
+
+bool is_hydrogen(const String& ele)
+{
+  return ele=="H" || ele=="D";
+}
+
+bool is_backbone(const String& name)
+{
+  return name=="CA" || name=="N" || name=="O" || name=="C";
+}
+
+String sorted_key(const String& a, const String& b, const String& mid="")
+{
+  String first=std::min(a, b), second=std::max(a, b);
+  return mid.empty() ? first+"-"+second : first+"-"+mid+"-"+second;
+}
+
+std::vector<String> atom_names(const EntityView& view)
+{
+  std::vector<String> names;
+  AtomViewList atoms=view.GetAtomList();
+  for (AtomViewList::const_iterator i=atoms.begin(); i!=atoms.end(); ++i) {
+    names.push_back(i->GetQualifiedName());
+  }
+  std::sort(names.begin(), names.end());
+  return names;
+}
+
+void keep_atoms(const ResidueView& res, bool remove_sc, bool remove_bb,
+                std::vector<String>& kept)
+{
+  if (remove_bb) {
+    return;
+  }
+  AtomViewList atoms=res.GetAtomList();
+  for (AtomViewList::const_iterator i=atoms.begin(); i!=atoms.end(); ++i) {
+    if (!remove_sc || is_backbone(i->GetName())) {
+      kept.push_back(i->GetQualifiedName());
+    }
+  }
+}
+
+struct Checked {
+  Checked(): bad_count(0) { }
+  std::vector<String> kept;
+  std::vector<Real> bond_zscores;
+  std::vector<Real> angle_zscores;
+  int bad_count;
+};
+
+// stereo-chemistry check with the parameters looked up by their string keys
+Checked check_stereo_chemistry(const EntityView& ent,
+                               const StereoChemicalParams& bond_table,
+                               const StereoChemicalParams& angle_table,
+                               Real tolerance)
+{
+  Checked checked;
+  ResidueViewList residues=ent.GetResidueList();
+  for (ResidueViewList::iterator i=residues.begin(); i!=residues.end(); ++i) {
+    bool remove_sc=false, remove_bb=false;
+    if (i->GetOneLetterCode()=='?') {
+      keep_atoms(*i, false, false, checked.kept);
+      continue;
+    }
+    AtomViewList atoms=i->GetAtomList();
+    for (AtomViewList::const_iterator j=atoms.begin(); j!=atoms.end(); ++j) {
+      if (is_hydrogen(j->GetElement())) {
+        continue;
+      }
+      AtomHandle atom=j->GetHandle();
+      AtomHandleList partners;
+      BondHandleList bonds=j->GetBondList();
+      for (BondHandleList::const_iterator b=bonds.begin(); b!=bonds.end(); ++b) {
+        AtomHandle other=b->GetOther(atom);
+        if (other.GetResidue()==atom.GetResidue() &&
+            !is_hydrogen(other.GetElement())) {
+          partners.push_back(other);
+        }
+      }
+      for (AtomHandleList::const_iterator p=partners.begin(); p!=partners.end(); ++p) {
+        if (p->GetHashCode()<=atom.GetHashCode()) {
+          continue;
+        }
+        std::pair<Real,Real> ref=bond_table.GetParam(sorted_key(j->GetName(),
+                                                                p->GetName()),
+                                                     i->GetName());
+        Real zscore=(geom::Distance(atom.GetPos(), p->GetPos())-ref.first)/
+                    ref.second;
+        checked.bond_zscores.push_back(zscore);
+        if (std::abs(zscore)>tolerance) {
+          ++checked.bad_count;
+          remove_sc=true;
+          remove_bb|=is_backbone(j->GetName()) || is_backbone(p->GetName());
+        }
+      }
+      for (AtomHandleList::const_iterator p1=partners.begin(); p1!=partners.end(); ++p1) {
+        for (AtomHandleList::const_iterator p2=partners.begin(); p2!=partners.end(); ++p2) {
+          if (p1->GetHashCode()<=p2->GetHashCode()) {
+            continue;
+          }
+          String key=sorted_key(p1->GetName(), p2->GetName(), j->GetName());
+          std::pair<Real,Real> ref=angle_table.GetParam(key, i->GetName());
+          Real width=geom::Angle(p1->GetPos()-atom.GetPos(),
+                                 p2->GetPos()-atom.GetPos())/Units::deg;
+          Real zscore=(width-ref.first)/ref.second;
+          checked.angle_zscores.push_back(zscore);
+          if (std::abs(zscore)>tolerance) {
+            ++checked.bad_count;
+            remove_sc=true;
+            remove_bb|=is_backbone(j->GetName());
+          }
+        }
+      }
+    }
+    keep_atoms(*i, remove_sc, remove_bb, checked.kept);
+  }
+  std::sort(checked.kept.begin(), checked.kept.end());
+  return checked;
+}
+
+// clash filter comparing all pairs of atoms, with the clashing distances
+// looked up by the element names
+Checked filter_clashes(const EntityView& ent, const ClashingDistances& distances)
+{
+  Checked checked;
+  Real max_distance=distances.GetMaxAdjustedDistance();
+  AtomViewList all_atoms=ent.GetAtomList();
+  ResidueViewList residues=ent.GetResidueList();
+  for (ResidueViewList::iterator i=residues.begin(); i!=residues.end(); ++i) {
+    bool remove_sc=false, remove_bb=false;
+    if (i->GetOneLetterCode()=='?') {
+      keep_atoms(*i, false, false, checked.kept);
+      continue;
+    }
+    AtomViewList atoms=i->GetAtomList();
+    for (AtomViewList::const_iterator j=atoms.begin(); j!=atoms.end(); ++j) {
+      if (is_hydrogen(j->GetElement())) {
+        continue;
+      }
+      for (AtomViewList::const_iterator k=all_atoms.begin(); k!=all_atoms.end(); ++k) {
+        Real d=geom::Distance(j->GetPos(), k->GetPos());
+        if (d>max_distance || *k==*j || is_hydrogen(k->GetElement()) ||
+            j->GetHandle().FindBondToAtom(k->GetHandle()).IsValid()) {
+          continue;
+        }
+        Real threshold=distances.GetAdjustedClashingDistance(j->GetElement(),
+                                                             k->GetElement());
+        if (d<threshold) {
+          ++checked.bad_count;
+          remove_sc=true;
+          remove_bb|=is_backbone(j->GetName());
+        }
+      }
+    }
+    keep_atoms(*i, remove_sc, remove_bb, checked.kept);
+  }
+  std::sort(checked.kept.begin(), checked.kept.end());
+  return checked;
+}
+
+Real average(const std::vector<Real>& values, size_t count)
+{
+  Real sum=0.0;
+  for (size_t i=0; i<values.size(); ++i) {
+    sum+=values[i];
+  }
+  return sum/count;
+}
+
+// returns the number of violations, or -1 if the parameters are incomplete
+int compare_stereo_chemistry(const EntityView& ent,
+                             const StereoChemicalParams& bond_table,
+                             const StereoChemicalParams& angle_table)
+{
+  const Real tolerance=12.0;
+  Checked expected;
+  try {
+    expected=check_stereo_chemistry(ent, bond_table, angle_table, tolerance);
+  } catch (Error&) {
+    BOOST_CHECK_THROW(CheckStereoChemistry(ent, bond_table, angle_table,
+                                           tolerance, tolerance), Error);
+    return -1;
+  }
+  std::pair<EntityView,StereoChemistryInfo> result=
+    CheckStereoChemistry(ent, bond_table, angle_table, tolerance, tolerance);
+  StereoChemistryInfo& info=result.second;
+  BOOST_CHECK(atom_names(result.first)==expected.kept);
+  BOOST_CHECK_EQUAL(info.GetBondCount(), int(expected.bond_zscores.size()));
+  // the angle count starts at one
+  BOOST_CHECK_EQUAL(info.GetAngleCount(), int(expected.angle_zscores.size())+1);
+  BOOST_CHECK_EQUAL(info.GetBadBondCount()+info.GetBadAngleCount(),
+                    expected.bad_count);
+  BOOST_CHECK_EQUAL(int(info.GetBondViolationList().size()),
+                    info.GetBadBondCount());
+  BOOST_CHECK_EQUAL(int(info.GetAngleViolationList().size()),
+                    info.GetBadAngleCount());
+  if (!expected.bond_zscores.empty()) {
+    BOOST_CHECK_CLOSE(info.GetAvgZscoreBonds(),
+                      average(expected.bond_zscores,
+                              expected.bond_zscores.size()), 1e-2);
+  }
+  BOOST_CHECK_CLOSE(info.GetAvgZscoreAngles(),
+                    average(expected.angle_zscores,
+                            expected.angle_zscores.size()+1), 1e-2);
+  return expected.bad_count;
+}
+
+// returns the number of clashes, or -1 if the parameters are incomplete
+int compare_clashes(const EntityView& ent, const ClashingDistances& distances)
+{
+  Checked expected;
+  try {
+    expected=filter_clashes(ent, distances);
+  } catch (Error&) {
+    BOOST_CHECK_THROW(FilterClashes(ent, distances), Error);
+    return -1;
+  }
+  std::pair<EntityView,ClashingInfo> result=FilterClashes(ent, distances);
+  BOOST_CHECK(atom_names(result.first)==expected.kept);
+  BOOST_CHECK_EQUAL(result.second.GetClashCount(), expected.bad_count/2);
+  return expected.bad_count;
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE( mol_alg );
+
+BOOST_AUTO_TEST_CASE(compiled_parameters_match_string_keys)
+{
+  std::vector<String> lines=load_parameter_file();
+  StereoChemicalParams bond_table=FillStereoChemicalParams("Bond", lines, true);
+  StereoChemicalParams angle_table=FillStereoChemicalParams("Angle", lines,
+                                                            true);
+  ClashingDistances distances=FillClashingDistances(lines, true);
+  const char* residues[]={"ALA", "ARG", "CYS", "GLY", "PHE", "PRO", "TRP"};
+  const char* atoms[]={"N", "CA", "C", "O", "CB", "CG", "CD", "NE", "SG",
+                       "CZ", "NE1", "CE2", "XX"};
+  int found=0;
+  for (size_t r=0; r<7; ++r) {
+    int bond_res=bond_table.GetResidueIndex(residues[r]);
+    int angle_res=angle_table.GetResidueIndex(residues[r]);
+    BOOST_CHECK(bond_res>=0 && angle_res>=0);
+    for (size_t a=0; a<13; ++a) {
+      int a_bond=bond_table.GetAtomIndex(bond_res, atoms[a]);
+      int a_angle=angle_table.GetAtomIndex(angle_res, atoms[a]);
+      for (size_t b=0; b<13; ++b) {
+        if (!(String(atoms[a])<atoms[b])) {
+          continue;
+        }
+        String key=sorted_key(atoms[a], atoms[b]);
+        const std::pair<Real,Real>* bond=bond_table.FindBond(bond_res, a_bond,
+                               bond_table.GetAtomIndex(bond_res, atoms[b]));
+        BOOST_CHECK_EQUAL(bond!=NULL, bond_table.ContainsParam(key, residues[r]));
+        if (bond) {
+          ++found;
+          BOOST_CHECK(*bond==bond_table.GetParam(key, residues[r]));
+        }
+        int b_angle=angle_table.GetAtomIndex(angle_res, atoms[b]);
+        for (size_t c=0; c<13; ++c) {
+          key=sorted_key(atoms[a], atoms[b], atoms[c]);
+          const std::pair<Real,Real>* angle=angle_table.FindAngle(angle_res,
+                              a_angle, angle_table.GetAtomIndex(angle_res,
+                                                                atoms[c]),
+                              b_angle);
+          BOOST_CHECK_EQUAL(angle!=NULL,
+                            angle_table.ContainsParam(key, residues[r]));
+          if (angle) {
+            ++found;
+            BOOST_CHECK(*angle==angle_table.GetParam(key, residues[r]));
+          }
+        }
+      }
+    }
+  }
+  BOOST_CHECK(found>50);
+  BOOST_CHECK_EQUAL(bond_table.GetResidueIndex("SEP"), -1);
+  BOOST_CHECK(bond_table.FindBond(-1, 0, 1)==NULL);
+
+  const char* elements[]={"C", "N", "O", "S", "SE"};
+  for (size_t a=0; a<5; ++a) {
+    for (size_t b=0; b<5; ++b) {
+      int a_index=distances.GetElementIndex(elements[a]);
+      int b_index=distances.GetElementIndex(elements[b]);
+      if (a_index<0 || b_index<0) {
+        BOOST_CHECK_THROW(distances.GetAdjustedClashingDistance(elements[a],
+                                                                elements[b]),
+                          Error);
+        continue;
+      }
+      BOOST_CHECK_EQUAL(distances.GetAdjustedClashingDistanceByIndex(a_index,
+                                                                     b_index),
+                        distances.GetAdjustedClashingDistance(elements[a],
+                                                              elements[b]));
+    }
+  }
+  BOOST_CHECK_EQUAL(distances.GetElementIndex("SE"), -1);
+}
+
+BOOST_AUTO_TEST_CASE(filter_clashes_matches_string_keyed_lookup)
+{
+  std::vector<String> lines=load_parameter_file();
+  StereoChemicalParams bond_table=FillStereoChemicalParams("Bond", lines, true);
+  StereoChemicalParams angle_table=FillStereoChemicalParams("Angle", lines,
+                                                            true);
+  ClashingDistances distances=FillClashingDistances(lines, true);
+  // 3fub.2 contains hetero residues and sep.pdb is a residue without
+  // stereo-chemical parameters
+  const char* files[]={"1aho.pdb", "3fub.2.pdb", "sep.pdb"};
+  for (size_t f=0; f<3; ++f) {
+    BOOST_TEST_MESSAGE(files[f]);
+    EntityHandle ent=load_structure(files[f]);
+    EntityHandle displaced=displace_atoms(ent, 0.8, f+1);
+    // there are no parameters for the terminal OXT atoms
+    int violations=compare_stereo_chemistry(displaced.CreateFullView(),
+                                            bond_table, angle_table);
+    BOOST_CHECK_EQUAL(violations, f<2 ? -1 : 0);
+    BOOST_CHECK(compare_clashes(displaced.CreateFullView(), distances)>=0);
+    // with and without some of the side chain atoms
+    const char* queries[]={"aname!=OXT", "aname!=OXT,CG,NZ"};
+    for (size_t q=0; q<2; ++q) {
+      compare_stereo_chemistry(ent.Select(queries[q]), bond_table, angle_table);
+      compare_clashes(ent.Select(queries[q]), distances);
+      violations=compare_stereo_chemistry(displaced.Select(queries[q]),
+                                          bond_table, angle_table);
+      int clashes=compare_clashes(displaced.Select(queries[q]), distances);
+      if (f<2) {
+        BOOST_CHECK(violations>0);
+        BOOST_CHECK(clashes>0);
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(filter_clashes_missing_parameters)
+{
+  std::vector<String> lines=load_parameter_file();
+  StereoChemicalParams bond_table=FillStereoChemicalParams("Bond", lines, true);
+  StereoChemicalParams angle_table=FillStereoChemicalParams("Angle", lines,
+                                                            true);
+  ClashingDistances distances=FillClashingDistances(lines, true);
+  EntityHandle ent=load_structure("1aho.pdb");
+  XCSEditor edi=ent.EditXCS();
+  AtomViewList oxt=ent.Select("aname=OXT").GetAtomList();
+  for (AtomViewList::iterator i=oxt.begin(); i!=oxt.end(); ++i) {
+    edi.DeleteAtom(i->GetHandle());
+  }
+  ResidueHandle res=ent.GetResidueList()[5];
+  BOOST_REQUIRE(res.GetOneLetterCode()!='?');
+  AtomHandle ca=res.FindAtom("CA");
+  BOOST_REQUIRE(ca.IsValid());
+  BOOST_CHECK(compare_stereo_chemistry(ent.CreateFullView(), bond_table,
+                                       angle_table)>=0);
+
+  // atoms without parameters do not matter as long as they are neither
+  // bonded to other atoms of the residue nor close to any other atom
+  AtomHandle extra=edi.InsertAtom(res, "XX", ca.GetPos()+geom::Vec3(50, 0, 0),
+                                  "SE");
+  BOOST_CHECK(compare_stereo_chemistry(ent.CreateFullView(), bond_table,
+                                       angle_table)>=0);
+  BOOST_CHECK(compare_clashes(ent.CreateFullView(), distances)>=0);
+
+  // missing clashing distance of an element
+  edi.SetAtomPos(extra, ca.GetPos()+geom::Vec3(2.0, 0, 0));
+  BOOST_CHECK_EQUAL(compare_clashes(ent.CreateFullView(), distances), -1);
+  BOOST_CHECK_THROW(FilterClashes(ent, distances), Error);
+
+  // missing bond and angle parameters of an atom
+  extra.SetElement("C");
+  edi.Connect(ca, extra);
+  BOOST_CHECK_EQUAL(compare_stereo_chemistry(ent.CreateFullView(), bond_table,
+                                             angle_table), -1);
+  BOOST_CHECK_THROW(CheckStereoChemistry(ent, bond_table, angle_table, 12.0,
+                                         12.0), Error);
+
+  // missing residue
+  edi.DeleteAtom(extra);
+  edi.RenameResidue(res, "XAA");
+  BOOST_CHECK_EQUAL(compare_stereo_chemistry(ent.CreateFullView(), bond_table,
+                                             angle_table), -1);
+  BOOST_CHECK_THROW(CheckStereoChemistry(ent, bond_table, angle_table, 12.0,
+                                         12.0), Error);
+}
+
+BOOST_AUTO_TEST_SUITE_END();
@@ -0,0 +1,228 @@
+//------------------------------------------------------------------------------
+// This file is part of the OpenStructure project <www.openstructure.org>
+//
+// Copyright (C) 2008-2020 by the OpenStructure authors
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 3.0 of the License, or (at your option)
+// any later version.
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//------------------------------------------------------------------------------
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <boost/random.hpp>
+#include <ost/mol/mol.hh>
+#include <ost/io/mol/pdb_reader.hh>
+#include <ost/mol/alg/local_dist_diff_test.hh>
+
+using namespace ost;
+using namespace ost::mol;
+using namespace ost::mol::alg;
+
+namespace {
+
+EntityHandle load_structure()
+{
+  String filepath="testfiles/1aho.pdb";
+  io::PDBReader reader(filepath, io::IOProfile());
+  EntityHandle ent=CreateEntity();
+  reader.Import(ent);
+  // the lDDTScorer only considers peptide residues
+  ResidueHandleList residues=ent.GetResidueList();
+  for (ResidueHandleList::iterator i=residues.begin(); i!=residues.end(); ++i) {
+    i->SetChemClass(ChemClass(ChemClass::L_PEPTIDE_LINKING));
+  }
+  return ent;
+}
+
+void swap_pos(ResidueHandle res, const String& name_a, const String& name_b,
+              XCSEditor& edi)
+{
+  AtomHandle a=res.FindAtom(name_a);
+  AtomHandle b=res.FindAtom(name_b);
+  if (a && b) {
+    geom::Vec3 pos_a=a.GetPos();
+    edi.SetAtomPos(a, b.GetPos());
+    edi.SetAtomPos(b, pos_a);
+  }
+}
+
+// model with randomly displaced atoms. Some of the ambiguously named atoms are
+// exchanged, to make the naming convention matter.
+EntityHandle create_model(unsigned int seed)
+{
+  EntityHandle mdl=load_structure();
+  boost::mt19937 rng(seed);
+  boost::uniform_real<Real> dist(-1.5, 1.5);
+  boost::variate_generator<boost::mt19937&, boost::uniform_real<Real> > gen(rng, dist);
+  XCSEditor edi=mdl.EditXCS(BUFFERED_EDIT);
+  AtomHandleList atoms=mdl.GetAtomList();
+  for (AtomHandleList::iterator i=atoms.begin(); i!=atoms.end(); ++i) {
+    Real x=gen();
+    Real y=gen();
+    Real z=gen();
+    edi.SetAtomPos(*i, i->GetPos()+geom::Vec3(x, y, z));
+  }
+  ResidueHandleList residues=mdl.GetResidueList();
+  for (ResidueHandleList::iterator i=residues.begin(); i!=residues.end(); ++i) {
+    if (i->GetNumber().GetNum()%2!=int(seed%2)) {
+      continue;
+    }
+    swap_pos(*i, "OD1", "OD2", edi);
+    swap_pos(*i, "OE1", "OE2", edi);
+    swap_pos(*i, "CD1", "CD2", edi);
+    swap_pos(*i, "CE1", "CE2", edi);
+  }
+  return mdl;
+}
+
+std::vector<Real> lddt_cutoffs()
+{
+  std::vector<Real> cutoffs;
+  cutoffs.push_back(0.5);
+  cutoffs.push_back(1.0);
+  cutoffs.push_back(2.0);
+  cutoffs.push_back(4.0);
+  return cutoffs;
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE( mol_alg );
+
+BOOST_AUTO_TEST_CASE(compiled_rd_list_matches_lddt)
+{
+  EntityView ref=load_structure().CreateFullView();
+  std::vector<Real> cutoffs=lddt_cutoffs();
+  GlobalRDMap glob_dist_list=CreateDistanceList(ref, 15.0);
+  for (int seq_sep=0; seq_sep<=2; seq_sep+=2) {
+    for (unsigned int seed=1; seed<=2; ++seed) {
+      EntityView mdl=create_model(seed).CreateFullView();
+      CompiledRDList compiled(glob_dist_list, mdl, seq_sep);
+      BOOST_CHECK_EQUAL(compiled.GetAtomCount(), size_t(mdl.GetAtomCount()));
+      BOOST_CHECK(compiled.GetSize()>0);
+      std::vector<std::pair<long int, long int> > per_residue;
+      std::vector<bool> swapped;
+      std::pair<long int, long int> ov=compiled.Evaluate(compiled.GetPositions(),
+                                                          cutoffs, per_residue,
+                                                          swapped);
+      BOOST_CHECK(std::find(swapped.begin(), swapped.end(), true)!=swapped.end());
+      // the reference implementation renames the atoms of the model
+      std::pair<long int, long int> expected=LocalDistDiffTest(mdl, glob_dist_list,
+                                                               cutoffs, seq_sep,
+                                                               "lddt");
+      BOOST_CHECK_EQUAL(ov.first, expected.first);
+      BOOST_CHECK_EQUAL(ov.second, expected.second);
+      ResidueViewList residues=mdl.GetResidueList();
+      for (size_t i=0; i<residues.size(); ++i) {
+        if (!residues[i].HasProp("lddt_total")) {
+          continue;
+        }
+        int index=residues[i].GetIndex();
+        BOOST_CHECK_EQUAL(per_residue[index].first,
+                          residues[i].GetIntProp("lddt_conserved"));
+        BOOST_CHECK_EQUAL(per_residue[index].second,
+                          residues[i].GetIntProp("lddt_total"));
+      }
+    }
+  }
+  // perfect model
+  CompiledRDList compiled(glob_dist_list, ref);
+  std::pair<long int, long int> ov=compiled.Evaluate(compiled.GetPositions(),
+                                                      cutoffs);
+  BOOST_CHECK(ov.second>0);
+  BOOST_CHECK_EQUAL(ov.first, ov.second);
+  BOOST_CHECK_THROW(compiled.Evaluate(geom::Vec3List(3), cutoffs), Error);
+}
+
+BOOST_AUTO_TEST_CASE(lddt_scorer_score_coordinates)
+{
+  std::vector<EntityView> refs(1, load_structure().CreateFullView());
+  EntityView mdl=create_model(1).CreateFullView();
+  lDDTSettings settings;
+  lDDTScorer scorer(refs, mdl, settings);
+  geom::Vec3List positions=scorer.GetCompiledDistanceList().GetPositions();
+  Real score=scorer.ScoreCoordinates(positions);
+  BOOST_CHECK_CLOSE(score, scorer.GetGlobalScore(), Real(1e-4));
+  BOOST_CHECK(score>0.0 && score<1.0);
+  // a different set of coordinates for the same topology
+  EntityView other=create_model(2).CreateFullView();
+  AtomViewList other_atoms=other.GetAtomList();
+  for (size_t i=0; i<positions.size(); ++i) {
+    positions[i]=other_atoms[i].GetPos();
+  }
+  lDDTScorer other_scorer(refs, other, settings);
+  BOOST_CHECK_CLOSE(scorer.ScoreCoordinates(positions),
+                    other_scorer.GetGlobalScore(), Real(1e-4));
+}
+
+BOOST_AUTO_TEST_CASE(lddt_threads)
+{
+  EntityView ref=load_structure().CreateFullView();
+  std::vector<Real> cutoffs=lddt_cutoffs();
+  GlobalRDMap glob_dist_list=CreateDistanceList(ref, 15.0);
+  GlobalRDMap glob_dist_list_mt=CreateDistanceList(ref, 15.0, 3);
+  BOOST_CHECK(glob_dist_list==glob_dist_list_mt);
+
+  EntityView mdl=create_model(1).CreateFullView();
+  CompiledRDList compiled(glob_dist_list, mdl);
+  CompiledRDList compiled_mt(glob_dist_list, mdl, 0, 4);
+  BOOST_CHECK_EQUAL(compiled.GetSize(), compiled_mt.GetSize());
+  geom::Vec3List positions=compiled.GetPositions();
+  std::vector<std::pair<long int, long int> > per_residue, per_residue_mt;
+  std::vector<bool> swapped, swapped_mt;
+  std::pair<long int, long int> ov=compiled.Evaluate(positions, cutoffs,
+                                                      per_residue, swapped);
+  std::pair<long int, long int> ov_mt=compiled_mt.Evaluate(positions, cutoffs,
+                                                           per_residue_mt,
+                                                           swapped_mt, 4);
+  BOOST_CHECK(ov==ov_mt);
+  BOOST_CHECK(per_residue==per_residue_mt);
+  BOOST_CHECK(swapped==swapped_mt);
+
+  // the multi-threaded version renames atoms and sets the properties just as
+  // the single-threaded one
+  std::pair<long int, long int> expected=LocalDistDiffTest(mdl, glob_dist_list,
+                                                           cutoffs, 0, "lddt");
+  EntityView mdl_mt=create_model(1).CreateFullView();
+  ov_mt=LocalDistDiffTest(mdl_mt, glob_dist_list, cutoffs, 0, "lddt", 4);
+  BOOST_CHECK(expected==ov_mt);
+  AtomViewList atoms=mdl.GetAtomList();
+  AtomViewList atoms_mt=mdl_mt.GetAtomList();
+  BOOST_CHECK_EQUAL(atoms.size(), atoms_mt.size());
+  for (size_t i=0; i<atoms.size(); ++i) {
+    BOOST_CHECK_EQUAL(atoms[i].GetName(), atoms_mt[i].GetName());
+  }
+  ResidueViewList residues=mdl.GetResidueList();
+  ResidueViewList residues_mt=mdl_mt.GetResidueList();
+  for (size_t i=0; i<residues.size(); ++i) {
+    BOOST_CHECK_EQUAL(residues[i].GetIntProp("lddt_conserved", -1),
+                      residues_mt[i].GetIntProp("lddt_conserved", -1));
+    BOOST_CHECK_EQUAL(residues[i].GetIntProp("lddt_total", -1),
+                      residues_mt[i].GetIntProp("lddt_total", -1));
+  }
+
+  // lDDTScorer with multiple threads
+  std::vector<EntityView> refs(1, ref);
+  lDDTSettings settings;
+  lDDTScorer scorer(refs, mdl, settings);
+  settings.num_threads=3;
+  lDDTScorer scorer_mt(refs, mdl_mt, settings);
+  BOOST_CHECK_EQUAL(scorer.GetNumConservedContacts(),
+                    scorer_mt.GetNumConservedContacts());
+  BOOST_CHECK_EQUAL(scorer.GetNumTotalContacts(),
+                    scorer_mt.GetNumTotalContacts());
+  BOOST_CHECK_EQUAL(scorer.GetLocalScores().size(),
+                    scorer_mt.GetLocalScores().size());
+}
+
+BOOST_AUTO_TEST_SUITE_END();
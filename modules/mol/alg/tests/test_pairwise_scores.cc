@@ -0,0 +1,134 @@
+//------------------------------------------------------------------------------
+// This file is part of the OpenStructure project <www.openstructure.org>
+//
+// Copyright (C) 2008-2020 by the OpenStructure authors
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 3.0 of the License, or (at your option)
+// any later version.
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//------------------------------------------------------------------------------
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+#include <ost/mol/mol.hh>
+#include <ost/mol/alg/svd_superpose.hh>
+#include <ost/mol/alg/pairwise_scores.hh>
+
+using namespace ost;
+using namespace ost::mol;
+using namespace ost::mol::alg;
+
+namespace {
+
+// rigidly moved copies of a random-walk chain with a few displaced atoms
+std::vector<geom::Vec3List> make_structures(int num_structures, int num_atoms)
+{
+  geom::Vec3List chain;
+  geom::Vec3 pos;
+  for (int i=0; i<num_atoms; ++i) {
+    pos+=geom::Vec3(std::sin(0.7*i), std::cos(1.3*i), std::sin(0.1*i*i))*3.8;
+    chain.push_back(pos);
+  }
+  std::vector<geom::Vec3List> structures;
+  for (int s=0; s<num_structures; ++s) {
+    geom::Mat3 rot=geom::EulerTransformation(0.3*s, -0.2*s, 0.1);
+    geom::Vec3List structure;
+    for (int i=0; i<num_atoms; ++i) {
+      geom::Vec3 p=chain[i];
+      if ((i+s)%7==0) {
+        p+=geom::Vec3(0.5*s, 0, 0);
+      }
+      structure.push_back(rot*p+geom::Vec3(s, 2*s, -s));
+    }
+    structures.push_back(structure);
+  }
+  return structures;
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE( mol_alg );
+
+BOOST_AUTO_TEST_CASE(pairwise_rmsd)
+{
+  // large enough for several tiles
+  std::vector<geom::Vec3List> structures=make_structures(12, 2000);
+  SimilarityMatrix m1=PairwiseScores(structures, PS_RMSD, 1);
+  SimilarityMatrix m3=PairwiseScores(structures, PS_RMSD, 3);
+  BOOST_REQUIRE_EQUAL(m1.GetSize(), 12);
+  for (int i=0; i<12; ++i) {
+    BOOST_CHECK_EQUAL(m1.Get(i, i), Real(0.0));
+    for (int j=i+1; j<12; ++j) {
+      Real rmsd=SuperposeSVD(structures[i], structures[j]).rmsd;
+      BOOST_CHECK_CLOSE(m1.Get(i, j), rmsd, Real(0.1));
+      BOOST_CHECK_EQUAL(m1.Get(i, j), m1.Get(j, i));
+      BOOST_CHECK_EQUAL(m1.Get(i, j), m3.Get(i, j));
+    }
+  }
+  structures[3].pop_back();
+  BOOST_CHECK_THROW(PairwiseScores(structures), Error);
+}
+
+BOOST_AUTO_TEST_CASE(pairwise_gdt_tm)
+{
+  std::vector<geom::Vec3List> structures=make_structures(4, 100);
+  // rigid copy of the first structure
+  structures.push_back(structures[0]);
+  for (size_t i=0; i<structures[4].size(); ++i) {
+    structures[4][i]=geom::EulerTransformation(1, 2, 3)*structures[4][i];
+  }
+  SimilarityMatrix gdt=PairwiseScores(structures, PS_GDT_TS);
+  SimilarityMatrix tm=PairwiseScores(structures, PS_TM_SCORE);
+  BOOST_CHECK_CLOSE(gdt.Get(0, 4), Real(1.0), Real(1e-3));
+  BOOST_CHECK_CLOSE(tm.Get(0, 4), Real(1.0), Real(1e-3));
+  BOOST_CHECK_EQUAL(gdt.Get(2, 2), Real(1.0));
+  for (int i=0; i<4; ++i) {
+    for (int j=i+1; j<4; ++j) {
+      BOOST_CHECK(gdt.Get(i, j)>0.0 && gdt.Get(i, j)<=1.0);
+      BOOST_CHECK(tm.Get(i, j)>0.0 && tm.Get(i, j)<=1.0);
+    }
+  }
+  // structures further apart score lower
+  BOOST_CHECK(gdt.Get(0, 3)<gdt.Get(0, 1));
+  BOOST_CHECK(tm.Get(0, 3)<tm.Get(0, 1));
+}
+
+BOOST_AUTO_TEST_CASE(pairwise_coord_group)
+{
+  std::vector<geom::Vec3List> structures=make_structures(6, 10);
+  EntityHandle ent=CreateEntity();
+  XCSEditor edi=ent.EditXCS();
+  ResidueHandle res=edi.AppendResidue(edi.InsertChain("A"), "UNK");
+  for (int i=0; i<10; ++i) {
+    edi.InsertAtom(res, i<5 ? "A" : "B", structures[0][i]);
+  }
+  CoordGroupHandle cg=CreateCoordGroup(ent.GetAtomList());
+  for (size_t i=0; i<structures.size(); ++i) {
+    cg.AddFrame(structures[i]);
+  }
+  SimilarityMatrix all=PairwiseScores(cg, EntityView(), PS_RMSD, 1, -1, 2);
+  SimilarityMatrix ref=PairwiseScores(std::vector<geom::Vec3List>(
+                                        structures.begin()+1,
+                                        structures.end()));
+  BOOST_REQUIRE_EQUAL(all.GetSize(), 5);
+  for (int i=0; i<5; ++i) {
+    for (int j=0; j<5; ++j) {
+      BOOST_CHECK_EQUAL(all.Get(i, j), ref.Get(i, j));
+    }
+  }
+  SimilarityMatrix sel=PairwiseScores(cg, ent.Select("aname=B"));
+  geom::Vec3List a(structures[0].begin()+5, structures[0].end());
+  geom::Vec3List b(structures[2].begin()+5, structures[2].end());
+  BOOST_CHECK_CLOSE(sel.Get(0, 2), SuperposeSVD(a, b).rmsd, Real(0.1));
+}
+
+BOOST_AUTO_TEST_SUITE_END();
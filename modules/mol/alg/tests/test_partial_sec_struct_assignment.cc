@@ -26,6 +26,69 @@
 #include <ost/mol/builder.hh>
 #include <ost/message.hh>
 
+namespace {
+
+// reference implementation evaluating all residue pairs
+void AllPairsDonors(const ost::mol::ResidueViewList& res_list,
+                    const std::vector<int>& res_indices,
+                    const std::vector<int>& connected_to_next,
+                    std::vector<int>& donor_for_one,
+                    std::vector<int>& donor_for_two) {
+  int num_residues = res_indices.size();
+  std::vector<geom::Vec3> n_pos, ca_pos, c_pos, o_pos;
+  for(int i = 0; i < num_residues; ++i) {
+    const ost::mol::ResidueView& res = res_list[res_indices[i]];
+    n_pos.push_back(res.FindAtom("N").GetPos());
+    ca_pos.push_back(res.FindAtom("CA").GetPos());
+    c_pos.push_back(res.FindAtom("C").GetPos());
+    o_pos.push_back(res.FindAtom("O").GetPos());
+  }
+  std::vector<geom::Vec3> h_pos(num_residues);
+  std::vector<int> valid_h(num_residues, 0);
+  for(int i = 0; i < num_residues - 1; ++i) {
+    if(connected_to_next[i] && res_list[res_indices[i+1]].GetName() != "PRO") {
+      h_pos[i+1] = n_pos[i+1] + geom::Normalize(c_pos[i] - o_pos[i]);
+      valid_h[i+1] = 1;
+    }
+  }
+  std::vector<Real> e_one(num_residues, std::numeric_limits<Real>::max());
+  std::vector<Real> e_two(num_residues, std::numeric_limits<Real>::max());
+  std::vector<int> a_one(num_residues, -1), a_two(num_residues, -1);
+  for(int i = 0; i < num_residues - 1; ++i) {
+    for(int j = i + 1; j < num_residues; ++j) {
+      if(geom::Length2(ca_pos[i] - ca_pos[j]) >= 81.0) continue;
+      int donors[] = {j, i};
+      int acceptors[] = {i, j};
+      for(int k = 0; k < 2; ++k) {
+        int d = donors[k];
+        int a = acceptors[k];
+        if(!valid_h[d] || (k == 0 && j == i + 1)) continue;
+        Real e = ost::mol::alg::DSSPHBondEnergy(h_pos[d], n_pos[d],
+                                                c_pos[a], o_pos[a]);
+        e = std::floor(e * 1000 + 0.5) * 0.001;
+        if(e < e_one[d]) {
+          e_two[d] = e_one[d];
+          a_two[d] = a_one[d];
+          e_one[d] = e;
+          a_one[d] = a;
+        }
+        else if(e < e_two[d]) {
+          e_two[d] = e;
+          a_two[d] = a;
+        }
+      }
+    }
+  }
+  donor_for_one.assign(num_residues, -1);
+  donor_for_two.assign(num_residues, -1);
+  for(int i = 0; i < num_residues; ++i) {
+    if(e_one[i] < -0.5) donor_for_one[i] = a_one[i];
+    if(e_two[i] < -0.5) donor_for_two[i] = a_two[i];
+  }
+}
+
+}
+
 
 
 BOOST_AUTO_TEST_SUITE( mol_alg );
@@ -84,4 +147,41 @@ BOOST_AUTO_TEST_CASE(partial_sec_struct_assignment) {
 
 }
 
+BOOST_AUTO_TEST_CASE(sec_struct_hbond_search) {
+
+  String filepath = "testfiles/1a0s.pdb";
+  ost::io::PDBReader reader(filepath, ost::io::IOProfile());
+  ost::mol::EntityHandle test_ent = ost::mol::CreateEntity();
+  reader.Import(test_ent);
+
+  ost::mol::EntityView view = test_ent.CreateFullView();
+  ost::mol::ResidueViewList res_list = view.GetResidueList();
+
+  std::vector<int> res_indices;
+  std::vector<geom::Vec3> ca_positions;
+  std::vector<int> donor_for_one;
+  std::vector<int> donor_for_two;
+  std::vector<int> connected_to_next;
+
+  ost::mol::alg::PrepareSSData(res_list, res_indices, ca_positions,
+                               donor_for_one, donor_for_two,
+                               connected_to_next);
+
+  std::vector<int> ref_donor_for_one;
+  std::vector<int> ref_donor_for_two;
+  AllPairsDonors(res_list, res_indices, connected_to_next,
+                 ref_donor_for_one, ref_donor_for_two);
+  BOOST_CHECK(donor_for_one == ref_donor_for_one);
+  BOOST_CHECK(donor_for_two == ref_donor_for_two);
+
+  // the number of threads must not affect the result
+  std::vector<int> mt_donor_for_one;
+  std::vector<int> mt_donor_for_two;
+  ost::mol::alg::PrepareSSData(res_list, res_indices, ca_positions,
+                               mt_donor_for_one, mt_donor_for_two,
+                               connected_to_next, 3);
+  BOOST_CHECK(mt_donor_for_one == donor_for_one);
+  BOOST_CHECK(mt_donor_for_two == donor_for_two);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -21,9 +21,12 @@
  * Author Juergen Haas
  */
 #include <ost/mol/alg/svd_superpose.hh>
+#include <ost/mol/alg/superpose_frames.hh>
 #define BOOST_TEST_DYN_LINK
 #include <boost/test/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
 #include <ost/mol/mol.hh>
+#include <ost/mol/coord_group.hh>
 #include <ost/mol/builder.hh>
 #include <ost/message.hh>
 
@@ -121,4 +124,87 @@ BOOST_AUTO_TEST_CASE(iterative_superposition_svd)
 
 
 
+BOOST_AUTO_TEST_CASE(superposition_qcp)
+{
+  geom::Vec3List points, points_ref;
+  geom::Mat3 rot=geom::EulerTransformation(0.3, -1.2, 2.0);
+  for (int i=0; i<20; ++i) {
+    geom::Vec3 p(i%3, (i*7)%5, (i*i)%11);
+    points.push_back(p);
+    points_ref.push_back(rot*p+geom::Vec3(1, -2, 3));
+  }
+  Real rmsd=-1.0;
+  geom::Mat4 tf=SuperposeQCP(&points[0], &points_ref[0], points.size(), &rmsd);
+  BOOST_CHECK_SMALL(rmsd, Real(1e-3));
+  for (size_t i=0; i<points.size(); ++i) {
+    BOOST_CHECK_SMALL(geom::Length(geom::Vec3(tf*geom::Vec4(points[i]))-
+                                   points_ref[i]), Real(1e-4));
+  }
+  // with noise, the RMSD reported by QCP matches the explicit RMSD
+  points_ref[3]+=geom::Vec3(0.5, 0, 0);
+  points_ref[7]+=geom::Vec3(0, -0.3, 0.2);
+  SuperpositionResult res=SuperposeSVD(points, points_ref);
+  tf=SuperposeQCP(&points[0], &points_ref[0], points.size(), &rmsd);
+  BOOST_CHECK_CLOSE(rmsd, res.rmsd, Real(1e-2));
+
+  // collinear points do not determine the rotation uniquely
+  geom::Vec3List line, line_ref;
+  for (int i=0; i<5; ++i) {
+    line.push_back(geom::Vec3(i, 0, 0));
+    line_ref.push_back(geom::Vec3(0, i, 0));
+  }
+  tf=SuperposeQCP(&line[0], &line_ref[0], line.size(), &rmsd);
+  BOOST_CHECK_SMALL(rmsd, Real(1e-3));
+  for (size_t i=0; i<line.size(); ++i) {
+    BOOST_CHECK_SMALL(geom::Length(geom::Vec3(tf*geom::Vec4(line[i]))-
+                                   line_ref[i]), Real(1e-4));
+  }
+  BOOST_CHECK_THROW(SuperposeQCP(&line[0], &line_ref[0], 2), Error);
+}
+
+BOOST_AUTO_TEST_CASE(superpose_frames_threads)
+{
+  Fixture f;
+  AtomHandleList atoms=f.e.GetAtomList();
+  CoordGroupHandle cg=CreateCoordGroup(atoms);
+  for (int i=0; i<10; ++i) {
+    geom::Mat3 rot=geom::EulerTransformation(0.1*i, 0.2*i, -0.3*i);
+    geom::Vec3List frame;
+    for (size_t j=0; j<atoms.size(); ++j) {
+      frame.push_back(rot*atoms[j].GetPos()+geom::Vec3(i, 0, 0)+
+                      geom::Vec3(0, 0.1*((i+j)%3), 0));
+    }
+    cg.AddFrame(frame);
+  }
+  EntityView sel;
+  for (int ref=-1; ref<2; ++ref) {
+    CoordGroupHandle s1=SuperposeFrames(cg, sel, 1, 9, ref, 1);
+    CoordGroupHandle s3=SuperposeFrames(cg, sel, 1, 9, ref, 3);
+    BOOST_REQUIRE_EQUAL(s1.GetFrameCount(), 8);
+    BOOST_REQUIRE_EQUAL(s3.GetFrameCount(), 8);
+    for (int i=0; i<8; ++i) {
+      CoordFramePtr a=s1.GetFrame(i), b=s3.GetFrame(i);
+      for (size_t j=0; j<atoms.size(); ++j) {
+        BOOST_CHECK_SMALL(geom::Length((*a)[j]-(*b)[j]), Real(1e-5));
+      }
+    }
+    if (ref==-1) {
+      // superposing each frame onto the superposed previous frame
+      for (int i=1; i<8; ++i) {
+        geom::Vec3List prev(*s1.GetFrame(i-1)), cur(*cg.GetFrame(i+1));
+        SuperpositionResult res=SuperposeSVD(cur, prev);
+        for (size_t j=0; j<atoms.size(); ++j) {
+          geom::Vec3 p(res.transformation*geom::Vec4(cur[j]));
+          BOOST_CHECK_SMALL(geom::Length(p-(*s1.GetFrame(i))[j]), Real(1e-4));
+        }
+      }
+    }
+  }
+  // reference frame is left untouched
+  CoordGroupHandle s=SuperposeFrames(cg, sel, 0, 10, 4, 2);
+  for (size_t j=0; j<atoms.size(); ++j) {
+    BOOST_CHECK_EQUAL((*s.GetFrame(4))[j], (*cg.GetFrame(4))[j]);
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -0,0 +1,96 @@
+//------------------------------------------------------------------------------
+// This file is part of the OpenStructure project <www.openstructure.org>
+//
+// Copyright (C) 2008-2020 by the OpenStructure authors
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 3.0 of the License, or (at your option)
+// any later version.
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//------------------------------------------------------------------------------
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+#include <ost/mol/mol.hh>
+#include <ost/mol/alg/trajectory_analysis.hh>
+#include <ost/mol/alg/trajectory_pipeline.hh>
+
+using namespace ost;
+using namespace ost::mol;
+using namespace ost::mol::alg;
+
+namespace {
+
+struct Fixture {
+  Fixture()
+  {
+    e=CreateEntity();
+    XCSEditor ed=e.EditXCS();
+    ChainHandle chain=ed.InsertChain("A");
+    ResidueHandle res=ed.AppendResidue(chain, "XXX");
+    for (int i=0; i<6; ++i) {
+      std::stringstream name;
+      name << "X" << i;
+      atoms.push_back(ed.InsertAtom(res, name.str(), geom::Vec3(i, 0, 0), "C"));
+    }
+    traj=CreateCoordGroup(atoms);
+    for (int f=0; f<37; ++f) {
+      geom::Vec3List pos;
+      for (int i=0; i<6; ++i) {
+        pos.push_back(geom::Vec3(i+0.1*f, 0.05*f*i, 0.3*i*i-0.02*f));
+      }
+      traj.AddFrame(pos);
+    }
+  }
+  EntityHandle     e;
+  AtomHandleList   atoms;
+  CoordGroupHandle traj;
+};
+
+}
+
+BOOST_AUTO_TEST_SUITE(mol_alg);
+
+BOOST_AUTO_TEST_CASE(trajectory_pipeline)
+{
+  Fixture f;
+  EntityView sele1=f.e.Select("aname=X0,X1,X2");
+  EntityView sele2=f.e.Select("aname=X3,X4,X5");
+  std::vector<Real> rmsd=AnalyzeRMSD(f.traj, sele1, sele2, 2);
+  std::vector<Real> dihedral=AnalyzeDihedralAngle(f.traj, f.atoms[0],
+                                                  f.atoms[1], f.atoms[2],
+                                                  f.atoms[3], 2);
+  std::vector<Real> min_dist=AnalyzeMinDistance(f.traj, sele1, sele2, 2);
+  geom::Vec3List com=AnalyzeCenterOfMassPos(f.traj, sele2, 2);
+  for (int num_threads=1; num_threads<4; ++num_threads) {
+    // small batches to test the double buffering
+    TrajectoryPipeline pipeline(f.traj, 2, num_threads, 5);
+    size_t rmsd_id=pipeline.AddRMSD(sele1, sele2);
+    size_t dihedral_id=pipeline.AddDihedralAngle(f.atoms[0], f.atoms[1],
+                                                 f.atoms[2], f.atoms[3]);
+    size_t min_dist_id=pipeline.AddMinDistance(sele1, sele2);
+    size_t com_id=pipeline.AddCenterOfMassPos(sele2);
+    pipeline.Run();
+    BOOST_CHECK_EQUAL(pipeline.GetFrameCount(), size_t(19));
+    BOOST_CHECK(pipeline.GetResult(rmsd_id)==rmsd);
+    BOOST_CHECK(pipeline.GetResult(dihedral_id)==dihedral);
+    BOOST_CHECK(pipeline.GetResult(min_dist_id)==min_dist);
+    geom::Vec3List pipeline_com=pipeline.GetVec3Result(com_id);
+    BOOST_REQUIRE_EQUAL(pipeline_com.size(), com.size());
+    for (size_t i=0; i<com.size(); ++i) {
+      BOOST_CHECK(pipeline_com[i]==com[i]);
+    }
+    BOOST_CHECK_THROW(pipeline.GetVec3Result(rmsd_id), Error);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END();
@@ -40,22 +40,16 @@ void export_Atom()
 {
   class_<AtomBase> atom_base("AtomBase", no_init);
   atom_base
-    .def("GetPos", &AtomBase::GetPos,
-         return_value_policy<copy_const_reference>())
-    .def("GetOriginalPos", &AtomBase::GetOriginalPos,
-         return_value_policy<copy_const_reference>())
+    .def("GetPos", &AtomBase::GetPos)
+    .def("GetOriginalPos", &AtomBase::GetOriginalPos)
     .def("GetName", &AtomBase::GetName,
          return_value_policy<copy_const_reference>())
     .def("GetQualifiedName", &AtomBase::GetQualifiedName)
     .add_property("qualified_name", &AtomBase::GetQualifiedName)
     .def(self_ns::str(self))
     .def("GetIndex", &AtomBase::GetIndex)
-    .add_property("pos",
-                  make_function(&AtomBase::GetPos,
-                                return_value_policy<copy_const_reference>()))
-    .add_property("original_pos",
-                  make_function(&AtomBase::GetOriginalPos,
-                                return_value_policy<copy_const_reference>()))
+    .add_property("pos", &AtomBase::GetPos)
+    .add_property("original_pos", &AtomBase::GetOriginalPos)
     .add_property("name",
                   make_function(&AtomBase::GetName,
                                 return_value_policy<copy_const_reference>()),
@@ -286,10 +286,16 @@ void export_Editors()
   void (XCSEditor::*set_transform1)(const geom::Mat4&) = &XCSEditor::SetTransform;
   void (XCSEditor::*set_transform2)(const geom::Transform&) = &XCSEditor::SetTransform;
 
+  void (XCSEditor::*set_t_pos_all)(const geom::Vec3List&) = &XCSEditor::SetAtomTransformedPos;
+  void (XCSEditor::*set_o_pos_all)(const geom::Vec3List&) = &XCSEditor::SetAtomOriginalPos;
+
   class_<XCSEditor, bases<EditorBase> >("XCSEditor", no_init)
     .def("SetAtomPos", set_t_pos)
+    .def("SetAtomPos", set_t_pos_all)
     .def("SetAtomTransformedPos", set_t_pos)
+    .def("SetAtomTransformedPos", set_t_pos_all)
     .def("SetAtomOriginalPos", set_o_pos)
+    .def("SetAtomOriginalPos", set_o_pos_all)
     .def("ApplyTransform", apply_transform1)
     .def("ApplyTransform", apply_transform2)
     .def("SetTransform", set_transform1)
@@ -97,21 +97,11 @@ PyObject* get_pos2(EntityHandle& entity, bool id_sorted)
       nad[1]=static_cast<npy_float>(pos[1]);
       nad[2]=static_cast<npy_float>(pos[2]);
     }
-  } else {
-    impl::EntityImplPtr ei=entity.Impl();
-    for(impl::ChainImplList::iterator cit=ei->GetChainList().begin();
-        cit!=ei->GetChainList().end();++cit) {
-      for (impl::ResidueImplList::iterator rit = (*cit)->GetResidueList().begin(),
-          ret = (*cit)->GetResidueList().end(); rit != ret; ++rit) {
-            
-        for (impl::AtomImplList::iterator ait = (*rit)->GetAtomList().begin(), 
-            aet = (*rit)->GetAtomList().end(); ait != aet; ++ait, nad+=3) {
-
-          geom::Vec3 pos=(*ait)->TransformedPos();
-          nad[0]=static_cast<npy_float>(pos[0]);
-          nad[1]=static_cast<npy_float>(pos[1]);
-          nad[2]=static_cast<npy_float>(pos[2]);
-    }}}
+  } else if (dims[0]>0) {
+    const Real* pos=entity.GetAtomPosData()->Data();
+    for (npy_intp i=0; i<dims[0]*3; ++i) {
+      nad[i]=static_cast<npy_float>(pos[i]);
+    }
   }
   return na;
 }
@@ -30,6 +30,7 @@ using namespace boost::python;
 #include <ost/mol/query.hh>
 #include <ost/mol/mol.hh>
 #include <ost/mol/view_op.hh>
+#include <ost/mol/neighbor_search.hh>
 using namespace ost;
 using namespace ost::mol;
 #include "bounds.hh"
@@ -49,6 +50,11 @@ std::vector<T> from_list(const object& seq)
 
 typedef ChainView (EntityView::*StringMethod)(const String&) const;
 typedef ChainView (EntityView::*StringMethod)(const String&) const;
+typedef NeighborPairList (*PairViewsFunc)(const EntityView&, const EntityView&,
+                                          Real, int);
+typedef NeighborPairList (*PairViewFunc)(const EntityView&, Real, int);
+PairViewsFunc find_pairs_views=&FindAllPairsWithin;
+PairViewFunc find_pairs_view=&FindAllPairsWithin;
 typedef EntityView (EntityView::*QueryMethod)(const Query&, uint) const;
 typedef EntityView (EntityView::*QSMethod)(const String&, uint) const;
 typedef ChainView (EntityView::*HandleMethod)(const ChainHandle&) const;
@@ -221,6 +227,22 @@ void export_EntityView()
     .def(vector_indexing_suite<EntityViewList>())
   ;
 
+  class_<NeighborPair>("NeighborPair", init<>())
+    .def(init<unsigned int, unsigned int, Real>())
+    .def_readwrite("first", &NeighborPair::first)
+    .def_readwrite("second", &NeighborPair::second)
+    .def_readwrite("dist2", &NeighborPair::dist2)
+    .def(self==self)
+    .def(self!=self)
+  ;
+  class_<NeighborPairList>("NeighborPairList", init<>())
+    .def(vector_indexing_suite<NeighborPairList>())
+  ;
+  def("FindAllPairsWithin", find_pairs_views,
+      (arg("view_a"), arg("view_b"), arg("cutoff"), arg("num_threads")=1));
+  def("FindAllPairsWithin", find_pairs_view,
+      (arg("view"), arg("cutoff"), arg("num_threads")=1));
+
   to_python_converter<std::pair<EntityView, EntityView>,
                       PairToTupleConverter<EntityView, EntityView> >();
 }
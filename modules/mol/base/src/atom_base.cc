@@ -51,13 +51,13 @@ void AtomBase::SetName(const String& atom_name)
   impl_->Name()=atom_name;
 }
 
-const geom::Vec3& AtomBase::GetPos() const 
+geom::Vec3 AtomBase::GetPos() const 
 {
   this->CheckValidity();  
   return impl_->TransformedPos();
 }
 
-const geom::Vec3& AtomBase::GetOriginalPos() const
+geom::Vec3 AtomBase::GetOriginalPos() const
 {
   this->CheckValidity();
   return impl_->OriginalPos();
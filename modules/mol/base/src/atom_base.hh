@@ -40,7 +40,9 @@ namespace ost { namespace mol {
 /// The position of the atoms can be accessed via #GetPos(). Note, however
 /// that the position of an atom is undefined when there are pending changes
 /// of an ICSEditor in buffered edit mode. Before calling #GetPos(),
-/// ICSEditor::UpdateXCS() should be called explicitly.
+/// ICSEditor::UpdateXCS() should be called explicitly. The positions of all
+/// atoms of an entity are stored in one contiguous array, which is why they
+/// are returned by value.
 class DLLEXPORT_OST_MOL AtomBase: public GenericPropContainer<AtomBase> {
 public:
   AtomBase();
@@ -77,10 +79,10 @@ public:
   void SetName(const String& atom_name);
     
   //! \brief Get global position in cartesian coordinates with entity transformations applied
-  const geom::Vec3& GetPos() const;
+  geom::Vec3 GetPos() const;
 
   //! \brief Get original global position in cartesian coordinates (no entity transformation is applied)
-  const geom::Vec3& GetOriginalPos() const;
+  geom::Vec3 GetOriginalPos() const;
   /// \brief get alternative atom position
   geom::Vec3 GetAltPos(const String& alt_group) const;
   Real GetAltBFactor(const String& alt_group) const;
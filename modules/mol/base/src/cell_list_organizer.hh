@@ -0,0 +1,364 @@
+//------------------------------------------------------------------------------
+// This file is part of the OpenStructure project <www.openstructure.org>
+//
+// Copyright (C) 2008-2020 by the OpenStructure authors
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 3.0 of the License, or (at your option)
+// any later version.
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//------------------------------------------------------------------------------
+#ifndef OST_CELL_LIST_ORGANIZER_HH
+#define OST_CELL_LIST_ORGANIZER_HH
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <boost/cstdint.hpp>
+
+#include <ost/geom/geom.hh>
+#include <ost/mol/module_config.hh>
+
+namespace ost { namespace mol {
+
+//! flat cell list
+/*
+  Drop-in replacement for the SpatialOrganizer with the same binning (items
+  are assigned to cubic cells of size delta, as given in the ctor). Instead of
+  a map of small vectors, all positions are kept in one contiguous SoA
+  coordinate array sorted by cell. An open-addressing hash table maps each
+  occupied cell to its range in that array.
+
+  Items can be added and removed at any time, the sorted representation is
+  rebuilt lazily upon the next query. Concurrent queries are safe as long as
+  Build() has been called after the last modification.
+
+  For identical input, FindWithin returns the items in the same order as the
+  SpatialOrganizer does.
+*/
+template <class ITEM, class VEC=geom::Vec3>
+class DLLEXPORT_OST_MOL CellListOrganizer {
+public:
+  typedef std::vector<ITEM> ItemList;
+
+private:
+  struct Index {
+    Index():
+      u(0),v(0),w(0) {}
+    Index(int uu, int vv, int ww):
+      u(uu),v(vv),w(ww) {}
+
+    int u,v,w;
+
+    static Index Max(const Index& a, const Index& b) {
+      return Index(std::max(a.u, b.u), std::max(a.v, b.v), std::max(a.w, b.w));
+    }
+
+    static Index Min(const Index& a, const Index& b) {
+      return Index(std::min(a.u, b.u), std::min(a.v, b.v), std::min(a.w, b.w));
+    }
+  };
+
+  // cell indices are clamped to [-kIndexOffset, kIndexOffset) such that they
+  // fit into 21 bits each. Clamping is monotonic, hence far-away items end up
+  // in border cells but are still found.
+  static const int kIndexOffset=1<<20;
+  static const boost::uint64_t kEmptyKey=~boost::uint64_t(0);
+
+public:
+
+  CellListOrganizer(Real delta): delta_(delta), dirty_(false), shift_(64) {
+    if(delta==0.0) {
+      throw "delta cannot be zero";
+    }
+  }
+
+  void Add(const ITEM& item, const VEC& pos) {
+    items_.push_back(item);
+    x_.push_back(pos[0]);
+    y_.push_back(pos[1]);
+    z_.push_back(pos[2]);
+    dirty_=true;
+  }
+
+  void Remove(const ITEM& item) {
+    for (size_t i=0; i<items_.size(); ++i) {
+      if (items_[i]==item) {
+        items_.erase(items_.begin()+i);
+        x_.erase(x_.begin()+i);
+        y_.erase(y_.begin()+i);
+        z_.erase(z_.begin()+i);
+        dirty_=true;
+        return;
+      }
+    }
+  }
+
+  /// \brief sort items by cell and set up the cell lookup table
+  ///
+  /// Called automatically by the queries, if needed.
+  void Build() const {
+    if (!dirty_) {
+      return;
+    }
+    size_t n=items_.size();
+    std::vector<boost::uint64_t> keys(n);
+    std::vector<size_t> perm(n);
+    for (size_t i=0; i<n; ++i) {
+      Index indx=gen_index(x_[i], y_[i], z_[i]);
+      keys[i]=gen_key(indx);
+      perm[i]=i;
+      if (i==0) {
+        min_=indx;
+        max_=indx;
+      } else {
+        min_=Index::Min(min_, indx);
+        max_=Index::Max(max_, indx);
+      }
+    }
+    // stable sort keeps the insertion order within a cell
+    std::stable_sort(perm.begin(), perm.end(), KeyLess(keys));
+    ItemList items;
+    items.reserve(n);
+    std::vector<Real> x(n), y(n), z(n);
+    cell_keys_.clear();
+    cell_begin_.clear();
+    for (size_t i=0; i<n; ++i) {
+      size_t j=perm[i];
+      items.push_back(items_[j]);
+      x[i]=x_[j];
+      y[i]=y_[j];
+      z[i]=z_[j];
+      if (cell_keys_.empty() || cell_keys_.back()!=keys[j]) {
+        cell_keys_.push_back(keys[j]);
+        cell_begin_.push_back(static_cast<boost::uint32_t>(i));
+      }
+    }
+    cell_begin_.push_back(static_cast<boost::uint32_t>(n));
+    items_.swap(items);
+    x_.swap(x);
+    y_.swap(y);
+    z_.swap(z);
+    this->build_table();
+    dirty_=false;
+  }
+
+  bool HasWithin(const VEC& pos, Real dist) const {
+    this->Build();
+    if (items_.empty()) {
+      return false;
+    }
+    Real dist2=dist*dist;
+    Real px=pos[0], py=pos[1], pz=pos[2];
+    Index imin=Index::Max(min_, gen_index(px-dist, py-dist, pz-dist));
+    Index imax=Index::Min(max_, gen_index(px+dist, py+dist, pz+dist));
+    if (imin.u>imax.u || imin.v>imax.v || imin.w>imax.w) {
+      return false;
+    }
+    if (this->num_query_cells(imin, imax)>cell_keys_.size()) {
+      return this->has_within_range(0, items_.size(), px, py, pz, dist2);
+    }
+    for(int wc=imin.w;wc<=imax.w;++wc) {
+      for(int vc=imin.v;vc<=imax.v;++vc) {
+        for(int uc=imin.u;uc<=imax.u;++uc) {
+          size_t c=this->find_cell(gen_key(Index(uc,vc,wc)));
+          if (c!=cell_keys_.size() &&
+              this->has_within_range(cell_begin_[c], cell_begin_[c+1],
+                                     px, py, pz, dist2)) {
+            return true;
+          }
+        }
+      }
+    }
+    return false;
+  }
+
+  ItemList FindWithin(const VEC& pos, Real dist) const {
+    this->Build();
+    ItemList item_list;
+    if (items_.empty()) {
+      return item_list;
+    }
+    Real dist2=dist*dist;
+    Real px=pos[0], py=pos[1], pz=pos[2];
+    Index imin=Index::Max(min_, gen_index(px-dist, py-dist, pz-dist));
+    Index imax=Index::Min(max_, gen_index(px+dist, py+dist, pz+dist));
+    if (imin.u>imax.u || imin.v>imax.v || imin.w>imax.w) {
+      return item_list;
+    }
+    // the items are sorted by (w,v,u), visiting all of them gives the same
+    // order as looping over the query cells.
+    if (this->num_query_cells(imin, imax)>cell_keys_.size()) {
+      this->find_within_range(0, items_.size(), px, py, pz, dist2, item_list);
+      return item_list;
+    }
+    for(int wc=imin.w;wc<=imax.w;++wc) {
+      for(int vc=imin.v;vc<=imax.v;++vc) {
+        for(int uc=imin.u;uc<=imax.u;++uc) {
+          size_t c=this->find_cell(gen_key(Index(uc,vc,wc)));
+          if (c!=cell_keys_.size()) {
+            this->find_within_range(cell_begin_[c], cell_begin_[c+1],
+                                    px, py, pz, dist2, item_list);
+          }
+        }
+      }
+    }
+    return item_list;
+  }
+
+  size_t GetSize() const { return items_.size(); }
+
+  void Clear()
+  {
+    items_.clear();
+    x_.clear();
+    y_.clear();
+    z_.clear();
+    cell_keys_.clear();
+    cell_begin_.clear();
+    table_keys_.clear();
+    table_cells_.clear();
+    dirty_=false;
+  }
+
+  void Swap(CellListOrganizer& o) {
+    items_.swap(o.items_);
+    x_.swap(o.x_);
+    y_.swap(o.y_);
+    z_.swap(o.z_);
+    cell_keys_.swap(o.cell_keys_);
+    cell_begin_.swap(o.cell_begin_);
+    table_keys_.swap(o.table_keys_);
+    table_cells_.swap(o.table_cells_);
+    std::swap(delta_,o.delta_);
+    std::swap(min_, o.min_);
+    std::swap(max_, o.max_);
+    std::swap(dirty_, o.dirty_);
+    std::swap(shift_, o.shift_);
+  }
+
+private:
+  struct KeyLess {
+    KeyLess(const std::vector<boost::uint64_t>& k): keys(k) {}
+    bool operator()(size_t a, size_t b) const { return keys[a]<keys[b]; }
+    const std::vector<boost::uint64_t>& keys;
+  };
+
+  bool has_within_range(size_t begin, size_t end, Real px, Real py, Real pz,
+                        Real dist2) const {
+    for (size_t i=begin; i<end; ++i) {
+      Real delta_x=x_[i]-px;
+      Real delta_y=y_[i]-py;
+      Real delta_z=z_[i]-pz;
+      if(delta_x*delta_x+delta_y*delta_y+delta_z*delta_z<=dist2) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void find_within_range(size_t begin, size_t end, Real px, Real py, Real pz,
+                         Real dist2, ItemList& item_list) const {
+    for (size_t i=begin; i<end; ++i) {
+      Real delta_x=x_[i]-px;
+      Real delta_y=y_[i]-py;
+      Real delta_z=z_[i]-pz;
+      if(delta_x*delta_x+delta_y*delta_y+delta_z*delta_z<=dist2) {
+        item_list.push_back(items_[i]);
+      }
+    }
+  }
+
+  size_t num_query_cells(const Index& imin, const Index& imax) const {
+    return size_t(imax.u-imin.u+1)*size_t(imax.v-imin.v+1)*
+           size_t(imax.w-imin.w+1);
+  }
+
+  void build_table() const {
+    size_t table_size=16;
+    int bits=4;
+    while (table_size<2*cell_keys_.size()) {
+      table_size<<=1;
+      ++bits;
+    }
+    shift_=64-bits;
+    table_keys_.assign(table_size, boost::uint64_t(kEmptyKey));
+    table_cells_.assign(table_size, 0);
+    size_t mask=table_size-1;
+    for (size_t c=0; c<cell_keys_.size(); ++c) {
+      size_t slot=this->hash(cell_keys_[c]);
+      while (table_keys_[slot]!=kEmptyKey) {
+        slot=(slot+1)&mask;
+      }
+      table_keys_[slot]=cell_keys_[c];
+      table_cells_[slot]=static_cast<boost::uint32_t>(c);
+    }
+  }
+
+  // returns the number of cells if the cell is not occupied
+  size_t find_cell(boost::uint64_t key) const {
+    size_t mask=table_keys_.size()-1;
+    for (size_t slot=this->hash(key); ; slot=(slot+1)&mask) {
+      if (table_keys_[slot]==key) {
+        return table_cells_[slot];
+      }
+      if (table_keys_[slot]==kEmptyKey) {
+        return cell_keys_.size();
+      }
+    }
+  }
+
+  size_t hash(boost::uint64_t key) const {
+    // fibonacci hashing
+    return static_cast<size_t>((key*0x9E3779B97F4A7C15ULL)>>shift_);
+  }
+
+  int gen_coord(Real x) const {
+    Real r=round(x/delta_);
+    if (r<-kIndexOffset) {
+      return -kIndexOffset;
+    }
+    if (r>kIndexOffset-1) {
+      return kIndexOffset-1;
+    }
+    return static_cast<int>(r);
+  }
+
+  Index gen_index(Real x, Real y, Real z) const {
+    Index nrvo(gen_coord(x), gen_coord(y), gen_coord(z));
+    return nrvo;
+  }
+
+  // keys sort lexicographically by (w,v,u), like the SpatialOrganizer::Index
+  static boost::uint64_t gen_key(const Index& i) {
+    return (boost::uint64_t(i.w+kIndexOffset)<<42) |
+           (boost::uint64_t(i.v+kIndexOffset)<<21) |
+           boost::uint64_t(i.u+kIndexOffset);
+  }
+
+  Real delta_;
+  mutable ItemList items_;
+  mutable std::vector<Real> x_;
+  mutable std::vector<Real> y_;
+  mutable std::vector<Real> z_;
+  mutable std::vector<boost::uint64_t> cell_keys_;
+  mutable std::vector<boost::uint32_t> cell_begin_;
+  mutable std::vector<boost::uint64_t> table_keys_;
+  mutable std::vector<boost::uint32_t> table_cells_;
+  mutable Index min_;
+  mutable Index max_;
+  mutable bool dirty_;
+  mutable int shift_;
+};
+
+}} // ns
+
+#endif
@@ -24,6 +24,8 @@
 #include <ost/geom/transform.hh>
 #include "atom_handle.hh"
 #include "xcs_editor.hh"
+#include "impl/atom_impl.hh"
+#include "impl/entity_impl.hh"
 #include "in_mem_coord_source.hh"
 #include "coord_source.hh"
 
@@ -36,7 +38,9 @@ CoordSource::CoordSource(const AtomHandleList& atoms):
   mutable_(false),
   atom_dict_(),
   delta_(1.0),
-  start_time_(0.0)
+  start_time_(0.0),
+  checked_layout_(static_cast<unsigned long>(-1)),
+  in_entity_order_(false)
 {
   if (!atoms_.empty()) {
     entity_=atoms_.front().GetEntity();
@@ -59,6 +63,10 @@ void CoordSource::CopyFrame(uint frame_id)
   }
   assert(frame->size()==atoms_.size());
   XCSEditor edi=atoms_.front().GetEntity().EditXCS(BUFFERED_EDIT);  
+  if (this->IsInEntityOrder()) {
+    edi.SetAtomPos(*frame);
+    return;
+  }
   CoordFrame::const_iterator c=frame->begin();
   for (AtomHandleList::iterator i=atoms_.begin(), 
        e=atoms_.end(); i!=e; ++i, ++c) {
@@ -71,9 +79,41 @@ int CoordSource::GetAtomCount() const
   return atoms_.size();
 }
 
+bool CoordSource::IsInEntityOrder()
+{
+  if (atoms_.empty() || !entity_.IsValid()) {
+    return false;
+  }
+  impl::EntityImplPtr ent=entity_.Impl();
+  if (static_cast<size_t>(ent->GetAtomCount())!=atoms_.size()) {
+    return false;
+  }
+  ent->CompactCoords();
+  unsigned long layout=ent->GetCoordBuffer()->GetLayoutVersion();
+  if (layout==checked_layout_) {
+    return in_entity_order_;
+  }
+  // after compaction, the slot of an atom is its index in the atom list
+  in_entity_order_=true;
+  for (size_t i=0; i<atoms_.size(); ++i) {
+    if (atoms_[i].Impl()->GetPosSlot()!=i) {
+      in_entity_order_=false;
+      break;
+    }
+  }
+  checked_layout_=layout;
+  return in_entity_order_;
+}
+
 void CoordSource::Capture()
 {
   std::vector<geom::Vec3> coords;
+  if (this->IsInEntityOrder()) {
+    const geom::Vec3* pos=entity_.GetAtomPosData();
+    coords.assign(pos, pos+atoms_.size());
+    this->AddFrame(coords);
+    return;
+  }
   coords.reserve(atoms_.size());
   for (AtomHandleList::const_iterator i=atoms_.begin(), 
        e=atoms_.end(); i!=e; ++i) {
@@ -92,11 +92,17 @@ public:
 protected:
   void SetMutable(bool flag);
 private:
+  // whether atoms_ holds all atoms of the entity in the order of the atom
+  // list. Frames can then be copied to and from the entity in one go.
+  bool IsInEntityOrder();
+
   AtomHandleList atoms_;
   EntityHandle   entity_;
   bool           mutable_;
   std::map<long,uint> atom_dict_;
   float delta_,start_time_;
+  unsigned long  checked_layout_;
+  bool           in_entity_order_;
 };
 
 }}
@@ -373,6 +373,11 @@ bool less_index(const mol::AtomHandle& a1, const mol::AtomHandle& a2)
 geom::Vec3List EntityHandle::GetAtomPosList(bool ordered_by_index) const {
   this->CheckValidity();
   geom::Vec3List atom_pos_list;
+  if (!ordered_by_index) {
+    const geom::Vec3* data=this->GetAtomPosData();
+    atom_pos_list.assign(data, data+this->GetAtomCount());
+    return atom_pos_list;
+  }
   atom_pos_list.reserve(this->GetAtomCount());
   AtomHandleList atom_list=this->GetAtomList();
   if (ordered_by_index){
@@ -383,6 +388,13 @@ geom::Vec3List EntityHandle::GetAtomPosList(bool ordered_by_index) const {
   }
   return atom_pos_list;
 }
+
+const geom::Vec3* EntityHandle::GetAtomPosData() const
+{
+  this->CheckValidity();
+  Impl()->CompactCoords();
+  return Impl()->GetCoordBuffer()->GetTransformedData();
+}
   
 EntityHandle EntityHandle::GetHandle() const
 {
@@ -257,6 +257,17 @@ public:
   
   /// \brief get complete list of atom positions
   geom::Vec3List GetAtomPosList(bool ordered_by_index = false) const;
+
+  /// \brief direct access to the atom positions
+  ///
+  /// Returns a pointer to the contiguous array of the transformed positions
+  /// of GetAtomCount() atoms, in the order of GetAtomList(). The atoms store
+  /// their positions in this array, no copy is made. The pointer is
+  /// invalidated when atoms are added, removed or reordered. Use the XCSEditor
+  /// to modify positions. The array is brought into atom list order under a
+  /// lock, so several threads may call this on an entity which isn't being
+  /// modified.
+  const geom::Vec3* GetAtomPosData() const;
   
   /// \brief Get editor for external coordinate system to manipulate atom 
   ///     positions
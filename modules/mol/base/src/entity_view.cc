@@ -36,6 +36,7 @@
 #include "bond_table.hh"
 #include "query_state.hh"
 #include "entity_property_mapper.hh"
+#include "neighbor_search.hh"
 
 #include "impl/entity_impl.hh"
 #include "impl/query_impl.hh"
@@ -799,16 +800,27 @@ EntityView EntityView::ExtendViewToSurrounding(Real gap) const
   this->CheckValidity();
   EntityView view=this->CreateEmptyView();
   AtomViewList atoms=this->GetAtomList();
-  AtomViewList::const_iterator atm_it;
+  AtomHandleList all_atoms=this->GetHandle().GetAtomList();
+  geom::Vec3List pos, all_pos;
+  pos.reserve(atoms.size());
+  for (AtomViewList::const_iterator i=atoms.begin(); i!=atoms.end(); ++i) {
+    pos.push_back(i->GetPos());
+  }
+  all_pos.reserve(all_atoms.size());
+  for (AtomHandleList::const_iterator i=all_atoms.begin(); 
+       i!=all_atoms.end(); ++i) {
+    all_pos.push_back(i->GetPos());
+  }
   Real max_dist=5+gap;
-  for (atm_it=atoms.begin(); atm_it!=atoms.end(); ++atm_it) {
-    view.AddAtom((*atm_it),mol::ViewAddFlag::INCLUDE_ALL|mol::ViewAddFlag::CHECK_DUPLICATES);
-    AtomHandleList prot_atoms=this->GetHandle().FindWithin((*atm_it).GetPos(),max_dist);
-    AtomHandleList::const_iterator protatm_it;
-    for (protatm_it=prot_atoms.begin(); protatm_it!=prot_atoms.end(); ++protatm_it){
-      Real dist=geom::Distance((*atm_it).GetPos(), (*protatm_it).GetPos());
-      if (dist <= (*atm_it).GetRadius() + (*protatm_it).GetRadius() + gap) {
-        view.AddAtom((*protatm_it),mol::ViewAddFlag::INCLUDE_ALL|mol::ViewAddFlag::CHECK_DUPLICATES);
+  NeighborPairList pairs=FindAllPairsWithin(pos, all_pos, max_dist);
+  NeighborPairList::const_iterator pair_it=pairs.begin();
+  for (size_t i=0; i<atoms.size(); ++i) {
+    view.AddAtom(atoms[i],mol::ViewAddFlag::INCLUDE_ALL|mol::ViewAddFlag::CHECK_DUPLICATES);
+    for (; pair_it!=pairs.end() && pair_it->first==i; ++pair_it) {
+      const AtomHandle& prot_atom=all_atoms[pair_it->second];
+      Real dist=std::sqrt(pair_it->dist2);
+      if (dist <= atoms[i].GetRadius() + prot_atom.GetRadius() + gap) {
+        view.AddAtom(prot_atom,mol::ViewAddFlag::INCLUDE_ALL|mol::ViewAddFlag::CHECK_DUPLICATES);
       }
     }
   }
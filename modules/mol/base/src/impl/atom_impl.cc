@@ -44,7 +44,8 @@ AtomImpl::AtomImpl(const EntityImplPtr& e,
                    unsigned long index):
   res_(r),
   name_(n),
-  pos_(p),
+  coords_(e->GetCoordBuffer()),
+  slot_(coords_->AllocSlot(this)),
   occupancy_(0.0),
   b_factor_(1.0),
   prop_(NULL),  
@@ -56,8 +57,8 @@ AtomImpl::AtomImpl(const EntityImplPtr& e,
   state_(0),
   index_(index)
 {
-  EntityImplPtr eip = GetEntity();
-  tf_pos_ = eip->HasTransform() ? eip->GetTransform().Apply(p) : p;
+  this->OriginalPos()=p;
+  this->TransformedPos()=e->HasTransform() ? e->GetTransform().Apply(p) : p;
   prop_=AtomProp::GetDefaultProps(element_);
 }
 
@@ -170,7 +171,7 @@ void AtomImpl::UpdateFromICS()
       if (atom.get()==this || atom->IsVisited()==true) {
         continue;
       }
-      atom->pos_=pos_+total_rot_*((*i)->GetDir()*(*i)->GetLength());
+      atom->OriginalPos()=this->OriginalPos()+total_rot_*((*i)->GetDir()*(*i)->GetLength());
       atom->total_rot_=total_rot_*(*i)->GetLocalRot();
     }
     (*i)->GetSecond()->UpdateFromICS();
@@ -207,6 +208,7 @@ void AtomImpl::UpdateFromXCS()
 }
 
 AtomImpl::~AtomImpl() {
+  coords_->FreeSlot(slot_);
   if (prop_ && !prop_->is_default) {
     delete prop_;
     prop_=NULL;
@@ -323,11 +325,11 @@ Real AtomImpl::GetFloatProperty(Prop::ID prop_id) const
 {
   switch (prop_id) {
     case Prop::AX:
-      return pos_[0];
+      return this->OriginalPos()[0];
     case Prop::AY:
-      return pos_[1];
+      return this->OriginalPos()[1];
     case Prop::AZ:
-      return pos_[2];            
+      return this->OriginalPos()[2];            
     case Prop::OCC:
       return occupancy_;
     case Prop::ABFAC:
@@ -25,6 +25,7 @@
 #include <ost/geom/geom.hh>
 #include <ost/mol/entity_visitor_fw.hh>
 #include <ost/mol/impl/atom_prop.hh>
+#include <ost/mol/impl/coord_buffer.hh>
 
 #include <ost/mol/impl/atom_impl_fw.hh>
 #include <ost/mol/impl/residue_impl_fw.hh>
@@ -65,11 +66,17 @@ public:
   // DEPRECATED
   const String& GetName() const {return name_;}
 
-  const geom::Vec3& TransformedPos() const {return tf_pos_;}
-  geom::Vec3& TransformedPos() {return tf_pos_;}
+  // the positions are stored in the coordinate buffer of the entity. The
+  // references are invalidated when atoms are added to or removed from the
+  // entity.
+  const geom::Vec3& TransformedPos() const {return coords_->Transformed(slot_);}
+  geom::Vec3& TransformedPos() {return coords_->Transformed(slot_);}
 
-  const geom::Vec3& OriginalPos() const {return pos_;}
-  geom::Vec3& OriginalPos() {return pos_;}
+  const geom::Vec3& OriginalPos() const {return coords_->Original(slot_);}
+  geom::Vec3& OriginalPos() {return coords_->Original(slot_);}
+
+  unsigned int GetPosSlot() const {return slot_;}
+  void SetPosSlot(unsigned int slot) {slot_=slot;}
 
   ResidueImplPtr GetResidue() const;
 
@@ -223,8 +230,8 @@ public:
 private:
   ResidueImplW res_;
   String       name_;
-  geom::Vec3   pos_;
-  geom::Vec3   tf_pos_;
+  CoordBufferPtr coords_;
+  unsigned int slot_;
   Real         occupancy_;
   Real         b_factor_;
   AtomProp*    prop_;
@@ -545,6 +545,7 @@ void ChainImpl::ReorderResidues()
 {
   std::sort(residue_list_.begin(),residue_list_.end(),rnum_cmp);
   UpdateShifts();
+  this->GetEntity()->GetCoordBuffer()->MarkLayoutDirty();
 }
 
 void ChainImpl::RenumberAllResidues(int start, bool keep_spacing)
@@ -0,0 +1,80 @@
+//------------------------------------------------------------------------------
+// This file is part of the OpenStructure project <www.openstructure.org>
+//
+// Copyright (C) 2008-2020 by the OpenStructure authors
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 3.0 of the License, or (at your option)
+// any later version.
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//------------------------------------------------------------------------------
+#include <ost/mol/impl/atom_impl.hh>
+#include "coord_buffer.hh"
+
+namespace ost { namespace mol { namespace impl {
+
+unsigned int CoordBuffer::AllocSlot(AtomImpl* atom)
+{
+  this->MarkLayoutDirty();
+  if (!free_slots_.empty()) {
+    unsigned int slot=free_slots_.back();
+    free_slots_.pop_back();
+    atoms_[slot]=atom;
+    return slot;
+  }
+  original_.push_back(geom::Vec3());
+  transformed_.push_back(geom::Vec3());
+  atoms_.push_back(atom);
+  return atoms_.size()-1;
+}
+
+void CoordBuffer::FreeSlot(unsigned int slot)
+{
+  this->MarkLayoutDirty();
+  atoms_[slot]=NULL;
+  free_slots_.push_back(slot);
+}
+
+void CoordBuffer::Compact(const AtomImplList& atoms)
+{
+  size_t num_alive=atoms_.size()-free_slots_.size();
+  std::vector<geom::Vec3> original, transformed;
+  std::vector<AtomImpl*> new_atoms;
+  original.reserve(num_alive);
+  transformed.reserve(num_alive);
+  new_atoms.reserve(num_alive);
+  std::vector<char> moved(atoms_.size(), 0);
+  for (AtomImplList::const_iterator i=atoms.begin(), e=atoms.end(); i!=e; ++i) {
+    unsigned int slot=(*i)->GetPosSlot();
+    original.push_back(original_[slot]);
+    transformed.push_back(transformed_[slot]);
+    new_atoms.push_back(i->get());
+    moved[slot]=1;
+  }
+  for (size_t slot=0; slot<atoms_.size(); ++slot) {
+    if (atoms_[slot] && !moved[slot]) {
+      original.push_back(original_[slot]);
+      transformed.push_back(transformed_[slot]);
+      new_atoms.push_back(atoms_[slot]);
+    }
+  }
+  for (size_t slot=0; slot<new_atoms.size(); ++slot) {
+    new_atoms[slot]->SetPosSlot(slot);
+  }
+  original_.swap(original);
+  transformed_.swap(transformed);
+  atoms_.swap(new_atoms);
+  free_slots_.clear();
+  ++layout_version_;
+  compact_=true;
+}
+
+}}} // ns
@@ -0,0 +1,102 @@
+//------------------------------------------------------------------------------
+// This file is part of the OpenStructure project <www.openstructure.org>
+//
+// Copyright (C) 2008-2020 by the OpenStructure authors
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 3.0 of the License, or (at your option)
+// any later version.
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//------------------------------------------------------------------------------
+#ifndef OST_COORD_BUFFER_HH
+#define OST_COORD_BUFFER_HH
+
+#include <vector>
+#include <boost/shared_ptr.hpp>
+
+#include <ost/mol/module_config.hh>
+#include <ost/geom/vec3.hh>
+#include <ost/mol/impl/atom_impl_fw.hh>
+
+namespace ost { namespace mol { namespace impl {
+
+/// \brief contiguous storage of the atom positions of an entity
+///
+/// Every atom owns a slot in the buffer, which holds its original and its
+/// transformed position. Slots of deleted atoms are reused. Compact() moves
+/// the positions into the order of the atom list, such that the positions
+/// of all atoms can be read or written as one array.
+/// \internal
+class DLLEXPORT_OST_MOL CoordBuffer {
+public:
+  CoordBuffer(): compact_(true), layout_version_(0) {}
+
+  unsigned int AllocSlot(AtomImpl* atom);
+
+  void FreeSlot(unsigned int slot);
+
+  geom::Vec3& Original(unsigned int slot) { return original_[slot]; }
+  const geom::Vec3& Original(unsigned int slot) const
+  {
+    return original_[slot];
+  }
+
+  geom::Vec3& Transformed(unsigned int slot) { return transformed_[slot]; }
+  const geom::Vec3& Transformed(unsigned int slot) const
+  {
+    return transformed_[slot];
+  }
+
+  geom::Vec3* GetOriginalData()
+  {
+    return original_.empty() ? NULL : &original_[0];
+  }
+  geom::Vec3* GetTransformedData()
+  {
+    return transformed_.empty() ? NULL : &transformed_[0];
+  }
+
+  /// \brief number of slots, including free ones
+  size_t GetSize() const { return atoms_.size(); }
+
+  /// \brief move positions of atoms to the front, in the given order
+  ///
+  /// Atoms which are not in the list, but still alive, e.g. deleted atoms
+  /// referenced by a handle, are moved behind them.
+  void Compact(const AtomImplList& atoms);
+
+  /// \brief whether the layout matches the last call to Compact()
+  bool IsCompact() const { return compact_; }
+
+  /// \brief to be called when the order of the atoms changes
+  void MarkLayoutDirty()
+  {
+    compact_=false;
+    ++layout_version_;
+  }
+
+  /// \brief changes whenever atoms move to other slots
+  unsigned long GetLayoutVersion() const { return layout_version_; }
+
+private:
+  std::vector<geom::Vec3>   original_;
+  std::vector<geom::Vec3>   transformed_;
+  std::vector<AtomImpl*>    atoms_;
+  std::vector<unsigned int> free_slots_;
+  bool                      compact_;
+  unsigned long             layout_version_;
+};
+
+typedef boost::shared_ptr<CoordBuffer> CoordBufferPtr;
+
+}}} // ns
+
+#endif
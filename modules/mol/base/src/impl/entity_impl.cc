@@ -20,6 +20,7 @@
 #include <sys/time.h>
 #endif
 #include <map>
+#include <algorithm>
 
 #include <boost/shared_ptr.hpp>
 #include <boost/version.hpp>
@@ -76,9 +77,14 @@ EntityImpl::EntityImpl():
   xcs_editor_count_(0),
   ics_editor_count_(0),  
   dirty_flags_(DisableICS),
+  coord_version_(0),
   name_(""),
   next_index_(0L),
-  default_query_flags_(0)
+  default_query_flags_(0),
+  atom_props_(new GenericPropTable),
+  residue_props_(new GenericPropTable),
+  chain_props_(new GenericPropTable),
+  coords_(new CoordBuffer)
 {    
 }
 
@@ -302,23 +308,30 @@ Real EntityImpl::GetMass() const {
 
 AtomImplPtr EntityImpl::CreateAtom(const ResidueImplPtr& rp,
                                    const String& name,
-                                   const geom::Vec3& pos2,
+                                   const geom::Vec3& pos,
                                    const String& ele)
 {
+  // pos may refer to the position of another atom, which moves when the
+  // coordinate buffer grows.
+  geom::Vec3 pos2=pos;
 #if MAKE_SHARED_AVAILABLE
   AtomImplPtr ap=boost::make_shared<AtomImpl>(shared_from_this(), rp, name, 
                                               pos2, ele,next_index_++);
 #else
   AtomImplPtr ap(new AtomImpl(shared_from_this(), rp, name, pos2, ele, next_index_++));
 #endif
-  geom::Vec3 pos = has_transform_ ? transform_.Apply(pos2) : pos2;
-  ap->TransformedPos()=pos;
-  atom_organizer_.Add(ap,pos);
+  ap->SetPropTable(atom_props_);
+  geom::Vec3 tf_pos = has_transform_ ? transform_.Apply(pos2) : pos2;
+  ap->TransformedPos()=tf_pos;
+  atom_organizer_.Add(ap,tf_pos);
   atom_map_.insert(AtomImplMap::value_type(ap.get(),ap));
   return ap;
 }
 
 void EntityImpl::DeleteAtom(const AtomImplPtr& atom) {
+  // the slot of the atom is only freed once the last handle is gone, but the
+  // atom list changes right away
+  coords_->MarkLayoutDirty();
   atom_map_.erase(atom.get());
   atom_organizer_.Remove(atom);
 }
@@ -327,10 +340,12 @@ ResidueImplPtr EntityImpl::CreateResidue(const ChainImplPtr& cp,
                                        const ResNum& n,
                                        const ResidueKey& k) {
 #if MAKE_SHARED_AVAILABLE
-  return boost::make_shared<ResidueImpl>(shared_from_this(), cp, n, k);
+  ResidueImplPtr rp=boost::make_shared<ResidueImpl>(shared_from_this(), cp, n, k);
 #else
-  return ResidueImplPtr(new ResidueImpl(shared_from_this(), cp, n, k));
+  ResidueImplPtr rp(new ResidueImpl(shared_from_this(), cp, n, k));
 #endif  
+  rp->SetPropTable(residue_props_);
+  return rp;
 }
 
 ChainImplPtr EntityImpl::InsertChain(const String& cname)
@@ -347,6 +362,7 @@ ChainImplPtr EntityImpl::InsertChain(const String& cname)
 #else
   ChainImplPtr cp(new ChainImpl(shared_from_this(), cname));
 #endif
+  cp->SetPropTable(chain_props_);
   chain_list_.push_back(cp);
   return cp;
 }
@@ -757,9 +773,8 @@ void EntityImpl::ClearTransform()
 void EntityImpl::FixTransform()
 {
   if(!has_transform_) return;
-  for(AtomImplMap::iterator it = atom_map_.begin();it!=atom_map_.end();++it) {
-    it->second->OriginalPos()=it->second->TransformedPos();
-  }
+  const geom::Vec3* tf_pos=coords_->GetTransformedData();
+  std::copy(tf_pos, tf_pos+coords_->GetSize(), coords_->GetOriginalData());
   transform_=geom::Transform();
   has_transform_=false;
   this->UpdateTransformedPos();
@@ -798,6 +813,30 @@ void EntityImpl::Swap(EntityImpl& impl)
   atom_organizer_.Swap(impl.atom_organizer_);
   fragment_list_.swap(impl.fragment_list_);
   observer_map_.swap(impl.observer_map_);
+  atom_props_.swap(impl.atom_props_);
+  residue_props_.swap(impl.residue_props_);
+  chain_props_.swap(impl.chain_props_);
+  coords_.swap(impl.coords_);
+}
+
+void EntityImpl::CompactCoords()
+{
+  boost::mutex::scoped_lock lock(coords_mutex_);
+  if (coords_->IsCompact()) {
+    return;
+  }
+  AtomImplList atoms;
+  atoms.reserve(atom_map_.size());
+  for (ChainImplList::const_iterator i=chain_list_.begin(),
+       e1=chain_list_.end(); i!=e1; ++i) {
+    const ResidueImplList& residues=(*i)->GetResidueList();
+    for (ResidueImplList::const_iterator j=residues.begin(),
+         e2=residues.end(); j!=e2; ++j) {
+      const AtomImplList& res_atoms=(*j)->GetAtomList();
+      atoms.insert(atoms.end(), res_atoms.begin(), res_atoms.end());
+    }
+  }
+  coords_->Compact(atoms);
 }
 
 
@@ -1071,12 +1110,14 @@ void EntityImpl::UpdateXCSIfNeeded()
     LOG_VERBOSE("XCS marked dirty. Updating");
     this->UpdateFromICS();
     dirty_flags_&=~DirtyXCS;
+    ++coord_version_;
   }
 }
 
 void EntityImpl::MarkXCSDirty() 
 {
   dirty_flags_|=DirtyXCS|DirtyOrganizer;
+  ++coord_version_;
 }
 
 void EntityImpl::MarkICSDirty()
@@ -1092,6 +1133,7 @@ void EntityImpl::MarkTraceDirty()
 void EntityImpl::MarkOrganizerDirty()
 {
     dirty_flags_|=DirtyOrganizer;
+    ++coord_version_;
 }
 
 void EntityImpl::EnableICS()
@@ -1190,8 +1232,17 @@ void EntityImpl::RenameChain(ChainImplPtr chain, const String& new_name)
 }
 
 void EntityImpl::UpdateTransformedPos(){
-  for(AtomImplMap::iterator it = atom_map_.begin();it!=atom_map_.end();++it) {
-    it->second->TransformedPos()=has_transform_ ? transform_.Apply(it->second->OriginalPos()) : it->second->OriginalPos();
+  // sweep over the coordinate buffer instead of chasing atom pointers. Free
+  // slots are transformed as well, which does not hurt.
+  const geom::Vec3* pos=coords_->GetOriginalData();
+  geom::Vec3* tf_pos=coords_->GetTransformedData();
+  size_t num_slots=coords_->GetSize();
+  if (has_transform_) {
+    for (size_t i=0; i<num_slots; ++i) {
+      tf_pos[i]=transform_.Apply(pos[i]);
+    }
+  } else {
+    std::copy(pos, pos+num_slots, tf_pos);
   }
   for(ChainImplList::iterator cit=chain_list_.begin();cit!=chain_list_.end();++cit) {
     (*cit)->UpdateTransformedPos();
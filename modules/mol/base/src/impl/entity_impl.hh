@@ -23,6 +23,7 @@
 #include <vector>
 
 #include <boost/enable_shared_from_this.hpp>
+#include <boost/thread/mutex.hpp>
 
 #include <ost/mol/module_config.hh>
 #include <ost/geom/geom.hh>
@@ -33,6 +34,7 @@
 
 #include <ost/mol/residue_prop.hh>
 #include <ost/mol/impl/atom_impl_fw.hh>
+#include <ost/mol/impl/coord_buffer.hh>
 #include <ost/mol/impl/residue_impl_fw.hh>
 #include <ost/mol/impl/chain_impl_fw.hh>
 #include <ost/mol/impl/connector_impl_fw.hh>
@@ -43,7 +45,7 @@
 #include <ost/mol/entity_observer_fw.hh>
 #include <ost/mol/entity_view.hh>
 #include <ost/mol/entity_handle.hh>
-#include <ost/mol/spatial_organizer.hh>
+#include <ost/mol/cell_list_organizer.hh>
 
 
 #include <ost/generic_property.hh>
@@ -65,7 +67,7 @@ typedef std::vector<FragmentImplP> FragmentImplList;
 /// \internal
 typedef std::map<EntityObserver*,EntityObserverPtr> EntityObserverMap;
 /// \internal
-typedef SpatialOrganizer<AtomImplPtr> SpatialAtomOrganizer;
+typedef CellListOrganizer<AtomImplPtr> SpatialAtomOrganizer;
 
 /// \internal
 typedef enum {
@@ -239,6 +241,11 @@ public:
   void MarkTraceDirty();
   void MarkOrganizerDirty();
 
+  /// \brief counter which is incremented whenever atom positions change
+  ///
+  /// Allows to detect whether data derived from the positions is outdated.
+  unsigned long GetCoordVersion() const { return coord_version_; }
+
   void UpdateTransformedPos();
 
   const String& GetName() const;
@@ -254,6 +261,30 @@ public:
 
   void RenumberChain(const String& name, int start, bool keep_spacing);
 
+  /// \brief columnar storage of the generic properties of all atoms
+  const GenericPropTablePtr& GetAtomPropTable() const { return atom_props_; }
+
+  const GenericPropTablePtr& GetResiduePropTable() const 
+  { 
+    return residue_props_; 
+  }
+
+  const GenericPropTablePtr& GetChainPropTable() const 
+  { 
+    return chain_props_; 
+  }
+
+  /// \brief contiguous storage of the positions of all atoms
+  const CoordBufferPtr& GetCoordBuffer() const { return coords_; }
+
+  /// \brief order the coordinate buffer like the atom list
+  ///
+  /// Afterwards, the first GetAtomCount() slots of the buffer hold the
+  /// positions of the atoms in the order of the atom list. Does nothing if
+  /// the buffer is already in that order. Guarded by a lock, such that
+  /// several threads may read the positions of an unmodified entity.
+  void CompactCoords();
+
 private:
   void DoCopy(EntityImplPtr dest);
   
@@ -276,12 +307,22 @@ private:
   int xcs_editor_count_;
   int ics_editor_count_;
   int dirty_flags_;
+  unsigned long coord_version_;
   String name_;
 
   unsigned long next_index_;
 
   QueryFlags default_query_flags_;
 
+  // generic properties of atoms, residues and chains are stored per entity
+  // and property name instead of in one map per object
+  GenericPropTablePtr atom_props_;
+  GenericPropTablePtr residue_props_;
+  GenericPropTablePtr chain_props_;
+
+  CoordBufferPtr coords_;
+  boost::mutex   coords_mutex_;
+
   template <bool always_true>
   EntityView do_selection(const EntityHandle&, const Query&, QueryFlags) const;
 };
@@ -174,8 +174,9 @@ AtomImplPtr ResidueImpl::InsertAltAtom(const String& name,
                                        const geom::Vec3& pos,
                                        const String& ele,
                                        Real occupancy, Real b_factor) {
-  AtomImplPtr atom=this->InsertAtom(name, pos, ele);
-  this->AddAltAtom(alt_group, atom, pos, occupancy, b_factor);
+  geom::Vec3 alt_pos=pos;
+  AtomImplPtr atom=this->InsertAtom(name, alt_pos, ele);
+  this->AddAltAtom(alt_group, atom, alt_pos, occupancy, b_factor);
   return atom;
 }
 
@@ -33,4 +33,5 @@
 #include <ost/mol/atom_view.hh>
 #include <ost/mol/xcs_editor.hh>
 #include <ost/mol/ics_editor.hh>
+#include <ost/mol/neighbor_search.hh>
 #endif
@@ -0,0 +1,263 @@
+//------------------------------------------------------------------------------
+// This file is part of the OpenStructure project <www.openstructure.org>
+//
+// Copyright (C) 2008-2020 by the OpenStructure authors
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 3.0 of the License, or (at your option)
+// any later version.
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//------------------------------------------------------------------------------
+#include <algorithm>
+#include <cmath>
+#include <boost/thread.hpp>
+#include <ost/message.hh>
+#include <ost/mol/atom_view.hh>
+#include "neighbor_search.hh"
+
+namespace ost { namespace mol {
+
+namespace {
+
+// dense cell grid spanning the bounding box of a set of points. The indices of
+// the points are sorted by cell, the coordinates are stored in the same order
+// to keep the inner loop on contiguous memory.
+class CellGrid {
+public:
+  CellGrid(const geom::Vec3List& pos, Real cutoff)
+  {
+    min_=pos[0];
+    geom::Vec3 max=pos[0];
+    for (size_t i=1; i<pos.size(); ++i) {
+      min_=geom::Min(min_, pos[i]);
+      max=geom::Max(max, pos[i]);
+    }
+    // a cell size of at least the cutoff guarantees that all neighbours are
+    // in the adjacent cells. For sparse point clouds, the cells are enlarged to
+    // keep the grid in the order of the number of points.
+    cell_size_=std::max(cutoff, Real(1e-3));
+    size_t max_cells=std::max(size_t(8*pos.size()), size_t(4096));
+    while (true) {
+      for (int k=0; k<3; ++k) {
+        dims_[k]=static_cast<int>(std::floor((max[k]-min_[k])/cell_size_))+1;
+      }
+      if (size_t(dims_[0])*size_t(dims_[1])*size_t(dims_[2])<=max_cells) {
+        break;
+      }
+      cell_size_*=Real(1.5);
+    }
+    size_t num_cells=size_t(dims_[0])*size_t(dims_[1])*size_t(dims_[2]);
+    std::vector<unsigned int> cell_of_point(pos.size());
+    cell_begin_.assign(num_cells+1, 0);
+    for (size_t i=0; i<pos.size(); ++i) {
+      int c[3];
+      for (int k=0; k<3; ++k) {
+        c[k]=std::min(dims_[k]-1,
+                      static_cast<int>((pos[i][k]-min_[k])/cell_size_));
+      }
+      cell_of_point[i]=(c[2]*dims_[1]+c[1])*dims_[0]+c[0];
+      ++cell_begin_[cell_of_point[i]+1];
+    }
+    for (size_t c=0; c<num_cells; ++c) {
+      cell_begin_[c+1]+=cell_begin_[c];
+    }
+    // counting sort, keeps the points sorted by index within a cell
+    std::vector<unsigned int> fill(cell_begin_.begin(), cell_begin_.end()-1);
+    index_.resize(pos.size());
+    x_.resize(pos.size());
+    y_.resize(pos.size());
+    z_.resize(pos.size());
+    for (size_t i=0; i<pos.size(); ++i) {
+      unsigned int j=fill[cell_of_point[i]]++;
+      index_[j]=i;
+      x_[j]=pos[i][0];
+      y_[j]=pos[i][1];
+      z_[j]=pos[i][2];
+    }
+  }
+
+  // appends all points within cutoff of p to pairs, sorted by index. Only
+  // points with an index of at least min_index are considered.
+  void FindWithin(const geom::Vec3& p, Real cutoff, Real cutoff2,
+                  unsigned int first, unsigned int min_index,
+                  NeighborPairList& pairs) const
+  {
+    int cmin[3], cmax[3];
+    for (int k=0; k<3; ++k) {
+      cmin[k]=this->ClampedCell(k, p[k]-cutoff);
+      cmax[k]=this->ClampedCell(k, p[k]+cutoff);
+      if (cmin[k]>cmax[k] || cmax[k]<0 || cmin[k]>=dims_[k]) {
+        return;
+      }
+      cmin[k]=std::max(0, cmin[k]);
+      cmax[k]=std::min(dims_[k]-1, cmax[k]);
+    }
+    Real px=p[0], py=p[1], pz=p[2];
+    size_t start=pairs.size();
+    for (int w=cmin[2]; w<=cmax[2]; ++w) {
+      for (int v=cmin[1]; v<=cmax[1]; ++v) {
+        size_t row=(size_t(w)*dims_[1]+v)*dims_[0];
+        // the cells of a row are contiguous in memory
+        for (unsigned int j=cell_begin_[row+cmin[0]],
+             e=cell_begin_[row+cmax[0]+1]; j<e; ++j) {
+          Real dx=x_[j]-px;
+          Real dy=y_[j]-py;
+          Real dz=z_[j]-pz;
+          Real d2=dx*dx+dy*dy+dz*dz;
+          if (d2<=cutoff2 && index_[j]>=min_index) {
+            pairs.push_back(NeighborPair(first, index_[j], d2));
+          }
+        }
+      }
+    }
+    std::sort(pairs.begin()+start, pairs.end(), less_second);
+  }
+
+private:
+  // cell index along axis k, clamped to [-1, dims] to avoid overflows for
+  // far-away points
+  int ClampedCell(int k, Real x) const
+  {
+    Real c=std::floor((x-min_[k])/cell_size_);
+    return static_cast<int>(std::max(Real(-1), std::min(Real(dims_[k]), c)));
+  }
+
+  static bool less_second(const NeighborPair& a, const NeighborPair& b)
+  {
+    return a.second<b.second;
+  }
+
+  geom::Vec3                min_;
+  Real                      cell_size_;
+  int                       dims_[3];
+  std::vector<unsigned int> cell_begin_;
+  std::vector<unsigned int> index_;
+  std::vector<Real>         x_;
+  std::vector<Real>         y_;
+  std::vector<Real>         z_;
+};
+
+struct find_pairs_mt {
+  find_pairs_mt(const CellGrid& g, const geom::Vec3List& p, Real c,
+                bool s, size_t b, size_t e, NeighborPairList& r):
+    grid(g), pos(p), cutoff(c), self(s), begin(b), end(e), result(r)
+  { }
+
+  void operator()() {
+    Real cutoff2=cutoff*cutoff;
+    for (size_t i=begin; i<end; ++i) {
+      grid.FindWithin(pos[i], cutoff, cutoff2, i, self ? i+1 : 0, result);
+    }
+  }
+
+  const CellGrid&       grid;
+  const geom::Vec3List& pos;
+  Real                  cutoff;
+  bool                  self;
+  size_t                begin;
+  size_t                end;
+  NeighborPairList&     result;
+};
+
+// the cell grid needs a finite bounding box, NaN or infinite coordinates
+// would never give a grid of bounded size
+void check_finite(const geom::Vec3List& pos)
+{
+  for (geom::Vec3List::const_iterator i=pos.begin(), e=pos.end(); i!=e; ++i) {
+    if (!std::isfinite((*i)[0]) || !std::isfinite((*i)[1]) ||
+        !std::isfinite((*i)[2])) {
+      throw Error("FindAllPairsWithin: coordinates must be finite");
+    }
+  }
+}
+
+NeighborPairList find_pairs(const geom::Vec3List& pos_a,
+                            const geom::Vec3List& pos_b,
+                            Real cutoff, bool self, int num_threads)
+{
+  NeighborPairList pairs;
+  if (pos_a.empty() || pos_b.empty() || !(cutoff>=0.0)) {
+    return pairs;
+  }
+  check_finite(pos_a);
+  if (!self) {
+    check_finite(pos_b);
+  }
+  CellGrid grid(pos_b, cutoff);
+  if (num_threads<=1 || pos_a.size()<size_t(2*num_threads)) {
+    find_pairs_mt(grid, pos_a, cutoff, self, 0, pos_a.size(), pairs)();
+    return pairs;
+  }
+  // each thread works on a contiguous chunk of pos_a. Concatenating the
+  // chunks gives the same result as the single-threaded search.
+  std::vector<NeighborPairList> chunks(num_threads);
+  size_t chunk_size=(pos_a.size()+num_threads-1)/num_threads;
+  boost::thread_group tg;
+  for (int i=0; i<num_threads; ++i) {
+    size_t begin=std::min(pos_a.size(), i*chunk_size);
+    size_t end=std::min(pos_a.size(), (i+1)*chunk_size);
+    tg.create_thread(find_pairs_mt(grid, pos_a, cutoff, self, begin, end,
+                                   chunks[i]));
+  }
+  tg.join_all();
+  size_t total=0;
+  for (int i=0; i<num_threads; ++i) {
+    total+=chunks[i].size();
+  }
+  pairs.reserve(total);
+  for (int i=0; i<num_threads; ++i) {
+    pairs.insert(pairs.end(), chunks[i].begin(), chunks[i].end());
+  }
+  return pairs;
+}
+
+geom::Vec3List atom_positions(const EntityView& view)
+{
+  AtomViewList atoms=view.GetAtomList();
+  geom::Vec3List pos;
+  pos.reserve(atoms.size());
+  for (AtomViewList::const_iterator i=atoms.begin(), e=atoms.end(); i!=e; ++i) {
+    pos.push_back(i->GetPos());
+  }
+  return pos;
+}
+
+}
+
+NeighborPairList FindAllPairsWithin(const geom::Vec3List& pos_a,
+                                    const geom::Vec3List& pos_b,
+                                    Real cutoff, int num_threads)
+{
+  return find_pairs(pos_a, pos_b, cutoff, false, num_threads);
+}
+
+NeighborPairList FindAllPairsWithin(const geom::Vec3List& pos, Real cutoff,
+                                    int num_threads)
+{
+  return find_pairs(pos, pos, cutoff, true, num_threads);
+}
+
+NeighborPairList FindAllPairsWithin(const EntityView& view_a,
+                                    const EntityView& view_b,
+                                    Real cutoff, int num_threads)
+{
+  return find_pairs(atom_positions(view_a), atom_positions(view_b), cutoff,
+                    false, num_threads);
+}
+
+NeighborPairList FindAllPairsWithin(const EntityView& view, Real cutoff,
+                                    int num_threads)
+{
+  geom::Vec3List pos=atom_positions(view);
+  return find_pairs(pos, pos, cutoff, true, num_threads);
+}
+
+}} // ns
@@ -0,0 +1,91 @@
+//------------------------------------------------------------------------------
+// This file is part of the OpenStructure project <www.openstructure.org>
+//
+// Copyright (C) 2008-2020 by the OpenStructure authors
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 3.0 of the License, or (at your option)
+// any later version.
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//------------------------------------------------------------------------------
+#ifndef OST_MOL_NEIGHBOR_SEARCH_HH
+#define OST_MOL_NEIGHBOR_SEARCH_HH
+
+#include <vector>
+#include <ost/geom/geom.hh>
+#include <ost/mol/module_config.hh>
+#include <ost/mol/entity_view.hh>
+
+namespace ost { namespace mol {
+
+/// \brief pair of points/atoms within a distance cutoff
+///
+/// first and second are indices into the first and second list of points
+/// (or atom lists of the views) passed to FindAllPairsWithin.
+struct DLLEXPORT_OST_MOL NeighborPair {
+  NeighborPair(): first(0), second(0), dist2(0.0) { }
+  NeighborPair(unsigned int f, unsigned int s, Real d2):
+    first(f), second(s), dist2(d2) { }
+
+  bool operator==(const NeighborPair& rhs) const {
+    return first==rhs.first && second==rhs.second && dist2==rhs.dist2;
+  }
+  bool operator!=(const NeighborPair& rhs) const { return !(*this==rhs); }
+
+  unsigned int first;
+  unsigned int second;
+  /// squared distance between the two points
+  Real dist2;
+};
+
+typedef std::vector<NeighborPair> NeighborPairList;
+
+/// \brief find all pairs of points in \p pos_a and \p pos_b that are at most
+///     \p cutoff apart
+///
+/// The pairs are determined in a single pass over a cell grid built for
+/// \p pos_b. They are sorted by first, then by second index and the result
+/// does not depend on the number of threads.
+///
+/// \throws Error if any of the coordinates is NaN or infinite
+NeighborPairList DLLEXPORT_OST_MOL
+FindAllPairsWithin(const geom::Vec3List& pos_a, const geom::Vec3List& pos_b,
+                   Real cutoff, int num_threads=1);
+
+/// \brief find all pairs i<j of points in \p pos that are at most \p cutoff
+///     apart
+NeighborPairList DLLEXPORT_OST_MOL
+FindAllPairsWithin(const geom::Vec3List& pos, Real cutoff, int num_threads=1);
+
+/// \brief find all pairs of atoms in \p view_a and \p view_b that are at most
+///     \p cutoff apart
+///
+/// The indices refer to the atom lists as returned by
+/// EntityView::GetAtomList(). Pairs of an atom with itself are included if the
+/// atom is part of both views.
+///
+/// \relates EntityView
+NeighborPairList DLLEXPORT_OST_MOL
+FindAllPairsWithin(const EntityView& view_a, const EntityView& view_b,
+                   Real cutoff, int num_threads=1);
+
+/// \brief find all pairs of distinct atoms in \p view that are at most
+///     \p cutoff apart.
+///
+/// Only pairs with first<second are returned.
+///
+/// \relates EntityView
+NeighborPairList DLLEXPORT_OST_MOL
+FindAllPairsWithin(const EntityView& view, Real cutoff, int num_threads=1);
+
+}} // ns
+
+#endif
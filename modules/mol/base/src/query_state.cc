@@ -36,7 +36,7 @@ struct LazilyBoundRef {
   LazilyBoundRef(): points(5.0) { }
   LazilyBoundRef& operator=(const LazilyBoundRef& rhs);
   // Stores the points in the lazily bound reference for efficient within calculation.
-  SpatialOrganizer<bool> points;
+  CellListOrganizer<bool> points;
 };
   
 struct LazilyBoundData {
@@ -44,7 +44,7 @@ struct LazilyBoundData {
 };
 
 
-void add_points_to_organizer(SpatialOrganizer<bool>& org, const EntityView& view) {
+void add_points_to_organizer(CellListOrganizer<bool>& org, const EntityView& view) {
   for (ChainViewList::const_iterator ci = view.GetChainList().begin(),
        ce = view.GetChainList().end(); ci != ce; ++ci) {
     for (ResidueViewList::const_iterator ri = ci->GetResidueList().begin(),
@@ -55,6 +55,7 @@ void add_points_to_organizer(SpatialOrganizer<bool>& org, const EntityView& view
       }
     }
   }
+  org.Build();
 }
     
 bool cmp_string(CompOP op,const String& lhs, const StringOrRegexParam& rhs) {
@@ -25,6 +25,7 @@
 #include <limits>
 
 #include <ost/geom/geom.hh>
+#include <ost/mol/module_config.hh>
 
 namespace ost { namespace mol {
 
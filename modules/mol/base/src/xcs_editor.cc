@@ -16,6 +16,8 @@
 // along with this library; if not, write to the Free Software Foundation, Inc.,
 // 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 //------------------------------------------------------------------------------
+#include <sstream>
+#include <algorithm>
 #include "xcs_editor.hh"
 #include <ost/mol/atom_handle.hh>
 #include <ost/mol/residue_handle.hh>
@@ -158,6 +160,64 @@ void XCSEditor::SetAtomOriginalPos(const AtomHandleList& alist, double *position
   this->Update();
 }
 
+namespace {
+  // copies positions to the first slots of the coordinate buffer and
+  // derives the other set of positions by applying tf
+  template<bool INVERSE>
+  void set_all_pos(impl::EntityImpl* ent, const geom::Vec3List& positions,
+                   geom::Vec3* dst, geom::Vec3* other)
+  {
+    std::copy(positions.begin(), positions.end(), dst);
+    if (!ent->HasTransform()) {
+      std::copy(positions.begin(), positions.end(), other);
+    } else {
+      const geom::Transform& tf=ent->GetTransform();
+      for (size_t i=0; i<positions.size(); ++i) {
+        other[i]=INVERSE ? tf.ApplyInverse(dst[i]) : tf.Apply(dst[i]);
+      }
+    }
+    ent->MarkICSDirty();
+    ent->MarkOrganizerDirty();
+  }
+
+  void check_pos_count(impl::EntityImpl* ent, const geom::Vec3List& positions)
+  {
+    if (positions.size()!=static_cast<size_t>(ent->GetAtomCount())) {
+      std::stringstream ss;
+      ss << "expected " << ent->GetAtomCount() << " positions, but got "
+         << positions.size();
+      throw Error(ss.str());
+    }
+  }
+} // anon ns
+
+void XCSEditor::SetAtomTransformedPos(const geom::Vec3List& positions)
+{
+  impl::EntityImpl* ent=ent_.Impl().get();
+  check_pos_count(ent, positions);
+  ent->CompactCoords();
+  impl::CoordBuffer& coords=*ent->GetCoordBuffer();
+  set_all_pos<true>(ent, positions, coords.GetTransformedData(),
+                    coords.GetOriginalData());
+  this->Update();
+}
+
+void XCSEditor::SetAtomOriginalPos(const geom::Vec3List& positions)
+{
+  impl::EntityImpl* ent=ent_.Impl().get();
+  check_pos_count(ent, positions);
+  ent->CompactCoords();
+  impl::CoordBuffer& coords=*ent->GetCoordBuffer();
+  set_all_pos<false>(ent, positions, coords.GetOriginalData(),
+                     coords.GetTransformedData());
+  this->Update();
+}
+
+void XCSEditor::SetAtomPos(const geom::Vec3List& positions)
+{
+  this->SetAtomTransformedPos(positions);
+}
+
 void XCSEditor::SetAtomPos(const AtomHandle& atom, const geom::Vec3& position)
 {
   this->SetAtomTransformedPos(atom,position);
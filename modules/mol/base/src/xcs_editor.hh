@@ -81,6 +81,21 @@ public:
   void SetAtomTransformedPos(const AtomHandleList& alist,
 			     double *positions);
 
+  /// \brief set transformed positions of all atoms
+  ///
+  /// The positions must be ordered like EntityHandle::GetAtomList(). They are
+  /// copied in one go into the coordinate storage of the entity, which makes
+  /// this the fastest way to apply e.g. a trajectory frame.
+  ///
+  /// \throws Error if the number of positions does not match the number of
+  ///     atoms
+  void SetAtomTransformedPos(const geom::Vec3List& positions);
+
+  /// \brief set original positions of all atoms
+  ///
+  /// \sa SetAtomTransformedPos(const geom::Vec3List&)
+  void SetAtomOriginalPos(const geom::Vec3List& positions);
+
   /// \brief same as SetAtomTransformedPos(AtomHandle, geom::Vec3)
   void SetAtomPos(const AtomHandle& atom,
 		  const geom::Vec3& position);
@@ -93,6 +108,9 @@ public:
   void SetAtomPos(const AtomHandleList& alist,
 		  double *positions);
 
+  /// \brief same as SetAtomTransformedPos(const geom::Vec3List&)
+  void SetAtomPos(const geom::Vec3List& positions);
+
   /// \brief apply additional transformation to all atoms
   /// 
   /// This transformation is applied \em after the transformation
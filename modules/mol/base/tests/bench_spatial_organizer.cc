@@ -0,0 +1,107 @@
+//------------------------------------------------------------------------------
+// This file is part of the OpenStructure project <www.openstructure.org>
+//
+// Copyright (C) 2008-2020 by the OpenStructure authors
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 3.0 of the License, or (at your option)
+// any later version.
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//------------------------------------------------------------------------------
+
+/*
+  Compares the map-based SpatialOrganizer with the flat CellListOrganizer.
+
+  usage: bench_spatial_organizer [num_points]
+
+  Points are placed randomly at roughly the atom density of a protein, then
+  FindWithin and HasWithin are called for every point.
+*/
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdlib>
+#include <boost/random.hpp>
+#include <ost/mol/spatial_organizer.hh>
+#include <ost/mol/cell_list_organizer.hh>
+
+using namespace ost;
+using namespace ost::mol;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double seconds_since(const Clock::time_point& start)
+{
+  return std::chrono::duration<double>(Clock::now()-start).count();
+}
+
+template <typename ORG>
+void run(const String& name, const std::vector<geom::Vec3>& points, Real radius)
+{
+  Clock::time_point start=Clock::now();
+  ORG org(5.0);
+  for (size_t i=0; i<points.size(); ++i) {
+    org.Add(i, points[i]);
+  }
+  // the cell list sorts lazily, make sure building is part of the timing
+  org.HasWithin(points[0], 0.0);
+  double t_build=seconds_since(start);
+
+  start=Clock::now();
+  size_t num_found=0;
+  for (size_t i=0; i<points.size(); ++i) {
+    num_found+=org.FindWithin(points[i], radius).size();
+  }
+  double t_find=seconds_since(start);
+
+  start=Clock::now();
+  size_t num_has=0;
+  for (size_t i=0; i<points.size(); ++i) {
+    num_has+=org.HasWithin(points[i]+geom::Vec3(radius, 0, 0), radius*0.5);
+  }
+  double t_has=seconds_since(start);
+  std::cout << std::setw(20) << name << std::setw(8) << radius
+            << std::setw(12) << t_build << std::setw(12) << t_find
+            << std::setw(12) << t_has << std::setw(14) << num_found
+            << std::setw(10) << num_has << std::endl;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  size_t num_points=argc>1 ? atoi(argv[1]) : 100000;
+  // approx. atom density of a protein: 1 atom per 12 cubic Angstrom
+  Real extent=0.5*std::pow(Real(num_points*12), Real(1.0/3.0));
+  boost::mt19937 rng(42);
+  boost::uniform_real<Real> dist(-extent, extent);
+  boost::variate_generator<boost::mt19937&, boost::uniform_real<Real> > gen(rng, dist);
+  std::vector<geom::Vec3> points;
+  for (size_t i=0; i<num_points; ++i) {
+    Real x=gen();
+    Real y=gen();
+    Real z=gen();
+    points.push_back(geom::Vec3(x, y, z));
+  }
+  std::cout << num_points << " points, times in seconds" << std::endl;
+  std::cout << std::setw(20) << "organizer" << std::setw(8) << "radius"
+            << std::setw(12) << "build" << std::setw(12) << "FindWithin"
+            << std::setw(12) << "HasWithin" << std::setw(14) << "found"
+            << std::setw(10) << "has" << std::endl;
+  Real radii[]={4.0, 8.0};
+  for (size_t r=0; r<2; ++r) {
+    run<SpatialOrganizer<int> >("SpatialOrganizer", points, radii[r]);
+    run<CellListOrganizer<int> >("CellListOrganizer", points, radii[r]);
+  }
+  return 0;
+}
@@ -0,0 +1,105 @@
+//------------------------------------------------------------------------------
+// This file is part of the OpenStructure project <www.openstructure.org>
+//
+// Copyright (C) 2008-2020 by the OpenStructure authors
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 3.0 of the License, or (at your option)
+// any later version.
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//------------------------------------------------------------------------------
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <boost/random.hpp>
+#include <ost/mol/spatial_organizer.hh>
+#include <ost/mol/cell_list_organizer.hh>
+
+using namespace ost;
+using namespace ost::mol;
+
+namespace {
+
+std::vector<geom::Vec3> random_points(size_t n, Real extent)
+{
+  boost::mt19937 rng(42);
+  boost::uniform_real<Real> dist(-extent, extent);
+  boost::variate_generator<boost::mt19937&, boost::uniform_real<Real> > gen(rng, dist);
+  std::vector<geom::Vec3> points;
+  for (size_t i=0; i<n; ++i) {
+    Real x=gen();
+    Real y=gen();
+    Real z=gen();
+    points.push_back(geom::Vec3(x, y, z));
+  }
+  return points;
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE( mol_base );
+
+BOOST_AUTO_TEST_CASE(cell_list_organizer_matches_spatial_organizer)
+{
+  std::vector<geom::Vec3> points=random_points(2000, 30.0);
+  SpatialOrganizer<int> map_org(5.0);
+  CellListOrganizer<int> cell_org(5.0);
+  for (size_t i=0; i<points.size(); ++i) {
+    map_org.Add(i, points[i]);
+    cell_org.Add(i, points[i]);
+  }
+  BOOST_CHECK_EQUAL(cell_org.GetSize(), points.size());
+  Real radii[]={0.5, 3.0, 7.5, 100.0};
+  for (size_t r=0; r<4; ++r) {
+    for (size_t i=0; i<points.size(); i+=37) {
+      std::vector<int> expected=map_org.FindWithin(points[i], radii[r]);
+      std::vector<int> found=cell_org.FindWithin(points[i], radii[r]);
+      BOOST_CHECK(expected==found);
+      BOOST_CHECK_EQUAL(map_org.HasWithin(points[i]+geom::Vec3(2,0,0),
+                                          radii[r]),
+                        cell_org.HasWithin(points[i]+geom::Vec3(2,0,0),
+                                           radii[r]));
+    }
+  }
+  // far away from all points
+  BOOST_CHECK(!cell_org.HasWithin(geom::Vec3(1000, 0, 0), 10.0));
+  BOOST_CHECK(cell_org.FindWithin(geom::Vec3(1000, 0, 0), 10.0).empty());
+}
+
+BOOST_AUTO_TEST_CASE(cell_list_organizer_modify)
+{
+  CellListOrganizer<int> org(5.0);
+  BOOST_CHECK(!org.HasWithin(geom::Vec3(0, 0, 0), 10.0));
+  org.Add(1, geom::Vec3(0, 0, 0));
+  org.Add(2, geom::Vec3(1, 0, 0));
+  org.Add(3, geom::Vec3(20, 0, 0));
+  BOOST_CHECK_EQUAL(org.FindWithin(geom::Vec3(0, 0, 0), 2.0).size(), size_t(2));
+  org.Remove(2);
+  std::vector<int> found=org.FindWithin(geom::Vec3(0, 0, 0), 2.0);
+  BOOST_CHECK_EQUAL(found.size(), size_t(1));
+  BOOST_CHECK_EQUAL(found[0], 1);
+  org.Add(4, geom::Vec3(19, 0, 0));
+  found=org.FindWithin(geom::Vec3(20, 0, 0), 1.5);
+  BOOST_CHECK_EQUAL(found.size(), size_t(2));
+  // items very far away are clamped into border cells, but still found
+  org.Add(5, geom::Vec3(1e8, 0, 0));
+  BOOST_CHECK(org.HasWithin(geom::Vec3(1e8, 0, 0), 1.0));
+  BOOST_CHECK(!org.HasWithin(geom::Vec3(9e7, 0, 0), 1.0));
+
+  CellListOrganizer<int> other(5.0);
+  other.Swap(org);
+  BOOST_CHECK_EQUAL(other.GetSize(), size_t(4));
+  BOOST_CHECK_EQUAL(org.GetSize(), size_t(0));
+  other.Clear();
+  BOOST_CHECK(!other.HasWithin(geom::Vec3(0, 0, 0), 10.0));
+}
+
+BOOST_AUTO_TEST_SUITE_END();
@@ -93,4 +93,35 @@ BOOST_AUTO_TEST_CASE(coord_group)
   }
 }
 
+BOOST_AUTO_TEST_CASE(coord_group_all_atoms)
+{
+  // frames covering all atoms in order are copied in one go
+  EntityHandle e=CreateEntity();
+  XCSEditor editor=e.EditXCS();
+  ChainHandle c=editor.InsertChain("A");
+  ResidueHandle r=editor.AppendResidue(c, "XXX");
+  editor.InsertAtom(r, "A", geom::Vec3(0,1,2));
+  editor.InsertAtom(r, "B", geom::Vec3(3,4,5));
+  CoordGroupHandle cg=CreateCoordGroup(e.GetAtomList());
+  cg.Capture();
+  std::vector<geom::Vec3> clist(2);
+  clist[0]=geom::Vec3(-1,-2,-3);
+  clist[1]=geom::Vec3(-4,-5,-6);
+  cg.AddFrame(clist);
+  cg.CopyFrame(1);
+  BOOST_CHECK(e.FindAtom("A", ResNum(1), "A").GetPos()==clist[0]);
+  BOOST_CHECK(e.FindAtom("A", ResNum(1), "B").GetPos()==clist[1]);
+  cg.CopyFrame(0);
+  BOOST_CHECK(e.FindAtom("A", ResNum(1), "B").GetPos()==geom::Vec3(3,4,5));
+
+  // a group in different order takes the slow path
+  AtomHandleList atoms=e.GetAtomList();
+  std::swap(atoms[0], atoms[1]);
+  CoordGroupHandle cg2=CreateCoordGroup(atoms);
+  cg2.AddFrame(clist);
+  cg2.CopyFrame(0);
+  BOOST_CHECK(e.FindAtom("A", ResNum(1), "A").GetPos()==clist[1]);
+  BOOST_CHECK(e.FindAtom("A", ResNum(1), "B").GetPos()==clist[0]);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
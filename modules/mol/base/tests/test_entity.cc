@@ -27,6 +27,8 @@
 #include <ost/mol/mol.hh>
 #include <ost/mol/property_id.hh>
 #include <cmath>
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
 
 #define CHECK_TRANSFORMED_ATOM_POSITION(ATOM,TARGET) \
    BOOST_CHECK(vec3_is_close(ATOM.GetPos(), TARGET,Real(0.1)))
@@ -493,4 +495,106 @@ BOOST_AUTO_TEST_CASE(prune) {
   BOOST_CHECK_EQUAL(ent.GetAtomCount(), 0);
 }
 
+BOOST_AUTO_TEST_CASE(atom_pos_data)
+{
+  EntityHandle ent=CreateEntity();
+  XCSEditor edi=ent.EditXCS();
+  ChainHandle ch=edi.InsertChain("A");
+  ResidueHandle r1=edi.AppendResidue(ch, "A", ResNum(1));
+  ResidueHandle r2=edi.AppendResidue(ch, "B", ResNum(2));
+  AtomHandle a1=edi.InsertAtom(r2, "X", geom::Vec3(1, 0, 0));
+  AtomHandle a2=edi.InsertAtom(r1, "X", geom::Vec3(2, 0, 0));
+  AtomHandle a3=edi.InsertAtom(r1, "Y", geom::Vec3(3, 0, 0));
+
+  // positions are ordered like the atom list, regardless of insertion order
+  const geom::Vec3* pos=ent.GetAtomPosData();
+  AtomHandleList atoms=ent.GetAtomList();
+  BOOST_REQUIRE_EQUAL(atoms.size(), size_t(3));
+  for (size_t i=0; i<atoms.size(); ++i) {
+    BOOST_CHECK_EQUAL(pos[i], atoms[i].GetPos());
+  }
+  BOOST_CHECK_EQUAL(pos[0], geom::Vec3(2, 0, 0));
+
+  // the array is shared with the atoms
+  edi.SetAtomPos(a3, geom::Vec3(4, 0, 0));
+  BOOST_CHECK_EQUAL(pos[1], geom::Vec3(4, 0, 0));
+
+  edi.DeleteAtom(a2);
+  pos=ent.GetAtomPosData();
+  BOOST_CHECK_EQUAL(pos[0], geom::Vec3(4, 0, 0));
+  BOOST_CHECK_EQUAL(pos[1], geom::Vec3(1, 0, 0));
+  // deleted atoms referenced by handles keep their position
+  BOOST_CHECK_EQUAL(a2.GetPos(), geom::Vec3(2, 0, 0));
+
+  edi.SetResidueNumber(r2, ResNum(0));
+  edi.ReorderResidues(ch);
+  pos=ent.GetAtomPosData();
+  BOOST_CHECK_EQUAL(pos[0], geom::Vec3(1, 0, 0));
+  BOOST_CHECK_EQUAL(pos[1], geom::Vec3(4, 0, 0));
+
+  // set all positions in one go, with and without transformation
+  geom::Vec3List new_pos;
+  new_pos.push_back(geom::Vec3(5, 0, 0));
+  new_pos.push_back(geom::Vec3(6, 0, 0));
+  edi.SetAtomPos(new_pos);
+  BOOST_CHECK_EQUAL(a1.GetPos(), geom::Vec3(5, 0, 0));
+  BOOST_CHECK_EQUAL(a3.GetOriginalPos(), geom::Vec3(6, 0, 0));
+  geom::Transform tf;
+  tf.SetTrans(geom::Vec3(0, 10, 0));
+  edi.SetTransform(tf);
+  BOOST_CHECK(vec3_is_close(ent.GetAtomPosData()[0], geom::Vec3(5, 10, 0),
+                            Real(1e-5)));
+  edi.SetAtomTransformedPos(new_pos);
+  CHECK_TRANSFORMED_ATOM_POSITION(a1, geom::Vec3(5, 0, 0));
+  CHECK_ORIGINAL_ATOM_POSITION(a1, geom::Vec3(5, -10, 0));
+  edi.SetAtomOriginalPos(new_pos);
+  CHECK_TRANSFORMED_ATOM_POSITION(a3, geom::Vec3(6, 10, 0));
+  CHECK_ORIGINAL_ATOM_POSITION(a3, geom::Vec3(6, 0, 0));
+  BOOST_CHECK_EQUAL(ent.GetAtomPosList().size(), size_t(2));
+
+  new_pos.push_back(geom::Vec3());
+  BOOST_CHECK_THROW(edi.SetAtomPos(new_pos), Error);
+}
+
+namespace {
+
+void get_atom_pos_list(const EntityHandle& ent, geom::Vec3List* pos)
+{
+  *pos=ent.GetAtomPosList();
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(atom_pos_data_threads)
+{
+  // atoms inserted in reverse order, the buffer is first compacted by one of
+  // the reading threads
+  EntityHandle ent=CreateEntity();
+  XCSEditor edi=ent.EditXCS();
+  ChainHandle ch=edi.InsertChain("A");
+  ResidueHandleList residues;
+  for (int i=0; i<200; ++i) {
+    residues.push_back(edi.AppendResidue(ch, "A", ResNum(i+1)));
+  }
+  for (int i=199; i>=0; --i) {
+    for (int j=0; j<10; ++j) {
+      edi.InsertAtom(residues[i], "X", geom::Vec3(i, j, 0));
+    }
+  }
+  std::vector<geom::Vec3List> pos(4);
+  boost::thread_group tg;
+  for (size_t i=0; i<pos.size(); ++i) {
+    tg.create_thread(boost::bind(&get_atom_pos_list, boost::cref(ent),
+                                 &pos[i]));
+  }
+  tg.join_all();
+  AtomHandleList atoms=ent.GetAtomList();
+  for (size_t i=0; i<pos.size(); ++i) {
+    BOOST_REQUIRE_EQUAL(pos[i].size(), atoms.size());
+    for (size_t j=0; j<atoms.size(); ++j) {
+      BOOST_CHECK_EQUAL(pos[i][j], atoms[j].GetPos());
+    }
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -0,0 +1,166 @@
+//------------------------------------------------------------------------------
+// This file is part of the OpenStructure project <www.openstructure.org>
+//
+// Copyright (C) 2008-2020 by the OpenStructure authors
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 3.0 of the License, or (at your option)
+// any later version.
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//------------------------------------------------------------------------------
+
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <limits>
+#include <boost/random.hpp>
+#include <ost/mol/mol.hh>
+#include <ost/mol/neighbor_search.hh>
+
+using namespace ost;
+using namespace ost::mol;
+
+namespace {
+
+geom::Vec3List random_points(size_t n, Real extent, unsigned int seed)
+{
+  boost::mt19937 rng(seed);
+  boost::uniform_real<Real> dist(-extent, extent);
+  boost::variate_generator<boost::mt19937&, boost::uniform_real<Real> > gen(rng, dist);
+  geom::Vec3List points;
+  for (size_t i=0; i<n; ++i) {
+    Real x=gen();
+    Real y=gen();
+    Real z=gen();
+    points.push_back(geom::Vec3(x, y, z));
+  }
+  return points;
+}
+
+NeighborPairList brute_force(const geom::Vec3List& a, const geom::Vec3List& b,
+                             Real cutoff, bool self)
+{
+  NeighborPairList pairs;
+  for (size_t i=0; i<a.size(); ++i) {
+    for (size_t j=self ? i+1 : 0; j<b.size(); ++j) {
+      Real d2=geom::Length2(a[i]-b[j]);
+      if (d2<=cutoff*cutoff) {
+        pairs.push_back(NeighborPair(i, j, d2));
+      }
+    }
+  }
+  return pairs;
+}
+
+bool same_pairs(const NeighborPairList& a, const NeighborPairList& b)
+{
+  if (a.size()!=b.size()) {
+    return false;
+  }
+  for (size_t i=0; i<a.size(); ++i) {
+    if (a[i].first!=b[i].first || a[i].second!=b[i].second ||
+        std::abs(a[i].dist2-b[i].dist2)>1e-4) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE( mol_base );
+
+BOOST_AUTO_TEST_CASE(neighbor_search_matches_brute_force)
+{
+  geom::Vec3List a=random_points(500, 20.0, 42);
+  geom::Vec3List b=random_points(700, 25.0, 7);
+  Real cutoffs[]={0.0, 1.5, 4.0, 12.0, 100.0};
+  for (size_t c=0; c<5; ++c) {
+    NeighborPairList expected=brute_force(a, b, cutoffs[c], false);
+    BOOST_CHECK(same_pairs(FindAllPairsWithin(a, b, cutoffs[c]), expected));
+    expected=brute_force(a, a, cutoffs[c], true);
+    BOOST_CHECK(same_pairs(FindAllPairsWithin(a, cutoffs[c]), expected));
+  }
+  BOOST_CHECK(FindAllPairsWithin(a, b, -1.0).empty());
+  BOOST_CHECK(FindAllPairsWithin(geom::Vec3List(), b, 5.0).empty());
+  BOOST_CHECK(FindAllPairsWithin(a, geom::Vec3List(), 5.0).empty());
+  // far away and widely spread points
+  geom::Vec3List c;
+  c.push_back(geom::Vec3(0, 0, 0));
+  c.push_back(geom::Vec3(1e6, 0, 0));
+  c.push_back(geom::Vec3(1e6, 1, 0));
+  NeighborPairList pairs=FindAllPairsWithin(c, 2.0);
+  BOOST_CHECK_EQUAL(pairs.size(), size_t(1));
+  BOOST_CHECK_EQUAL(pairs[0].first, 1u);
+  BOOST_CHECK_EQUAL(pairs[0].second, 2u);
+}
+
+BOOST_AUTO_TEST_CASE(neighbor_search_threads)
+{
+  geom::Vec3List a=random_points(2000, 30.0, 42);
+  geom::Vec3List b=random_points(1000, 30.0, 7);
+  NeighborPairList single=FindAllPairsWithin(a, b, 5.0, 1);
+  BOOST_CHECK(single==FindAllPairsWithin(a, b, 5.0, 4));
+  single=FindAllPairsWithin(a, 5.0, 1);
+  BOOST_CHECK(single==FindAllPairsWithin(a, 5.0, 3));
+}
+
+BOOST_AUTO_TEST_CASE(neighbor_search_views)
+{
+  EntityHandle ent=CreateEntity();
+  XCSEditor editor=ent.EditXCS();
+  ChainHandle ch=editor.InsertChain("A");
+  ResidueHandle r1=editor.AppendResidue(ch, "A");
+  ResidueHandle r2=editor.AppendResidue(ch, "B");
+  editor.InsertAtom(r1, "X1", geom::Vec3(0, 0, 0));
+  editor.InsertAtom(r1, "X2", geom::Vec3(1, 0, 0));
+  editor.InsertAtom(r2, "X3", geom::Vec3(3, 0, 0));
+  editor.InsertAtom(r2, "X4", geom::Vec3(9, 0, 0));
+  AtomHandleList atoms=ent.GetAtomList();
+  for (AtomHandleList::iterator i=atoms.begin(); i!=atoms.end(); ++i) {
+    i->SetRadius(1.0);
+  }
+  EntityView all=ent.CreateFullView();
+  NeighborPairList pairs=FindAllPairsWithin(all, 2.5);
+  BOOST_CHECK_EQUAL(pairs.size(), size_t(2));
+  BOOST_CHECK(pairs[0]==NeighborPair(0, 1, 1.0));
+  BOOST_CHECK(pairs[1]==NeighborPair(1, 2, 4.0));
+
+  EntityView first=ent.Select("rname=A");
+  pairs=FindAllPairsWithin(first, all, 3.0);
+  BOOST_CHECK_EQUAL(pairs.size(), size_t(6));
+  BOOST_CHECK(pairs[0]==NeighborPair(0, 0, 0.0));
+  BOOST_CHECK(pairs[2]==NeighborPair(0, 2, 9.0));
+  BOOST_CHECK(pairs[5]==NeighborPair(1, 2, 4.0));
+
+  EntityView ext=ent.Select("aname=X1").ExtendViewToSurrounding(1.0);
+  BOOST_CHECK(ext.FindAtom("A", 1, "X2").IsValid());
+  BOOST_CHECK(ext.FindAtom("A", 2, "X3").IsValid());
+  BOOST_CHECK(!ext.FindAtom("A", 2, "X4").IsValid());
+}
+
+BOOST_AUTO_TEST_CASE(neighbor_search_non_finite)
+{
+  geom::Vec3List pos;
+  pos.push_back(geom::Vec3(0, 0, 0));
+  pos.push_back(geom::Vec3(1, 0, 0));
+  pos.push_back(geom::Vec3(std::numeric_limits<Real>::quiet_NaN(), 0, 0));
+  BOOST_CHECK_THROW(FindAllPairsWithin(pos, 2.0), Error);
+  pos[2]=geom::Vec3(0, std::numeric_limits<Real>::infinity(), 0);
+  BOOST_CHECK_THROW(FindAllPairsWithin(pos, 2.0), Error);
+  geom::Vec3List finite(pos.begin(), pos.begin()+2);
+  BOOST_CHECK_THROW(FindAllPairsWithin(finite, pos, 2.0), Error);
+  BOOST_CHECK_THROW(FindAllPairsWithin(pos, finite, 2.0), Error);
+  BOOST_CHECK(FindAllPairsWithin(finite,
+                                 std::numeric_limits<Real>::quiet_NaN()).empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END();
@@ -28,6 +28,9 @@
 #include <ost/seq/alg/local_align.hh>
 #include <ost/seq/alg/global_align.hh>
 #include <ost/seq/alg/semiglobal_align.hh>
+#include <ost/seq/alg/align_score.hh>
+#include <ost/seq/alg/align_one_to_many.hh>
+#include <ost/seq/alg/profile_align.hh>
 #include <ost/seq/alg/entropy.hh>
 #include <ost/seq/alg/pair_subst_weight_matrix.hh>
 #include <ost/seq/alg/contact_weight_matrix.hh>
@@ -76,6 +79,34 @@ list VarMapGetData(const VarianceMapPtr v_map) {
 list DistToMeanGetData(const Dist2MeanPtr d2m) {
   return GetList(*d2m, d2m->GetNumResidues(), d2m->GetNumStructures());
 }
+
+list WrapGetScoreMatrix(const ProfileAligner& aligner,
+                        const ProfileHandle& target) {
+  std::vector<Real> scores = aligner.GetScoreMatrix(target);
+  list ret;
+  for (uint row = 0; row < uint(aligner.GetQueryLength()); ++row) {
+    list my_row;
+    for (uint col = 0; col < target.size(); ++col) {
+      my_row.append(scores[row * target.size() + col]);
+    }
+    ret.append(my_row);
+  }
+  return ret;
+}
+
+ProfileAlignHitList WrapProfileAlignOneToMany(const ProfileHandle& query,
+                                              const list& targets,
+                                              Real gap_open, Real gap_ext,
+                                              AlignMode::Type mode, int top_k,
+                                              bool alignments,
+                                              int num_threads) {
+  ProfileHandleList target_list;
+  for (int i = 0; i < len(targets); ++i) {
+    target_list.push_back(extract<ProfileHandlePtr>(targets[i]));
+  }
+  return ProfileAlignOneToMany(query, target_list, gap_open, gap_ext, mode,
+                               top_k, alignments, num_threads);
+}
 } // anon ns
 ////////////////////////////////////////////////////////////////////
 
@@ -114,6 +145,68 @@ void export_aln_alg()
       arg("gap_open")=-5, arg("gap_ext")=-2));
   def("SemiGlobalAlign", &SemiGlobalAlign,(arg("seq1"),arg("seq2"),arg("subst_weight"), 
       arg("gap_open")=-5, arg("gap_ext")=-2));
+  def("LocalAlignScore", &LocalAlignScore, (arg("seq1"), arg("seq2"),
+      arg("subst_weight"), arg("gap_open")=-5, arg("gap_ext")=-2));
+  def("GlobalAlignScore", &GlobalAlignScore, (arg("seq1"), arg("seq2"),
+      arg("subst_weight"), arg("gap_open")=-5, arg("gap_ext")=-2));
+  def("SemiGlobalAlignScore", &SemiGlobalAlignScore, (arg("seq1"), arg("seq2"),
+      arg("subst_weight"), arg("gap_open")=-5, arg("gap_ext")=-2));
+  class_<AlignScorer>("AlignScorer", init<const ConstSequenceHandle&,
+                                          const SubstWeightMatrix&,
+                                          optional<int, int> >(
+                      (arg("query"), arg("subst_weight"), arg("gap_open")=-5,
+                       arg("gap_ext")=-2)))
+    .def("LocalScore", &AlignScorer::LocalScore, (arg("target")))
+    .def("GlobalScore", &AlignScorer::GlobalScore, (arg("target")))
+    .def("SemiGlobalScore", &AlignScorer::SemiGlobalScore, (arg("target")))
+    .def("Align", &AlignScorer::Align, (arg("target"), arg("mode")))
+    .def("GetQueryLength", &AlignScorer::GetQueryLength)
+    .def("GetSIMDName", &AlignScorer::GetSIMDName).staticmethod("GetSIMDName")
+  ;
+  enum_<AlignMode::Type>("AlignMode")
+    .value("LOCAL", AlignMode::LOCAL)
+    .value("GLOBAL", AlignMode::GLOBAL)
+    .value("SEMIGLOBAL", AlignMode::SEMIGLOBAL)
+  ;
+  class_<AlignHit>("AlignHit", init<>())
+    .def_readonly("index", &AlignHit::index)
+    .def_readonly("score", &AlignHit::score)
+    .def_readonly("aln", &AlignHit::aln)
+  ;
+  class_<AlignHitList>("AlignHitList", init<>())
+    .def(vector_indexing_suite<AlignHitList>())
+  ;
+  def("AlignOneToMany", &AlignOneToMany, (arg("query"), arg("targets"),
+      arg("subst_weight"), arg("gap_open")=-5, arg("gap_ext")=-2,
+      arg("mode")=AlignMode::LOCAL, arg("top_k")=-1, arg("alignments")=false,
+      arg("num_threads")=1));
+  Real (ProfileAligner::*profile_score)(const ProfileHandle&,
+                                        AlignMode::Type) const=
+    &ProfileAligner::Score;
+  class_<ProfileAligner>("ProfileAligner", init<const ProfileHandle&,
+                                                optional<Real, Real> >(
+                         (arg("query"), arg("gap_open")=-3.0,
+                          arg("gap_ext")=-0.6)))
+    .def("Score", profile_score, (arg("target"), arg("mode")=AlignMode::LOCAL))
+    .def("Align", &ProfileAligner::Align,
+         (arg("target"), arg("mode")=AlignMode::LOCAL))
+    .def("GetScoreMatrix", &WrapGetScoreMatrix, (arg("target")))
+    .def("GetQueryLength", &ProfileAligner::GetQueryLength)
+    .def("GetSIMDName", &ProfileAligner::GetSIMDName)
+    .staticmethod("GetSIMDName")
+  ;
+  class_<ProfileAlignHit>("ProfileAlignHit", init<>())
+    .def_readonly("index", &ProfileAlignHit::index)
+    .def_readonly("score", &ProfileAlignHit::score)
+    .def_readonly("aln", &ProfileAlignHit::aln)
+  ;
+  class_<ProfileAlignHitList>("ProfileAlignHitList", init<>())
+    .def(vector_indexing_suite<ProfileAlignHitList>())
+  ;
+  def("ProfileAlignOneToMany", &WrapProfileAlignOneToMany, (arg("query"),
+      arg("targets"), arg("gap_open")=-3.0, arg("gap_ext")=-0.6,
+      arg("mode")=AlignMode::LOCAL, arg("top_k")=-1, arg("alignments")=false,
+      arg("num_threads")=1));
   def("ShannonEntropy", &ShannonEntropy, (arg("aln"), arg("ignore_gaps")=true));
 }
 
@@ -141,9 +234,12 @@ void export_contact_prediction()
     .def("SetScore",&ContactPredictionScoreResult::SetScore,(arg("i"),arg("j"),arg("score")))
   ;
   def("CalculateMutualInformation", &CalculateMutualInformation,(arg("aln"),arg("w")=LoadConstantContactWeightMatrix(),
-                                                        arg("apc_correction")=true,arg("zpx_transformation")=true,arg("small_number_correction")=0.05));
-  def("CalculateContactScore", &CalculateContactScore,(arg("aln"), arg("w")=LoadDefaultContactWeightMatrix()));
-  def("CalculateContactSubstitutionScore", &CalculateContactSubstitutionScore,(arg("aln"), arg("ref_seq_index")=0, arg("w")=LoadDefaultPairSubstWeightMatrix()));
+                                                        arg("apc_correction")=true,arg("zpx_transformation")=true,arg("small_number_correction")=0.05,
+                                                        arg("num_threads")=1));
+  def("CalculateContactScore", &CalculateContactScore,(arg("aln"), arg("w")=LoadDefaultContactWeightMatrix(),
+                                                      arg("num_threads")=1));
+  def("CalculateContactSubstitutionScore", &CalculateContactSubstitutionScore,(arg("aln"), arg("ref_seq_index")=0, arg("w")=LoadDefaultPairSubstWeightMatrix(),
+                                                                              arg("num_threads")=1));
   def("LoadDefaultContactWeightMatrix",LoadDefaultContactWeightMatrix);
   def("LoadConstantContactWeightMatrix",LoadConstantContactWeightMatrix);
   def("LoadDefaultPairSubstWeightMatrix",LoadDefaultPairSubstWeightMatrix);
@@ -0,0 +1,123 @@
+//------------------------------------------------------------------------------
+// This file is part of the OpenStructure project <www.openstructure.org>
+//
+// Copyright (C) 2008-2020 by the OpenStructure authors
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 3.0 of the License, or (at your option)
+// any later version.
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//------------------------------------------------------------------------------
+#include <algorithm>
+#include <boost/thread/thread.hpp>
+#include <boost/bind.hpp>
+#include <ost/message.hh>
+#include "align_one_to_many.hh"
+
+namespace ost { namespace seq { namespace alg {
+
+namespace {
+
+typedef std::vector<ConstSequenceHandle> TargetList;
+
+bool compare_hits(const AlignHit& lhs, const AlignHit& rhs)
+{
+  if (lhs.score!=rhs.score) {
+    return lhs.score>rhs.score;
+  }
+  return lhs.index<rhs.index;
+}
+
+// scores every num_threads-th target, starting at first. The workspace is
+// private to the thread and shared by all of its targets.
+void score_targets(const AlignScorer& scorer, const TargetList& targets,
+                   AlignMode::Type mode, int first, int num_threads,
+                   AlignHitList& hits)
+{
+  std::vector<int> workspace;
+  for (size_t i=first; i<targets.size(); i+=num_threads) {
+    hits[i]=AlignHit(i, scorer.Score(targets[i], mode, workspace));
+  }
+}
+
+// the traceback is only calculated for the band of the best path, see
+// AlignScorer::Align
+void align_hits(const AlignScorer& scorer, const TargetList& targets,
+                AlignMode::Type mode, int first, int num_threads,
+                AlignHitList& hits)
+{
+  for (size_t i=first; i<hits.size(); i+=num_threads) {
+    AlignmentList alns=scorer.Align(targets[hits[i].index], mode);
+    if (!alns.empty()) {
+      hits[i].aln=alns.front();
+    }
+  }
+}
+
+}
+
+AlignHitList AlignOneToMany(const ConstSequenceHandle& query,
+                            const SequenceList& targets,
+                            SubstWeightMatrixPtr& subst, int gap_open,
+                            int gap_ext, AlignMode::Type mode, int top_k,
+                            bool alignments, int num_threads)
+{
+  if (!subst) {
+    throw Error("Invalid substitution weight matrix");
+  }
+  if (num_threads<1) {
+    throw Error("Number of threads must be at least 1");
+  }
+  TargetList target_list;
+  target_list.reserve(targets.GetCount());
+  for (int i=0; i<targets.GetCount(); ++i) {
+    target_list.push_back(targets[i]);
+  }
+  num_threads=std::max(1, std::min(num_threads, int(target_list.size())));
+  AlignScorer scorer(query, *subst, gap_open, gap_ext);
+  AlignHitList hits(target_list.size());
+  if (num_threads==1) {
+    score_targets(scorer, target_list, mode, 0, 1, hits);
+  } else {
+    boost::thread_group tg;
+    for (int i=0; i<num_threads; ++i) {
+      tg.create_thread(boost::bind(&score_targets, boost::cref(scorer),
+                                   boost::cref(target_list), mode, i,
+                                   num_threads, boost::ref(hits)));
+    }
+    tg.join_all();
+  }
+  if (top_k>0 && size_t(top_k)<hits.size()) {
+    std::partial_sort(hits.begin(), hits.begin()+top_k, hits.end(),
+                      compare_hits);
+    hits.resize(top_k);
+  } else {
+    std::sort(hits.begin(), hits.end(), compare_hits);
+  }
+  if (!alignments || hits.empty()) {
+    return hits;
+  }
+  num_threads=std::min(num_threads, int(hits.size()));
+  if (num_threads==1) {
+    align_hits(scorer, target_list, mode, 0, 1, hits);
+  } else {
+    boost::thread_group tg;
+    for (int i=0; i<num_threads; ++i) {
+      tg.create_thread(boost::bind(&align_hits, boost::cref(scorer),
+                                   boost::cref(target_list), mode, i,
+                                   num_threads, boost::ref(hits)));
+    }
+    tg.join_all();
+  }
+  return hits;
+}
+
+}}}
@@ -0,0 +1,78 @@
+//------------------------------------------------------------------------------
+// This file is part of the OpenStructure project <www.openstructure.org>
+//
+// Copyright (C) 2008-2020 by the OpenStructure authors
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 3.0 of the License, or (at your option)
+// any later version.
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//------------------------------------------------------------------------------
+#ifndef OST_SEQ_ALG_ALIGN_ONE_TO_MANY_HH
+#define OST_SEQ_ALG_ALIGN_ONE_TO_MANY_HH
+
+#include <vector>
+#include <ost/seq/alignment_handle.hh>
+#include <ost/seq/sequence_list.hh>
+#include <ost/seq/alg/subst_weight_matrix.hh>
+#include <ost/seq/alg/align_score.hh>
+#include "module_config.hh"
+
+namespace ost { namespace seq { namespace alg {
+
+/// \brief hit of AlignOneToMany
+struct DLLEXPORT_OST_SEQ_ALG AlignHit {
+  AlignHit(): index(-1), score(0) { }
+  AlignHit(int i, int s): index(i), score(s) { }
+
+  /// \brief index of the target in the list of targets
+  int index;
+  /// \brief alignment score
+  int score;
+  /// \brief alignment of the query with the target. Only valid if alignments
+  ///     were requested and, for local alignments, if the sequences share a
+  ///     local alignment of at least two residues.
+  AlignmentHandle aln;
+
+  bool operator==(const AlignHit& rhs) const
+  {
+    return index==rhs.index && score==rhs.score;
+  }
+  bool operator!=(const AlignHit& rhs) const
+  {
+    return !this->operator==(rhs);
+  }
+};
+
+typedef std::vector<AlignHit> AlignHitList;
+
+/// \brief align query to each of the targets and return the best hits
+///
+/// The substitution weights of the query are looked up once (see AlignScorer)
+/// and the targets are scored in parallel by num_threads threads, each of
+/// which reuses its own scratch buffers. The hits are sorted by descending
+/// score, ties are ordered by target index, so the result does not depend on
+/// the number of threads. If top_k is positive, only the top_k best hits are
+/// returned.
+///
+/// If alignments is true, the full alignment is calculated for the returned
+/// hits with AlignScorer::Align, which gives the same alignments as
+/// LocalAlign, GlobalAlign or SemiGlobalAlign. The scores are identical to the
+/// scores of these alignments.
+AlignHitList DLLEXPORT_OST_SEQ_ALG
+AlignOneToMany(const ConstSequenceHandle& query, const SequenceList& targets,
+               SubstWeightMatrixPtr& subst, int gap_open=-5, int gap_ext=-2,
+               AlignMode::Type mode=AlignMode::LOCAL, int top_k=-1,
+               bool alignments=false, int num_threads=1);
+
+}}}
+
+#endif
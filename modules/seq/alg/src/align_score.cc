@@ -0,0 +1,520 @@
+//------------------------------------------------------------------------------
+// This file is part of the OpenStructure project <www.openstructure.org>
+//
+// Copyright (C) 2008-2020 by the OpenStructure authors
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 3.0 of the License, or (at your option)
+// any later version.
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//------------------------------------------------------------------------------
+#include <algorithm>
+#include <cassert>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#include <ost/log.hh>
+#include "impl/align_impl.hh"
+#include "align_score.hh"
+
+/*
+  The recursion is the one of LocalAlign, GlobalAlign and SemiGlobalAlign: the
+  gap extension penalty is used when the best path into the neighbouring cell
+  is a gap in the same direction, ties are broken in favour of the diagonal.
+  Cell (x, y) depends on (x-1, y-1), (x, y-1) and (x-1, y) only, so all cells
+  of an anti-diagonal d=x+y can be calculated at the same time. The cells of a
+  diagonal are stored by their x index, the neighbours of cell x are then x-1
+  and x of the two previous diagonals, which allows for contiguous SIMD loads.
+  The directions are stored as masks (0 or -1), one for gaps in the query and
+  one for gaps in the target.
+*/
+
+namespace ost { namespace seq { namespace alg {
+
+namespace {
+
+#if defined(__AVX2__)
+
+typedef __m256i simd_int;
+const int SIMD_WIDTH=8;
+
+inline simd_int simd_load(const int* p)
+{
+  return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+}
+inline void simd_store(int* p, simd_int a)
+{
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), a);
+}
+inline simd_int simd_set1(int a) { return _mm256_set1_epi32(a); }
+inline simd_int simd_add(simd_int a, simd_int b) { return _mm256_add_epi32(a, b); }
+inline simd_int simd_gt(simd_int a, simd_int b) { return _mm256_cmpgt_epi32(a, b); }
+inline simd_int simd_and(simd_int a, simd_int b) { return _mm256_and_si256(a, b); }
+inline simd_int simd_or(simd_int a, simd_int b) { return _mm256_or_si256(a, b); }
+// ~a & b
+inline simd_int simd_andnot(simd_int a, simd_int b) { return _mm256_andnot_si256(a, b); }
+inline simd_int simd_max(simd_int a, simd_int b) { return _mm256_max_epi32(a, b); }
+// mask ? a : b
+inline simd_int simd_select(simd_int mask, simd_int a, simd_int b)
+{
+  return _mm256_blendv_epi8(b, a, mask);
+}
+
+#elif defined(__SSE2__)
+
+typedef __m128i simd_int;
+const int SIMD_WIDTH=4;
+
+inline simd_int simd_load(const int* p)
+{
+  return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+}
+inline void simd_store(int* p, simd_int a)
+{
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(p), a);
+}
+inline simd_int simd_set1(int a) { return _mm_set1_epi32(a); }
+inline simd_int simd_add(simd_int a, simd_int b) { return _mm_add_epi32(a, b); }
+inline simd_int simd_gt(simd_int a, simd_int b) { return _mm_cmpgt_epi32(a, b); }
+inline simd_int simd_and(simd_int a, simd_int b) { return _mm_and_si128(a, b); }
+inline simd_int simd_or(simd_int a, simd_int b) { return _mm_or_si128(a, b); }
+inline simd_int simd_andnot(simd_int a, simd_int b) { return _mm_andnot_si128(a, b); }
+inline simd_int simd_select(simd_int mask, simd_int a, simd_int b)
+{
+  return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+// SSE2 lacks a 32 bit integer max
+inline simd_int simd_max(simd_int a, simd_int b)
+{
+  return simd_select(simd_gt(a, b), a, b);
+}
+
+#else
+
+const int SIMD_WIDTH=1;
+
+#endif
+
+// scalar version of the cell recursion. free_ins1 and free_ins2 disable the
+// gap penalties for end gaps in semi-global mode.
+inline void calc_cell(int w, int diag_h, int left_h, int left_ins1,
+                      int up_h, int up_ins2, int gap_open, int gap_ext,
+                      bool local, bool free_ins1, bool free_ins2,
+                      int& h, int& ins1_flag, int& ins2_flag)
+{
+  int diag=w+diag_h;
+  int ins1=left_h+(free_ins1 ? 0 : (left_ins1 ? gap_ext : gap_open));
+  int ins2=up_h+(free_ins2 ? 0 : (up_ins2 ? gap_ext : gap_open));
+  if (local) {
+    ins1=std::max(0, ins1);
+    ins2=std::max(0, ins2);
+  }
+  if (diag>=ins1) {
+    if (diag>=ins2) {
+      h=diag; ins1_flag=0; ins2_flag=0;
+    } else {
+      h=ins2; ins1_flag=0; ins2_flag=-1;
+    }
+  } else if (ins1>ins2) {
+    h=ins1; ins1_flag=-1; ins2_flag=0;
+  } else {
+    h=ins2; ins1_flag=0; ins2_flag=-1;
+  }
+}
+
+int boundary_score(AlignMode::Type mode, int d, int gap_open, int gap_ext)
+{
+  if (mode!=AlignMode::GLOBAL || d==0) {
+    return 0;
+  }
+  return gap_open+(d-1)*gap_ext;
+}
+
+/*
+  The alignment is calculated in two passes, which both fill the matrix row by
+  row like the aligners, but keep only two rows. For every cell, the first
+  pass also keeps the range of diagonals x-y the traceback from this cell
+  passes through. The second pass stores the cells of the band of diagonals
+  of the best path, which is all the traceback needs. The band is narrow for
+  similar sequences, the memory needed for the full matrix is saved at the
+  expense of filling the matrix twice.
+*/
+
+// a cell of the alignment matrix and the range of diagonals of its traceback
+struct BandPos {
+  BandPos(): score(0), from(impl::UNKN), lo(0), hi(0) { }
+  BandPos(int s, impl::Path f): score(s), from(f), lo(0), hi(0) { }
+  int        score;
+  impl::Path from;
+  int        lo;
+  int        hi;
+};
+
+// the two rows of the matrix needed to fill it row by row
+class RowPair {
+public:
+  RowPair(int height): rows_(2*height), height_(height) { }
+  BandPos& operator()(int x, int y) { return rows_[(x&1)*height_+y]; }
+private:
+  std::vector<BandPos> rows_;
+  int                  height_;
+};
+
+// the cells of the matrix with diagonal x-y in [lo, hi]
+class BandMat {
+public:
+  BandMat(int width, int height, int lo, int hi):
+    cells_(size_t(width)*(hi-lo+1)), height_(height), lo_(lo), hi_(hi)
+  { }
+
+  bool Contains(int x, int y) const
+  {
+    return y>=0 && y<height_ && x-y>=lo_ && x-y<=hi_;
+  }
+
+  BandPos& operator()(int x, int y)
+  {
+    assert(this->Contains(x, y));
+    return cells_[size_t(x)*(hi_-lo_+1)+(x-y-lo_)];
+  }
+private:
+  std::vector<BandPos> cells_;
+  int                  height_;
+  int                  lo_;
+  int                  hi_;
+};
+
+// Calculates cell (x, y) from its neighbours, exactly like LocalAlign,
+// GlobalAlign and SemiGlobalAlign do, including the boundary. n and m are
+// the lengths of the sequences.
+template <typename M>
+void fill_cell(M& mat, int x, int y, int weight, int n, int m,
+               int gap_open, int gap_ext, AlignMode::Type mode)
+{
+  BandPos& cell=mat(x, y);
+  int k=x-y;
+  if (x==0 || y==0) {
+    if (mode==AlignMode::LOCAL || (x==0 && y==0)) {
+      cell=BandPos(0, impl::UNKN);
+    } else if (x==0) {
+      const BandPos& prev=mat(0, y-1);
+      int pen=mode==AlignMode::SEMIGLOBAL ? 0 : (y==1 ? gap_open : gap_ext);
+      cell=BandPos(prev.score+pen, impl::INS1);
+    } else {
+      const BandPos& prev=mat(x-1, 0);
+      int pen=mode==AlignMode::SEMIGLOBAL ? 0 :
+              (prev.from==impl::INS2 ? gap_ext : gap_open);
+      cell=BandPos(prev.score+pen, impl::INS2);
+    }
+    // the global paths run along the boundary to the origin
+    cell.lo=(mode==AlignMode::LOCAL ? k : std::min(k, 0));
+    cell.hi=(mode==AlignMode::LOCAL ? k : std::max(k, 0));
+    return;
+  }
+  const BandPos& d=mat(x-1, y-1);
+  const BandPos& l=mat(x, y-1);
+  const BandPos& u=mat(x-1, y);
+  int diag=weight+d.score;
+  int ins1=l.score+(l.from==impl::INS1 ? gap_ext : gap_open);
+  int ins2=u.score+(u.from==impl::INS2 ? gap_ext : gap_open);
+  if (mode==AlignMode::LOCAL) {
+    ins1=std::max(0, ins1);
+    ins2=std::max(0, ins2);
+  } else if (mode==AlignMode::SEMIGLOBAL) {
+    // end gaps are free
+    if (y==m) {
+      ins2=u.score;
+    }
+    if (x==n) {
+      ins1=l.score;
+    }
+  }
+  const BandPos* prev;
+  int pk;
+  if (diag>=ins1 && diag>=ins2) {
+    cell=BandPos(diag, impl::DIAG);
+    prev=&d; pk=k;
+  } else if (diag>=ins1 || ins1<=ins2) {
+    cell=BandPos(ins2, impl::INS2);
+    prev=&u; pk=k-1;
+  } else {
+    cell=BandPos(ins1, impl::INS1);
+    prev=&l; pk=k+1;
+  }
+  // local paths end at the first cell without a positive score
+  if (mode==AlignMode::LOCAL && prev->score<=0) {
+    cell.lo=std::min(k, pk);
+    cell.hi=std::max(k, pk);
+  } else {
+    cell.lo=std::min(k, prev->lo);
+    cell.hi=std::max(k, prev->hi);
+  }
+}
+
+}
+
+AlignScorer::AlignScorer(const ConstSequenceHandle& query,
+                         const SubstWeightMatrix& subst,
+                         int gap_open, int gap_ext):
+  query_seq_(query), query_(query.GetLength()), table_(), gap_open_(gap_open),
+  gap_ext_(gap_ext)
+{
+  const int size=impl::WeightLookup::TABLE_SIZE;
+  table_.assign(size*size, 0);
+  for (int a=0; a<size-1; ++a) {
+    for (int b=0; b<size-1; ++b) {
+      table_[a*size+b]=subst.GetWeight('A'+a, 'A'+b);
+    }
+  }
+  for (int i=0; i<query.GetLength(); ++i) {
+    query_[i]=impl::ResidueCode(query[i])*size;
+  }
+}
+
+const char* AlignScorer::GetSIMDName()
+{
+#if defined(__AVX2__)
+  return "AVX2";
+#elif defined(__SSE2__)
+  return "SSE2";
+#else
+  return "none";
+#endif
+}
+
+int AlignScorer::LocalScore(const ConstSequenceHandle& target) const
+{
+  return this->Score(target, AlignMode::LOCAL);
+}
+
+int AlignScorer::GlobalScore(const ConstSequenceHandle& target) const
+{
+  return this->Score(target, AlignMode::GLOBAL);
+}
+
+int AlignScorer::SemiGlobalScore(const ConstSequenceHandle& target) const
+{
+  return this->Score(target, AlignMode::SEMIGLOBAL);
+}
+
+int AlignScorer::Score(const ConstSequenceHandle& target,
+                       AlignMode::Type mode) const
+{
+  std::vector<int> workspace;
+  return this->Score(target, mode, workspace);
+}
+
+int AlignScorer::Score(const ConstSequenceHandle& target, AlignMode::Type mode,
+                       std::vector<int>& workspace) const
+{
+  const int n=query_.size();
+  const int m=target.GetLength();
+  const bool local=(mode==AlignMode::LOCAL);
+  // three diagonals of scores, two of each direction mask, the weights of
+  // the current diagonal and the residue codes of the target
+  const int size=n+1;
+  workspace.resize(8*size+m);
+  std::fill(workspace.begin(), workspace.begin()+8*size, 0);
+  int* buffer=&workspace[0];
+  int* col=buffer+8*size;
+  for (int j=0; j<m; ++j) {
+    col[j]=impl::ResidueCode(target[j]);
+  }
+  int* h2=&buffer[0];
+  int* h1=&buffer[size];
+  int* h=&buffer[2*size];
+  int* ins1_prev=&buffer[3*size];
+  int* ins2_prev=&buffer[4*size];
+  int* ins1=&buffer[5*size];
+  int* ins2=&buffer[6*size];
+  int* w=&buffer[7*size];
+  int best=0;
+#if defined(__AVX2__) || defined(__SSE2__)
+  const simd_int v_open=simd_set1(gap_open_);
+  const simd_int v_ext=simd_set1(gap_ext_);
+  const simd_int v_zero=simd_set1(0);
+  const simd_int v_ones=simd_set1(-1);
+  simd_int v_best=v_zero;
+#endif
+  for (int d=0; d<=n+m; ++d) {
+    if (d<=m) {
+      // cell (0, d)
+      h[0]=boundary_score(mode, d, gap_open_, gap_ext_);
+      ins1[0]=(!local && d>0) ? -1 : 0;
+      ins2[0]=0;
+    }
+    if (d>0 && d<=n) {
+      // cell (d, 0)
+      h[d]=boundary_score(mode, d, gap_open_, gap_ext_);
+      ins1[d]=0;
+      ins2[d]=local ? 0 : -1;
+    }
+    const int lo=std::max(1, d-m);
+    const int hi=std::min(n, d-1);
+    for (int x=lo; x<=hi; ++x) {
+      w[x]=table_[query_[x-1]+col[d-x-1]];
+    }
+    int x=lo;
+#if defined(__AVX2__) || defined(__SSE2__)
+    for (; x+SIMD_WIDTH-1<=hi; x+=SIMD_WIDTH) {
+      simd_int diag=simd_add(simd_load(w+x), simd_load(h2+x-1));
+      simd_int gap1=simd_add(simd_load(h1+x),
+                             simd_select(simd_load(ins1_prev+x), v_ext, v_open));
+      simd_int gap2=simd_add(simd_load(h1+x-1),
+                             simd_select(simd_load(ins2_prev+x-1), v_ext,
+                                         v_open));
+      if (local) {
+        gap1=simd_max(gap1, v_zero);
+        gap2=simd_max(gap2, v_zero);
+      }
+      simd_int gap1_wins=simd_gt(gap1, diag);
+      simd_int gap2_wins=simd_gt(gap2, diag);
+      simd_int is_diag=simd_andnot(simd_or(gap1_wins, gap2_wins), v_ones);
+      simd_int is_ins1=simd_and(gap1_wins, simd_gt(gap1, gap2));
+      simd_int score=simd_select(is_diag, diag,
+                                 simd_select(is_ins1, gap1, gap2));
+      simd_store(h+x, score);
+      simd_store(ins1+x, is_ins1);
+      simd_store(ins2+x, simd_andnot(simd_or(is_diag, is_ins1), v_ones));
+      if (local) {
+        v_best=simd_max(v_best, score);
+      }
+    }
+#endif
+    for (; x<=hi; ++x) {
+      calc_cell(w[x], h2[x-1], h1[x], ins1_prev[x], h1[x-1], ins2_prev[x-1],
+                gap_open_, gap_ext_, local, false, false, h[x], ins1[x],
+                ins2[x]);
+      best=std::max(best, h[x]);
+    }
+    if (mode==AlignMode::SEMIGLOBAL) {
+      // end gaps are free, recalculate the cells in the last row and column
+      for (int k=0; k<2; ++k) {
+        int xe=(k==0 ? d-m : n);
+        if (xe<lo || xe>hi || (k==1 && xe==d-m)) {
+          continue;
+        }
+        calc_cell(w[xe], h2[xe-1], h1[xe], ins1_prev[xe], h1[xe-1],
+                  ins2_prev[xe-1], gap_open_, gap_ext_, false, xe==n,
+                  d-xe==m, h[xe], ins1[xe], ins2[xe]);
+      }
+    }
+    std::swap(h2, h1);
+    std::swap(h1, h);
+    std::swap(ins1_prev, ins1);
+    std::swap(ins2_prev, ins2);
+  }
+  if (!local) {
+    return h1[n];
+  }
+#if defined(__AVX2__) || defined(__SSE2__)
+  int lanes[SIMD_WIDTH];
+  simd_store(lanes, v_best);
+  for (int i=0; i<SIMD_WIDTH; ++i) {
+    best=std::max(best, lanes[i]);
+  }
+#endif
+  return best;
+}
+
+AlignmentList AlignScorer::Align(const ConstSequenceHandle& target,
+                                 AlignMode::Type mode) const
+{
+  const int n=query_.size();
+  const int m=target.GetLength();
+  std::vector<int> col(m);
+  for (int j=0; j<m; ++j) {
+    col[j]=impl::ResidueCode(target[j]);
+  }
+  // find the end of the best path and the diagonals it passes through. Like
+  // the local aligner, the last cell with the highest score is taken.
+  RowPair rows(m+1);
+  int end_x=n, end_y=m;
+  int best=0, lo=0, hi=0;
+  for (int x=0; x<=n; ++x) {
+    for (int y=0; y<=m; ++y) {
+      int weight=(x>0 && y>0) ? table_[query_[x-1]+col[y-1]] : 0;
+      fill_cell(rows, x, y, weight, n, m, gap_open_, gap_ext_, mode);
+      const BandPos& cell=rows(x, y);
+      if (mode==AlignMode::LOCAL && cell.score>=best) {
+        best=cell.score;
+        end_x=x;
+        end_y=y;
+        lo=cell.lo;
+        hi=cell.hi;
+      }
+    }
+  }
+  if (mode!=AlignMode::LOCAL) {
+    const BandPos& cell=rows(n, m);
+    best=cell.score;
+    lo=cell.lo;
+    hi=cell.hi;
+  }
+  AlignmentList alignments;
+  if (mode==AlignMode::LOCAL && best<=0) {
+    return alignments;
+  }
+  // the same cells again, the path ends in row end_x
+  BandMat mat(end_x+1, m+1, lo, hi);
+  for (int x=0; x<=end_x; ++x) {
+    for (int y=0; y<=m; ++y) {
+      int weight=(x>0 && y>0) ? table_[query_[x-1]+col[y-1]] : 0;
+      fill_cell(rows, x, y, weight, n, m, gap_open_, gap_ext_, mode);
+      if (mat.Contains(x, y)) {
+        mat(x, y)=rows(x, y);
+      }
+    }
+  }
+  int i=end_x, j=end_y;
+  String aln_str1, aln_str2;
+  if (mode==AlignMode::LOCAL) {
+    while (i>0 && j>0 && mat(i, j).score>0) {
+      impl::SetRoute(mat, i, j, query_seq_, target, aln_str1, aln_str2);
+    }
+    if (aln_str1.size()<2) {
+      return alignments;
+    }
+  } else {
+    while (i>0 || j>0) {
+      impl::SetRoute(mat, i, j, query_seq_, target, aln_str1, aln_str2);
+    }
+  }
+  impl::StoreStrAsAln(aln_str1, aln_str2, query_seq_, target, i, j,
+                      alignments);
+  return alignments;
+}
+
+int LocalAlignScore(const ConstSequenceHandle& s1,
+                    const ConstSequenceHandle& s2,
+                    SubstWeightMatrixPtr& subst, int gap_open, int gap_ext)
+{
+  return AlignScorer(s1, *subst, gap_open, gap_ext).LocalScore(s2);
+}
+
+int GlobalAlignScore(const ConstSequenceHandle& s1,
+                     const ConstSequenceHandle& s2,
+                     SubstWeightMatrixPtr& subst, int gap_open, int gap_ext)
+{
+  return AlignScorer(s1, *subst, gap_open, gap_ext).GlobalScore(s2);
+}
+
+int SemiGlobalAlignScore(const ConstSequenceHandle& s1,
+                         const ConstSequenceHandle& s2,
+                         SubstWeightMatrixPtr& subst, int gap_open,
+                         int gap_ext)
+{
+  return AlignScorer(s1, *subst, gap_open, gap_ext).SemiGlobalScore(s2);
+}
+
+}}}
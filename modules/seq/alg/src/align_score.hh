@@ -0,0 +1,124 @@
+//------------------------------------------------------------------------------
+// This file is part of the OpenStructure project <www.openstructure.org>
+//
+// Copyright (C) 2008-2020 by the OpenStructure authors
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 3.0 of the License, or (at your option)
+// any later version.
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//------------------------------------------------------------------------------
+#ifndef OST_SEQ_ALG_ALIGN_SCORE_HH
+#define OST_SEQ_ALG_ALIGN_SCORE_HH
+
+#include <vector>
+#include <ost/seq/sequence_handle.hh>
+#include <ost/seq/alignment_handle.hh>
+#include <ost/seq/alg/subst_weight_matrix.hh>
+#include "module_config.hh"
+
+namespace ost { namespace seq { namespace alg {
+
+/// \brief type of pairwise alignment
+struct AlignMode {
+  enum Type {
+    LOCAL=0,
+    GLOBAL,
+    SEMIGLOBAL
+  };
+};
+
+/// \brief score-only pairwise alignment of a query against many sequences
+///
+/// The scores are identical to the scores of the alignments returned by
+/// LocalAlign, GlobalAlign and SemiGlobalAlign, but only linear memory is
+/// required. The dynamic programming matrix is filled along anti-diagonals,
+/// whose cells are independent and processed with SSE2 instructions, or AVX2
+/// instructions when compiled with ENABLE_AVX2. The substitution weights of
+/// the query are precomputed once, which makes the scorer suitable to screen
+/// many sequences before calculating the full alignment for the best hits
+/// only.
+///
+/// Align calculates the alignment itself. The path of the best alignment is
+/// located in linear memory first, the traceback matrix is then only filled
+/// for the band of diagonals the path runs through.
+///
+/// The scorer is not modified by the scoring functions and can be used from
+/// several threads at the same time.
+class DLLEXPORT_OST_SEQ_ALG AlignScorer {
+public:
+  AlignScorer(const ConstSequenceHandle& query, const SubstWeightMatrix& subst,
+              int gap_open=-5, int gap_ext=-2);
+
+  /// \brief score of the best local alignment, see LocalAlign
+  int LocalScore(const ConstSequenceHandle& target) const;
+
+  /// \brief score of the global alignment, see GlobalAlign
+  int GlobalScore(const ConstSequenceHandle& target) const;
+
+  /// \brief score of the semi-global alignment, see SemiGlobalAlign
+  int SemiGlobalScore(const ConstSequenceHandle& target) const;
+
+  /// \brief score of the alignment of the given type
+  int Score(const ConstSequenceHandle& target, AlignMode::Type mode) const;
+
+  /// \brief score of the alignment of the given type
+  ///
+  /// The scratch buffers are stored in workspace, which can be reused for
+  /// subsequent calls to avoid memory allocations.
+  int Score(const ConstSequenceHandle& target, AlignMode::Type mode,
+            std::vector<int>& workspace) const;
+
+  /// \brief best alignment of the given type
+  ///
+  /// The alignment is identical to the first alignment returned by
+  /// LocalAlign, GlobalAlign or SemiGlobalAlign. The traceback matrix is only
+  /// filled for the band of diagonals of the best path, which needs much less
+  /// memory than the full aligners for similar sequences. In local mode, the
+  /// list is empty if no alignment of at least two columns is found.
+  AlignmentList Align(const ConstSequenceHandle& target,
+                      AlignMode::Type mode) const;
+
+  int GetQueryLength() const { return int(query_.size()); }
+
+  /// \brief name of the SIMD instruction set used by the scoring kernel
+  static const char* GetSIMDName();
+
+private:
+  ConstSequenceHandle query_seq_;
+  std::vector<int> query_;
+  std::vector<int> table_;
+  int              gap_open_;
+  int              gap_ext_;
+};
+
+/// \brief score of the best local alignment of s1 and s2, see LocalAlign
+int DLLEXPORT_OST_SEQ_ALG LocalAlignScore(const ConstSequenceHandle& s1,
+                                          const ConstSequenceHandle& s2,
+                                          SubstWeightMatrixPtr& subst,
+                                          int gap_open=-5, int gap_ext=-2);
+
+/// \brief score of the global alignment of s1 and s2, see GlobalAlign
+int DLLEXPORT_OST_SEQ_ALG GlobalAlignScore(const ConstSequenceHandle& s1,
+                                           const ConstSequenceHandle& s2,
+                                           SubstWeightMatrixPtr& subst,
+                                           int gap_open=-5, int gap_ext=-2);
+
+/// \brief score of the semi-global alignment of s1 and s2, see
+///     SemiGlobalAlign
+int DLLEXPORT_OST_SEQ_ALG SemiGlobalAlignScore(const ConstSequenceHandle& s1,
+                                               const ConstSequenceHandle& s2,
+                                               SubstWeightMatrixPtr& subst,
+                                               int gap_open=-5,
+                                               int gap_ext=-2);
+}}}
+
+#endif
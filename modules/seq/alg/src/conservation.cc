@@ -20,6 +20,7 @@
 #include <ost/seq/aligned_column.hh>
 #include <ost/seq/alignment_handle.hh>
 #include <ost/seq/alg/conservation.hh>
+#include <ost/seq/alg/encoded_alignment.hh>
 
 namespace ost { namespace seq { namespace alg {
 
@@ -104,19 +105,42 @@ float PhysicoChemicalDissim(char c1, char c2, bool ignore_gap)
 std::vector<Real> Conservation(const AlignmentHandle& aln, bool assign, 
                                const String& prop, bool ignore_gap)
 {
+  // amino acids in the order of the rows of CHEM_DISSIM. Gaps and unknown 
+  // characters have index 20.
+  static const char alphabet[]="CPAGSTQENDHKRVLIMFYW-XZB";
+  std::vector<char> aa_list(alphabet, alphabet+24);
+  EncodedAlignment ali(aln, aa_list);
+  float dissim[24][24];
+  for (int a=0; a<24; ++a) {
+    for (int b=a; b<24; ++b) {
+      dissim[a][b]=dissim[b][a]=CHEM_DISSIM[a][b-a];
+    }
+  }
+  if (ignore_gap) {
+    dissim[20][20]=6.0;
+  }
   std::vector<Real> cons(aln.GetLength(), 0.0);
   int comb=(aln.GetCount()*(aln.GetCount()-1))/2;
+  std::vector<uint32_t> counts;
   for (int col=0; col<aln.GetLength(); ++col) {
-    float score=0.0;
-    AlignedColumn c=aln[col];
-    for (int i=0; i<aln.GetCount(); ++i) {
-      for (int j=i+1; j<aln.GetCount(); ++j) {
-        score+=PhysicoChemicalDissim(c[i], c[j], ignore_gap);
+    // the sum over all pairs of sequences only depends on how often each 
+    // amino acid occurs in the column
+    ali.CountColumn(col, counts);
+    counts[20]+=counts[24];
+    double score_sum=0.0;
+    for (int a=0; a<24; ++a) {
+      if (counts[a]==0) {
+        continue;
+      }
+      score_sum+=0.5*counts[a]*(counts[a]-1.0)*dissim[a][a];
+      for (int b=a+1; b<24; ++b) {
+        score_sum+=double(counts[a])*counts[b]*dissim[a][b];
       }
     }
-    score=1.0-score/(6.0*comb);
+    float score=1.0-score_sum/(6.0*comb);
     cons[col]=score;
     if (assign) {
+      AlignedColumn c=aln[col];
       for (int i=0; i<aln.GetCount(); ++i) {
         if (c[i]!='-') {
           mol::ResidueView r=c.GetResidue(i);
@@ -19,7 +19,12 @@
 
 #include <ost/seq/aligned_column.hh>
 #include <ost/seq/alignment_handle.hh>
+#include <boost/thread/thread.hpp>
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+#include <ost/message.hh>
 #include <ost/seq/alg/contact_prediction_score.hh>
+#include <ost/seq/alg/encoded_alignment.hh>
 #include <math.h>
 
 namespace {
@@ -64,141 +69,196 @@ void ContactPredictionScoreResult::SetScore(int i, int j, Real score){
   }
 
 
-ContactPredictionScoreResult CalculateContactSubstitutionScore(const AlignmentHandle& aln, int ref_seq_index, PairSubstWeightMatrix w){
-  int n_col=aln.GetLength();
-  int n_row=aln.GetCount();
-  //We transform the alignment in a list of ints
-  std::vector< std::vector <int> > ali(n_col, std::vector <int> (n_row) );
-  int naa=w.aa_list.size();
-  for (int i=0; i<n_col; ++i) {
-    for (int j=0; j<n_row; ++j) {
-      std::map<char,int>::iterator iter=w.aa_dict.find(aln[i][j]);
-      if (iter!=w.aa_dict.end()){
-        ali[i][j]=w.aa_dict[aln[i][j]];
-      }
-      else ali[i][j]=naa;
-    }
+namespace {
+
+// calls rows(first, num_threads) from num_threads threads. Each call scores
+// the column pairs (col1, col2) with col2>col1 for every num_threads-th col1,
+// starting at first, which spreads the triangle of column pairs evenly.
+void run_column_rows(const boost::function<void (int, int)>& rows,
+                     int num_threads)
+{
+  if (num_threads<1) {
+    throw Error("Number of threads must be at least 1");
   }
-  std::vector< std::vector <Real> > contact_subst_score(n_col, std::vector <Real> (n_col,0) );
-  for (int col1=0; col1<n_col; ++col1) {
-    std::vector<int> c1=ali[col1];
-    int i1=c1[ref_seq_index];
-    if (i1==naa){
-      for (int col2=col1+1; col2<n_col; ++col2) {
-        contact_subst_score[col1][col2]=0.0;
-        contact_subst_score[col2][col1]=0.0;
-      }
+  if (num_threads==1) {
+    rows(0, 1);
+    return;
+  }
+  boost::thread_group tg;
+  for (int i=0; i<num_threads; ++i) {
+    tg.create_thread(boost::bind(rows, i, num_threads));
+  }
+  tg.join_all();
+}
+
+// The scores below are sums over the sequences of a term that only depends
+// on the amino acid pair of the two columns. They are computed from the
+// counts of the amino acid pairs, the code naa (gaps and unknown amino acids)
+// does not contribute.
+
+void contact_subst_score_rows(const EncodedAlignment& ali,
+                              const PairSubstWeightMatrix& w,
+                              int ref_seq_index, int first, int num_threads,
+                              std::vector<std::vector<Real> >& scores)
+{
+  int n_col=ali.GetLength();
+  int n_row=ali.GetCount();
+  int naa=ali.GetAlphabetSize();
+  std::vector<uint32_t> counts;
+  for (int col1=first; col1<n_col; col1+=num_threads) {
+    int i1=ali.GetCode(col1, ref_seq_index);
+    if (i1==naa) {
       continue;
     }
     for (int col2=col1+1; col2<n_col; ++col2) {
-      std::vector<int> c2=ali[col2];
-      int i2=c2[ref_seq_index];
-      if (i2==naa){
-        contact_subst_score[col1][col2]=0.0;
-        contact_subst_score[col2][col1]=0.0;
+      int i2=ali.GetCode(col2, ref_seq_index);
+      if (i2==naa) {
         continue;
-        }
+      }
+      ali.CountColumnPair(col1, col2, counts);
+      const std::vector<std::vector<Real> >& w12=w.weights[i1][i2];
       Real score=0.0;
-      for (int i=0 ; i<n_row; ++i){
-        if (i==ref_seq_index) continue;
-        int i3=c1[i], i4=c2[i];
-        if (i3==naa || i4==naa){
-          score+=0.0;
-          continue;
+      for (int aa1=0; aa1<naa; ++aa1) {
+        const uint32_t* c=&counts[aa1*(naa+1)];
+        for (int aa2=0; aa2<naa; ++aa2) {
+          score+=c[aa2]*w12[aa1][aa2];
         }
-        score+=w.weights[i1][i2][i3][i4];
       }
-    contact_subst_score[col1][col2]=score/(n_row-1.);
-    contact_subst_score[col2][col1]=score/(n_row-1.);
+      // the reference sequence is not compared to itself
+      score-=w12[i1][i2];
+      scores[col1][col2]=score/(n_row-1.);
+      scores[col2][col1]=score/(n_row-1.);
     }
   }
-  return ContactPredictionScoreResult(contact_subst_score);
 }
 
-ContactPredictionScoreResult CalculateContactScore(const AlignmentHandle& aln, ContactWeightMatrix weights){
-  int n_col=aln.GetLength();
-  int n_row=aln.GetCount();
-  //We transform the alignment in a list of ints
-  std::vector< std::vector <int> > ali(n_col, std::vector <int> (n_row) );
-  int naa=weights.aa_list.size();
-  for (int i=0; i<n_col; ++i) {
-    for (int j=0; j<n_row; ++j) {
-      std::map<char,int>::iterator iter=weights.aa_dict.find(aln[i][j]);
-      if (iter!=weights.aa_dict.end()){
-        ali[i][j]=weights.aa_dict[aln[i][j]];
-      }
-      else ali[i][j]=naa;
-    }
-  }
-
-  std::vector< std::vector <Real> > mi(n_col, std::vector <Real> (n_col,0) );
-
-  for (int col1=0; col1<n_col; ++col1) {
-    std::vector<int> c1=ali[col1];
+void contact_score_rows(const EncodedAlignment& ali,
+                        const ContactWeightMatrix& w, int first,
+                        int num_threads,
+                        std::vector<std::vector<Real> >& scores)
+{
+  int n_col=ali.GetLength();
+  int n_row=ali.GetCount();
+  int naa=ali.GetAlphabetSize();
+  std::vector<uint32_t> counts;
+  for (int col1=first; col1<n_col; col1+=num_threads) {
     for (int col2=col1+1; col2<n_col; ++col2) {
-      float score=0.0;
-      for (int i=0 ; i<n_row; ++i){
-        int aa1=c1[i];
-        int aa2=ali[col2][i];
-        if (aa1==naa || aa2==naa) continue;
-        score+=weights.weights[aa1][aa2];
+      ali.CountColumnPair(col1, col2, counts);
+      Real score=0.0;
+      for (int aa1=0; aa1<naa; ++aa1) {
+        const uint32_t* c=&counts[aa1*(naa+1)];
+        for (int aa2=0; aa2<naa; ++aa2) {
+          score+=c[aa2]*w.weights[aa1][aa2];
+        }
       }
-      mi[col1][col2]=score/n_row;
-      mi[col2][col1]=score/n_row;
+      scores[col1][col2]=score/n_row;
+      scores[col2][col1]=score/n_row;
     }
   }
-  return ContactPredictionScoreResult(mi);
 }
 
-
-ContactPredictionScoreResult CalculateMutualInformation(const AlignmentHandle& aln, ContactWeightMatrix weights,
-                                  bool apc_correction,bool zpx_transformation, float small_number_correction){
-  int n_col=aln.GetLength();
-  int n_row=aln.GetCount();
-  //We transform the alignment in a list of ints
-  std::vector< std::vector <int> > ali(n_col, std::vector <int> (n_row) );
-  int naa=weights.aa_list.size();
-  for (int i=0; i<n_col; ++i) {
-    for (int j=0; j<n_row; ++j) {
-      std::map<char,int>::iterator iter=weights.aa_dict.find(aln[i][j]);
-      if (iter!=weights.aa_dict.end()){
-        ali[i][j]=weights.aa_dict[aln[i][j]];
-      }
-      else ali[i][j]=naa;
+void mutual_information_rows(const EncodedAlignment& ali,
+                             const ContactWeightMatrix& w,
+                             Real small_number_correction, int first,
+                             int num_threads,
+                             std::vector<std::vector<Real> >& mi)
+{
+  int n_col=ali.GetLength();
+  int n_row=ali.GetCount();
+  int naa=ali.GetAlphabetSize();
+  Real snc=small_number_correction;
+  // logarithms of the pair frequencies p12=count+snc for all possible counts
+  std::vector<Real> log_p12(n_row+1, 0.0);
+  for (int c=0; c<=n_row; ++c) {
+    if (c+snc>0.0) {
+      log_p12[c]=std::log(c+snc);
     }
   }
-
-  std::vector< std::vector <Real> > mi(n_col, std::vector <Real> (n_col,0) );
-
-  for (int col1=0; col1<n_col; ++col1) {
-    std::vector<int> c1=ali[col1];
+  std::vector<uint32_t> counts;
+  std::vector<Real> p1(naa), p2(naa), log_p1(naa), log_p2(naa);
+  for (int col1=first; col1<n_col; col1+=num_threads) {
     for (int col2=col1+1; col2<n_col; ++col2) {
-      std::vector<float> p1(naa,naa*small_number_correction),p2(naa,naa*small_number_correction);
-      std::vector<std::vector<float> > p12(naa, std::vector<float> (naa,small_number_correction));
-      for (int i=0 ; i<n_row; ++i){
-        int aa1=c1[i];
-        int aa2=ali[col2][i];
-        if (aa1==naa || aa2==naa) continue;
-        p1[aa1]++;
-        p2[aa2]++;
-        p12[aa1][aa2]++;
+      ali.CountColumnPair(col1, col2, counts);
+      std::fill(p1.begin(), p1.end(), naa*snc);
+      std::fill(p2.begin(), p2.end(), naa*snc);
+      for (int aa1=0; aa1<naa; ++aa1) {
+        const uint32_t* c=&counts[aa1*(naa+1)];
+        for (int aa2=0; aa2<naa; ++aa2) {
+          p1[aa1]+=c[aa2];
+          p2[aa2]+=c[aa2];
+        }
       }
-      float n=naa*small_number_correction;
-      for (int aa1=0; aa1!=naa; ++aa1){
-        n+=p1[aa1];
+      Real n=naa*snc;
+      for (int aa=0; aa<naa; ++aa) {
+        n+=p1[aa];
+        log_p1[aa]=p1[aa]>0.0 ? std::log(p1[aa]) : 0.0;
+        log_p2[aa]=p2[aa]>0.0 ? std::log(p2[aa]) : 0.0;
       }
-      float score=0.0;
-      for (int aa1=0; aa1!=naa; ++aa1){
-        if(p1[aa1]==0.0) continue;
-        for (int aa2=0; aa2!=naa; ++aa2){
-          if(p12[aa1][aa2]==0.0 || p2[aa2]==0.0) continue;
-          score+=weights.weights[aa1][aa2]*p12[aa1][aa2]/n*std::log(n*p12[aa1][aa2]/(p1[aa1]*p2[aa2]));
+      // sum of w*p12/n*log(n*p12/(p1*p2))
+      Real log_n=n>0.0 ? std::log(n) : 0.0;
+      Real score=0.0;
+      for (int aa1=0; aa1<naa; ++aa1) {
+        if (p1[aa1]==0.0) {
+          continue;
+        }
+        const uint32_t* c=&counts[aa1*(naa+1)];
+        for (int aa2=0; aa2<naa; ++aa2) {
+          Real p12=c[aa2]+snc;
+          if (p12==0.0 || p2[aa2]==0.0) {
+            continue;
+          }
+          score+=w.weights[aa1][aa2]*p12*(log_n+log_p12[c[aa2]]-log_p1[aa1]-
+                                          log_p2[aa2]);
         }
       }
+      if (n>0.0) {
+        score/=n;
+      }
       mi[col1][col2]=score;
       mi[col2][col1]=score;
     }
   }
+}
+
+}
+
+ContactPredictionScoreResult CalculateContactSubstitutionScore(const AlignmentHandle& aln, int ref_seq_index,
+                                                               PairSubstWeightMatrix w, int num_threads){
+  if (ref_seq_index<0 || ref_seq_index>=aln.GetCount()) {
+    throw Error("Reference sequence index out of range");
+  }
+  int n_col=aln.GetLength();
+  EncodedAlignment ali(aln, w.aa_list);
+  std::vector< std::vector <Real> > contact_subst_score(n_col, std::vector <Real> (n_col,0) );
+  run_column_rows(boost::bind(&contact_subst_score_rows, boost::cref(ali),
+                              boost::cref(w), ref_seq_index, _1, _2,
+                              boost::ref(contact_subst_score)),
+                  num_threads);
+  return ContactPredictionScoreResult(contact_subst_score);
+}
+
+ContactPredictionScoreResult CalculateContactScore(const AlignmentHandle& aln, ContactWeightMatrix weights,
+                                                   int num_threads){
+  int n_col=aln.GetLength();
+  EncodedAlignment ali(aln, weights.aa_list);
+  std::vector< std::vector <Real> > mi(n_col, std::vector <Real> (n_col,0) );
+  run_column_rows(boost::bind(&contact_score_rows, boost::cref(ali),
+                              boost::cref(weights), _1, _2, boost::ref(mi)),
+                  num_threads);
+  return ContactPredictionScoreResult(mi);
+}
+
+
+ContactPredictionScoreResult CalculateMutualInformation(const AlignmentHandle& aln, ContactWeightMatrix weights,
+                                  bool apc_correction,bool zpx_transformation, float small_number_correction,
+                                  int num_threads){
+  int n_col=aln.GetLength();
+  EncodedAlignment ali(aln, weights.aa_list);
+  std::vector< std::vector <Real> > mi(n_col, std::vector <Real> (n_col,0) );
+  run_column_rows(boost::bind(&mutual_information_rows, boost::cref(ali),
+                              boost::cref(weights), small_number_correction,
+                              _1, _2, boost::ref(mi)),
+                  num_threads);
   if (apc_correction==true){
     float average_mi=0.;
     std::vector <float> mi_col(n_col,0.);
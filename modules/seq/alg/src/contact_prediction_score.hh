@@ -48,10 +48,15 @@ struct DLLEXPORT_OST_SEQ_ALG ContactPredictionScoreResult {
   ContactPredictionScoreResult(std::vector <std::vector <Real> >);
 };
 
-ContactPredictionScoreResult DLLEXPORT_OST_SEQ_ALG CalculateContactScore(const AlignmentHandle& aln, ContactWeightMatrix w=LoadDefaultContactWeightMatrix());
-ContactPredictionScoreResult DLLEXPORT_OST_SEQ_ALG CalculateContactSubstitutionScore(const AlignmentHandle& aln, int ref_seq_index=0, PairSubstWeightMatrix w=LoadDefaultPairSubstWeightMatrix());
+/// The scores are computed from the counts of the amino acid pairs in each pair
+/// of columns, the column pairs are distributed among num_threads threads.
+ContactPredictionScoreResult DLLEXPORT_OST_SEQ_ALG CalculateContactScore(const AlignmentHandle& aln, ContactWeightMatrix w=LoadDefaultContactWeightMatrix(),
+                            int num_threads=1);
+ContactPredictionScoreResult DLLEXPORT_OST_SEQ_ALG CalculateContactSubstitutionScore(const AlignmentHandle& aln, int ref_seq_index=0, PairSubstWeightMatrix w=LoadDefaultPairSubstWeightMatrix(),
+                            int num_threads=1);
 ContactPredictionScoreResult DLLEXPORT_OST_SEQ_ALG CalculateMutualInformation(const AlignmentHandle& aln, ContactWeightMatrix w=LoadConstantContactWeightMatrix(),bool apc_correction=true, 
-                            bool zpx_transformation=true,float small_number_correction=0.05);
+                            bool zpx_transformation=true,float small_number_correction=0.05,
+                            int num_threads=1);
 
 }}}
 #endif
@@ -0,0 +1,91 @@
+//------------------------------------------------------------------------------
+// This file is part of the OpenStructure project <www.openstructure.org>
+//
+// Copyright (C) 2008-2020 by the OpenStructure authors
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 3.0 of the License, or (at your option)
+// any later version.
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//------------------------------------------------------------------------------
+#include <algorithm>
+#include <ost/message.hh>
+#include <ost/seq/alg/encoded_alignment.hh>
+
+namespace ost { namespace seq { namespace alg {
+
+EncodedAlignment::EncodedAlignment(const AlignmentHandle& aln,
+                                   const std::vector<char>& alphabet):
+  length_(aln.GetLength()), count_(aln.GetCount()),
+  alphabet_size_(alphabet.size())
+{
+  if (alphabet.size()>254) {
+    throw Error("Alphabet of encoded alignment must have less than 255 "
+                "characters");
+  }
+  uint8_t lookup[256];
+  std::fill_n(lookup, 256, uint8_t(alphabet_size_));
+  // the last occurrence wins, as for the aa_dict of the weight matrices
+  for (int i=0; i<alphabet_size_; ++i) {
+    lookup[static_cast<unsigned char>(alphabet[i])]=uint8_t(i);
+  }
+  codes_.resize(size_t(length_)*count_);
+  // the sequences are stored row by row, transpose them while encoding
+  for (int row=0; row<count_; ++row) {
+    ConstSequenceHandle s=aln.GetSequence(row);
+    const String& seq=s.GetString();
+    uint8_t* dst=&codes_[row];
+    for (int col=0; col<length_; ++col, dst+=count_) {
+      *dst=lookup[static_cast<unsigned char>(seq[col])];
+    }
+  }
+}
+
+void EncodedAlignment::CountColumn(int col, std::vector<uint32_t>& counts) const
+{
+  counts.assign(alphabet_size_+1, 0);
+  const uint8_t* c=this->GetColumn(col);
+  for (int i=0; i<count_; ++i) {
+    ++counts[c[i]];
+  }
+}
+
+void EncodedAlignment::CountColumnPair(int col1, int col2,
+                                       std::vector<uint32_t>& counts) const
+{
+  const uint8_t* c1=this->GetColumn(col1);
+  const uint8_t* c2=this->GetColumn(col2);
+  const int n=alphabet_size_+1;
+  const int n2=n*n;
+  // four interleaved histograms, so that consecutive increments of the same
+  // pair do not wait for each other
+  counts.assign(4*n2, 0);
+  uint32_t* h0=&counts[0];
+  uint32_t* h1=h0+n2;
+  uint32_t* h2=h1+n2;
+  uint32_t* h3=h2+n2;
+  int i=0;
+  for (; i+4<=count_; i+=4) {
+    ++h0[c1[i  ]*n+c2[i  ]];
+    ++h1[c1[i+1]*n+c2[i+1]];
+    ++h2[c1[i+2]*n+c2[i+2]];
+    ++h3[c1[i+3]*n+c2[i+3]];
+  }
+  for (; i<count_; ++i) {
+    ++h0[c1[i]*n+c2[i]];
+  }
+  for (int k=0; k<n2; ++k) {
+    h0[k]+=h1[k]+h2[k]+h3[k];
+  }
+  counts.resize(n2);
+}
+
+}}}
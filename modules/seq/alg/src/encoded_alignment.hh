@@ -0,0 +1,86 @@
+//------------------------------------------------------------------------------
+// This file is part of the OpenStructure project <www.openstructure.org>
+//
+// Copyright (C) 2008-2020 by the OpenStructure authors
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 3.0 of the License, or (at your option)
+// any later version.
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//------------------------------------------------------------------------------
+#ifndef OST_SEQ_ALG_ENCODED_ALIGNMENT_HH
+#define OST_SEQ_ALG_ENCODED_ALIGNMENT_HH
+
+#include <vector>
+#include <ost/stdint.hh>
+#include <ost/seq/alignment_handle.hh>
+#include <ost/seq/alg/module_config.hh>
+
+namespace ost { namespace seq { namespace alg {
+
+/// \brief multiple sequence alignment stored column by column as one byte
+///     codes
+///
+/// Each character is replaced by its index in the alphabet. Characters that
+/// are not part of the alphabet get the code GetAlphabetSize(). The codes of
+/// a column are contiguous in memory, which makes it cheap to count the
+/// characters of a column or the character pairs of two columns.
+class DLLEXPORT_OST_SEQ_ALG EncodedAlignment {
+public:
+  EncodedAlignment(const AlignmentHandle& aln,
+                   const std::vector<char>& alphabet);
+
+  /// \brief number of columns
+  int GetLength() const { return length_; }
+
+  /// \brief number of sequences
+  int GetCount() const { return count_; }
+
+  /// \brief number of characters in the alphabet, which is also the code of
+  ///     characters not in the alphabet
+  int GetAlphabetSize() const { return alphabet_size_; }
+
+  /// \brief codes of the column, one per sequence
+  const uint8_t* GetColumn(int col) const
+  {
+    return &codes_[size_t(col)*count_];
+  }
+
+  uint8_t GetCode(int col, int row) const
+  {
+    return codes_[size_t(col)*count_+row];
+  }
+
+  /// \brief count the codes of a column
+  ///
+  /// counts is resized to GetAlphabetSize()+1 entries, entry a being the
+  /// number of sequences with code a in the column.
+  void CountColumn(int col, std::vector<uint32_t>& counts) const;
+
+  /// \brief count the code pairs of two columns
+  ///
+  /// With n=GetAlphabetSize()+1, counts is resized to n*n entries, entry a*n+b
+  /// being the number of sequences with code a in col1 and code b in col2.
+  /// The buffer can be reused for subsequent calls to avoid memory
+  /// allocations.
+  void CountColumnPair(int col1, int col2,
+                       std::vector<uint32_t>& counts) const;
+
+private:
+  std::vector<uint8_t> codes_;
+  int                  length_;
+  int                  count_;
+  int                  alphabet_size_;
+};
+
+}}}
+
+#endif
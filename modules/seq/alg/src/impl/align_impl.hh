@@ -38,6 +38,50 @@ struct DLLEXPORT AlnPos {
   impl::Path  from;
 };
 
+/// \brief code of a residue in substitution weight lookup tables. Letters are
+///     mapped to 0-25, everything else to 26.
+inline int ResidueCode(char aa)
+{
+  int c=toupper(aa)-'A';
+  return (c>=0 && c<SubstWeightMatrix::ALPHABET_SIZE) ? c : 
+                                                SubstWeightMatrix::ALPHABET_SIZE;
+}
+
+/// \brief substitution weights of the residues of two sequences
+/// 
+/// The residues are converted to codes once, so the weight of a pair of
+/// residues is a plain table lookup without the character checks of
+/// SubstWeightMatrix::GetWeight.
+struct DLLEXPORT WeightLookup {
+  const static int TABLE_SIZE=SubstWeightMatrix::ALPHABET_SIZE+1;
+
+  WeightLookup(const SubstWeightMatrix& subst, const ConstSequenceHandle& s1,
+               const ConstSequenceHandle& s2):
+    table_(TABLE_SIZE*TABLE_SIZE, 0), row_(s1.GetLength()), 
+    col_(s2.GetLength())
+  {
+    for (int a=0; a<TABLE_SIZE-1; ++a) {
+      for (int b=0; b<TABLE_SIZE-1; ++b) {
+        table_[a*TABLE_SIZE+b]=subst.GetWeight('A'+a, 'A'+b);
+      }
+    }
+    for (int i=0; i<s1.GetLength(); ++i) {
+      row_[i]=ResidueCode(s1[i])*TABLE_SIZE;
+    }
+    for (int j=0; j<s2.GetLength(); ++j) {
+      col_[j]=ResidueCode(s2[j]);
+    }
+  }
+
+  /// \brief weight of the i-th residue of s1 and the j-th residue of s2
+  short operator()(int i, int j) const { return table_[row_[i]+col_[j]]; }
+
+ private:
+  std::vector<short> table_;
+  std::vector<int>   row_;
+  std::vector<int>   col_;
+};
+
 struct DLLEXPORT AlnMat {
   AlnMat(int width, int height): 
     mat_(width*height), width_(width), height_(height)
@@ -58,7 +102,12 @@ struct DLLEXPORT AlnMat {
   int               height_;  
 };
         
-inline void DLLEXPORT SetRoute(impl::AlnMat& mat, int& i, int& j,
+/// \brief follow the path one cell back from (i, j), appending the aligned
+///     residues to the (reversed) alignment strings
+///
+/// The matrix type must give access to the cells with mat(i, j), e.g. AlnMat.
+template <typename M>
+inline void SetRoute(M& mat, int& i, int& j,
                      const ConstSequenceHandle& s1, 
                      const ConstSequenceHandle& s2,
                      String& aln_str1, String& aln_str2)
@@ -66,11 +66,10 @@ AlignmentList LocalAlign(const ConstSequenceHandle& s1,
                          int gap_open, int gap_ext)
 {
   impl::AlnMat mat(s1.GetLength()+1, s2.GetLength()+1);
+  impl::WeightLookup weights(*subst, s1, s2);
   for (int i=0; i<mat.GetWidth()-1; ++i) {
     for (int j=0; j<mat.GetHeight()-1; ++j) {
-      char c1=s1[i];
-      char c2=s2[j];
-      short weight=subst->GetWeight(c1, c2);
+      short weight=weights(i, j);
       int diag=weight+mat(i, j).score;
       int ins1=mat(i+1, j).score
               +(mat(i+1, j).from==impl::INS1 ? gap_ext : gap_open);
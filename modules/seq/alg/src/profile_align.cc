@@ -0,0 +1,396 @@
+//------------------------------------------------------------------------------
+// This file is part of the OpenStructure project <www.openstructure.org>
+//
+// Copyright (C) 2008-2020 by the OpenStructure authors
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 3.0 of the License, or (at your option)
+// any later version.
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//------------------------------------------------------------------------------
+#include <algorithm>
+#include <cmath>
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#include <boost/thread/thread.hpp>
+#include <boost/bind.hpp>
+#include <ost/message.hh>
+#include "impl/align_impl.hh"
+#include "profile_align.hh"
+
+namespace ost { namespace seq { namespace alg {
+
+namespace {
+
+const int NUM_FREQS=20;
+
+#if defined(__AVX__)
+
+typedef __m256 simd_float;
+const int SIMD_WIDTH=8;
+
+inline simd_float simd_load(const float* p) { return _mm256_loadu_ps(p); }
+inline void simd_store(float* p, simd_float a) { _mm256_storeu_ps(p, a); }
+inline simd_float simd_set1(float a) { return _mm256_set1_ps(a); }
+inline simd_float simd_add(simd_float a, simd_float b) { return _mm256_add_ps(a, b); }
+inline simd_float simd_mul(simd_float a, simd_float b) { return _mm256_mul_ps(a, b); }
+
+#elif defined(__SSE2__)
+
+typedef __m128 simd_float;
+const int SIMD_WIDTH=4;
+
+inline simd_float simd_load(const float* p) { return _mm_loadu_ps(p); }
+inline void simd_store(float* p, simd_float a) { _mm_storeu_ps(p, a); }
+inline simd_float simd_set1(float a) { return _mm_set1_ps(a); }
+inline simd_float simd_add(simd_float a, simd_float b) { return _mm_add_ps(a, b); }
+inline simd_float simd_mul(simd_float a, simd_float b) { return _mm_mul_ps(a, b); }
+
+#else
+
+const int SIMD_WIDTH=1;
+
+#endif
+
+// Fills the dynamic programming matrix with the recursion of LocalAlign,
+// GlobalAlign and SemiGlobalAlign. Only two rows are kept unless full is
+// true, which is required for the traceback. Returns the alignment score,
+// end_i and end_j are set to the cell the traceback starts from.
+float fill_matrix(const float* scores, int stride, int len1, int len2,
+                  float gap_open, float gap_ext, AlignMode::Type mode,
+                  bool full, std::vector<float>& dp_scores,
+                  std::vector<char>& dp_paths, int& end_i, int& end_j)
+{
+  const bool local=mode==AlignMode::LOCAL;
+  const bool semi=mode==AlignMode::SEMIGLOBAL;
+  const int width=len2+1;
+  dp_scores.resize((full ? len1+1 : 2)*width);
+  dp_paths.resize(dp_scores.size());
+  float* h=&dp_scores[0];
+  char* path=&dp_paths[0];
+  h[0]=0;
+  path[0]=impl::UNKN;
+  for (int j=1; j<width; ++j) {
+    if (mode==AlignMode::GLOBAL) {
+      h[j]=(j==1 ? gap_open : h[j-1]+gap_ext);
+    } else {
+      h[j]=0;
+    }
+    path[j]=(local ? impl::UNKN : impl::INS1);
+  }
+  float best=0;
+  end_i=0;
+  end_j=0;
+  for (int i=0; i<len1; ++i) {
+    int prev_row=(full ? i : i%2)*width;
+    int cur_row=(full ? i+1 : (i+1)%2)*width;
+    const float* h_prev=h+prev_row;
+    const char* path_prev=path+prev_row;
+    float* h_cur=h+cur_row;
+    char* path_cur=path+cur_row;
+    const float* row_scores=scores+i*stride;
+    if (mode==AlignMode::GLOBAL) {
+      h_cur[0]=h_prev[0]+(path_prev[0]==impl::INS2 ? gap_ext : gap_open);
+    } else {
+      h_cur[0]=0;
+    }
+    path_cur[0]=(local ? impl::UNKN : impl::INS2);
+    const bool last_row=i+1==len1;
+    for (int j=0; j<len2; ++j) {
+      float diag=row_scores[j]+h_prev[j];
+      float ins1=h_cur[j]+(path_cur[j]==impl::INS1 ? gap_ext : gap_open);
+      float ins2=h_prev[j+1]+(path_prev[j+1]==impl::INS2 ? gap_ext : gap_open);
+      if (semi) {
+        // end gaps are free
+        if (j+1==len2) {
+          ins2=h_prev[j+1];
+        }
+        if (last_row) {
+          ins1=h_cur[j];
+        }
+      } else if (local) {
+        ins1=std::max(0.0f, ins1);
+        ins2=std::max(0.0f, ins2);
+      }
+      if (diag>=ins1) {
+        if (diag>=ins2) {
+          h_cur[j+1]=diag;
+          path_cur[j+1]=impl::DIAG;
+        } else {
+          h_cur[j+1]=ins2;
+          path_cur[j+1]=impl::INS2;
+        }
+      } else if (ins1>ins2) {
+        h_cur[j+1]=ins1;
+        path_cur[j+1]=impl::INS1;
+      } else {
+        h_cur[j+1]=ins2;
+        path_cur[j+1]=impl::INS2;
+      }
+      if (local && h_cur[j+1]>=best) {
+        best=h_cur[j+1];
+        end_i=i+1;
+        end_j=j+1;
+      }
+    }
+  }
+  if (local) {
+    return best;
+  }
+  end_i=len1;
+  end_j=len2;
+  return h[(full ? len1 : len1%2)*width+len2];
+}
+
+}
+
+ProfileAligner::ProfileAligner(const ProfileHandle& query, Real gap_open,
+                               Real gap_ext):
+  query_(query.size()*NUM_FREQS), sequence_(query.GetSequence()),
+  gap_open_(gap_open), gap_ext_(gap_ext)
+{
+  const Real* null_model=query.GetNullModel().freqs_begin();
+  for (size_t i=0; i<query.size(); ++i) {
+    const Real* freqs=query[i].freqs_begin();
+    for (int k=0; k<NUM_FREQS; ++k) {
+      query_[i*NUM_FREQS+k]=freqs[k]/null_model[k];
+    }
+  }
+}
+
+const char* ProfileAligner::GetSIMDName()
+{
+#if defined(__AVX__)
+  return "AVX";
+#elif defined(__SSE2__)
+  return "SSE2";
+#else
+  return "none";
+#endif
+}
+
+int ProfileAligner::ScoreMatrix(const ProfileHandle& target,
+                                Workspace& workspace) const
+{
+  const int len1=sequence_.size();
+  const int len2=target.size();
+  // the target is stored by frequency, so the frequencies of consecutive
+  // target columns can be loaded at once
+  const int stride=std::max(1, (len2+SIMD_WIDTH-1)/SIMD_WIDTH)*SIMD_WIDTH;
+  workspace.target.assign(NUM_FREQS*stride, 0.0f);
+  for (int j=0; j<len2; ++j) {
+    const Real* freqs=target[j].freqs_begin();
+    for (int k=0; k<NUM_FREQS; ++k) {
+      workspace.target[k*stride+j]=freqs[k];
+    }
+  }
+  workspace.scores.resize(len1*stride);
+  const float* t=workspace.target.empty() ? NULL : &workspace.target[0];
+  for (int i=0; i<len1; ++i) {
+    const float* q=&query_[i*NUM_FREQS];
+    float* row_scores=&workspace.scores[i*stride];
+#if defined(__AVX__) || defined(__SSE2__)
+    for (int j=0; j<stride; j+=SIMD_WIDTH) {
+      // offset to avoid zero score, see ProfileColumn::GetScore
+      simd_float sum=simd_set1(0.001f);
+      for (int k=0; k<NUM_FREQS; ++k) {
+        sum=simd_add(sum, simd_mul(simd_set1(q[k]),
+                                   simd_load(t+k*stride+j)));
+      }
+      simd_store(row_scores+j, sum);
+    }
+#else
+    for (int j=0; j<len2; ++j) {
+      float sum=0.001f;
+      for (int k=0; k<NUM_FREQS; ++k) {
+        sum+=q[k]*t[k*stride+j];
+      }
+      row_scores[j]=sum;
+    }
+#endif
+    for (int j=0; j<len2; ++j) {
+      row_scores[j]=std::log(row_scores[j]);
+    }
+  }
+  return stride;
+}
+
+std::vector<Real> ProfileAligner::GetScoreMatrix(
+                                           const ProfileHandle& target) const
+{
+  Workspace workspace;
+  int stride=this->ScoreMatrix(target, workspace);
+  std::vector<Real> scores(sequence_.size()*target.size());
+  for (size_t i=0; i<sequence_.size(); ++i) {
+    for (size_t j=0; j<target.size(); ++j) {
+      scores[i*target.size()+j]=workspace.scores[i*stride+j];
+    }
+  }
+  return scores;
+}
+
+Real ProfileAligner::Score(const ProfileHandle& target,
+                           AlignMode::Type mode) const
+{
+  Workspace workspace;
+  return this->Score(target, mode, workspace);
+}
+
+Real ProfileAligner::Score(const ProfileHandle& target, AlignMode::Type mode,
+                           Workspace& workspace) const
+{
+  int stride=this->ScoreMatrix(target, workspace);
+  int end_i, end_j;
+  const float* scores=workspace.scores.empty() ? NULL : &workspace.scores[0];
+  return fill_matrix(scores, stride, sequence_.size(), target.size(),
+                     gap_open_, gap_ext_, mode, false, workspace.dp_scores,
+                     workspace.dp_paths, end_i, end_j);
+}
+
+AlignmentHandle ProfileAligner::Align(const ProfileHandle& target,
+                                      AlignMode::Type mode) const
+{
+  Workspace workspace;
+  int stride=this->ScoreMatrix(target, workspace);
+  const int len1=sequence_.size();
+  const int len2=target.size();
+  int i, j;
+  const float* scores=workspace.scores.empty() ? NULL : &workspace.scores[0];
+  fill_matrix(scores, stride, len1, len2, gap_open_, gap_ext_, mode, true,
+              workspace.dp_scores, workspace.dp_paths, i, j);
+  const String target_seq=target.GetSequence();
+  String aln_str1, aln_str2;
+  const int width=len2+1;
+  while (mode==AlignMode::LOCAL ?
+         (i>0 && j>0 && workspace.dp_scores[i*width+j]>0) : (i>0 || j>0)) {
+    switch (workspace.dp_paths[i*width+j]) {
+      case impl::DIAG:
+        --i;
+        --j;
+        aln_str1.push_back(sequence_[i]);
+        aln_str2.push_back(target_seq[j]);
+        break;
+      case impl::INS1:
+        --j;
+        aln_str1.push_back('-');
+        aln_str2.push_back(target_seq[j]);
+        break;
+      default:
+        --i;
+        aln_str1.push_back(sequence_[i]);
+        aln_str2.push_back('-');
+        break;
+    }
+  }
+  if (mode==AlignMode::LOCAL && aln_str1.size()<2) {
+    return AlignmentHandle();
+  }
+  std::reverse(aln_str1.begin(), aln_str1.end());
+  std::reverse(aln_str2.begin(), aln_str2.end());
+  AlignmentHandle aln=CreateAlignment();
+  aln.AddSequence(CreateSequence("query", aln_str1));
+  aln.AddSequence(CreateSequence("target", aln_str2));
+  aln.SetSequenceOffset(0, i);
+  aln.SetSequenceOffset(1, j);
+  return aln;
+}
+
+namespace {
+
+bool compare_hits(const ProfileAlignHit& lhs, const ProfileAlignHit& rhs)
+{
+  if (lhs.score!=rhs.score) {
+    return lhs.score>rhs.score;
+  }
+  return lhs.index<rhs.index;
+}
+
+// scores every num_threads-th target, starting at first. The workspace is
+// private to the thread and shared by all of its targets.
+void score_profiles(const ProfileAligner& aligner,
+                    const ProfileHandleList& targets, AlignMode::Type mode,
+                    int first, int num_threads, ProfileAlignHitList& hits)
+{
+  ProfileAligner::Workspace workspace;
+  for (size_t i=first; i<targets.size(); i+=num_threads) {
+    hits[i]=ProfileAlignHit(i, aligner.Score(*targets[i], mode, workspace));
+  }
+}
+
+void align_profile_hits(const ProfileAligner& aligner,
+                        const ProfileHandleList& targets,
+                        AlignMode::Type mode, int first, int num_threads,
+                        ProfileAlignHitList& hits)
+{
+  for (size_t i=first; i<hits.size(); i+=num_threads) {
+    hits[i].aln=aligner.Align(*targets[hits[i].index], mode);
+  }
+}
+
+}
+
+ProfileAlignHitList ProfileAlignOneToMany(const ProfileHandle& query,
+                                          const ProfileHandleList& targets,
+                                          Real gap_open, Real gap_ext,
+                                          AlignMode::Type mode, int top_k,
+                                          bool alignments, int num_threads)
+{
+  if (num_threads<1) {
+    throw Error("Number of threads must be at least 1");
+  }
+  for (size_t i=0; i<targets.size(); ++i) {
+    if (!targets[i]) {
+      throw Error("Invalid target profile");
+    }
+  }
+  num_threads=std::max(1, std::min(num_threads, int(targets.size())));
+  ProfileAligner aligner(query, gap_open, gap_ext);
+  ProfileAlignHitList hits(targets.size());
+  if (num_threads==1) {
+    score_profiles(aligner, targets, mode, 0, 1, hits);
+  } else {
+    boost::thread_group tg;
+    for (int i=0; i<num_threads; ++i) {
+      tg.create_thread(boost::bind(&score_profiles, boost::cref(aligner),
+                                   boost::cref(targets), mode, i,
+                                   num_threads, boost::ref(hits)));
+    }
+    tg.join_all();
+  }
+  if (top_k>0 && size_t(top_k)<hits.size()) {
+    std::partial_sort(hits.begin(), hits.begin()+top_k, hits.end(),
+                      compare_hits);
+    hits.resize(top_k);
+  } else {
+    std::sort(hits.begin(), hits.end(), compare_hits);
+  }
+  if (!alignments || hits.empty()) {
+    return hits;
+  }
+  num_threads=std::min(num_threads, int(hits.size()));
+  if (num_threads==1) {
+    align_profile_hits(aligner, targets, mode, 0, 1, hits);
+  } else {
+    boost::thread_group tg;
+    for (int i=0; i<num_threads; ++i) {
+      tg.create_thread(boost::bind(&align_profile_hits, boost::cref(aligner),
+                                   boost::cref(targets), mode, i,
+                                   num_threads, boost::ref(hits)));
+    }
+    tg.join_all();
+  }
+  return hits;
+}
+
+}}}
@@ -0,0 +1,136 @@
+//------------------------------------------------------------------------------
+// This file is part of the OpenStructure project <www.openstructure.org>
+//
+// Copyright (C) 2008-2020 by the OpenStructure authors
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 3.0 of the License, or (at your option)
+// any later version.
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//------------------------------------------------------------------------------
+#ifndef OST_SEQ_ALG_PROFILE_ALIGN_HH
+#define OST_SEQ_ALG_PROFILE_ALIGN_HH
+
+#include <vector>
+#include <ost/seq/alignment_handle.hh>
+#include <ost/seq/profile_handle.hh>
+#include <ost/seq/alg/align_score.hh>
+#include "module_config.hh"
+
+namespace ost { namespace seq { namespace alg {
+
+/// \brief pairwise alignment of a query profile with target profiles
+///
+/// Column pairs are scored with ProfileColumn::GetScore, using the null model
+/// of the query. The query columns are divided by the null model once, which
+/// turns the column score into the logarithm of a dot product. The scores of
+/// all column pairs of query and target are precomputed before the alignment,
+/// the dot products are calculated for several target columns at once with
+/// SIMD instructions if available (AVX or SSE2).
+///
+/// The alignment uses the recursion of LocalAlign, GlobalAlign and
+/// SemiGlobalAlign: gap_open is added for the first position of a gap and
+/// gap_ext for every further position.
+///
+/// The aligner is not modified by the alignment functions and can be used from
+/// several threads at the same time.
+class DLLEXPORT_OST_SEQ_ALG ProfileAligner {
+public:
+  /// \brief scratch buffers of the alignment functions
+  struct Workspace {
+    std::vector<float> target;
+    std::vector<float> scores;
+    std::vector<float> dp_scores;
+    std::vector<char>  dp_paths;
+  };
+
+  ProfileAligner(const ProfileHandle& query, Real gap_open=-3.0,
+                 Real gap_ext=-0.6);
+
+  /// \brief score of the alignment of the given type
+  Real Score(const ProfileHandle& target, AlignMode::Type mode) const;
+
+  /// \brief score of the alignment of the given type
+  ///
+  /// The scratch buffers are stored in workspace, which can be reused for
+  /// subsequent calls to avoid memory allocations.
+  Real Score(const ProfileHandle& target, AlignMode::Type mode,
+             Workspace& workspace) const;
+
+  /// \brief alignment of the given type with the query as first and the
+  ///     target as second sequence, named "query" and "target".
+  ///
+  /// For local alignments, an invalid handle is returned if query and target
+  /// do not share a local alignment of at least two columns.
+  AlignmentHandle Align(const ProfileHandle& target,
+                        AlignMode::Type mode) const;
+
+  /// \brief scores of all column pairs. Entry i*target.size()+j is the score
+  ///     of column i of the query with column j of the target.
+  std::vector<Real> GetScoreMatrix(const ProfileHandle& target) const;
+
+  int GetQueryLength() const { return int(sequence_.size()); }
+
+  /// \brief name of the SIMD instruction set used for the column scores
+  static const char* GetSIMDName();
+
+private:
+  int ScoreMatrix(const ProfileHandle& target, Workspace& workspace) const;
+
+  std::vector<float> query_;
+  String             sequence_;
+  float              gap_open_;
+  float              gap_ext_;
+};
+
+/// \brief hit of ProfileAlignOneToMany
+struct DLLEXPORT_OST_SEQ_ALG ProfileAlignHit {
+  ProfileAlignHit(): index(-1), score(0) { }
+  ProfileAlignHit(int i, Real s): index(i), score(s) { }
+
+  /// \brief index of the target in the list of targets
+  int index;
+  /// \brief alignment score
+  Real score;
+  /// \brief alignment of the query with the target. Only valid if alignments
+  ///     were requested and, for local alignments, if the profiles share a
+  ///     local alignment of at least two columns.
+  AlignmentHandle aln;
+
+  bool operator==(const ProfileAlignHit& rhs) const
+  {
+    return index==rhs.index && score==rhs.score;
+  }
+  bool operator!=(const ProfileAlignHit& rhs) const
+  {
+    return !this->operator==(rhs);
+  }
+};
+
+typedef std::vector<ProfileAlignHit> ProfileAlignHitList;
+
+/// \brief align query profile to each of the target profiles and return the
+///     best hits
+///
+/// Works like AlignOneToMany: the targets are scored with a ProfileAligner by
+/// num_threads threads. The hits are sorted by descending score, ties are
+/// ordered by target index. If top_k is positive, only the top_k best hits are
+/// returned. If alignments is true, the alignments of the returned hits are
+/// calculated as well.
+ProfileAlignHitList DLLEXPORT_OST_SEQ_ALG
+ProfileAlignOneToMany(const ProfileHandle& query,
+                      const ProfileHandleList& targets, Real gap_open=-3.0,
+                      Real gap_ext=-0.6, AlignMode::Type mode=AlignMode::LOCAL,
+                      int top_k=-1, bool alignments=false, int num_threads=1);
+
+}}}
+
+#endif
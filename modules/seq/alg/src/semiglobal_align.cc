@@ -43,6 +43,7 @@ AlignmentList SemiGlobalAlign(const ConstSequenceHandle& s1,
                               int gap_open,int gap_ext)
 {
   impl::AlnMat mat(s1.GetLength()+1, s2.GetLength()+1);
+  impl::WeightLookup weights(*subst, s1, s2);
   // init first column of matrix no start gap penalty
   if (mat.GetHeight() > 1) {
     mat(0, 1).score = mat(0, 0).score;
@@ -57,9 +58,7 @@ AlignmentList SemiGlobalAlign(const ConstSequenceHandle& s1,
     mat(i+1, 0).score = mat(i, 0).score;
     mat(i+1, 0).from = impl::INS2;
     for (int j = 0; j < mat.GetHeight()-1; ++j) {
-      char c1=s1[i];
-      char c2=s2[j];
-      short weight=subst->GetWeight(c1, c2);
+      short weight=weights(i, j);
       int diag=weight+mat(i, j).score;
       int ins1=mat(i+1, j).score
               +(mat(i+1, j).from==impl::INS1 ? gap_ext : gap_open);
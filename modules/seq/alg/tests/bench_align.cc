@@ -0,0 +1,136 @@
+//------------------------------------------------------------------------------
+// This file is part of the OpenStructure project <www.openstructure.org>
+//
+// Copyright (C) 2008-2020 by the OpenStructure authors
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 3.0 of the License, or (at your option)
+// any later version.
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//------------------------------------------------------------------------------
+
+/*
+  Measures the throughput of the pairwise aligners in GCUPS (giga cell updates
+  per second).
+
+  usage: bench_align [query_length] [target_length] [num_targets]
+
+  A random query is aligned to random targets with the full aligners and with
+  the score-only AlignScorer. The scores of both must agree. AlignScorer::Align
+  is timed for local alignments with banded traceback.
+*/
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdlib>
+#include <boost/random.hpp>
+#include <ost/seq/alg/local_align.hh>
+#include <ost/seq/alg/global_align.hh>
+#include <ost/seq/alg/semiglobal_align.hh>
+#include <ost/seq/alg/align_score.hh>
+
+using namespace ost;
+using namespace ost::seq;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double seconds_since(const Clock::time_point& start)
+{
+  return std::chrono::duration<double>(Clock::now()-start).count();
+}
+
+String random_seq(boost::mt19937& rng, int length)
+{
+  const char* letters="ACDEFGHIKLMNPQRSTVWY";
+  boost::uniform_int<int> dist(0, 19);
+  String s;
+  for (int i=0; i<length; ++i) {
+    s.push_back(letters[dist(rng)]);
+  }
+  return s;
+}
+
+void report(const String& name, double cells, double seconds)
+{
+  std::cout << std::setw(24) << name << std::setw(12) << std::fixed
+            << std::setprecision(3) << seconds << std::setw(12)
+            << cells/seconds*1e-9 << std::endl;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  int query_length=argc>1 ? atoi(argv[1]) : 300;
+  int target_length=argc>2 ? atoi(argv[2]) : 300;
+  int num_targets=argc>3 ? atoi(argv[3]) : 200;
+  boost::mt19937 rng(42);
+  SequenceHandle query=CreateSequence("query", random_seq(rng, query_length));
+  SequenceList targets=CreateSequenceList();
+  for (int i=0; i<num_targets; ++i) {
+    targets.AddSequence(CreateSequence("target",
+                                       random_seq(rng, target_length)));
+  }
+  alg::SubstWeightMatrixPtr subst(new alg::SubstWeightMatrix);
+  subst->AssignPreset(alg::SubstWeightMatrix::BLOSUM62);
+  double cells=double(query_length)*target_length*num_targets;
+  std::cout << num_targets << " alignments of " << query_length << "x"
+            << target_length << ", SIMD: " << alg::AlignScorer::GetSIMDName()
+            << std::endl;
+  std::cout << std::setw(24) << "method" << std::setw(12) << "seconds"
+            << std::setw(12) << "GCUPS" << std::endl;
+
+  Clock::time_point start=Clock::now();
+  for (int i=0; i<num_targets; ++i) {
+    alg::LocalAlign(query, targets[i], subst);
+  }
+  report("LocalAlign", cells, seconds_since(start));
+  start=Clock::now();
+  for (int i=0; i<num_targets; ++i) {
+    alg::GlobalAlign(query, targets[i], subst);
+  }
+  report("GlobalAlign", cells, seconds_since(start));
+
+  alg::AlignScorer scorer(query, *subst);
+  std::vector<int> local_scores(num_targets), global_scores(num_targets);
+  start=Clock::now();
+  for (int i=0; i<num_targets; ++i) {
+    local_scores[i]=scorer.LocalScore(targets[i]);
+  }
+  report("AlignScorer::LocalScore", cells, seconds_since(start));
+  start=Clock::now();
+  for (int i=0; i<num_targets; ++i) {
+    global_scores[i]=scorer.GlobalScore(targets[i]);
+  }
+  report("AlignScorer::GlobalScore", cells, seconds_since(start));
+  start=Clock::now();
+  for (int i=0; i<num_targets; ++i) {
+    scorer.SemiGlobalScore(targets[i]);
+  }
+  report("AlignScorer::SemiGlobal", cells, seconds_since(start));
+  start=Clock::now();
+  for (int i=0; i<num_targets; ++i) {
+    scorer.Align(targets[i], alg::AlignMode::LOCAL);
+  }
+  report("AlignScorer::Align", cells, seconds_since(start));
+
+  // spot check against the plain score functions
+  for (int i=0; i<std::min(num_targets, 10); ++i) {
+    if (local_scores[i]!=alg::LocalAlignScore(query, targets[i], subst) ||
+        global_scores[i]!=alg::GlobalAlignScore(query, targets[i], subst)) {
+      std::cerr << "ERROR: inconsistent scores" << std::endl;
+      return 1;
+    }
+  }
+  return 0;
+}
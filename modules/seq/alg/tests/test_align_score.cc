@@ -0,0 +1,236 @@
+//------------------------------------------------------------------------------
+// This file is part of the OpenStructure project <www.openstructure.org>
+//
+// Copyright (C) 2008-2020 by the OpenStructure authors
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 3.0 of the License, or (at your option)
+// any later version.
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//------------------------------------------------------------------------------
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <boost/random.hpp>
+#include <ost/seq/alg/local_align.hh>
+#include <ost/seq/alg/global_align.hh>
+#include <ost/seq/alg/semiglobal_align.hh>
+#include <ost/seq/alg/align_score.hh>
+#include <ost/seq/alg/align_one_to_many.hh>
+
+using namespace ost;
+using namespace ost::seq;
+
+namespace {
+
+// score of a pairwise alignment with the gap penalties used by the aligners:
+// the extension penalty applies when the previous column is a gap in the same
+// sequence. For semi-global alignments, leading and trailing gaps are free.
+int aln_score(const AlignmentHandle& aln, alg::SubstWeightMatrixPtr subst,
+              int gap_open, int gap_ext, bool semi)
+{
+  String s1=aln.GetSequence(0).GetString();
+  String s2=aln.GetSequence(1).GetString();
+  int len1=aln.GetSequence(0).GetGaplessString().size();
+  int len2=aln.GetSequence(1).GetGaplessString().size();
+  int score=0, pos1=0, pos2=0;
+  char prev=0;
+  for (size_t i=0; i<s1.size(); ++i) {
+    char state;
+    if (s1[i]!='-' && s2[i]!='-') {
+      score+=subst->GetWeight(s1[i], s2[i]);
+      state='d';
+    } else if (s1[i]=='-') {
+      state='1';
+      if (!semi || (pos1>0 && pos1<len1)) {
+        score+=(prev==state ? gap_ext : gap_open);
+      }
+    } else {
+      state='2';
+      if (!semi || (pos2>0 && pos2<len2)) {
+        score+=(prev==state ? gap_ext : gap_open);
+      }
+    }
+    pos1+=(s1[i]!='-');
+    pos2+=(s2[i]!='-');
+    prev=state;
+  }
+  return score;
+}
+
+String random_seq(boost::mt19937& rng, int length)
+{
+  // includes a lower case letter and a character without weight
+  const char* letters="ACDEFGHIKLMNPQRSTVWYacX?";
+  boost::uniform_int<int> dist(0, 23);
+  String s;
+  for (int i=0; i<length; ++i) {
+    s.push_back(letters[dist(rng)]);
+  }
+  return s;
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(ost_seq_alg);
+
+BOOST_AUTO_TEST_CASE(align_score_simple)
+{
+  alg::SubstWeightMatrixPtr subst(new alg::SubstWeightMatrix);
+  subst->AssignPreset(alg::SubstWeightMatrix::BLOSUM62);
+  SequenceHandle s1=CreateSequence("A", "ACDEFGHIKLMN");
+  SequenceHandle s2=CreateSequence("B", "ACDHIKLMN");
+  AlignmentList alns=alg::GlobalAlign(s1, s2, subst);
+  BOOST_CHECK_EQUAL(alg::GlobalAlignScore(s1, s2, subst),
+                    aln_score(alns[0], subst, -5, -2, false));
+  // identical sequences
+  alg::AlignScorer scorer(s1, *subst);
+  int self_score=0;
+  for (int i=0; i<s1.GetLength(); ++i) {
+    self_score+=subst->GetWeight(s1[i], s1[i]);
+  }
+  BOOST_CHECK_EQUAL(scorer.LocalScore(s1), self_score);
+  BOOST_CHECK_EQUAL(scorer.GlobalScore(s1), self_score);
+  BOOST_CHECK_EQUAL(scorer.SemiGlobalScore(s1), self_score);
+  // empty target
+  SequenceHandle empty=CreateSequence("C", "");
+  BOOST_CHECK_EQUAL(scorer.LocalScore(empty), 0);
+  BOOST_CHECK_EQUAL(scorer.GlobalScore(empty), -5-2*11);
+  BOOST_CHECK_EQUAL(scorer.SemiGlobalScore(empty), 0);
+}
+
+BOOST_AUTO_TEST_CASE(align_score_random)
+{
+  alg::SubstWeightMatrixPtr subst(new alg::SubstWeightMatrix);
+  subst->AssignPreset(alg::SubstWeightMatrix::BLOSUM62);
+  boost::mt19937 rng(7);
+  boost::uniform_int<int> length(1, 70);
+  for (int k=0; k<50; ++k) {
+    SequenceHandle s1=CreateSequence("A", random_seq(rng, length(rng)));
+    SequenceHandle s2=CreateSequence("B", random_seq(rng, length(rng)));
+    // identical sequences with insertions give long alignments
+    if (k%5==0) {
+      s2=CreateSequence("B", s1.GetString().substr(0, s1.GetLength()/2)+
+                        random_seq(rng, 5)+
+                        s1.GetString().substr(s1.GetLength()/2));
+    }
+    int gap_open=-(k%7)-2;
+    int gap_ext=-(k%3)-1;
+    alg::AlignScorer scorer(s1, *subst, gap_open, gap_ext);
+    AlignmentList alns=alg::GlobalAlign(s1, s2, subst, gap_open, gap_ext);
+    BOOST_CHECK_EQUAL(scorer.GlobalScore(s2),
+                      aln_score(alns[0], subst, gap_open, gap_ext, false));
+    alns=alg::SemiGlobalAlign(s1, s2, subst, gap_open, gap_ext);
+    BOOST_CHECK_EQUAL(scorer.SemiGlobalScore(s2),
+                      aln_score(alns[0], subst, gap_open, gap_ext, true));
+    alns=alg::LocalAlign(s1, s2, subst, gap_open, gap_ext);
+    if (!alns.empty()) {
+      BOOST_CHECK_EQUAL(scorer.LocalScore(s2),
+                        aln_score(alns[0], subst, gap_open, gap_ext, false));
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(align_score_banded_traceback)
+{
+  alg::SubstWeightMatrixPtr subst(new alg::SubstWeightMatrix);
+  subst->AssignPreset(alg::SubstWeightMatrix::BLOSUM62);
+  boost::mt19937 rng(13);
+  boost::uniform_int<int> length(0, 60);
+  for (int k=0; k<60; ++k) {
+    SequenceHandle s1=CreateSequence("A", random_seq(rng, length(rng)));
+    SequenceHandle s2=CreateSequence("B", random_seq(rng, length(rng)));
+    // similar sequences give narrow bands
+    if (k%3==0) {
+      s2=CreateSequence("B", s1.GetString().substr(0, s1.GetLength()/2)+
+                        random_seq(rng, 4)+
+                        s1.GetString().substr(s1.GetLength()/2));
+    }
+    int gap_open=-(k%7)-2;
+    int gap_ext=-(k%3)-1;
+    alg::AlignScorer scorer(s1, *subst, gap_open, gap_ext);
+    AlignmentList expected[]={
+      alg::LocalAlign(s1, s2, subst, gap_open, gap_ext),
+      alg::GlobalAlign(s1, s2, subst, gap_open, gap_ext),
+      alg::SemiGlobalAlign(s1, s2, subst, gap_open, gap_ext)
+    };
+    alg::AlignMode::Type modes[]={ alg::AlignMode::LOCAL,
+                                   alg::AlignMode::GLOBAL,
+                                   alg::AlignMode::SEMIGLOBAL };
+    for (int m=0; m<3; ++m) {
+      AlignmentList alns=scorer.Align(s2, modes[m]);
+      BOOST_REQUIRE_EQUAL(alns.size(), std::min(expected[m].size(), size_t(1)));
+      if (alns.empty()) {
+        continue;
+      }
+      for (int i=0; i<2; ++i) {
+        BOOST_CHECK_EQUAL(alns[0].GetSequence(i).GetString(),
+                          expected[m][0].GetSequence(i).GetString());
+        BOOST_CHECK_EQUAL(alns[0].GetSequence(i).GetOffset(),
+                          expected[m][0].GetSequence(i).GetOffset());
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(align_one_to_many)
+{
+  alg::SubstWeightMatrixPtr subst(new alg::SubstWeightMatrix);
+  subst->AssignPreset(alg::SubstWeightMatrix::BLOSUM62);
+  boost::mt19937 rng(11);
+  boost::uniform_int<int> length(1, 50);
+  SequenceHandle query=CreateSequence("Q", random_seq(rng, 40));
+  SequenceList targets=CreateSequenceList();
+  for (int i=0; i<23; ++i) {
+    targets.AddSequence(CreateSequence("T", random_seq(rng, length(rng))));
+  }
+  // duplicates give ties, which are ordered by index
+  targets.AddSequence(targets[3].Copy());
+  alg::AlignScorer scorer(query, *subst);
+  alg::AlignMode::Type modes[]={ alg::AlignMode::LOCAL, alg::AlignMode::GLOBAL,
+                                 alg::AlignMode::SEMIGLOBAL };
+  for (int m=0; m<3; ++m) {
+    alg::AlignHitList all=alg::AlignOneToMany(query, targets, subst, -5, -2,
+                                              modes[m]);
+    BOOST_REQUIRE_EQUAL(all.size(), size_t(targets.GetCount()));
+    for (size_t i=0; i<all.size(); ++i) {
+      BOOST_CHECK_EQUAL(all[i].score,
+                        scorer.Score(targets[all[i].index], modes[m]));
+      BOOST_CHECK(!all[i].aln.IsValid());
+      if (i>0) {
+        BOOST_CHECK(all[i-1].score>all[i].score ||
+                    (all[i-1].score==all[i].score &&
+                     all[i-1].index<all[i].index));
+      }
+    }
+    for (int num_threads=1; num_threads<5; ++num_threads) {
+      alg::AlignHitList top=alg::AlignOneToMany(query, targets, subst, -5, -2,
+                                                modes[m], 7, true,
+                                                num_threads);
+      BOOST_REQUIRE_EQUAL(top.size(), size_t(7));
+      for (size_t i=0; i<top.size(); ++i) {
+        BOOST_CHECK(top[i]==all[i]);
+        if (top[i].aln.IsValid()) {
+          BOOST_CHECK_EQUAL(aln_score(top[i].aln, subst, -5, -2,
+                                      modes[m]==alg::AlignMode::SEMIGLOBAL),
+                            top[i].score);
+        } else {
+          BOOST_CHECK(modes[m]==alg::AlignMode::LOCAL);
+        }
+      }
+    }
+  }
+  SequenceList empty=CreateSequenceList();
+  BOOST_CHECK(alg::AlignOneToMany(query, empty, subst, -5, -2,
+                                  alg::AlignMode::LOCAL, 5, true, 4).empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END();
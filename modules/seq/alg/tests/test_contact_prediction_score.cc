@@ -0,0 +1,234 @@
+//------------------------------------------------------------------------------
+// This file is part of the OpenStructure project <www.openstructure.org>
+//
+// Copyright (C) 2008-2020 by the OpenStructure authors
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 3.0 of the License, or (at your option)
+// any later version.
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//------------------------------------------------------------------------------
+#define BOOST_TEST_DYN_LINK
+#include <cmath>
+#include <boost/test/unit_test.hpp>
+#include <boost/random.hpp>
+#include <ost/seq/aligned_column.hh>
+#include <ost/seq/alg/encoded_alignment.hh>
+#include <ost/seq/alg/contact_prediction_score.hh>
+#include <ost/seq/alg/conservation.hh>
+
+using namespace ost;
+using namespace ost::seq;
+
+namespace {
+
+AlignmentHandle random_alignment(boost::mt19937& rng, int n_seq, int length)
+{
+  // a few columns are conserved, the others are mostly random
+  const String chars="ACDEFGHIKLMNPQRSTVWY-X";
+  boost::uniform_int<int> aa(0, chars.size()-1);
+  boost::uniform_int<int> percent(0, 99);
+  String consensus;
+  for (int i=0; i<length; ++i) {
+    consensus+=chars[aa(rng)];
+  }
+  AlignmentHandle aln=CreateAlignment();
+  for (int i=0; i<n_seq; ++i) {
+    String s=consensus;
+    for (int j=0; j<length; ++j) {
+      if (percent(rng)<(j%3)*40) {
+        s[j]=chars[aa(rng)];
+      }
+    }
+    aln.AddSequence(CreateSequence("seq", s));
+  }
+  return aln;
+}
+
+int aa_index(const std::map<char,int>& aa_dict, char c, int naa)
+{
+  std::map<char,int>::const_iterator i=aa_dict.find(c);
+  return i==aa_dict.end() ? naa : i->second;
+}
+
+// direct sums over the sequences of the alignment
+
+Real ref_contact_score(const AlignmentHandle& aln,
+                       const alg::ContactWeightMatrix& w, int col1, int col2)
+{
+  int naa=w.aa_list.size();
+  Real score=0;
+  for (int i=0; i<aln.GetCount(); ++i) {
+    int aa1=aa_index(w.aa_dict, aln[col1][i], naa);
+    int aa2=aa_index(w.aa_dict, aln[col2][i], naa);
+    if (aa1!=naa && aa2!=naa) {
+      score+=w.weights[aa1][aa2];
+    }
+  }
+  return score/aln.GetCount();
+}
+
+Real ref_subst_score(const AlignmentHandle& aln,
+                     const alg::PairSubstWeightMatrix& w, int ref, int col1,
+                     int col2)
+{
+  int naa=w.aa_list.size();
+  int i1=aa_index(w.aa_dict, aln[col1][ref], naa);
+  int i2=aa_index(w.aa_dict, aln[col2][ref], naa);
+  if (i1==naa || i2==naa) {
+    return 0;
+  }
+  Real score=0;
+  for (int i=0; i<aln.GetCount(); ++i) {
+    int aa1=aa_index(w.aa_dict, aln[col1][i], naa);
+    int aa2=aa_index(w.aa_dict, aln[col2][i], naa);
+    if (i!=ref && aa1!=naa && aa2!=naa) {
+      score+=w.weights[i1][i2][aa1][aa2];
+    }
+  }
+  return score/(aln.GetCount()-1);
+}
+
+Real ref_mutual_information(const AlignmentHandle& aln,
+                            const alg::ContactWeightMatrix& w, Real snc,
+                            int col1, int col2)
+{
+  int naa=w.aa_list.size();
+  std::vector<Real> p1(naa, naa*snc), p2(naa, naa*snc);
+  std::vector<std::vector<Real> > p12(naa, std::vector<Real>(naa, snc));
+  for (int i=0; i<aln.GetCount(); ++i) {
+    int aa1=aa_index(w.aa_dict, aln[col1][i], naa);
+    int aa2=aa_index(w.aa_dict, aln[col2][i], naa);
+    if (aa1!=naa && aa2!=naa) {
+      p1[aa1]+=1;
+      p2[aa2]+=1;
+      p12[aa1][aa2]+=1;
+    }
+  }
+  Real n=naa*snc;
+  for (int aa1=0; aa1<naa; ++aa1) {
+    n+=p1[aa1];
+  }
+  Real score=0;
+  for (int aa1=0; aa1<naa; ++aa1) {
+    for (int aa2=0; aa2<naa; ++aa2) {
+      if (p12[aa1][aa2]>0) {
+        score+=w.weights[aa1][aa2]*p12[aa1][aa2]/n*
+               std::log(n*p12[aa1][aa2]/(p1[aa1]*p2[aa2]));
+      }
+    }
+  }
+  return score;
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(ost_seq_alg);
+
+BOOST_AUTO_TEST_CASE(encoded_alignment)
+{
+  AlignmentHandle aln=CreateAlignment();
+  aln.AddSequence(CreateSequence("a", "AC-DZ"));
+  aln.AddSequence(CreateSequence("b", "AD-CA"));
+  aln.AddSequence(CreateSequence("c", "CCADX"));
+  std::vector<char> alphabet;
+  alphabet.push_back('A');
+  alphabet.push_back('C');
+  alphabet.push_back('D');
+  alg::EncodedAlignment ali(aln, alphabet);
+  BOOST_CHECK_EQUAL(ali.GetLength(), 5);
+  BOOST_CHECK_EQUAL(ali.GetCount(), 3);
+  BOOST_CHECK_EQUAL(ali.GetAlphabetSize(), 3);
+  const uint8_t* col=ali.GetColumn(1);
+  BOOST_CHECK_EQUAL(int(col[0]), 1);
+  BOOST_CHECK_EQUAL(int(col[1]), 2);
+  BOOST_CHECK_EQUAL(int(col[2]), 1);
+  BOOST_CHECK_EQUAL(int(ali.GetCode(2, 0)), 3);
+  BOOST_CHECK_EQUAL(int(ali.GetCode(4, 2)), 3);
+  std::vector<uint32_t> counts;
+  ali.CountColumn(4, counts);
+  BOOST_REQUIRE_EQUAL(counts.size(), size_t(4));
+  BOOST_CHECK_EQUAL(counts[0], uint32_t(1));
+  BOOST_CHECK_EQUAL(counts[3], uint32_t(2));
+  ali.CountColumnPair(0, 3, counts);
+  BOOST_REQUIRE_EQUAL(counts.size(), size_t(16));
+  BOOST_CHECK_EQUAL(counts[0*4+2], uint32_t(1));
+  BOOST_CHECK_EQUAL(counts[0*4+1], uint32_t(1));
+  BOOST_CHECK_EQUAL(counts[1*4+2], uint32_t(1));
+  uint32_t total=0;
+  for (size_t i=0; i<counts.size(); ++i) {
+    total+=counts[i];
+  }
+  BOOST_CHECK_EQUAL(total, uint32_t(3));
+}
+
+BOOST_AUTO_TEST_CASE(contact_prediction_scores)
+{
+  boost::mt19937 rng(7);
+  AlignmentHandle aln=random_alignment(rng, 37, 15);
+  alg::ContactWeightMatrix cw=alg::LoadDefaultContactWeightMatrix();
+  alg::ContactWeightMatrix mw=alg::LoadConstantContactWeightMatrix();
+  alg::PairSubstWeightMatrix sw=alg::LoadDefaultPairSubstWeightMatrix();
+  for (int num_threads=1; num_threads<4; num_threads+=2) {
+    alg::ContactPredictionScoreResult co=alg::CalculateContactScore(aln, cw,
+                                                                  num_threads);
+    alg::ContactPredictionScoreResult cs=
+      alg::CalculateContactSubstitutionScore(aln, 2, sw, num_threads);
+    alg::ContactPredictionScoreResult mi=
+      alg::CalculateMutualInformation(aln, mw, false, false, 0.05,
+                                      num_threads);
+    for (int i=0; i<aln.GetLength(); ++i) {
+      BOOST_CHECK_EQUAL(co.GetScore(i, i), Real(0));
+      for (int j=i+1; j<aln.GetLength(); ++j) {
+        BOOST_CHECK_SMALL(co.GetScore(i, j)-ref_contact_score(aln, cw, i, j),
+                          Real(1e-5));
+        BOOST_CHECK_EQUAL(co.GetScore(i, j), co.GetScore(j, i));
+        BOOST_CHECK_SMALL(cs.GetScore(i, j)-ref_subst_score(aln, sw, 2, i, j),
+                          Real(1e-5));
+        BOOST_CHECK_EQUAL(cs.GetScore(i, j), cs.GetScore(j, i));
+        BOOST_CHECK_SMALL(mi.GetScore(i, j)-
+                          ref_mutual_information(aln, mw, 0.05, i, j),
+                          Real(1e-4));
+        BOOST_CHECK_EQUAL(mi.GetScore(i, j), mi.GetScore(j, i));
+      }
+    }
+  }
+  // corrected scores do not depend on the number of threads
+  alg::ContactPredictionScoreResult mi1=
+    alg::CalculateMutualInformation(aln, mw, true, true, 0.05, 1);
+  alg::ContactPredictionScoreResult mi3=
+    alg::CalculateMutualInformation(aln, mw, true, true, 0.05, 3);
+  BOOST_CHECK(mi1.matrix==mi3.matrix);
+  BOOST_CHECK_THROW(alg::CalculateContactScore(aln, cw, 0), Error);
+  BOOST_CHECK_THROW(alg::CalculateContactSubstitutionScore(aln, 37, sw),
+                    Error);
+}
+
+BOOST_AUTO_TEST_CASE(conservation)
+{
+  AlignmentHandle aln=CreateAlignment();
+  aln.AddSequence(CreateSequence("a", "AAA-"));
+  aln.AddSequence(CreateSequence("b", "AC--"));
+  std::vector<Real> cons=alg::Conservation(aln, false);
+  BOOST_REQUIRE_EQUAL(cons.size(), size_t(4));
+  BOOST_CHECK_CLOSE(cons[0], Real(1.0), Real(1e-4));
+  BOOST_CHECK_CLOSE(cons[1], Real(1.0-1.39/6.0), Real(1e-4));
+  BOOST_CHECK_SMALL(cons[2], Real(1e-6));
+  BOOST_CHECK_CLOSE(cons[3], Real(1.0-0.5/6.0), Real(1e-4));
+  cons=alg::Conservation(aln, false, "cons", true);
+  BOOST_CHECK_SMALL(cons[3], Real(1e-6));
+  // three sequences give the pairs (A,A), (A,C) and (A,C)
+  aln.AddSequence(CreateSequence("c", "CCCC"));
+  cons=alg::Conservation(aln, false);
+  BOOST_CHECK_CLOSE(cons[0], Real(1.0-2*1.39/18.0), Real(1e-4));
+}
+
+BOOST_AUTO_TEST_SUITE_END();
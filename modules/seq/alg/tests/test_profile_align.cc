@@ -0,0 +1,220 @@
+//------------------------------------------------------------------------------
+// This file is part of the OpenStructure project <www.openstructure.org>
+//
+// Copyright (C) 2008-2020 by the OpenStructure authors
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 3.0 of the License, or (at your option)
+// any later version.
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+//------------------------------------------------------------------------------
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <boost/random.hpp>
+#include <ost/seq/alg/profile_align.hh>
+
+using namespace ost;
+using namespace ost::seq;
+
+namespace {
+
+ProfileHandlePtr random_profile(boost::mt19937& rng, int length)
+{
+  const char* olc="ACDEFGHIKLMNPQRSTVWY";
+  boost::uniform_real<Real> freq(0, 1);
+  boost::uniform_int<int> aa(0, 19);
+  ProfileHandlePtr prof(new ProfileHandle);
+  for (int i=0; i<length; ++i) {
+    ProfileColumn col;
+    // columns are dominated by a few amino acids as in real profiles
+    Real sum=0;
+    for (int k=0; k<3; ++k) {
+      Real f=freq(rng);
+      col.SetFreq(olc[aa(rng)], f);
+      sum+=f;
+    }
+    for (Real* f=col.freqs_begin(); f!=col.freqs_end(); ++f) {
+      *f/=sum;
+    }
+    prof->AddColumn(col, olc[aa(rng)]);
+  }
+  return prof;
+}
+
+// score of a profile alignment with the gap penalties used by the aligners,
+// see aln_score in test_align_score.cc
+Real aln_score(const AlignmentHandle& aln, const ProfileHandle& prof1,
+               const ProfileHandle& prof2, Real gap_open, Real gap_ext,
+               bool semi)
+{
+  String s1=aln.GetSequence(0).GetString();
+  String s2=aln.GetSequence(1).GetString();
+  int pos1=aln.GetSequence(0).GetOffset();
+  int pos2=aln.GetSequence(1).GetOffset();
+  int len1=prof1.size();
+  int len2=prof2.size();
+  Real score=0;
+  char prev=0;
+  for (size_t i=0; i<s1.size(); ++i) {
+    char state;
+    if (s1[i]!='-' && s2[i]!='-') {
+      score+=prof1[pos1].GetScore(prof2[pos2], prof1.GetNullModel());
+      state='d';
+    } else if (s1[i]=='-') {
+      state='1';
+      if (!semi || (pos1>0 && pos1<len1)) {
+        score+=(prev==state ? gap_ext : gap_open);
+      }
+    } else {
+      state='2';
+      if (!semi || (pos2>0 && pos2<len2)) {
+        score+=(prev==state ? gap_ext : gap_open);
+      }
+    }
+    pos1+=(s1[i]!='-');
+    pos2+=(s2[i]!='-');
+    prev=state;
+  }
+  return score;
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(ost_seq_alg);
+
+BOOST_AUTO_TEST_CASE(profile_align_scores)
+{
+  boost::mt19937 rng(5);
+  ProfileHandlePtr query=random_profile(rng, 13);
+  ProfileHandlePtr target=random_profile(rng, 11);
+  alg::ProfileAligner aligner(*query);
+  BOOST_CHECK_EQUAL(aligner.GetQueryLength(), 13);
+  std::vector<Real> scores=aligner.GetScoreMatrix(*target);
+  BOOST_REQUIRE_EQUAL(scores.size(), size_t(13*11));
+  for (size_t i=0; i<query->size(); ++i) {
+    for (size_t j=0; j<target->size(); ++j) {
+      Real expected=(*query)[i].GetScore((*target)[j],
+                                         query->GetNullModel());
+      BOOST_CHECK_SMALL(scores[i*target->size()+j]-expected, Real(1e-4));
+    }
+  }
+  // identical profiles align without gaps
+  Real self_score=0;
+  for (size_t i=0; i<query->size(); ++i) {
+    self_score+=(*query)[i].GetScore((*query)[i], query->GetNullModel());
+  }
+  BOOST_CHECK_CLOSE(aligner.Score(*query, alg::AlignMode::GLOBAL), self_score,
+                    Real(1e-3));
+  AlignmentHandle aln=aligner.Align(*query, alg::AlignMode::GLOBAL);
+  BOOST_CHECK_EQUAL(aln.GetSequence(0).GetString(), query->GetSequence());
+  BOOST_CHECK_EQUAL(aln.GetSequence(1).GetString(), query->GetSequence());
+  // empty target
+  ProfileHandle empty;
+  BOOST_CHECK_EQUAL(aligner.Score(empty, alg::AlignMode::LOCAL), Real(0));
+  BOOST_CHECK_CLOSE(aligner.Score(empty, alg::AlignMode::GLOBAL),
+                    Real(-3.0-0.6*12), Real(1e-3));
+  BOOST_CHECK_EQUAL(aligner.Score(empty, alg::AlignMode::SEMIGLOBAL), Real(0));
+  BOOST_CHECK(!aligner.Align(empty, alg::AlignMode::LOCAL).IsValid());
+}
+
+BOOST_AUTO_TEST_CASE(profile_align_random)
+{
+  boost::mt19937 rng(3);
+  boost::uniform_int<int> length(1, 60);
+  alg::AlignMode::Type modes[]={ alg::AlignMode::LOCAL, alg::AlignMode::GLOBAL,
+                                 alg::AlignMode::SEMIGLOBAL };
+  for (int k=0; k<30; ++k) {
+    ProfileHandlePtr query=random_profile(rng, length(rng));
+    ProfileHandlePtr target=random_profile(rng, length(rng));
+    // related profiles with an insertion give long alignments
+    if (k%3==0 && query->size()>1) {
+      int half=query->size()/2;
+      target=query->Extract(0, half);
+      ProfileHandlePtr insertion=random_profile(rng, 4);
+      for (size_t i=0; i<insertion->size(); ++i) {
+        target->AddColumn((*insertion)[i], 'X');
+      }
+      for (size_t i=half; i<query->size(); ++i) {
+        target->AddColumn((*query)[i], query->GetSequence()[i]);
+      }
+    }
+    Real gap_open=-(k%5)-1.5;
+    Real gap_ext=-(k%3)*0.5-0.2;
+    alg::ProfileAligner aligner(*query, gap_open, gap_ext);
+    for (int m=0; m<3; ++m) {
+      Real score=aligner.Score(*target, modes[m]);
+      AlignmentHandle aln=aligner.Align(*target, modes[m]);
+      if (!aln.IsValid()) {
+        BOOST_CHECK(modes[m]==alg::AlignMode::LOCAL);
+        continue;
+      }
+      BOOST_CHECK_SMALL(score-aln_score(aln, *query, *target, gap_open,
+                                        gap_ext,
+                                        modes[m]==alg::AlignMode::SEMIGLOBAL),
+                        Real(1e-3));
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(profile_align_one_to_many)
+{
+  boost::mt19937 rng(17);
+  boost::uniform_int<int> length(1, 50);
+  ProfileHandlePtr query=random_profile(rng, 40);
+  ProfileHandleList targets;
+  for (int i=0; i<20; ++i) {
+    targets.push_back(random_profile(rng, length(rng)));
+  }
+  // duplicates give ties, which are ordered by index
+  targets.push_back(targets[3]);
+  targets.push_back(query->Extract(5, 30));
+  alg::ProfileAligner aligner(*query);
+  alg::AlignMode::Type modes[]={ alg::AlignMode::LOCAL, alg::AlignMode::GLOBAL,
+                                 alg::AlignMode::SEMIGLOBAL };
+  for (int m=0; m<3; ++m) {
+    alg::ProfileAlignHitList all=alg::ProfileAlignOneToMany(*query, targets,
+                                                            -3.0, -0.6,
+                                                            modes[m]);
+    BOOST_REQUIRE_EQUAL(all.size(), targets.size());
+    for (size_t i=0; i<all.size(); ++i) {
+      BOOST_CHECK_EQUAL(all[i].score,
+                        aligner.Score(*targets[all[i].index], modes[m]));
+      BOOST_CHECK(!all[i].aln.IsValid());
+      if (i>0) {
+        BOOST_CHECK(all[i-1].score>all[i].score ||
+                    (all[i-1].score==all[i].score &&
+                     all[i-1].index<all[i].index));
+      }
+    }
+    if (modes[m]!=alg::AlignMode::GLOBAL) {
+      // the fragment of the query is the best hit
+      BOOST_CHECK_EQUAL(all[0].index, 21);
+    }
+    for (int num_threads=1; num_threads<5; ++num_threads) {
+      alg::ProfileAlignHitList top=alg::ProfileAlignOneToMany(*query, targets,
+                                                              -3.0, -0.6,
+                                                              modes[m], 7,
+                                                              true,
+                                                              num_threads);
+      BOOST_REQUIRE_EQUAL(top.size(), size_t(7));
+      for (size_t i=0; i<top.size(); ++i) {
+        BOOST_CHECK(top[i]==all[i]);
+        BOOST_CHECK(top[i].aln.IsValid() || modes[m]==alg::AlignMode::LOCAL);
+      }
+    }
+  }
+  ProfileHandleList empty;
+  BOOST_CHECK(alg::ProfileAlignOneToMany(*query, empty, -3.0, -0.6,
+                                         alg::AlignMode::LOCAL, 5, true,
+                                         4).empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END();
@@ -79,7 +79,8 @@ void export_profile_handle()
   ;
 
   class_<ProfileDB, ProfileDBPtr>("ProfileDB", init<>())
-    .def("Load", &ProfileDB::Load, (arg("filename"))).staticmethod("Load")
+    .def("Load", &ProfileDB::Load,
+         (arg("filename"), arg("memory_map")=false)).staticmethod("Load")
     .def("Save", &ProfileDB::Save, (arg("filename")))
     .def("AddProfile", &ProfileDB::AddProfile, (arg("name"), arg("prof")))
     .def("GetProfile", &ProfileDB::GetProfile, (arg("name")))
@@ -21,8 +21,10 @@
   Author: Gerardo Tauriello, Gabriel Studer
  */
 
+#include <cstdio>
 #include <fstream>
 #include <iostream>
+#include <algorithm>
 #include <ost/seq/profile_handle.hh>
 
 namespace ost { namespace seq{ 
@@ -187,34 +189,40 @@ Real ProfileHandle::GetAverageScore(const ProfileHandle& other,
 // ProfileDB
 //////////////////////////////////////////////////////////////////////////////
 
-void ProfileDB::Save(const String& filename) const{
-
-  std::ofstream out_stream(filename.c_str(), std::ios::binary);
+namespace {
+
+// Files written by ProfileDB::Save start with a magic number, followed by
+// the number of profiles and the index. Each index entry consists of the
+// length of the name (uint8), the name and the offset of the profile from
+// the beginning of the file (uint64). The profiles are stored in the same
+// format as the one without index, i.e. null model, number of columns,
+// sequence and columns with frequencies stored as int16.
+const char PROFILE_DB_MAGIC[4] = {'O', 'P', 'D', 'B'};
+const uint32_t PROFILE_DB_VERSION = 1;
+const uint64_t COLUMN_BYTES = 20 * sizeof(int16_t);
+
+// bytes used by a profile with the given number of columns
+uint64_t ProfileBytes(uint64_t num_columns) {
+  return COLUMN_BYTES + sizeof(uint32_t) + num_columns * (1 + COLUMN_BYTES);
+}
 
-  //write out total size
-  uint32_t total_size = data_.size();
-  out_stream.write(reinterpret_cast<char*>(&total_size),4);
+void ThrowCorrupted(const String& filename) {
+  std::stringstream ss;
+  ss << "the profile database '" << filename << "' is corrupted.";
+  throw Error(ss.str());
+}
 
-  //write out the data elements
-  char string_size;
-  for (std::map<String, ProfileHandlePtr>::const_iterator i = data_.begin();
-       i != data_.end(); ++i){
-    string_size = static_cast<char>(i->first.size());
-    out_stream.write(reinterpret_cast<char*>(&string_size),1);
-    out_stream.write(i->first.c_str(),string_size);
-    out_stream << *i->second;
+void DecodeColumn(const char* data, ProfileColumn& col) {
+  int16_t freqs[20];
+  memcpy(freqs, data, sizeof(freqs));
+  Real* col_freqs = col.freqs_begin();
+  for (uint i = 0; i < 20; ++i) {
+    col_freqs[i] = freqs[i] * 0.0001;
   }
-  out_stream.close();
 }
 
-ProfileDBPtr ProfileDB::Load(const String& filename){
-
-  std::ifstream in_stream(filename.c_str(), std::ios::binary);
-  if (!in_stream){
-    std::stringstream ss;
-    ss << "the file '" << filename << "' does not exist.";
-    throw Error(ss.str());
-  }
+// reads files written before the index has been introduced
+ProfileDBPtr LoadWithoutIndex(std::ifstream& in_stream) {
 
   ProfileDBPtr db(new ProfileDB);
 
@@ -236,6 +244,175 @@ ProfileDBPtr ProfileDB::Load(const String& filename){
   return db;
 }
 
+}
+
+void ProfileDB::Save(const String& filename) const{
+
+  std::vector<String> names = this->GetNames();
+
+  // the index is followed by the profiles in the same order
+  uint64_t offset = sizeof(PROFILE_DB_MAGIC) + 2 * sizeof(uint32_t);
+  for (uint i = 0; i < names.size(); ++i) {
+    offset += 1 + names[i].size() + sizeof(uint64_t);
+  }
+
+  // the profiles of a memory mapped database are read from the mapped file
+  // while writing. Truncating it would crash with SIGBUS if filename is the
+  // mapped file itself, so a temporary file is written, which then replaces
+  // the target. The mapping stays valid when the file is replaced.
+  String out_filename = mapped_file_ ? filename + ".tmp" : filename;
+  std::ofstream out_stream(out_filename.c_str(), std::ios::binary);
+  if (!out_stream) {
+    std::stringstream ss;
+    ss << "could not open '" << out_filename << "' for writing.";
+    throw Error(ss.str());
+  }
+
+  out_stream.write(PROFILE_DB_MAGIC, sizeof(PROFILE_DB_MAGIC));
+  out_stream.write(reinterpret_cast<const char*>(&PROFILE_DB_VERSION), 4);
+  uint32_t total_size = names.size();
+  out_stream.write(reinterpret_cast<char*>(&total_size), 4);
+
+  for (uint i = 0; i < names.size(); ++i) {
+    uint8_t string_size = static_cast<uint8_t>(names[i].size());
+    out_stream.write(reinterpret_cast<char*>(&string_size), 1);
+    out_stream.write(names[i].c_str(), string_size);
+    out_stream.write(reinterpret_cast<char*>(&offset), sizeof(uint64_t));
+    offset += this->GetProfileSize(names[i]);
+  }
+
+  for (uint i = 0; i < names.size(); ++i) {
+    out_stream << *this->GetProfile(names[i]);
+  }
+  out_stream.close();
+  if (!mapped_file_) {
+    return;
+  }
+  if (!out_stream ||
+      std::rename(out_filename.c_str(), filename.c_str()) != 0) {
+    std::remove(out_filename.c_str());
+    std::stringstream ss;
+    ss << "could not write '" << filename << "'.";
+    throw Error(ss.str());
+  }
+}
+
+ProfileDBPtr ProfileDB::Load(const String& filename, bool memory_map){
+
+  std::ifstream in_stream(filename.c_str(), std::ios::binary);
+  if (!in_stream){
+    std::stringstream ss;
+    ss << "the file '" << filename << "' does not exist.";
+    throw Error(ss.str());
+  }
+
+  char magic[4];
+  in_stream.read(magic, sizeof(magic));
+  if (!in_stream || memcmp(magic, PROFILE_DB_MAGIC, sizeof(magic)) != 0) {
+    if (memory_map) {
+      std::stringstream ss;
+      ss << "the profile database '" << filename << "' has no index and can "
+         << "not be memory mapped. Load and save it again to add an index.";
+      throw Error(ss.str());
+    }
+    in_stream.clear();
+    in_stream.seekg(0, std::ios::beg);
+    return LoadWithoutIndex(in_stream);
+  }
+  in_stream.close();
+
+  ProfileDBPtr db(new ProfileDB);
+  try {
+    db->mapped_file_.reset(
+      new boost::iostreams::mapped_file_source(filename));
+  } catch (std::exception&) {
+    std::stringstream ss;
+    ss << "could not map the file '" << filename << "' into memory.";
+    throw Error(ss.str());
+  }
+
+  const char* data = db->mapped_file_->data();
+  const uint64_t file_size = db->mapped_file_->size();
+  uint64_t pos = sizeof(PROFILE_DB_MAGIC);
+  if (file_size < pos + 2 * sizeof(uint32_t)) {
+    ThrowCorrupted(filename);
+  }
+  uint32_t version, total_size;
+  memcpy(&version, data + pos, 4);
+  memcpy(&total_size, data + pos + 4, 4);
+  pos += 8;
+  if (version != PROFILE_DB_VERSION) {
+    std::stringstream ss;
+    ss << "the profile database '" << filename << "' has unsupported "
+       << "version " << version << ".";
+    throw Error(ss.str());
+  }
+
+  // names are stored in sorted order, inserting at the end is constant time
+  for (uint i = 0; i < total_size; ++i) {
+    if (pos + 1 > file_size) {
+      ThrowCorrupted(filename);
+    }
+    uint8_t string_size = static_cast<uint8_t>(data[pos]);
+    pos += 1;
+    if (pos + string_size + sizeof(uint64_t) > file_size) {
+      ThrowCorrupted(filename);
+    }
+    String name(data + pos, string_size);
+    pos += string_size;
+    uint64_t offset;
+    memcpy(&offset, data + pos, sizeof(uint64_t));
+    pos += sizeof(uint64_t);
+    if (offset + COLUMN_BYTES + sizeof(uint32_t) > file_size) {
+      ThrowCorrupted(filename);
+    }
+    db->index_.insert(db->index_.end(), std::make_pair(name, offset));
+  }
+
+  if (!memory_map) {
+    for (std::map<String, uint64_t>::const_iterator i = db->index_.begin();
+         i != db->index_.end(); ++i) {
+      db->data_[i->first] = db->DecodeProfile(i->second);
+    }
+    db->index_.clear();
+    db->mapped_file_.reset();
+  }
+
+  return db;
+}
+
+uint64_t ProfileDB::GetProfileSize(const String& name) const {
+  std::map<String, ProfileHandlePtr>::const_iterator i = data_.find(name);
+  if (i != data_.end()) {
+    return ProfileBytes(i->second->size());
+  }
+  // avoid decoding mapped profiles just to get their size
+  uint32_t size;
+  memcpy(&size, mapped_file_->data() + index_.find(name)->second + COLUMN_BYTES,
+         sizeof(uint32_t));
+  return ProfileBytes(size);
+}
+
+ProfileHandlePtr ProfileDB::DecodeProfile(uint64_t offset) const {
+  const char* data = mapped_file_->data() + offset;
+  ProfileHandlePtr prof(new ProfileHandle);
+  ProfileColumn col;
+  DecodeColumn(data, col);
+  prof->SetNullModel(col);
+  uint32_t size;
+  memcpy(&size, data + COLUMN_BYTES, sizeof(uint32_t));
+  if (offset + ProfileBytes(size) > mapped_file_->size()) {
+    throw Error("the memory mapped profile database is corrupted.");
+  }
+  const char* seq = data + COLUMN_BYTES + sizeof(uint32_t);
+  const char* columns = seq + size;
+  for (uint i = 0; i < size; ++i) {
+    DecodeColumn(columns + i * COLUMN_BYTES, col);
+    prof->AddColumn(col, seq[i]);
+  }
+  return prof;
+}
+
 void ProfileDB::AddProfile(const String& name, ProfileHandlePtr prof) {
   if (name.size() > 255) {
     throw Error("Name of Profile must be smaller than 256!");
@@ -244,17 +421,22 @@ void ProfileDB::AddProfile(const String& name, ProfileHandlePtr prof) {
     throw Error("Name must not be empty!");
   }
   data_[name] = prof;
+  index_.erase(name);
 }
 
 ProfileHandlePtr ProfileDB::GetProfile(const String& name) const{
   std::map<String,ProfileHandlePtr>::const_iterator i = data_.find(name);
-  if (i == data_.end()) {
+  if (i != data_.end()) {
+    return i->second;
+  }
+  std::map<String,uint64_t>::const_iterator j = index_.find(name);
+  if (j == index_.end()) {
     std::stringstream ss;
     ss << "Profile database does not contain an entry with name ";
     ss << name << "!";
     throw Error(ss.str());
   }
-  return i->second;
+  return this->DecodeProfile(j->second);
 }
 
 std::vector<String> ProfileDB::GetNames() const{
@@ -264,6 +446,13 @@ std::vector<String> ProfileDB::GetNames() const{
        i != data_.end(); ++i){
     return_vec.push_back(i->first);
   }
+  if (!index_.empty()) {
+    for (std::map<String, uint64_t>::const_iterator i = index_.begin();
+         i != index_.end(); ++i){
+      return_vec.push_back(i->first);
+    }
+    std::sort(return_vec.begin(), return_vec.end());
+  }
   return return_vec;
 }
 
@@ -34,6 +34,7 @@
 #include <map>
 #include <fstream>
 #include <boost/shared_ptr.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
 
 namespace ost { namespace seq { 
 
@@ -254,24 +255,46 @@ private:
 };
 
 /// \brief Contains a DB of profiles (identified by a unique name (String)).
+///
+/// A DB loaded with memory_map enabled only keeps the index of the profile
+/// names in memory. Profiles are decoded from the mapped file when requested,
+/// so that many processes can share one copy of a large DB.
 class DLLEXPORT_OST_SEQ ProfileDB {
 public:
   /// \brief Saves all profiles in DB with limited accuracy of internal data.
-  /// Binary format with fixed-width integers (should be portable).
+  /// Binary format with fixed-width integers (should be portable). The
+  /// profiles are preceded by an index with their names and offsets.
+  /// A memory mapped DB is written to a temporary file, which then replaces
+  /// the target, so it can also be saved to the file it has been loaded from.
   void Save(const String& filename) const;
 
-  static ProfileDBPtr Load(const String& filename);
+  /// \brief Loads DB written by Save().
+  ///
+  /// \param memory_map If true, only the index is read and the profiles are
+  ///                   decoded from the memory mapped file by GetProfile.
+  /// \throw Error if the file can not be read or if memory_map is requested
+  ///        for a file written in the format without index.
+  static ProfileDBPtr Load(const String& filename, bool memory_map = false);
 
   void AddProfile(const String& name, ProfileHandlePtr prof);
 
+  /// \brief Get profile with given name. Profiles of a memory mapped DB are
+  /// decoded on each call and not kept by the DB.
   ProfileHandlePtr GetProfile(const String& name) const;
 
-  size_t size() const { return data_.size(); }
+  size_t size() const { return data_.size() + index_.size(); }
 
   std::vector<String> GetNames() const;
 
 private:
+  ProfileHandlePtr DecodeProfile(uint64_t offset) const;
+
+  uint64_t GetProfileSize(const String& name) const;
+
   std::map<String, ProfileHandlePtr> data_;
+  // offsets of the profiles in the mapped file which are not in data_
+  std::map<String, uint64_t> index_;
+  boost::shared_ptr<boost::iostreams::mapped_file_source> mapped_file_;
 };
 
 }}
@@ -24,6 +24,7 @@
 #define BOOST_TEST_DYN_LINK
 #include <boost/test/unit_test.hpp>
 #include <iostream>
+#include <cstdio>
 
 #include <ost/seq/profile_handle.hh>
 #include <ost/io/seq/hhm_io_handler.hh>
@@ -165,5 +166,91 @@ BOOST_AUTO_TEST_CASE(profile_handle)
   BOOST_CHECK_THROW(prof.Extract(3, 6), ost::Error);
 }
 
+BOOST_AUTO_TEST_CASE(profile_db)
+{
+  ProfileDB db;
+  std::vector<ProfileHandlePtr> profiles;
+  for (uint i = 0; i < 3; ++i) {
+    ProfileHandlePtr prof(new ProfileHandle);
+    prof->SetNullModel(ProfileColumn::BLOSUMNullModel());
+    for (uint j = 0; j < 5 + i; ++j) {
+      ProfileColumn col;
+      col.SetFreq('A', 0.1 * j);
+      col.SetFreq('W', 0.5);
+      col.SetFreq('Y', 0.0001 * i);
+      prof->AddColumn(col, "ACDEFGHIKL"[j]);
+    }
+    profiles.push_back(prof);
+  }
+  db.AddProfile("b", profiles[0]);
+  db.AddProfile("a", profiles[1]);
+  db.AddProfile("c", profiles[2]);
+  db.Save("test_profile_db.tmp");
+
+  for (uint mapped = 0; mapped < 2; ++mapped) {
+    ProfileDBPtr loaded = ProfileDB::Load("test_profile_db.tmp", mapped);
+    BOOST_CHECK_EQUAL(loaded->size(), size_t(3));
+    std::vector<String> names = loaded->GetNames();
+    BOOST_REQUIRE_EQUAL(names.size(), size_t(3));
+    BOOST_CHECK_EQUAL(names[0], "a");
+    BOOST_CHECK_EQUAL(names[2], "c");
+    BOOST_CHECK_THROW(loaded->GetProfile("d"), ost::Error);
+    const char* keys[] = {"b", "a", "c"};
+    for (uint i = 0; i < 3; ++i) {
+      ProfileHandlePtr prof = loaded->GetProfile(keys[i]);
+      BOOST_REQUIRE_EQUAL(prof->size(), profiles[i]->size());
+      BOOST_CHECK_EQUAL(prof->GetSequence(), profiles[i]->GetSequence());
+      for (uint j = 0; j < prof->size(); ++j) {
+        BOOST_CHECK_CLOSE(prof->at(j).GetFreq('A'),
+                          profiles[i]->at(j).GetFreq('A'), Real(1e-2));
+        BOOST_CHECK_CLOSE(prof->at(j).GetFreq('W'), Real(0.5), Real(1e-2));
+      }
+      BOOST_CHECK_CLOSE(prof->GetNullModel().GetFreq('A'), Real(0.0732),
+                        Real(1e-2));
+    }
+    // profiles added to a mapped db replace the mapped ones
+    loaded->AddProfile("a", profiles[0]);
+    loaded->AddProfile("d", profiles[0]);
+    BOOST_CHECK_EQUAL(loaded->size(), size_t(4));
+    BOOST_CHECK(*loaded->GetProfile("a") == *profiles[0]);
+    loaded->Save("test_profile_db2.tmp");
+    ProfileDBPtr reloaded = ProfileDB::Load("test_profile_db2.tmp");
+    BOOST_CHECK_EQUAL(reloaded->size(), size_t(4));
+    BOOST_CHECK(*reloaded->GetProfile("c") == *loaded->GetProfile("c"));
+  }
+
+  // a memory mapped db can be saved to its own file
+  {
+    ProfileDBPtr mapped = ProfileDB::Load("test_profile_db.tmp", true);
+    mapped->Save("test_profile_db.tmp");
+    ProfileDBPtr reloaded = ProfileDB::Load("test_profile_db.tmp");
+    BOOST_CHECK_EQUAL(reloaded->size(), size_t(3));
+    const char* keys[] = {"b", "a", "c"};
+    for (uint i = 0; i < 3; ++i) {
+      BOOST_CHECK(*reloaded->GetProfile(keys[i]) ==
+                  *mapped->GetProfile(keys[i]));
+    }
+  }
+
+  // files without index can still be loaded, but not memory mapped
+  {
+    std::ofstream out_stream("test_profile_db.tmp", std::ios::binary);
+    uint32_t total_size = 1;
+    out_stream.write(reinterpret_cast<char*>(&total_size), 4);
+    char string_size = 1;
+    out_stream.write(&string_size, 1);
+    out_stream.write("a", 1);
+    out_stream << *profiles[1];
+  }
+  ProfileDBPtr loaded = ProfileDB::Load("test_profile_db.tmp");
+  BOOST_CHECK_EQUAL(loaded->size(), size_t(1));
+  BOOST_CHECK_EQUAL(loaded->GetProfile("a")->GetSequence(),
+                    profiles[1]->GetSequence());
+  BOOST_CHECK_THROW(ProfileDB::Load("test_profile_db.tmp", true), ost::Error);
+
+  std::remove("test_profile_db.tmp");
+  std::remove("test_profile_db2.tmp");
+}
+
 
 BOOST_AUTO_TEST_SUITE_END();